@@ -46,6 +46,8 @@
 #include "Landscape.h"
 #include "ToolTargetManager.h"
 #include "Foundation/HxlbHexIterators.h"
+#include "Foundation/HxlbHexRanges.h"
+#include "Foundation/HxlbHexShapes.h"
 #include "Macros/HexLibLoggingMacros.h"
 #include "Subsystems/HxlbEditorMessageChannels.h"
 #include "Subsystems/HxlbEditorMessagingSubsystem.h"
@@ -289,6 +291,7 @@ void UHxlbSelectionToolBase::OnClickPress(const FInputDeviceRay& PressPos)
 	
 	// Turn off hover while selection is in progress
 	bSelectionInProgress = true;
+	bDragSelecting = false;
 	ClearHover();
 
 	// Get starting hex, draw it.
@@ -309,7 +312,7 @@ void UHxlbSelectionToolBase::OnClickPress(const FInputDeviceRay& PressPos)
 			SelectionState.SelectedHexes.Empty();
 		}
 	
-		SelectHex(HexCoord.Get());
+		bDragSelecting = SelectHex(HexCoord.Get());
 	}
 	
 	PublishSelection();
@@ -366,16 +369,19 @@ void UHxlbSelectionToolBase::OnClickDrag(const FInputDeviceRay& DragPos)
 			}
 		case (EHxlbGridToolSelectionMode::Hexagonal):
 			{
+				// Shapes are clipped to the map row by row, so large radii don't validate every hex outside of the map.
+				int32 Radius = HexMath::AxialDistance(SelectionState.FirstSelectedHex, HexCoords);
+				auto Shape = HxlbShapes::ClipToMap(HxlbShapes::Spans(FHxlbRadialRange(SelectionState.FirstSelectedHex, Radius)), GetMapLayout());
+				
 				if (bIsRemoving)
 				{
-					int32 Radius = HexMath::AxialDistance(SelectionState.FirstSelectedHex, HexCoords);
-					auto Iterator = FHxlbRadialIterator(SelectionState.FirstSelectedHex, Radius);
+					auto Iterator = HxlbShapes::MakeIterator(MoveTemp(Shape));
 					UpdateRemovingHexes(Iterator);
 				}
-				else if (!SelectionState.SelectingHexes.IsEmpty())
+				else if (bDragSelecting)
 				{
-					int32 Radius = HexMath::AxialDistance(SelectionState.FirstSelectedHex, HexCoords);
-					auto Iterator = FHxlbRadialIterator(SelectionState.FirstSelectedHex, Radius);
+					// The preview keeps hexes that are already selected, so that dragging over them still shows the shape.
+					auto Iterator = HxlbShapes::MakeIterator(MoveTemp(Shape));
 					UpdateSelectingHexes(Iterator);
 				}
 				
@@ -385,16 +391,22 @@ void UHxlbSelectionToolBase::OnClickDrag(const FInputDeviceRay& DragPos)
 			}
 		case (EHxlbGridToolSelectionMode::Ring):
 			{
+				// A ring is the hexagon of its radius minus the hexagon one step smaller.
+				int32 Radius = HexMath::AxialDistance(SelectionState.FirstSelectedHex, HexCoords);
+				auto Shape = HxlbShapes::ClipToMap(
+					HxlbShapes::Subtract(
+						HxlbShapes::Spans(FHxlbRadialRange(SelectionState.FirstSelectedHex, Radius)),
+						HxlbShapes::Spans(FHxlbRadialRange(SelectionState.FirstSelectedHex, Radius - 1))),
+					GetMapLayout());
+				
 				if (bIsRemoving)
 				{
-					int32 Radius = HexMath::AxialDistance(SelectionState.FirstSelectedHex, HexCoords);
-					auto Iterator = FHxlbRingIterator(SelectionState.FirstSelectedHex, Radius);
+					auto Iterator = HxlbShapes::MakeIterator(MoveTemp(Shape));
 					UpdateRemovingHexes(Iterator);
 				}
-				else if (!SelectionState.SelectingHexes.IsEmpty())
+				else if (bDragSelecting)
 				{
-					int32 Radius = HexMath::AxialDistance(SelectionState.FirstSelectedHex, HexCoords);
-					auto Iterator = FHxlbRingIterator(SelectionState.FirstSelectedHex, Radius);
+					auto Iterator = HxlbShapes::MakeIterator(MoveTemp(Shape));
 					UpdateSelectingHexes(Iterator);
 				}
 				
@@ -415,7 +427,7 @@ void UHxlbSelectionToolBase::OnClickDrag(const FInputDeviceRay& DragPos)
 					auto Iterator = FHxlbRectangularIterator(SelectionState.FirstSelectedHex, HexCoords);
 					UpdateRemovingHexes(Iterator);
 				}
-				else if (!SelectionState.SelectingHexes.IsEmpty())
+				else if (bDragSelecting)
 				{
 					auto Iterator = FHxlbRectangularIterator(SelectionState.FirstSelectedHex, HexCoords);
 					UpdateSelectingHexes(Iterator);
@@ -435,12 +447,14 @@ void UHxlbSelectionToolBase::OnClickDrag(const FInputDeviceRay& DragPos)
 void UHxlbSelectionToolBase::OnClickRelease(const FInputDeviceRay& ReleasePos)
 {
 	bSelectionInProgress = false;
+	bDragSelecting = false;
 	UpdateAndPublishSelection();
 }
 
 void UHxlbSelectionToolBase::OnTerminateDragSequence()
 {
 	bSelectionInProgress = false;
+	bDragSelecting = false;
 }
 
 bool UHxlbSelectionToolBase::RouteHexEditorMessage(FName Channel, FInstancedStruct& MessagePayload)
@@ -568,6 +582,19 @@ bool UHxlbSelectionToolBase::SelectHex(const FIntPoint& NewSelection, bool bIsRe
 	return !bAlreadyInSet;
 }
 
+const FHxlbDenseLayout& UHxlbSelectionToolBase::GetMapLayout()
+{
+	static const FHxlbDenseLayout EmptyLayout;
+	
+	AHxlbHexManager* HexManager = FindHexManager(/*bCachedOnly=*/true);
+	if (!HexManager || !HexManager->MapComponent)
+	{
+		// An empty layout doesn't clip anything. ValidateHex() still rejects hexes outside of the grid.
+		return EmptyLayout;
+	}
+	return HexManager->MapComponent->GetDenseLayout();
+}
+
 void UHxlbSelectionToolBase::UpdateSelectingHexes(FHxlbHexIterator& Iterator)
 {
 	// We have to flush the selection set and re-add everything because it may have shrunk.
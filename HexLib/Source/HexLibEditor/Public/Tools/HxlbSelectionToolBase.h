@@ -42,6 +42,7 @@
 #include "HxlbSelectionToolBase.generated.h"
 
 struct FHxlbHexIterator;
+class FHxlbDenseLayout;
 class UHxlbHexMapComponent;
 class ALandscape;
 class UHxlbHex;
@@ -182,6 +183,7 @@ protected:
 	virtual void ConfigureActionProperties() {}
 	virtual void ConfigureSettingsProperties();
 	void ApplyPendingAction();
+	const FHxlbDenseLayout& GetMapLayout();
 	
 	bool SelectHex(const FIntPoint& NewSelection, bool bIsRefresh = false);
 	void UpdateSelectingHexes(FHxlbHexIterator& Iterator);
@@ -233,6 +235,10 @@ protected:
 
 	FHxlbHexCoord HitGridHexCoords;
 	bool bSelectionInProgress = false;
+
+	// True while a drag that started on a valid hex is adding to the selection. The preview may be empty meanwhile, e.g.
+	// while a ring lies outside of the map.
+	bool bDragSelecting = false;
 	bool bNewSelectionStarted = false;
 	FHxlbSelectionState SelectionState;
 	FHxlbHexCoordDelta HoverState;
@@ -0,0 +1,329 @@
+// Copyright © Mason Stevenson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the disclaimer
+// below) provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+// THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+// CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+// NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "Analysis/HxlbDistanceField.h"
+
+#include "Algo/BinarySearch.h"
+#include "Algo/Unique.h"
+#include "Async/ParallelFor.h"
+#include "FunctionLibraries/HxlbMath.h"
+
+using HexMath = UHxlbMath;
+
+namespace
+{
+	// Frontiers smaller than this are expanded on a single thread.
+	constexpr int32 kMinFrontierBatchSize = 512;
+	constexpr int32 kMaxFrontierBatches = 64;
+}
+
+void FHxlbDistanceField::Build(const FHxlbDenseLayout& NewLayout, TConstArrayView<int32> SourceIndices)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(HXLB_BuildDistanceField);
+	
+	Layout = &NewLayout;
+	CostField = FHxlbCostField();
+	Init(SourceIndices);
+	BuildUnweighted();
+}
+
+void FHxlbDistanceField::Build(const FHxlbCostField& NewCostField, TConstArrayView<int32> SourceIndices)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(HXLB_BuildWeightedDistanceField);
+	
+	if (!NewCostField.IsValid())
+	{
+		Reset();
+		return;
+	}
+	Layout = &NewCostField.GetLayout();
+	CostField = NewCostField;
+	Init(SourceIndices);
+	for (int32 Source : Sources)
+	{
+		SetHex(Source, 0.0f, Source);
+		Heap.Push(0.0f, Source);
+	}
+	Propagate();
+	ClearUpdatedHexes();
+}
+
+void FHxlbDistanceField::Reset()
+{
+	Layout = nullptr;
+	CostField = FHxlbCostField();
+	Sources.Reset();
+	Distances.Reset();
+	NearestSources.Reset();
+	Heap.Reset();
+	UpdatedHexes.Reset();
+	UpdatedMask.Reset();
+}
+
+void FHxlbDistanceField::Init(TConstArrayView<int32> SourceIndices)
+{
+	Sources.Reset();
+	for (int32 Source : SourceIndices)
+	{
+		if (Source >= 0 && Source < Layout->Num())
+		{
+			Sources.Add(Source);
+		}
+	}
+	Sources.Sort();
+	Sources.SetNum(Algo::Unique(Sources), EAllowShrinking::No);
+
+	Distances.Init(Unreachable, Layout->Num());
+	NearestSources.Init(INDEX_NONE, Layout->Num());
+	UpdatedMask.Init(0, Layout->Num());
+	UpdatedHexes.Reset();
+	Heap.Reset();
+}
+
+void FHxlbDistanceField::ClearUpdatedHexes()
+{
+	for (int32 DenseIndex : UpdatedHexes)
+	{
+		UpdatedMask[DenseIndex] = 0;
+	}
+	UpdatedHexes.Reset();
+}
+
+bool FHxlbDistanceField::IsSource(int32 DenseIndex) const
+{
+	return Algo::BinarySearch(Sources, DenseIndex) != INDEX_NONE;
+}
+
+void FHxlbDistanceField::BuildUnweighted()
+{
+	TArray<int32> Frontier = Sources;
+	for (int32 Source : Sources)
+	{
+		Distances[Source] = 0.0f;
+		NearestSources[Source] = Source;
+	}
+
+	TArray<TArray<int32>> BatchHexes;
+	TArray<int32> NextFrontier;
+	TArray<int32> NextNearest;
+	float Distance = 0.0f;
+	while (!Frontier.IsEmpty())
+	{
+		// Unreached neighbors of the frontier, gathered in parallel and then sorted so that the next ring doesn't depend
+		// on how the work was split.
+		const int32 NumBatches = FMath::Clamp(Frontier.Num() / kMinFrontierBatchSize, 1, kMaxFrontierBatches);
+		BatchHexes.SetNum(NumBatches);
+		ParallelFor(NumBatches, [this, &Frontier, &BatchHexes, NumBatches](int32 BatchIndex)
+		{
+			TArray<int32>& Found = BatchHexes[BatchIndex];
+			Found.Reset();
+			const int32 Begin = static_cast<int32>(static_cast<int64>(Frontier.Num()) * BatchIndex / NumBatches);
+			const int32 End = static_cast<int32>(static_cast<int64>(Frontier.Num()) * (BatchIndex + 1) / NumBatches);
+			for (int32 FrontierIndex = Begin; FrontierIndex < End; FrontierIndex++)
+			{
+				const FIntPoint HexCoord = Layout->CoordOf(Frontier[FrontierIndex]);
+				for (int32 Direction = 0; Direction < 6; Direction++)
+				{
+					const int32 Neighbor = Layout->NeighborIndex(HexCoord, Direction);
+					if (Neighbor != INDEX_NONE && Distances[Neighbor] == Unreachable)
+					{
+						Found.Add(Neighbor);
+					}
+				}
+			}
+		}, NumBatches == 1 ? EParallelForFlags::ForceSingleThread : EParallelForFlags::None);
+
+		NextFrontier.Reset();
+		for (const TArray<int32>& Found : BatchHexes)
+		{
+			NextFrontier.Append(Found);
+		}
+		NextFrontier.Sort();
+		NextFrontier.SetNum(Algo::Unique(NextFrontier), EAllowShrinking::No);
+		
+		// Each hex of the ring takes the smallest nearest source among its neighbors on the previous ring, which is the
+		// smallest of its nearest sources.
+		NextNearest.SetNumUninitialized(NextFrontier.Num());
+		ParallelFor(NextFrontier.Num(), [this, &NextFrontier, &NextNearest, Distance](int32 FrontierIndex)
+		{
+			const FIntPoint HexCoord = Layout->CoordOf(NextFrontier[FrontierIndex]);
+			int32 Nearest = MAX_int32;
+			for (int32 Direction = 0; Direction < 6; Direction++)
+			{
+				const int32 Neighbor = Layout->NeighborIndex(HexCoord, Direction);
+				if (Neighbor != INDEX_NONE && Distances[Neighbor] == Distance)
+				{
+					Nearest = FMath::Min(Nearest, NearestSources[Neighbor]);
+				}
+			}
+			NextNearest[FrontierIndex] = Nearest;
+		});
+		
+		Distance += 1.0f;
+		for (int32 FrontierIndex = 0; FrontierIndex < NextFrontier.Num(); FrontierIndex++)
+		{
+			Distances[NextFrontier[FrontierIndex]] = Distance;
+			NearestSources[NextFrontier[FrontierIndex]] = NextNearest[FrontierIndex];
+		}
+		Swap(Frontier, NextFrontier);
+	}
+}
+
+void FHxlbDistanceField::AddSources(TConstArrayView<int32> SourceIndices)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(HXLB_AddDistanceSources);
+	
+	ClearUpdatedHexes();
+	for (int32 Source : SourceIndices)
+	{
+		if (Source < 0 || Source >= Layout->Num() || IsSource(Source))
+		{
+			continue;
+		}
+		Sources.Insert(Source, Algo::LowerBound(Sources, Source));
+		if (IsBetter(0.0f, Source, Source))
+		{
+			SetHex(Source, 0.0f, Source);
+			Heap.Push(0.0f, Source);
+		}
+	}
+	Propagate();
+}
+
+void FHxlbDistanceField::RemoveSources(TConstArrayView<int32> SourceIndices)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(HXLB_RemoveDistanceSources);
+	
+	ClearUpdatedHexes();
+
+	// The hexes a source is nearest to are connected to it, since every one of them is reached from a neighbor with the
+	// same nearest source. Flood them and clear them.
+	TArray<int32> Cleared;
+	for (int32 Source : SourceIndices)
+	{
+		const int32 SourcePosition = Algo::BinarySearch(Sources, Source);
+		if (SourcePosition == INDEX_NONE)
+		{
+			continue;
+		}
+		Sources.RemoveAt(SourcePosition);
+		
+		const int32 FirstCleared = Cleared.Num();
+		Cleared.Add(Source);
+		SetHex(Source, Unreachable, INDEX_NONE);
+		for (int32 ClearedIndex = FirstCleared; ClearedIndex < Cleared.Num(); ClearedIndex++)
+		{
+			const FIntPoint HexCoord = Layout->CoordOf(Cleared[ClearedIndex]);
+			for (int32 Direction = 0; Direction < 6; Direction++)
+			{
+				const int32 Neighbor = Layout->NeighborIndex(HexCoord, Direction);
+				if (Neighbor != INDEX_NONE && NearestSources[Neighbor] == Source)
+				{
+					SetHex(Neighbor, Unreachable, INDEX_NONE);
+					Cleared.Add(Neighbor);
+				}
+			}
+		}
+	}
+
+	// Search into the cleared hexes again from the hexes around them.
+	for (int32 DenseIndex : Cleared)
+	{
+		if (IsWeighted() && CostField.IsBlocked(DenseIndex))
+		{
+			continue;
+		}
+		
+		const FIntPoint HexCoord = Layout->CoordOf(DenseIndex);
+		for (int32 Direction = 0; Direction < 6; Direction++)
+		{
+			const int32 Neighbor = Layout->NeighborIndex(HexCoord, Direction);
+			if (Neighbor == INDEX_NONE || NearestSources[Neighbor] == INDEX_NONE)
+			{
+				continue;
+			}
+			const float Distance = Distances[Neighbor] + StepCost(DenseIndex);
+			if (IsBetter(Distance, NearestSources[Neighbor], DenseIndex))
+			{
+				SetHex(DenseIndex, Distance, NearestSources[Neighbor]);
+			}
+		}
+		if (NearestSources[DenseIndex] != INDEX_NONE)
+		{
+			Heap.Push(Distances[DenseIndex], DenseIndex);
+		}
+	}
+	Propagate();
+}
+
+void FHxlbDistanceField::Propagate()
+{
+	while (!Heap.IsEmpty())
+	{
+		const FHxlbHeapNode Node = Heap.Pop();
+		if (Node.Key != Distances[Node.Index])
+		{
+			// Stale entry.
+			continue;
+		}
+		
+		const int32 Source = NearestSources[Node.Index];
+		const FIntPoint HexCoord = Layout->CoordOf(Node.Index);
+		for (int32 Direction = 0; Direction < 6; Direction++)
+		{
+			const int32 Neighbor = Layout->NeighborIndex(HexCoord, Direction);
+			if (Neighbor == INDEX_NONE || (IsWeighted() && CostField.IsBlocked(Neighbor)))
+			{
+				continue;
+			}
+
+			// A hex that only gets a smaller nearest source at the same distance is pushed again too, so that the
+			// smaller source spreads as far as it ties.
+			const float Distance = Node.Key + StepCost(Neighbor);
+			if (IsBetter(Distance, Source, Neighbor))
+			{
+				SetHex(Neighbor, Distance, Source);
+				Heap.Push(Distance, Neighbor);
+			}
+		}
+	}
+}
+
+void FHxlbDistanceField::SetHex(int32 DenseIndex, float Distance, int32 Source)
+{
+	Distances[DenseIndex] = Distance;
+	NearestSources[DenseIndex] = Source;
+	if (!UpdatedMask[DenseIndex])
+	{
+		UpdatedMask[DenseIndex] = 1;
+		UpdatedHexes.Add(DenseIndex);
+	}
+}
@@ -0,0 +1,282 @@
+// Copyright © Mason Stevenson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the disclaimer
+// below) provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+// THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+// CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+// NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "Analysis/HxlbHexAggregate.h"
+
+#include "Async/ParallelFor.h"
+
+void FHxlbHexAggregate::Build(const FHxlbHexHierarchy& NewHierarchy, EHxlbAggregateOp NewOp, FValueFunction ValueOf)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(HXLB_BuildHexAggregate);
+	
+	Reset();
+	if (!NewHierarchy.IsBuilt())
+	{
+		return;
+	}
+	Hierarchy = &NewHierarchy;
+	Op = NewOp;
+
+	const int32 NumLevels = Hierarchy->NumLevels();
+	LevelValues.SetNum(NumLevels);
+	UpdatedHexes.SetNum(NumLevels);
+	LevelHistograms.SetNum(Op == EHxlbAggregateOp::Dominant ? NumLevels : 0);
+	
+	TArray<float>& Leaves = LevelValues[0];
+	Leaves.SetNumUninitialized(Hierarchy->GetLayout(0).Num());
+	for (int32 LeafIndex = 0; LeafIndex < Leaves.Num(); LeafIndex++)
+	{
+		Leaves[LeafIndex] = ValueOf(LeafIndex);
+	}
+
+	// Each super-hex only writes its own slot, so a whole level can be computed in parallel.
+	for (int32 Level = 1; Level < NumLevels; Level++)
+	{
+		const int32 NumHexes = Hierarchy->GetLayout(Level).Num();
+		LevelValues[Level].Init(0.0f, NumHexes);
+		if (Op == EHxlbAggregateOp::Dominant)
+		{
+			LevelHistograms[Level].SetNum(NumHexes);
+		}
+		ParallelFor(NumHexes, [this, Level](int32 DenseIndex)
+		{
+			Recompute(Level, DenseIndex);
+		});
+	}
+}
+
+void FHxlbHexAggregate::Reset()
+{
+	Hierarchy = nullptr;
+	LevelValues.Reset();
+	LevelHistograms.Reset();
+	UpdatedHexes.Reset();
+}
+
+void FHxlbHexAggregate::Update(TConstArrayView<int32> ChangedLeaves, FValueFunction ValueOf)
+{
+	if (!Hierarchy)
+	{
+		return;
+	}
+	for (TArray<int32>& Updated : UpdatedHexes)
+	{
+		Updated.Reset();
+	}
+
+	TArray<int32> Dirty;
+	for (int32 LeafIndex : ChangedLeaves)
+	{
+		const float NewValue = ValueOf(LeafIndex);
+		if (NewValue != LevelValues[0][LeafIndex])
+		{
+			LevelValues[0][LeafIndex] = NewValue;
+			UpdatedHexes[0].Add(LeafIndex);
+			
+			const int32 Parent = Hierarchy->GetParent(0, LeafIndex);
+			if (Parent != INDEX_NONE)
+			{
+				Dirty.Add(Parent);
+			}
+		}
+	}
+	UpdatedHexes[0].Sort();
+
+	for (int32 Level = 1; Level < Hierarchy->NumLevels() && !Dirty.IsEmpty(); Level++)
+	{
+		Dirty.Sort();
+		int32 NumUnique = 0;
+		for (int32 DirtyIndex = 0; DirtyIndex < Dirty.Num(); DirtyIndex++)
+		{
+			if (DirtyIndex == 0 || Dirty[DirtyIndex] != Dirty[NumUnique - 1])
+			{
+				Dirty[NumUnique++] = Dirty[DirtyIndex];
+			}
+		}
+		Dirty.SetNum(NumUnique, EAllowShrinking::No);
+
+		TArray<uint8> Changed;
+		Changed.SetNumZeroed(Dirty.Num());
+		ParallelFor(Dirty.Num(), [this, Level, &Dirty, &Changed](int32 DirtyIndex)
+		{
+			Changed[DirtyIndex] = Recompute(Level, Dirty[DirtyIndex]) ? 1 : 0;
+		});
+
+		// Ancestors of super-hexes that didn't change don't need to be looked at.
+		TArray<int32> NextDirty;
+		for (int32 DirtyIndex = 0; DirtyIndex < Dirty.Num(); DirtyIndex++)
+		{
+			if (!Changed[DirtyIndex])
+			{
+				continue;
+			}
+			UpdatedHexes[Level].Add(Dirty[DirtyIndex]);
+			
+			const int32 Parent = Hierarchy->GetParent(Level, Dirty[DirtyIndex]);
+			if (Parent != INDEX_NONE)
+			{
+				NextDirty.Add(Parent);
+			}
+		}
+		Dirty = MoveTemp(NextDirty);
+	}
+}
+
+bool FHxlbHexAggregate::Recompute(int32 Level, int32 DenseIndex)
+{
+	const TConstArrayView<int32> Children = Hierarchy->GetChildren(Level, DenseIndex);
+	const TArray<float>& ChildValues = LevelValues[Level - 1];
+	float Value = 0.0f;
+	bool bHistogramChanged = false;
+	
+	switch (Op)
+	{
+	case EHxlbAggregateOp::Sum:
+		for (int32 Child : Children)
+		{
+			Value += ChildValues[Child];
+		}
+		break;
+		
+	case EHxlbAggregateOp::Mean:
+		if (const int32 LeafCount = Hierarchy->GetLeafCount(Level, DenseIndex))
+		{
+			for (int32 Child : Children)
+			{
+				Value += ChildValues[Child] * Hierarchy->GetLeafCount(Level - 1, Child);
+			}
+			Value /= LeafCount;
+		}
+		break;
+		
+	case EHxlbAggregateOp::Min:
+	case EHxlbAggregateOp::Max:
+		{
+			bool bAny = false;
+			for (int32 Child : Children)
+			{
+				if (Hierarchy->GetLeafCount(Level - 1, Child) == 0)
+				{
+					continue;
+				}
+				const float ChildValue = ChildValues[Child];
+				Value = !bAny ? ChildValue : (Op == EHxlbAggregateOp::Min ? FMath::Min(Value, ChildValue) : FMath::Max(Value, ChildValue));
+				bAny = true;
+			}
+		}
+		break;
+		
+	case EHxlbAggregateOp::Dominant:
+		{
+			// Histograms are kept sorted by category so that equal histograms compare equal.
+			FHistogram Histogram;
+			auto AddCount = [&Histogram](int32 Category, int32 Count)
+			{
+				int32 Position = 0;
+				while (Position < Histogram.Num() && Histogram[Position].Category < Category)
+				{
+					Position++;
+				}
+				if (Position < Histogram.Num() && Histogram[Position].Category == Category)
+				{
+					Histogram[Position].Count += Count;
+				}
+				else
+				{
+					Histogram.Insert(FCategoryCount{Category, Count}, Position);
+				}
+			};
+			for (int32 Child : Children)
+			{
+				if (Level == 1)
+				{
+					AddCount(FMath::RoundToInt32(ChildValues[Child]), 1);
+					continue;
+				}
+				for (const FCategoryCount& ChildCount : LevelHistograms[Level - 1][Child])
+				{
+					AddCount(ChildCount.Category, ChildCount.Count);
+				}
+			}
+			
+			int32 BestCount = 0;
+			for (const FCategoryCount& CategoryCount : Histogram)
+			{
+				if (CategoryCount.Count > BestCount)
+				{
+					BestCount = CategoryCount.Count;
+					Value = static_cast<float>(CategoryCount.Category);
+				}
+			}
+			
+			FHistogram& Stored = LevelHistograms[Level][DenseIndex];
+			bHistogramChanged = Stored != Histogram;
+			Stored = MoveTemp(Histogram);
+		}
+		break;
+	}
+
+	float& Stored = LevelValues[Level][DenseIndex];
+	const bool bValueChanged = Stored != Value;
+	Stored = Value;
+	return bValueChanged || bHistogramChanged;
+}
+
+void FHxlbHexAggregate::FindLeaves(TFunctionRef<bool(float)> Predicate, TArray<int32>& OutLeaves) const
+{
+	if (!Hierarchy)
+	{
+		return;
+	}
+	
+	const int32 TopLevel = Hierarchy->NumLevels() - 1;
+	for (int32 DenseIndex = 0; DenseIndex < LevelValues[TopLevel].Num(); DenseIndex++)
+	{
+		FindLeavesRecursive(TopLevel, DenseIndex, Predicate, OutLeaves);
+	}
+}
+
+void FHxlbHexAggregate::FindLeavesRecursive(int32 Level, int32 DenseIndex, TFunctionRef<bool(float)> Predicate, TArray<int32>& OutLeaves) const
+{
+	if (Hierarchy->GetLeafCount(Level, DenseIndex) == 0 || !Predicate(LevelValues[Level][DenseIndex]))
+	{
+		return;
+	}
+	if (Level == 0)
+	{
+		OutLeaves.Add(DenseIndex);
+		return;
+	}
+	for (int32 Child : Hierarchy->GetChildren(Level, DenseIndex))
+	{
+		FindLeavesRecursive(Level - 1, Child, Predicate, OutLeaves);
+	}
+}
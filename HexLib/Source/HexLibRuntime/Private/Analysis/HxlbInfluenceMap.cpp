@@ -0,0 +1,396 @@
+// Copyright © Mason Stevenson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the disclaimer
+// below) provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+// THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+// CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+// NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "Analysis/HxlbInfluenceMap.h"
+
+#include "Async/ParallelFor.h"
+#include "FunctionLibraries/HxlbMath.h"
+#include "Navigation/HxlbSearchScratch.h"
+
+using HexMath = UHxlbMath;
+
+float FHxlbInfluenceSource::GetInfluenceAt(int32 Steps) const
+{
+	if (Steps > Radius)
+	{
+		return 0.0f;
+	}
+	
+	switch (Falloff)
+	{
+	case EHxlbInfluenceFalloff::Constant:
+		return Strength;
+	case EHxlbInfluenceFalloff::Linear:
+		return Strength * (1.0f - static_cast<float>(Steps) / static_cast<float>(Radius + 1));
+	case EHxlbInfluenceFalloff::Exponential:
+		return Strength * FMath::Pow(Decay, static_cast<float>(Steps));
+	}
+	return 0.0f;
+}
+
+void FHxlbInfluenceMap::Init(const FHxlbDenseLayout& NewLayout)
+{
+	Layout = &NewLayout;
+	for (TArray<float>& Values : FactionValues)
+	{
+		Values.Init(0.0f, Layout->Num());
+	}
+	for (auto& SourceKV : Sources)
+	{
+		SourceKV.Value.Contributions.Reset();
+		SourceKV.Value.bDirty = true;
+	}
+	DirtyChunks.Init(0, Layout->NumChunks());
+	UpdatedChunks.Reset();
+	bAllChunksDirty = true;
+}
+
+void FHxlbInfluenceMap::SetSource(int32 SourceId, const FHxlbInfluenceSource& Source)
+{
+	FSourceState* State = Sources.Find(SourceId);
+	if (!State)
+	{
+		State = &Sources.Add(SourceId);
+	}
+	else if (State->Source == Source)
+	{
+		return;
+	}
+	State->Source = Source;
+	State->bDirty = true;
+}
+
+bool FHxlbInfluenceMap::RemoveSource(int32 SourceId)
+{
+	const FSourceState* State = Sources.Find(SourceId);
+	if (!State)
+	{
+		return false;
+	}
+
+	MarkChunksDirty(*State);
+	Sources.Remove(SourceId);
+	return true;
+}
+
+void FHxlbInfluenceMap::Reset()
+{
+	Sources.Reset();
+	FactionSlots.Reset();
+	FactionValues.Reset();
+	UpdatedChunks.Reset();
+	for (uint8& bDirty : DirtyChunks)
+	{
+		bDirty = 0;
+	}
+	bAllChunksDirty = false;
+}
+
+void FHxlbInfluenceMap::MarkHexesChanged(TConstArrayView<int32> DenseIndices)
+{
+	if (!Layout || DenseIndices.IsEmpty())
+	{
+		return;
+	}
+
+	TArray<FIntPoint> ChangedCoords;
+	ChangedCoords.Reserve(DenseIndices.Num());
+	for (int32 DenseIndex : DenseIndices)
+	{
+		ChangedCoords.Add(Layout->CoordOf(DenseIndex));
+	}
+
+	// Paths around blocked hexes are never shorter than the straight distance, so farther hexes can't matter.
+	for (auto& SourceKV : Sources)
+	{
+		FSourceState& State = SourceKV.Value;
+		if (!State.Source.bBlockedByTerrain)
+		{
+			continue;
+		}
+		for (int32 ChangedIndex = 0; ChangedIndex < ChangedCoords.Num() && !State.bDirty; ChangedIndex++)
+		{
+			State.bDirty = HexMath::AxialDistanceFast(ChangedCoords[ChangedIndex], State.Source.HexCoord) <= State.Source.Radius;
+		}
+	}
+}
+
+void FHxlbInfluenceMap::MarkAllChanged()
+{
+	for (auto& SourceKV : Sources)
+	{
+		SourceKV.Value.bDirty |= SourceKV.Value.Source.bBlockedByTerrain;
+	}
+}
+
+bool FHxlbInfluenceMap::NeedsUpdate() const
+{
+	if (bAllChunksDirty || DirtyChunks.Contains(1))
+	{
+		return true;
+	}
+	for (const auto& SourceKV : Sources)
+	{
+		if (SourceKV.Value.bDirty)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void FHxlbInfluenceMap::Update(const FHxlbCostField& CostField)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(HXLB_UpdateInfluenceMap);
+
+	UpdatedChunks.Reset();
+	if (!Layout || !Layout->IsValid())
+	{
+		return;
+	}
+	
+	const bool bCostFieldMatches = CostField.IsValid() && CostField.GetLayout().HasSameShape(*Layout);
+	const FHxlbCostField Terrain = bCostFieldMatches ? CostField : FHxlbCostField();
+
+	TArray<FSourceState*> DirtyStates;
+	for (auto& SourceKV : Sources)
+	{
+		if (SourceKV.Value.bDirty)
+		{
+			MarkChunksDirty(SourceKV.Value);
+			DirtyStates.Add(&SourceKV.Value);
+		}
+	}
+	
+	ParallelFor(DirtyStates.Num(), [this, &Terrain, &DirtyStates](int32 DirtyIndex)
+	{
+		ComputeContributions(Terrain, *DirtyStates[DirtyIndex]);
+	});
+	
+	for (FSourceState* State : DirtyStates)
+	{
+		MarkChunksDirty(*State);
+		FindOrAddFaction(State->Source.Faction);
+		State->bDirty = false;
+	}
+
+	for (int32 ChunkIndex = 0; ChunkIndex < DirtyChunks.Num(); ChunkIndex++)
+	{
+		if (bAllChunksDirty || DirtyChunks[ChunkIndex])
+		{
+			UpdatedChunks.Add(ChunkIndex);
+		}
+		DirtyChunks[ChunkIndex] = 0;
+	}
+	bAllChunksDirty = false;
+
+	// Gathers the runs of contributions that land in each updated chunk. Runs are added in source order, so every chunk
+	// is summed in the same order no matter which sources changed.
+	struct FContributionRun
+	{
+		const FContribution* First;
+		int32 Num;
+		int32 Slot;
+	};
+	TArray<int32> UpdatedSlotOfChunk;
+	UpdatedSlotOfChunk.Init(INDEX_NONE, Layout->NumChunks());
+	for (int32 UpdatedIndex = 0; UpdatedIndex < UpdatedChunks.Num(); UpdatedIndex++)
+	{
+		UpdatedSlotOfChunk[UpdatedChunks[UpdatedIndex]] = UpdatedIndex;
+	}
+	
+	TArray<TArray<FContributionRun>> RunsPerChunk;
+	RunsPerChunk.SetNum(UpdatedChunks.Num());
+	for (const auto& SourceKV : Sources)
+	{
+		const TArray<FContribution>& Contributions = SourceKV.Value.Contributions;
+		const int32 Slot = FactionSlots.FindChecked(SourceKV.Value.Source.Faction);
+		for (int32 RunStart = 0; RunStart < Contributions.Num();)
+		{
+			int32 RunEnd = RunStart + 1;
+			while (RunEnd < Contributions.Num() && Contributions[RunEnd].Chunk == Contributions[RunStart].Chunk)
+			{
+				RunEnd++;
+			}
+			
+			const int32 UpdatedIndex = UpdatedSlotOfChunk[Contributions[RunStart].Chunk];
+			if (UpdatedIndex != INDEX_NONE)
+			{
+				RunsPerChunk[UpdatedIndex].Add(FContributionRun{&Contributions[RunStart], RunEnd - RunStart, Slot});
+			}
+			RunStart = RunEnd;
+		}
+	}
+
+	// Chunks cover disjoint sets of hexes, so they can be summed in parallel.
+	ParallelFor(UpdatedChunks.Num(), [this, &RunsPerChunk](int32 UpdatedIndex)
+	{
+		Layout->ForEachChunkSpan(UpdatedChunks[UpdatedIndex], [this](const FHxlbHexRowSpan& Span, int32 FirstIndex)
+		{
+			for (TArray<float>& Values : FactionValues)
+			{
+				FMemory::Memzero(&Values[FirstIndex], Span.Num() * sizeof(float));
+			}
+		});
+		
+		for (const FContributionRun& Run : RunsPerChunk[UpdatedIndex])
+		{
+			TArray<float>& Values = FactionValues[Run.Slot];
+			for (int32 Offset = 0; Offset < Run.Num; Offset++)
+			{
+				Values[Run.First[Offset].Index] += Run.First[Offset].Value;
+			}
+		}
+	});
+}
+
+void FHxlbInfluenceMap::ComputeContributions(const FHxlbCostField& CostField, FSourceState& State) const
+{
+	const FHxlbInfluenceSource& Source = State.Source;
+	TArray<FContribution>& Contributions = State.Contributions;
+	Contributions.Reset();
+
+	const int32 Origin = Layout->IndexOf(Source.HexCoord);
+	if (Origin == INDEX_NONE || Source.Radius < 0)
+	{
+		return;
+	}
+
+	if (Source.bBlockedByTerrain && CostField.IsValid())
+	{
+		// Breadth-first search, with the contribution list doubling as the queue.
+		FHxlbSearchScratch& Scratch = FHxlbSearchScratch::GetForThisThread();
+		Scratch.Begin(Layout->Num());
+		Scratch.Open(Origin, Source.HexCoord, 0.0f, INDEX_NONE);
+		Contributions.Add(FContribution{Layout->ChunkOf(Source.HexCoord), Origin, Source.GetInfluenceAt(0)});
+		
+		for (int32 Head = 0; Head < Contributions.Num(); Head++)
+		{
+			const int32 Current = Contributions[Head].Index;
+			const int32 Steps = static_cast<int32>(Scratch.GetCost(Current));
+			if (Steps >= Source.Radius)
+			{
+				continue;
+			}
+			
+			const FIntPoint CurrentCoord = Scratch.GetCoord(Current);
+			for (int32 Direction = 0; Direction < 6; Direction++)
+			{
+				const FIntPoint NeighborCoord = CurrentCoord + HexMath::DirectionIndexToAxial(Direction);
+				const int32 Neighbor = Layout->IndexOf(NeighborCoord);
+				if (Neighbor == INDEX_NONE || Scratch.IsOpened(Neighbor) || CostField.IsBlocked(Neighbor))
+				{
+					continue;
+				}
+				
+				Scratch.Open(Neighbor, NeighborCoord, static_cast<float>(Steps + 1), Current);
+				Contributions.Add(FContribution{Layout->ChunkOf(NeighborCoord), Neighbor, Source.GetInfluenceAt(Steps + 1)});
+			}
+		}
+	}
+	else
+	{
+		// Without terrain the range is a hexagon, which is walked row by row.
+		const int32 OriginQ = HEX_Q(Source.HexCoord);
+		const int32 OriginR = HEX_R(Source.HexCoord);
+		const int32 FirstR = FMath::Max(OriginR - Source.Radius, Layout->GetMinR());
+		const int32 LastR = FMath::Min(OriginR + Source.Radius, Layout->GetMaxR());
+		for (int32 R = FirstR; R <= LastR; R++)
+		{
+			const int32 DeltaR = R - OriginR;
+			const int32 RowIndex = R - Layout->GetMinR();
+			const FHxlbHexRowSpan& Row = Layout->GetRow(RowIndex);
+			const int32 QMin = FMath::Max(OriginQ + FMath::Max(-Source.Radius, -DeltaR - Source.Radius), Row.QMin);
+			const int32 QMax = FMath::Min(OriginQ + FMath::Min(Source.Radius, -DeltaR + Source.Radius), Row.QMax);
+			for (int32 Q = QMin; Q <= QMax; Q++)
+			{
+				const FIntPoint Coord(Q, R);
+				Contributions.Add(FContribution{
+					Layout->ChunkOf(Coord),
+					Layout->GetRowStart(RowIndex) + (Q - Row.QMin),
+					Source.GetInfluenceAt(HexMath::AxialDistanceFast(Coord, Source.HexCoord))
+				});
+			}
+		}
+	}
+
+	Contributions.Sort([](const FContribution& A, const FContribution& B)
+	{
+		return A.Chunk < B.Chunk || (A.Chunk == B.Chunk && A.Index < B.Index);
+	});
+}
+
+void FHxlbInfluenceMap::MarkChunksDirty(const FSourceState& State)
+{
+	for (const FContribution& Contribution : State.Contributions)
+	{
+		DirtyChunks[Contribution.Chunk] = 1;
+	}
+}
+
+int32 FHxlbInfluenceMap::FindOrAddFaction(int32 Faction)
+{
+	if (const int32* Slot = FactionSlots.Find(Faction))
+	{
+		return *Slot;
+	}
+
+	const int32 Slot = FactionValues.AddDefaulted();
+	FactionValues[Slot].Init(0.0f, Layout->Num());
+	FactionSlots.Add(Faction, Slot);
+	return Slot;
+}
+
+float FHxlbInfluenceMap::GetInfluence(int32 Faction, int32 DenseIndex) const
+{
+	const TConstArrayView<float> Values = GetValues(Faction);
+	return Values.IsValidIndex(DenseIndex) ? Values[DenseIndex] : 0.0f;
+}
+
+float FHxlbInfluenceMap::GetOpposingInfluence(int32 Faction, int32 DenseIndex) const
+{
+	float Influence = 0.0f;
+	for (const auto& SlotKV : FactionSlots)
+	{
+		const TArray<float>& Values = FactionValues[SlotKV.Value];
+		if (SlotKV.Key != Faction && Values.IsValidIndex(DenseIndex))
+		{
+			Influence += Values[DenseIndex];
+		}
+	}
+	return Influence;
+}
+
+TConstArrayView<float> FHxlbInfluenceMap::GetValues(int32 Faction) const
+{
+	const int32* Slot = FactionSlots.Find(Faction);
+	return Slot ? TConstArrayView<float>(FactionValues[*Slot]) : TConstArrayView<float>();
+}
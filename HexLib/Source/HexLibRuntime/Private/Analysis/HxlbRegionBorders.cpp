@@ -0,0 +1,229 @@
+// Copyright © Mason Stevenson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the disclaimer
+// below) provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+// THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+// CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+// NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "Analysis/HxlbRegionBorders.h"
+
+#include "FunctionLibraries/HxlbMath.h"
+
+using HexMath = UHxlbMath;
+
+// The edge of a hex toward direction D runs from its corner D + 1 to its corner D + 2 (see UHxlbMath::GetHexCorner()),
+// which walks counterclockwise around the hex.
+namespace
+{
+	FORCEINLINE int32 EdgeStartCorner(int32 Direction) { return (Direction + 1) % 6; }
+	FORCEINLINE int32 EdgeEndCorner(int32 Direction) { return (Direction + 2) % 6; }
+}
+
+int64 FHxlbRegionBorders::CornerKey(FIntPoint HexCoord, int32 CornerIndex)
+{
+	// Even corners are named after the hex they are corner 0 of, odd corners after the hex they are corner 1 of.
+	static constexpr int32 OwnerQ[6] = {0, 0, 1, 0, 0, -1};
+	static constexpr int32 OwnerR[6] = {0, 0, -1, -1, -1, 0};
+	const int64 Q = HEX_Q(HexCoord) + OwnerQ[CornerIndex];
+	const int64 R = HEX_R(HexCoord) + OwnerR[CornerIndex];
+	return (Q << 32) ^ static_cast<uint32>(R * 2 + (CornerIndex & 1));
+}
+
+void FHxlbRegionBorders::Build(const FHxlbDenseLayout& NewLayout, TConstArrayView<int32> RegionIds, double NewHexSize, int32 NewNoRegion)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(HXLB_BuildRegionBorders);
+	check(RegionIds.Num() == NewLayout.Num());
+
+	Layout = &NewLayout;
+	HexSize = NewHexSize;
+	NoRegion = NewNoRegion;
+	KnownRegionIds.Reset();
+	KnownRegionIds.Append(RegionIds.GetData(), RegionIds.Num());
+	Borders.Reset();
+	DirtyRegions.Reset();
+
+	for (int32 DenseIndex = 0; DenseIndex < Layout->Num(); DenseIndex++)
+	{
+		const int32 RegionId = KnownRegionIds[DenseIndex];
+		if (RegionId == NoRegion)
+		{
+			continue;
+		}
+		
+		const FIntPoint HexCoord = Layout->CoordOf(DenseIndex);
+		for (int32 Direction = 0; Direction < 6; Direction++)
+		{
+			const int32 Neighbor = Layout->NeighborIndex(HexCoord, Direction);
+			if (Neighbor == INDEX_NONE || KnownRegionIds[Neighbor] != RegionId)
+			{
+				SetEdge(RegionId, DenseIndex, Direction, true);
+			}
+		}
+	}
+
+	UpdatedRegions.Reset();
+	for (auto& BorderKV : Borders)
+	{
+		ChainLoops(BorderKV.Value);
+		UpdatedRegions.Add(BorderKV.Key);
+	}
+	UpdatedRegions.Sort();
+	DirtyRegions.Reset();
+}
+
+void FHxlbRegionBorders::Reset()
+{
+	Layout = nullptr;
+	KnownRegionIds.Reset();
+	Borders.Reset();
+	DirtyRegions.Reset();
+	UpdatedRegions.Reset();
+}
+
+void FHxlbRegionBorders::Update(TConstArrayView<int32> RegionIds, TConstArrayView<int32> ChangedIndices)
+{
+	UpdatedRegions.Reset();
+	if (!Layout || RegionIds.Num() != KnownRegionIds.Num())
+	{
+		return;
+	}
+
+	// Hexes are moved one at a time, so that each one sees its neighbors as they are at that point.
+	for (int32 DenseIndex : ChangedIndices)
+	{
+		const int32 OldRegionId = KnownRegionIds[DenseIndex];
+		const int32 NewRegionId = RegionIds[DenseIndex];
+		if (OldRegionId == NewRegionId)
+		{
+			continue;
+		}
+		KnownRegionIds[DenseIndex] = NewRegionId;
+		
+		const FIntPoint HexCoord = Layout->CoordOf(DenseIndex);
+		for (int32 Direction = 0; Direction < 6; Direction++)
+		{
+			const int32 Neighbor = Layout->NeighborIndex(HexCoord, Direction);
+			const int32 NeighborRegionId = Neighbor != INDEX_NONE ? KnownRegionIds[Neighbor] : NoRegion;
+			
+			SetEdge(OldRegionId, DenseIndex, Direction, false);
+			SetEdge(NewRegionId, DenseIndex, Direction, NeighborRegionId != NewRegionId);
+			if (Neighbor != INDEX_NONE)
+			{
+				SetEdge(NeighborRegionId, Neighbor, (Direction + 3) % 6, NeighborRegionId != NewRegionId);
+			}
+		}
+	}
+
+	for (int32 RegionId : DirtyRegions)
+	{
+		FHxlbRegionBorder* Border = Borders.Find(RegionId);
+		if (Border && Border->Edges.IsEmpty())
+		{
+			Borders.Remove(RegionId);
+		}
+		else if (Border)
+		{
+			ChainLoops(*Border);
+		}
+		UpdatedRegions.Add(RegionId);
+	}
+	UpdatedRegions.Sort();
+	DirtyRegions.Reset();
+}
+
+void FHxlbRegionBorders::SetEdge(int32 RegionId, int32 DenseIndex, int32 Direction, bool bIsBorder)
+{
+	if (RegionId == NoRegion)
+	{
+		return;
+	}
+
+	const int32 EdgeKey = DenseIndex * 6 + Direction;
+	if (bIsBorder)
+	{
+		bool bAlreadyInSet = false;
+		Borders.FindOrAdd(RegionId).Edges.Add(EdgeKey, &bAlreadyInSet);
+		if (!bAlreadyInSet)
+		{
+			DirtyRegions.Add(RegionId);
+		}
+	}
+	else if (FHxlbRegionBorder* Border = Borders.Find(RegionId))
+	{
+		if (Border->Edges.Remove(EdgeKey) > 0)
+		{
+			DirtyRegions.Add(RegionId);
+		}
+	}
+}
+
+void FHxlbRegionBorders::ChainLoops(FHxlbRegionBorder& Border) const
+{
+	Border.Vertices.Reset();
+	Border.LoopStarts.Reset();
+
+	// Every corner on the border of a region starts exactly one of its border edges: a corner is shared by three hexes,
+	// and the region either has one of them or two neighboring ones.
+	TArray<int32> SortedEdges = Border.Edges.Array();
+	SortedEdges.Sort();
+	TMap<int64, int32> EdgeStartingAt;
+	EdgeStartingAt.Reserve(SortedEdges.Num());
+	for (int32 EdgeKey : SortedEdges)
+	{
+		EdgeStartingAt.Add(CornerKey(Layout->CoordOf(EdgeKey / 6), EdgeStartCorner(EdgeKey % 6)), EdgeKey);
+	}
+
+	Border.Vertices.Reserve(SortedEdges.Num());
+	for (int32 FirstEdge : SortedEdges)
+	{
+		const FIntPoint FirstCoord = Layout->CoordOf(FirstEdge / 6);
+		if (!EdgeStartingAt.Contains(CornerKey(FirstCoord, EdgeStartCorner(FirstEdge % 6))))
+		{
+			continue;
+		}
+
+		Border.LoopStarts.Add(Border.Vertices.Num());
+		int32 EdgeKey = FirstEdge;
+		while (true)
+		{
+			const FIntPoint HexCoord = Layout->CoordOf(EdgeKey / 6);
+			const int32 Direction = EdgeKey % 6;
+			EdgeStartingAt.Remove(CornerKey(HexCoord, EdgeStartCorner(Direction)));
+			
+			const FVector Center = HexMath::AxialToWorld(HexCoord, HexSize);
+			Border.Vertices.Add(HexMath::GetHexCorner(Center, HexSize, EdgeStartCorner(Direction)));
+
+			// The loop is closed once the next edge is the first one, which has already been taken out.
+			const int32* NextEdge = EdgeStartingAt.Find(CornerKey(HexCoord, EdgeEndCorner(Direction)));
+			if (!NextEdge)
+			{
+				break;
+			}
+			EdgeKey = *NextEdge;
+		}
+	}
+}
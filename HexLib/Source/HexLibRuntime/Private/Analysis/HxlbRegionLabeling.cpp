@@ -0,0 +1,404 @@
+// Copyright © Mason Stevenson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the disclaimer
+// below) provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+// THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+// CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+// NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "Analysis/HxlbRegionLabeling.h"
+
+#include "Foundation/HxlbHexBitmap.h"
+#include "FunctionLibraries/HxlbMath.h"
+
+using HexMath = UHxlbMath;
+
+namespace
+{
+	struct FFloodNode
+	{
+		int32 Index;
+		FIntPoint Coord;
+	};
+
+	// Local updates touch a few hexes each. Past this fraction of the map, labeling everything again is cheaper.
+	constexpr int32 kRebuildFraction = 8;
+}
+
+void FHxlbRegionLabeling::Build(const FHxlbDenseLayout& NewLayout, FKeyFunction KeyOf)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(HXLB_BuildRegionLabeling);
+	
+	Layout = &NewLayout;
+	const int32 NumHexes = Layout->Num();
+	Keys.SetNumUninitialized(NumHexes);
+	for (int32 DenseIndex = 0; DenseIndex < NumHexes; DenseIndex++)
+	{
+		Keys[DenseIndex] = KeyOf(DenseIndex);
+	}
+	RegionIds.Init(INDEX_NONE, NumHexes);
+	RegionSizes.Reset();
+	RegionKeys.Reset();
+	FreeRegionIds.Reset();
+	VisitStamps.Init(0, NumHexes);
+	VisitOwners.SetNumUninitialized(NumHexes);
+	Generation = 0;
+
+	for (int32 DenseIndex = 0; DenseIndex < NumHexes; DenseIndex++)
+	{
+		if (Keys[DenseIndex] != 0 && RegionIds[DenseIndex] == INDEX_NONE)
+		{
+			const int32 RegionId = AllocateRegion(Keys[DenseIndex]);
+			RegionSizes[RegionId] = Relabel(DenseIndex, RegionId);
+		}
+	}
+}
+
+void FHxlbRegionLabeling::Reset()
+{
+	Layout = nullptr;
+	Keys.Reset();
+	RegionIds.Reset();
+	RegionSizes.Reset();
+	RegionKeys.Reset();
+	FreeRegionIds.Reset();
+	VisitStamps.Reset();
+	VisitOwners.Reset();
+	Generation = 0;
+}
+
+void FHxlbRegionLabeling::Update(TConstArrayView<int32> ChangedIndices, FKeyFunction KeyOf)
+{
+	if (!Layout)
+	{
+		return;
+	}
+	if (ChangedIndices.Num() > Layout->Num() / kRebuildFraction)
+	{
+		Build(*Layout, KeyOf);
+		return;
+	}
+
+	for (int32 DenseIndex : ChangedIndices)
+	{
+		const uint32 NewKey = KeyOf(DenseIndex);
+		if (NewKey == Keys[DenseIndex])
+		{
+			continue;
+		}
+
+		const FIntPoint HexCoord = Layout->CoordOf(DenseIndex);
+		if (Keys[DenseIndex] != 0)
+		{
+			RemoveHex(DenseIndex, HexCoord);
+		}
+		Keys[DenseIndex] = NewKey;
+		if (NewKey != 0)
+		{
+			AddHex(DenseIndex, HexCoord);
+		}
+	}
+}
+
+void FHxlbRegionLabeling::AddHex(int32 DenseIndex, FIntPoint HexCoord)
+{
+	const uint32 Key = Keys[DenseIndex];
+	int32 RegionId = AllocateRegion(Key);
+	RegionIds[DenseIndex] = RegionId;
+	RegionSizes[RegionId] = 1;
+
+	for (int32 Direction = 0; Direction < 6; Direction++)
+	{
+		const int32 Neighbor = Layout->NeighborIndex(HexCoord, Direction);
+		if (Neighbor == INDEX_NONE || Keys[Neighbor] != Key || RegionIds[Neighbor] == RegionId)
+		{
+			continue;
+		}
+
+		// Union by size: the smaller region takes the id of the bigger one.
+		const int32 NeighborRegionId = RegionIds[Neighbor];
+		const bool bNeighborIsBigger = RegionSizes[NeighborRegionId] >= RegionSizes[RegionId];
+		const int32 BigRegionId = bNeighborIsBigger ? NeighborRegionId : RegionId;
+		const int32 SmallRegionId = bNeighborIsBigger ? RegionId : NeighborRegionId;
+		
+		Relabel(bNeighborIsBigger ? DenseIndex : Neighbor, BigRegionId);
+		RegionSizes[BigRegionId] += RegionSizes[SmallRegionId];
+		FreeRegion(SmallRegionId);
+		RegionId = BigRegionId;
+	}
+}
+
+void FHxlbRegionLabeling::RemoveHex(int32 DenseIndex, FIntPoint HexCoord)
+{
+	const int32 OldRegionId = RegionIds[DenseIndex];
+	RegionIds[DenseIndex] = INDEX_NONE;
+	if (--RegionSizes[OldRegionId] == 0)
+	{
+		FreeRegion(OldRegionId);
+		return;
+	}
+
+	// Neighbors next to each other around the hex touch each other, so only the first of each run of neighbors in the
+	// region needs to be flooded from.
+	bool bInRegion[6];
+	FFloodNode Neighbors[6];
+	for (int32 Direction = 0; Direction < 6; Direction++)
+	{
+		Neighbors[Direction].Coord = HexCoord + HexMath::DirectionIndexToAxial(Direction);
+		Neighbors[Direction].Index = Layout->IndexOf(Neighbors[Direction].Coord);
+		bInRegion[Direction] = Neighbors[Direction].Index != INDEX_NONE && RegionIds[Neighbors[Direction].Index] == OldRegionId;
+	}
+
+	TArray<FFloodNode, TInlineAllocator<3>> Seeds;
+	for (int32 Direction = 0; Direction < 6; Direction++)
+	{
+		if (bInRegion[Direction] && !bInRegion[(Direction + 5) % 6])
+		{
+			Seeds.Add(Neighbors[Direction]);
+		}
+	}
+	if (Seeds.Num() <= 1)
+	{
+		return;
+	}
+
+	if (++Generation == 0)
+	{
+		// The stamps wrapped around, so stale stamps could read as current.
+		VisitStamps.Init(0, VisitStamps.Num());
+		Generation = 1;
+	}
+
+	// Each flood keeps every hex it visited, in visiting order, so that its unprocessed hexes are the ones past Head.
+	// Floods that run into each other are in the same piece, which is tracked by a tiny union-find over the floods.
+	const int32 NumFloods = Seeds.Num();
+	TArray<TArray<FFloodNode>, TInlineAllocator<6>> Floods;
+	TArray<int32, TInlineAllocator<6>> Heads;
+	TArray<int32, TInlineAllocator<6>> Groups;
+	for (int32 Flood = 0; Flood < NumFloods; Flood++)
+	{
+		Floods.AddDefaulted_GetRef().Add(Seeds[Flood]);
+		Heads.Add(0);
+		Groups.Add(Flood);
+		VisitStamps[Seeds[Flood].Index] = Generation;
+		VisitOwners[Seeds[Flood].Index] = Flood;
+	}
+	auto FindGroup = [&Groups](int32 Flood)
+	{
+		while (Groups[Flood] != Flood)
+		{
+			Flood = Groups[Flood];
+		}
+		return Flood;
+	};
+	auto IsGroupActive = [&](int32 Group)
+	{
+		for (int32 Flood = 0; Flood < NumFloods; Flood++)
+		{
+			if (FindGroup(Flood) == Group && Heads[Flood] < Floods[Flood].Num())
+			{
+				return true;
+			}
+		}
+		return false;
+	};
+	auto CountGroups = [&](int32& OutNumActive)
+	{
+		int32 NumGroups = 0;
+		OutNumActive = 0;
+		for (int32 Flood = 0; Flood < NumFloods; Flood++)
+		{
+			if (FindGroup(Flood) == Flood)
+			{
+				NumGroups++;
+				OutNumActive += IsGroupActive(Flood) ? 1 : 0;
+			}
+		}
+		return NumGroups;
+	};
+
+	int32 NumActive = 0;
+	while (CountGroups(NumActive) > 1 && NumActive > 1)
+	{
+		for (int32 Flood = 0; Flood < NumFloods; Flood++)
+		{
+			if (Heads[Flood] >= Floods[Flood].Num())
+			{
+				continue;
+			}
+			
+			const FFloodNode Current = Floods[Flood][Heads[Flood]++];
+			for (int32 Direction = 0; Direction < 6; Direction++)
+			{
+				const FIntPoint NeighborCoord = Current.Coord + HexMath::DirectionIndexToAxial(Direction);
+				const int32 Neighbor = Layout->IndexOf(NeighborCoord);
+				if (Neighbor == INDEX_NONE || RegionIds[Neighbor] != OldRegionId)
+				{
+					continue;
+				}
+				if (VisitStamps[Neighbor] == Generation)
+				{
+					Groups[FindGroup(VisitOwners[Neighbor])] = FindGroup(Flood);
+					continue;
+				}
+				VisitStamps[Neighbor] = Generation;
+				VisitOwners[Neighbor] = Flood;
+				Floods[Flood].Add(FFloodNode{Neighbor, NeighborCoord});
+			}
+		}
+	}
+
+	// Every group that ran out of hexes is a whole piece. The piece that is still growing, or the biggest one if they
+	// all ran out, keeps the old id.
+	TArray<int32, TInlineAllocator<6>> GroupSizes;
+	GroupSizes.Init(0, NumFloods);
+	for (int32 Flood = 0; Flood < NumFloods; Flood++)
+	{
+		GroupSizes[FindGroup(Flood)] += Floods[Flood].Num();
+	}
+	
+	int32 KeptGroup = INDEX_NONE;
+	for (int32 Group = 0; Group < NumFloods; Group++)
+	{
+		if (FindGroup(Group) == Group && IsGroupActive(Group))
+		{
+			KeptGroup = Group;
+		}
+	}
+	if (KeptGroup == INDEX_NONE)
+	{
+		for (int32 Group = 0; Group < NumFloods; Group++)
+		{
+			if (FindGroup(Group) == Group && (KeptGroup == INDEX_NONE || GroupSizes[Group] > GroupSizes[KeptGroup]))
+			{
+				KeptGroup = Group;
+			}
+		}
+	}
+
+	for (int32 Group = 0; Group < NumFloods; Group++)
+	{
+		if (FindGroup(Group) != Group || Group == KeptGroup)
+		{
+			continue;
+		}
+		
+		const int32 NewRegionId = AllocateRegion(Keys[DenseIndex]);
+		for (int32 Flood = 0; Flood < NumFloods; Flood++)
+		{
+			if (FindGroup(Flood) != Group)
+			{
+				continue;
+			}
+			for (const FFloodNode& Node : Floods[Flood])
+			{
+				RegionIds[Node.Index] = NewRegionId;
+			}
+		}
+		RegionSizes[NewRegionId] = GroupSizes[Group];
+		RegionSizes[OldRegionId] -= GroupSizes[Group];
+	}
+}
+
+int32 FHxlbRegionLabeling::Relabel(int32 Seed, int32 NewRegionId)
+{
+	// While building, unlabeled hexes have INDEX_NONE as their id, so the key has to match as well.
+	const int32 OldRegionId = RegionIds[Seed];
+	const uint32 Key = Keys[Seed];
+	
+	TArray<FFloodNode> Queue;
+	Queue.Add(FFloodNode{Seed, Layout->CoordOf(Seed)});
+	RegionIds[Seed] = NewRegionId;
+	for (int32 Head = 0; Head < Queue.Num(); Head++)
+	{
+		const FFloodNode Current = Queue[Head];
+		for (int32 Direction = 0; Direction < 6; Direction++)
+		{
+			const FIntPoint NeighborCoord = Current.Coord + HexMath::DirectionIndexToAxial(Direction);
+			const int32 Neighbor = Layout->IndexOf(NeighborCoord);
+			if (Neighbor != INDEX_NONE && RegionIds[Neighbor] == OldRegionId && Keys[Neighbor] == Key)
+			{
+				RegionIds[Neighbor] = NewRegionId;
+				Queue.Add(FFloodNode{Neighbor, NeighborCoord});
+			}
+		}
+	}
+	return Queue.Num();
+}
+
+void FHxlbRegionLabeling::GetRegionHexes(int32 DenseIndex, TArray<int32>& OutIndices) const
+{
+	if (!Layout || !RegionIds.IsValidIndex(DenseIndex) || RegionIds[DenseIndex] == INDEX_NONE)
+	{
+		return;
+	}
+
+	const int32 RegionId = RegionIds[DenseIndex];
+	FHxlbHexBitmap Visited(Layout->Num());
+	TArray<FFloodNode> Queue;
+	Queue.Reserve(RegionSizes[RegionId]);
+	Queue.Add(FFloodNode{DenseIndex, Layout->CoordOf(DenseIndex)});
+	Visited.Set(DenseIndex);
+	for (int32 Head = 0; Head < Queue.Num(); Head++)
+	{
+		const FFloodNode Current = Queue[Head];
+		OutIndices.Add(Current.Index);
+		for (int32 Direction = 0; Direction < 6; Direction++)
+		{
+			const FIntPoint NeighborCoord = Current.Coord + HexMath::DirectionIndexToAxial(Direction);
+			const int32 Neighbor = Layout->IndexOf(NeighborCoord);
+			if (Neighbor != INDEX_NONE && RegionIds[Neighbor] == RegionId && !Visited.Get(Neighbor))
+			{
+				Visited.Set(Neighbor);
+				Queue.Add(FFloodNode{Neighbor, NeighborCoord});
+			}
+		}
+	}
+}
+
+int32 FHxlbRegionLabeling::AllocateRegion(uint32 Key)
+{
+	int32 RegionId;
+	if (!FreeRegionIds.IsEmpty())
+	{
+		RegionId = FreeRegionIds.Pop(EAllowShrinking::No);
+	}
+	else
+	{
+		RegionId = RegionSizes.Add(0);
+		RegionKeys.Add(0);
+	}
+	RegionSizes[RegionId] = 0;
+	RegionKeys[RegionId] = Key;
+	return RegionId;
+}
+
+void FHxlbRegionLabeling::FreeRegion(int32 RegionId)
+{
+	RegionSizes[RegionId] = 0;
+	RegionKeys[RegionId] = 0;
+	FreeRegionIds.Add(RegionId);
+}
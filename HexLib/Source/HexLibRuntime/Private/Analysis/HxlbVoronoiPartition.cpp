@@ -0,0 +1,273 @@
+// Copyright © Mason Stevenson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the disclaimer
+// below) provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+// THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+// CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+// NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "Analysis/HxlbVoronoiPartition.h"
+
+#include "Algo/BinarySearch.h"
+#include "Async/ParallelFor.h"
+#include "Foundation/HxlbHexRanges.h"
+#include "FunctionLibraries/HxlbMath.h"
+
+using HexMath = UHxlbMath;
+
+namespace
+{
+	// Flips the sign bit so that unsigned order matches signed order.
+	FORCEINLINE uint64 PackRegionPair(int32 RegionA, int32 RegionB)
+	{
+		return (static_cast<uint64>(static_cast<uint32>(RegionA) ^ 0x80000000U) << 32) | (static_cast<uint32>(RegionB) ^ 0x80000000U);
+	}
+
+	FORCEINLINE int32 UnpackRegion(uint32 Packed)
+	{
+		return static_cast<int32>(Packed ^ 0x80000000U);
+	}
+}
+
+void FHxlbVoronoiPartition::Build(const FHxlbDenseLayout& NewLayout, TConstArrayView<int32> SeedIndices, int32 LloydIterations)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(HXLB_BuildVoronoiPartition);
+	
+	Reset();
+	if (!NewLayout.IsValid())
+	{
+		return;
+	}
+	Layout = &NewLayout;
+	Seeds.Append(SeedIndices);
+	Partition(nullptr, LloydIterations);
+}
+
+void FHxlbVoronoiPartition::Build(const FHxlbCostField& NewCostField, TConstArrayView<int32> SeedIndices, int32 LloydIterations)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(HXLB_BuildWeightedVoronoiPartition);
+	
+	Reset();
+	if (!NewCostField.IsValid())
+	{
+		return;
+	}
+	Layout = &NewCostField.GetLayout();
+	Seeds.Append(SeedIndices);
+	Partition(&NewCostField, LloydIterations);
+}
+
+void FHxlbVoronoiPartition::Reset()
+{
+	Layout = nullptr;
+	Seeds.Reset();
+	RegionIds.Reset();
+	RegionSizes.Reset();
+	NumIterations = 0;
+	DistanceField.Reset();
+}
+
+void FHxlbVoronoiPartition::Partition(const FHxlbCostField* CostField, int32 LloydIterations)
+{
+	Flood(CostField);
+	while (NumIterations < LloydIterations && MoveSeedsToCentroids())
+	{
+		NumIterations++;
+		Flood(CostField);
+	}
+	
+	// The field is only scratch for the floods.
+	DistanceField.Reset();
+}
+
+void FHxlbVoronoiPartition::Flood(const FHxlbCostField* CostField)
+{
+	if (CostField)
+	{
+		DistanceField.Build(*CostField, Seeds);
+	}
+	else
+	{
+		DistanceField.Build(*Layout, Seeds);
+	}
+
+	const int32 NumHexes = Layout->Num();
+	RegionIds.Init(INDEX_NONE, NumHexes);
+	for (int32 RegionIndex = 0; RegionIndex < Seeds.Num(); RegionIndex++)
+	{
+		const int32 Seed = Seeds[RegionIndex];
+		if (Seed >= 0 && Seed < NumHexes && RegionIds[Seed] == INDEX_NONE)
+		{
+			RegionIds[Seed] = RegionIndex;
+		}
+	}
+
+	// Every hex takes the region of its nearest seed. Seeds are skipped, so the entries being read are never written.
+	HxlbParallelForEachHex(*Layout, [this](FIntPoint HexCoord, int32 DenseIndex)
+	{
+		const int32 NearestSeed = DistanceField.GetNearestSource(DenseIndex);
+		if (NearestSeed != DenseIndex)
+		{
+			RegionIds[DenseIndex] = NearestSeed != INDEX_NONE ? RegionIds[NearestSeed] : INDEX_NONE;
+		}
+	});
+
+	RegionSizes.Init(0, Seeds.Num());
+	for (const int32 RegionIndex : RegionIds)
+	{
+		if (RegionIndex != INDEX_NONE)
+		{
+			RegionSizes[RegionIndex]++;
+		}
+	}
+}
+
+bool FHxlbVoronoiPartition::MoveSeedsToCentroids()
+{
+	// Axial coordinates are a linear transform of world positions, so their mean is the centroid of the region too.
+	TArray<FVector2d> CoordSums;
+	CoordSums.Init(FVector2d::ZeroVector, Seeds.Num());
+	for (int32 RowIndex = 0, DenseIndex = 0; RowIndex < Layout->NumRows(); RowIndex++)
+	{
+		const FHxlbHexRowSpan& Row = Layout->GetRow(RowIndex);
+		for (int32 Q = Row.QMin; Q <= Row.QMax; Q++, DenseIndex++)
+		{
+			if (RegionIds[DenseIndex] != INDEX_NONE)
+			{
+				CoordSums[RegionIds[DenseIndex]] += FVector2d(Q, Row.R);
+			}
+		}
+	}
+
+	TArray<FIntPoint> Centroids;
+	Centroids.SetNumUninitialized(Seeds.Num());
+	for (int32 RegionIndex = 0; RegionIndex < Seeds.Num(); RegionIndex++)
+	{
+		Centroids[RegionIndex] = RegionSizes[RegionIndex] > 0 ? HexMath::AxialRound(CoordSums[RegionIndex] / RegionSizes[RegionIndex]) : FIntPoint::ZeroValue;
+	}
+
+	// The centroid of a region that wraps around an obstacle can fall outside of it, so the new seed is the closest hex
+	// that is inside. Rows are walked in dense order, so ties go to the smaller dense index.
+	TArray<int32> BestDistances;
+	BestDistances.Init(MAX_int32, Seeds.Num());
+	TArray<int32> NewSeeds = Seeds;
+	for (int32 RowIndex = 0, DenseIndex = 0; RowIndex < Layout->NumRows(); RowIndex++)
+	{
+		const FHxlbHexRowSpan& Row = Layout->GetRow(RowIndex);
+		for (int32 Q = Row.QMin; Q <= Row.QMax; Q++, DenseIndex++)
+		{
+			const int32 RegionIndex = RegionIds[DenseIndex];
+			if (RegionIndex == INDEX_NONE)
+			{
+				continue;
+			}
+			const int32 Distance = HexMath::AxialDistanceFast(FIntPoint(Q, Row.R), Centroids[RegionIndex]);
+			if (Distance < BestDistances[RegionIndex])
+			{
+				BestDistances[RegionIndex] = Distance;
+				NewSeeds[RegionIndex] = DenseIndex;
+			}
+		}
+	}
+
+	const bool bMoved = NewSeeds != Seeds;
+	Seeds = MoveTemp(NewSeeds);
+	return bMoved;
+}
+
+void FHxlbRegionAdjacency::Build(const FHxlbDenseLayout& Layout, TConstArrayView<int32> RegionIds, int32 NoRegion)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(HXLB_BuildRegionAdjacency);
+	
+	Links.Reset();
+	if (!Layout.IsValid() || RegionIds.Num() != Layout.Num())
+	{
+		return;
+	}
+
+	// Each row gathers the region pairs across the edges toward +Q and +R, which visits every edge of the map once.
+	static constexpr int32 kForwardDirections[3] = {0, 4, 5};
+	TArray<TArray<uint64>> RowPairs;
+	RowPairs.SetNum(Layout.NumRows());
+	ParallelFor(Layout.NumRows(), [&Layout, &RegionIds, &RowPairs, NoRegion](int32 RowIndex)
+	{
+		const FHxlbHexRowSpan& Row = Layout.GetRow(RowIndex);
+		int32 DenseIndex = Layout.GetRowStart(RowIndex);
+		TArray<uint64>& Pairs = RowPairs[RowIndex];
+		for (int32 Q = Row.QMin; Q <= Row.QMax; Q++, DenseIndex++)
+		{
+			const int32 Region = RegionIds[DenseIndex];
+			if (Region == NoRegion)
+			{
+				continue;
+			}
+			for (const int32 Direction : kForwardDirections)
+			{
+				const int32 NeighborIndex = Layout.NeighborIndex(FIntPoint(Q, Row.R), Direction);
+				const int32 NeighborRegion = NeighborIndex != INDEX_NONE ? RegionIds[NeighborIndex] : NoRegion;
+				if (NeighborRegion != NoRegion && NeighborRegion != Region)
+				{
+					Pairs.Add(PackRegionPair(FMath::Min(Region, NeighborRegion), FMath::Max(Region, NeighborRegion)));
+				}
+			}
+		}
+	});
+
+	TArray<uint64> Pairs;
+	for (const TArray<uint64>& Row : RowPairs)
+	{
+		Pairs.Append(Row);
+	}
+	Pairs.Sort();
+
+	// Pairs are sorted by their first region, then by their second, so every list comes out sorted.
+	for (int32 RunStart = 0; RunStart < Pairs.Num();)
+	{
+		int32 RunEnd = RunStart + 1;
+		while (RunEnd < Pairs.Num() && Pairs[RunEnd] == Pairs[RunStart])
+		{
+			RunEnd++;
+		}
+		const int32 RegionA = UnpackRegion(static_cast<uint32>(Pairs[RunStart] >> 32));
+		const int32 RegionB = UnpackRegion(static_cast<uint32>(Pairs[RunStart]));
+		Links.FindOrAdd(RegionA).Add(FHxlbRegionLink{RegionB, RunEnd - RunStart});
+		Links.FindOrAdd(RegionB).Add(FHxlbRegionLink{RegionA, RunEnd - RunStart});
+		RunStart = RunEnd;
+	}
+}
+
+TConstArrayView<FHxlbRegionLink> FHxlbRegionAdjacency::GetNeighbors(int32 RegionId) const
+{
+	const TArray<FHxlbRegionLink>* Neighbors = Links.Find(RegionId);
+	return Neighbors ? TConstArrayView<FHxlbRegionLink>(*Neighbors) : TConstArrayView<FHxlbRegionLink>();
+}
+
+bool FHxlbRegionAdjacency::AreNeighbors(int32 RegionIdA, int32 RegionIdB) const
+{
+	const TConstArrayView<FHxlbRegionLink> Neighbors = GetNeighbors(RegionIdA);
+	const int32 Index = Algo::LowerBoundBy(Neighbors, RegionIdB, &FHxlbRegionLink::Region);
+	return Index < Neighbors.Num() && Neighbors[Index].Region == RegionIdB;
+}
@@ -0,0 +1,211 @@
+// Copyright © Mason Stevenson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the disclaimer
+// below) provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+// THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+// CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+// NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "Foundation/HxlbDenseLayout.h"
+
+#include "Algo/BinarySearch.h"
+#include "HexLibRuntimeLoggingDefs.h"
+#include "Macros/HexLibLoggingMacros.h"
+
+void FHxlbDenseLayout::InitHexagonal(int32 Radius, int32 NewChunkSize)
+{
+	TArray<FHxlbHexRowSpan> NewRows;
+	if (Radius >= 0)
+	{
+		NewRows.Reserve(2 * Radius + 1);
+		for (int32 R = -Radius; R <= Radius; ++R)
+		{
+			NewRows.Emplace(R, FMath::Max(-Radius, -R - Radius), FMath::Min(Radius, -R + Radius));
+		}
+	}
+	
+	InitFromRows(NewRows, NewChunkSize);
+}
+
+void FHxlbDenseLayout::InitRectangular(int32 HalfWidth, int32 HalfHeight, int32 NewChunkSize)
+{
+	TArray<FHxlbHexRowSpan> NewRows;
+	if (HalfWidth >= 0 && HalfHeight >= 0)
+	{
+		// Same bounds as UHxlbHexMapComponent::IsValidAxialCoord() (pointy algo).
+		NewRows.Reserve(2 * HalfHeight + 1);
+		for (int32 R = -HalfHeight; R <= HalfHeight; ++R)
+		{
+			NewRows.Emplace(R, -HalfWidth - FloorHalf(R), HalfWidth - FloorHalf(R));
+		}
+	}
+
+	InitFromRows(NewRows, NewChunkSize);
+}
+
+void FHxlbDenseLayout::InitFromRows(const TArray<FHxlbHexRowSpan>& NewRows, int32 NewChunkSize)
+{
+	Reset();
+
+	if (NewChunkSize < 1)
+	{
+		HXLB_LOG(LogHxlbRuntime, Error, TEXT("FHxlbDenseLayout: invalid chunk size (%d). Using the default."), NewChunkSize);
+		NewChunkSize = kDefaultChunkSize;
+	}
+	ChunkSize = NewChunkSize;
+	
+	if (NewRows.IsEmpty())
+	{
+		return;
+	}
+
+	for (int32 RowIndex = 1; RowIndex < NewRows.Num(); ++RowIndex)
+	{
+		if (NewRows[RowIndex].R != NewRows[RowIndex - 1].R + 1)
+		{
+			HXLB_LOG(LogHxlbRuntime, Error, TEXT("FHxlbDenseLayout: rows must be sorted and contiguous."));
+			return;
+		}
+	}
+
+	Rows = NewRows;
+	MinR = Rows[0].R;
+	RowStarts.SetNumUninitialized(Rows.Num());
+	
+	for (int32 RowIndex = 0; RowIndex < Rows.Num(); ++RowIndex)
+	{
+		RowStarts[RowIndex] = NumHexes;
+		NumHexes += Rows[RowIndex].Num();
+	}
+
+	BuildChunks();
+}
+
+void FHxlbDenseLayout::Reset()
+{
+	Rows.Reset();
+	RowStarts.Reset();
+	MinR = 0;
+	NumHexes = 0;
+	ChunkColumns = 0;
+	ChunkRows = 0;
+	MinColumn = 0;
+	ChunkHexCounts.Reset();
+}
+
+bool FHxlbDenseLayout::HasSameShape(const FHxlbDenseLayout& Other) const
+{
+	if (NumHexes != Other.NumHexes || MinR != Other.MinR || ChunkSize != Other.ChunkSize || Rows.Num() != Other.Rows.Num())
+	{
+		return false;
+	}
+	for (int32 RowIndex = 0; RowIndex < Rows.Num(); RowIndex++)
+	{
+		if (Rows[RowIndex].QMin != Other.Rows[RowIndex].QMin || Rows[RowIndex].QMax != Other.Rows[RowIndex].QMax)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+FIntPoint FHxlbDenseLayout::CoordOf(int32 Index) const
+{
+	if (Index < 0 || Index >= NumHexes)
+	{
+		return FIntPoint::ZeroValue;
+	}
+
+	// Last row that starts at or before Index. Empty rows share their start with the next row, so UpperBound always
+	// lands on the row that actually contains the hex.
+	const int32 RowIndex = Algo::UpperBound(RowStarts, Index) - 1;
+	return FIntPoint(Rows[RowIndex].QMin + (Index - RowStarts[RowIndex]), Rows[RowIndex].R);
+}
+
+int32 FHxlbDenseLayout::ChunkOf(FIntPoint AxialCoord) const
+{
+	if (!Contains(AxialCoord))
+	{
+		return INDEX_NONE;
+	}
+
+	const int32 ChunkRow = (HEX_R(AxialCoord) - MinR) / ChunkSize;
+	const int32 ChunkColumn = (OffsetColumn(AxialCoord) - MinColumn) / ChunkSize;
+	return ChunkRow * ChunkColumns + ChunkColumn;
+}
+
+FHxlbHexRowSpan FHxlbDenseLayout::GetChunkRowSpan(int32 ChunkIndex, int32 LocalRow) const
+{
+	const int32 ChunkRow = ChunkIndex / FMath::Max(1, ChunkColumns);
+	const int32 ChunkColumn = ChunkIndex % FMath::Max(1, ChunkColumns);
+	const int32 RowIndex = ChunkRow * ChunkSize + LocalRow;
+
+	if (ChunkIndex < 0 || ChunkIndex >= NumChunks() || LocalRow < 0 || LocalRow >= ChunkSize || RowIndex >= Rows.Num())
+	{
+		return FHxlbHexRowSpan();
+	}
+
+	const FHxlbHexRowSpan& Row = Rows[RowIndex];
+	const int32 ColumnMin = MinColumn + ChunkColumn * ChunkSize;
+	const int32 ColumnMax = ColumnMin + ChunkSize - 1;
+	const int32 RowShift = FloorHalf(Row.R);
+
+	return FHxlbHexRowSpan(Row.R, FMath::Max(Row.QMin, ColumnMin - RowShift), FMath::Min(Row.QMax, ColumnMax - RowShift));
+}
+
+void FHxlbDenseLayout::BuildChunks()
+{
+	int32 MaxColumn = TNumericLimits<int32>::Lowest();
+	MinColumn = TNumericLimits<int32>::Max();
+	
+	for (const FHxlbHexRowSpan& Row : Rows)
+	{
+		if (Row.IsEmpty())
+		{
+			continue;
+		}
+		MinColumn = FMath::Min(MinColumn, Row.QMin + FloorHalf(Row.R));
+		MaxColumn = FMath::Max(MaxColumn, Row.QMax + FloorHalf(Row.R));
+	}
+
+	if (MaxColumn < MinColumn)
+	{
+		MinColumn = 0;
+		return;
+	}
+
+	ChunkColumns = FMath::DivideAndRoundUp(MaxColumn - MinColumn + 1, ChunkSize);
+	ChunkRows = FMath::DivideAndRoundUp(Rows.Num(), ChunkSize);
+	ChunkHexCounts.SetNumZeroed(ChunkColumns * ChunkRows);
+
+	for (int32 ChunkIndex = 0; ChunkIndex < ChunkHexCounts.Num(); ++ChunkIndex)
+	{
+		for (int32 LocalRow = 0; LocalRow < ChunkSize; ++LocalRow)
+		{
+			ChunkHexCounts[ChunkIndex] += GetChunkRowSpan(ChunkIndex, LocalRow).Num();
+		}
+	}
+}
@@ -0,0 +1,159 @@
+// Copyright © Mason Stevenson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the disclaimer
+// below) provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+// THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+// CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+// NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "Foundation/HxlbHexBitmap.h"
+
+void FHxlbHexBitmap::Init(int32 NewNumBits)
+{
+	NumBits = FMath::Max(0, NewNumBits);
+	Words.SetNumUninitialized(NumWordsFor(NumBits), EAllowShrinking::No);
+	Reset();
+}
+
+void FHxlbHexBitmap::Reset()
+{
+	if (!Words.IsEmpty())
+	{
+		FMemory::Memzero(Words.GetData(), Words.Num() * sizeof(uint64));
+	}
+}
+
+uint64 FHxlbHexBitmap::ReadWordBits(TConstArrayView<uint64> SourceWords, int32 FirstIndex, int32 Count)
+{
+	check(Count >= 0 && Count <= kBitsPerWord);
+	if (Count == 0)
+	{
+		return 0;
+	}
+	
+	const int32 WordIndex = FirstIndex / kBitsPerWord;
+	const int32 Shift = FirstIndex % kBitsPerWord;
+	uint64 Bits = SourceWords[WordIndex] >> Shift;
+	if (Shift > 0 && Shift + Count > kBitsPerWord && WordIndex + 1 < SourceWords.Num())
+	{
+		Bits |= SourceWords[WordIndex + 1] << (kBitsPerWord - Shift);
+	}
+	return Count == kBitsPerWord ? Bits : Bits & ((static_cast<uint64>(1) << Count) - 1);
+}
+
+void FHxlbHexBitmap::OrWordBits(TArrayView<uint64> TargetWords, int32 FirstIndex, uint64 Bits, int32 Count)
+{
+	check(Count >= 0 && Count <= kBitsPerWord);
+	if (Count == 0)
+	{
+		return;
+	}
+	if (Count < kBitsPerWord)
+	{
+		Bits &= (static_cast<uint64>(1) << Count) - 1;
+	}
+	
+	const int32 WordIndex = FirstIndex / kBitsPerWord;
+	const int32 Shift = FirstIndex % kBitsPerWord;
+	TargetWords[WordIndex] |= Bits << Shift;
+	if (Shift > 0 && Shift + Count > kBitsPerWord)
+	{
+		TargetWords[WordIndex + 1] |= Bits >> (kBitsPerWord - Shift);
+	}
+}
+
+int32 FHxlbHexBitmap::CountSetBits() const
+{
+	int32 Count = 0;
+	for (uint64 Word : Words)
+	{
+		Count += static_cast<int32>(FMath::CountBits(Word));
+	}
+	return Count;
+}
+
+bool FHxlbHexBitmap::IsEmpty() const
+{
+	for (uint64 Word : Words)
+	{
+		if (Word)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+FHxlbHexBitmap& FHxlbHexBitmap::operator|=(const FHxlbHexBitmap& Other)
+{
+	check(NumBits == Other.NumBits);
+	for (int32 WordIndex = 0; WordIndex < Words.Num(); WordIndex++)
+	{
+		Words[WordIndex] |= Other.Words[WordIndex];
+	}
+	return *this;
+}
+
+FHxlbHexBitmap& FHxlbHexBitmap::operator&=(const FHxlbHexBitmap& Other)
+{
+	check(NumBits == Other.NumBits);
+	for (int32 WordIndex = 0; WordIndex < Words.Num(); WordIndex++)
+	{
+		Words[WordIndex] &= Other.Words[WordIndex];
+	}
+	return *this;
+}
+
+FHxlbHexBitmap& FHxlbHexBitmap::AndNot(const FHxlbHexBitmap& Other)
+{
+	check(NumBits == Other.NumBits);
+	for (int32 WordIndex = 0; WordIndex < Words.Num(); WordIndex++)
+	{
+		Words[WordIndex] &= ~Other.Words[WordIndex];
+	}
+	return *this;
+}
+
+void FHxlbHexBitmap::ToCoords(const FHxlbDenseLayout& Layout, TArray<FIntPoint>& OutCoords) const
+{
+	OutCoords.Reset();
+	if (Layout.Num() != NumBits)
+	{
+		return;
+	}
+
+	// Walk rows alongside the bits instead of calling CoordOf() for every set bit.
+	OutCoords.Reserve(CountSetBits());
+	int32 RowIndex = 0;
+	ForEachSetBit([&Layout, &OutCoords, &RowIndex](int32 DenseIndex)
+	{
+		while (RowIndex + 1 < Layout.NumRows() && Layout.GetRowStart(RowIndex + 1) <= DenseIndex)
+		{
+			RowIndex++;
+		}
+		OutCoords.Add(Layout.GetRow(RowIndex).Get(DenseIndex - Layout.GetRowStart(RowIndex)));
+	});
+}
@@ -0,0 +1,198 @@
+// Copyright © Mason Stevenson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the disclaimer
+// below) provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+// THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+// CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+// NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "Foundation/HxlbHexHierarchy.h"
+
+// Flower centers are the hexes where Q - 2R is a multiple of 7, and the six neighbors of a center each have a different
+// non-zero remainder, which says which way the center is. The centers are spanned by (2, 1) and (-1, 3), which are the
+// images of the axial directions (1, 0) and (0, 1) of the next level.
+namespace
+{
+	constexpr int32 kPetalQ[7] = {0, 1, 0, 1, -1, 0, -1};
+	constexpr int32 kPetalR[7] = {0, 0, -1, -1, 1, 1, 0};
+
+	FORCEINLINE int32 PositiveModulo(int32 Value, int32 Divisor)
+	{
+		const int32 Remainder = Value % Divisor;
+		return Remainder < 0 ? Remainder + Divisor : Remainder;
+	}
+}
+
+FIntPoint FHxlbHexHierarchy::ParentOf(FIntPoint AxialCoord)
+{
+	const int32 Petal = PositiveModulo(HEX_Q(AxialCoord) - 2 * HEX_R(AxialCoord), kAperture);
+	const int32 CenterQ = HEX_Q(AxialCoord) - kPetalQ[Petal];
+	const int32 CenterR = HEX_R(AxialCoord) - kPetalR[Petal];
+
+	// Inverse of CenterOf(). Both divisions are exact.
+	return FIntPoint((3 * CenterQ + CenterR) / kAperture, (2 * CenterR - CenterQ) / kAperture);
+}
+
+FIntPoint FHxlbHexHierarchy::CenterOf(FIntPoint ParentCoord)
+{
+	return FIntPoint(2 * HEX_Q(ParentCoord) - HEX_R(ParentCoord), HEX_Q(ParentCoord) + 3 * HEX_R(ParentCoord));
+}
+
+FIntPoint FHxlbHexHierarchy::AncestorOf(FIntPoint AxialCoord, int32 NumLevels)
+{
+	for (int32 Level = 0; Level < NumLevels; Level++)
+	{
+		AxialCoord = ParentOf(AxialCoord);
+	}
+	return AxialCoord;
+}
+
+FIntPoint FHxlbHexHierarchy::LeafCenterOf(FIntPoint AncestorCoord, int32 NumLevels)
+{
+	for (int32 Level = 0; Level < NumLevels; Level++)
+	{
+		AncestorCoord = CenterOf(AncestorCoord);
+	}
+	return AncestorCoord;
+}
+
+void FHxlbHexHierarchy::Build(const FHxlbDenseLayout& NewLeafLayout, int32 MaxTopLevelHexes)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(HXLB_BuildHexHierarchy);
+	
+	Reset();
+	if (!NewLeafLayout.IsValid())
+	{
+		return;
+	}
+	LeafLayout = &NewLeafLayout;
+	Levels.AddDefaulted();
+
+	while (GetLayout(Levels.Num() - 1).Num() > FMath::Max(1, MaxTopLevelHexes))
+	{
+		const int32 ChildLevel = Levels.Num() - 1;
+		const FHxlbDenseLayout& ChildLayout = GetLayout(ChildLevel);
+
+		// Rows of the next level span from the leftmost to the rightmost parent in each row, so they can contain a few
+		// super-hexes without children.
+		TArray<FIntPoint> ParentCoords;
+		ParentCoords.SetNumUninitialized(ChildLayout.Num());
+		int32 MinR = TNumericLimits<int32>::Max();
+		int32 MaxR = TNumericLimits<int32>::Lowest();
+		for (int32 RowIndex = 0; RowIndex < ChildLayout.NumRows(); RowIndex++)
+		{
+			const FHxlbHexRowSpan& Row = ChildLayout.GetRow(RowIndex);
+			for (int32 Offset = 0; Offset < Row.Num(); Offset++)
+			{
+				const FIntPoint ParentCoord = ParentOf(Row.Get(Offset));
+				ParentCoords[ChildLayout.GetRowStart(RowIndex) + Offset] = ParentCoord;
+				MinR = FMath::Min(MinR, HEX_R(ParentCoord));
+				MaxR = FMath::Max(MaxR, HEX_R(ParentCoord));
+			}
+		}
+		
+		TArray<FHxlbHexRowSpan> ParentRows;
+		for (int32 R = MinR; R <= MaxR; R++)
+		{
+			ParentRows.Emplace(R, TNumericLimits<int32>::Max(), TNumericLimits<int32>::Lowest());
+		}
+		for (const FIntPoint& ParentCoord : ParentCoords)
+		{
+			FHxlbHexRowSpan& Row = ParentRows[HEX_R(ParentCoord) - MinR];
+			Row.QMin = FMath::Min(Row.QMin, HEX_Q(ParentCoord));
+			Row.QMax = FMath::Max(Row.QMax, HEX_Q(ParentCoord));
+		}
+		for (FHxlbHexRowSpan& Row : ParentRows)
+		{
+			if (Row.QMax < Row.QMin)
+			{
+				Row = FHxlbHexRowSpan(Row.R, 0, -1);
+			}
+		}
+
+		FHxlbDenseLayout ParentLayout;
+		ParentLayout.InitFromRows(ParentRows, ChildLayout.GetChunkSize());
+		if (ParentLayout.Num() >= ChildLayout.Num())
+		{
+			// Tiny layouts can stop shrinking, e.g. a single hex is its own parent.
+			break;
+		}
+
+		FLevel& Parent = Levels.AddDefaulted_GetRef();
+		FLevel& Child = Levels[ChildLevel];
+		Parent.Layout = MoveTemp(ParentLayout);
+		Child.Parents.SetNumUninitialized(ParentCoords.Num());
+		Parent.ChildStarts.Init(0, Parent.Layout.Num() + 1);
+		Parent.LeafCounts.Init(0, Parent.Layout.Num());
+		for (int32 ChildIndex = 0; ChildIndex < ParentCoords.Num(); ChildIndex++)
+		{
+			const int32 ParentIndex = Parent.Layout.IndexOf(ParentCoords[ChildIndex]);
+			Child.Parents[ChildIndex] = ParentIndex;
+			Parent.ChildStarts[ParentIndex + 1]++;
+			Parent.LeafCounts[ParentIndex] += GetLeafCount(ChildLevel, ChildIndex);
+		}
+		for (int32 ParentIndex = 0; ParentIndex < Parent.Layout.Num(); ParentIndex++)
+		{
+			Parent.ChildStarts[ParentIndex + 1] += Parent.ChildStarts[ParentIndex];
+		}
+
+		// Children are listed in ascending dense order.
+		TArray<int32> Cursors(Parent.ChildStarts.GetData(), Parent.Layout.Num());
+		Parent.Children.SetNumUninitialized(ParentCoords.Num());
+		for (int32 ChildIndex = 0; ChildIndex < ParentCoords.Num(); ChildIndex++)
+		{
+			Parent.Children[Cursors[Child.Parents[ChildIndex]]++] = ChildIndex;
+		}
+	}
+}
+
+void FHxlbHexHierarchy::Reset()
+{
+	LeafLayout = nullptr;
+	Levels.Reset();
+}
+
+int32 FHxlbHexHierarchy::FindLevelWithAtMost(int32 MaxHexes) const
+{
+	for (int32 Level = 0; Level < Levels.Num(); Level++)
+	{
+		if (GetLayout(Level).Num() <= MaxHexes)
+		{
+			return Level;
+		}
+	}
+	return Levels.Num() - 1;
+}
+
+int32 FHxlbHexHierarchy::GetAncestor(int32 LeafIndex, int32 Level) const
+{
+	int32 DenseIndex = LeafIndex;
+	for (int32 CurrentLevel = 0; CurrentLevel < Level && DenseIndex != INDEX_NONE; CurrentLevel++)
+	{
+		DenseIndex = GetParent(CurrentLevel, DenseIndex);
+	}
+	return DenseIndex;
+}
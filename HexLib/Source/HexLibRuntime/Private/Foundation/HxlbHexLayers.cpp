@@ -0,0 +1,97 @@
+// Copyright © Mason Stevenson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the disclaimer
+// below) provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+// THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+// CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+// NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "Foundation/HxlbHexLayers.h"
+
+void FHxlbHexLayerBase::Resize(const FHxlbDenseLayout& NewLayout)
+{
+	Layout = &NewLayout;
+	NumValues = NewLayout.Num();
+	ResizeValues(NumValues);
+
+	ChunkVersions.Init(Version, NewLayout.NumChunks());
+	PendingChanges.Reset();
+	PendingMask.Init(false, NumValues);
+	MarkAllChanged();
+}
+
+void FHxlbHexLayerBase::MarkChanged(int32 DenseIndex)
+{
+	if (bAllPending || PendingMask[DenseIndex])
+	{
+		return;
+	}
+	PendingMask[DenseIndex] = true;
+	PendingChanges.Add(DenseIndex);
+}
+
+void FHxlbHexLayerBase::MarkAllChanged()
+{
+	bAllPending = true;
+	for (int32 DenseIndex : PendingChanges)
+	{
+		PendingMask[DenseIndex] = false;
+	}
+	PendingChanges.Reset();
+}
+
+void FHxlbHexLayerBase::CommitChanges()
+{
+	if (!HasPendingChanges())
+	{
+		return;
+	}
+	
+	Version++;
+	if (bAllPending)
+	{
+		for (uint32& ChunkVersion : ChunkVersions)
+		{
+			ChunkVersion = Version;
+		}
+	}
+	else if (Layout)
+	{
+		for (int32 DenseIndex : PendingChanges)
+		{
+			ChunkVersions[Layout->ChunkOfIndex(DenseIndex)] = Version;
+			PendingMask[DenseIndex] = false;
+		}
+	}
+
+	// Listeners may write to the layer again, so hand them a copy of the change list and clear ours first.
+	const bool bAllChanged = bAllPending;
+	TArray<int32> ChangedIndices = MoveTemp(PendingChanges);
+	PendingChanges.Reset();
+	bAllPending = false;
+	
+	OnChanged.Broadcast(*this, bAllChanged ? TConstArrayView<int32>() : TConstArrayView<int32>(ChangedIndices), bAllChanged);
+}
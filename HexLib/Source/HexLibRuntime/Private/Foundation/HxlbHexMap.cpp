@@ -35,6 +35,8 @@
 #include "HxlbGameplayTags.h"
 #include "Actor/HxlbHexActor.h"
 #include "Foundation/HxlbHexIterators.h"
+#include "Foundation/HxlbHexRanges.h"
+#include "Foundation/HxlbHexShapes.h"
 #include "FunctionLibraries/HxlbMath.h"
 #include "Landscape.h"
 #include "LandscapeInfo.h"
@@ -47,28 +49,1019 @@
 
 using HexMath = UHxlbMath;
 
+const FName UHxlbHexMapComponent::kMovementCostLayerName = TEXT("Hxlb.MovementCost");
+
 FHxlbMapSettings::FHxlbMapSettings()
 {
-	DebugTag = HxlbGameplayTags::TAG_HEXGAME_MAP_ZONE;	
+	DebugTag = HxlbGameplayTags::TAG_HEXGAME_MAP_ZONE;	
+}
+
+UHxlbHexMapComponent::UHxlbHexMapComponent(const FObjectInitializer& Initializer): Super(Initializer)
+{
+#if WITH_EDITORONLY_DATA
+	static ConstructorHelpers::FObjectFinder<UMaterialInterface> OverlayMaterial_Finder(TEXT("/HxLib/Materials/MI_DefaultHexOverlay.MI_DefaultHexOverlay"));
+	MapSettings.OverlaySettings.OverlayMaterial = OverlayMaterial_Finder.Object;
+	
+	static ConstructorHelpers::FObjectFinder<UTextureRenderTarget2D> LandscapeRT_Finder(TEXT("/HxLib/RenderTargets/RT_DefaultHexOverlay_2K.RT_DefaultHexOverlay_2K"));
+	MapSettings.OverlaySettings.LandscapeHeightRT = LandscapeRT_Finder.Object;
+
+	static ConstructorHelpers::FObjectFinder<UTextureRenderTarget2D> PerHexDataRT_Finder(TEXT("/HxLib/RenderTargets/RT_HexInfo_256.RT_HexInfo_256"));
+	MapSettings.OverlaySettings.PerHexDataRT = PerHexDataRT_Finder.Object;
+#endif
+}
+
+void UHxlbHexMapComponent::InitGridData(FVector NewGridOrigin)
+{
+	GridOrigin = HexMath::WorldToAxial(NewGridOrigin, MapSettings.HexSize, MapSettings.HexOrientation);
+	RebuildDenseLayout();
+}
+
+bool UHxlbHexMapComponent::RebuildDenseLayout()
+{
+	// Centered on (0, 0) to match IsValidAxialCoord().
+	FHxlbDenseLayout NewLayout;
+	switch (MapSettings.Shape)
+	{
+	case EHexMapShape::Hexagonal:
+		NewLayout.InitHexagonal(MapSettings.HaxagonalMapSettings.Radius);
+		break;
+	case EHexMapShape::Rectangular:
+		NewLayout.InitRectangular(MapSettings.RectangularHexMapSettings.Width, MapSettings.RectangularHexMapSettings.Height);
+		break;
+	default:
+		break;
+	}
+
+	// Rebuilding resets every layer, so don't do it unless the map actually changed shape.
+	if (NewLayout.HasSameShape(DenseLayout))
+	{
+		return false;
+	}
+
+	// Dense indices don't carry over to the new layout, so distance field sources are kept as coords until it is in place.
+	TMap<FName, TArray<FIntPoint>> DistanceSources;
+	for (const auto& FieldKV : DistanceFields)
+	{
+		TArray<FIntPoint>& Sources = DistanceSources.Add(FieldKV.Key);
+		for (int32 SourceIndex : FieldKV.Value->GetSources())
+		{
+			Sources.Add(DenseLayout.CoordOf(SourceIndex));
+		}
+	}
+	
+	DenseLayout = MoveTemp(NewLayout);
+	if (FogOfWar.IsInitialized())
+	{
+		FogOfWar.Init(DenseLayout);
+	}
+	CoverMap.MarkAllChanged();
+	if (InfluenceMap.IsInitialized())
+	{
+		InfluenceMap.Init(DenseLayout);
+	}
+	if (Occupancy.IsInitialized())
+	{
+		Occupancy.Init(DenseLayout);
+	}
+	if (HexTimers.IsInitialized())
+	{
+		HexTimers.Init(DenseLayout);
+	}
+	QueryCache.Reset();
+	for (const auto& IndexKV : TagIndexes)
+	{
+		FillTagIndex(IndexKV.Key, *IndexKV.Value);
+	}
+	if (Stencil.IsInitialized())
+	{
+		Stencil.Init(DenseLayout);
+	}
+	if (HexHierarchy.IsBuilt())
+	{
+		// Before the layers are committed, so that aggregates rebuild against the new hierarchy.
+		HexHierarchy.Build(DenseLayout);
+	}
+	for (const auto& LayerKV : HexLayers)
+	{
+		LayerKV.Value->Resize(DenseLayout);
+
+		// The cost layer is committed once it has been recompiled below, so that listeners don't see it reset.
+		if (LayerKV.Key != kMovementCostLayerName)
+		{
+			LayerKV.Value->CommitChanges();
+		}
+	}
+	for (const auto& FieldKV : DistanceFields)
+	{
+		// The layers they were mirrored into have just been reset. Sources that fell off the map are dropped.
+		TArray<int32> SourceIndices;
+		ToDenseIndices(DistanceSources.FindChecked(FieldKV.Key), SourceIndices);
+		RebuildDistanceField(FieldKV.Key, *FieldKV.Value, SourceIndices, FieldKV.Value->IsWeighted());
+	}
+	if (FindLayerBase(kMovementCostLayerName))
+	{
+		CompileCostLayer();
+	}
+	return true;
+}
+
+FHxlbHexLayerBase* UHxlbHexMapComponent::FindLayerBase(FName LayerName) const
+{
+	const TSharedRef<FHxlbHexLayerBase>* Layer = HexLayers.Find(LayerName);
+	return Layer ? &Layer->Get() : nullptr;
+}
+
+bool UHxlbHexMapComponent::RemoveLayer(FName LayerName)
+{
+	RegionLabelings.Remove(LayerName);
+	RegionBorders.Remove(LayerName);
+	LayerAggregates.Remove(LayerName);
+	DistanceFields.Remove(LayerName);
+	VisionLayerBindings.Remove(LayerName);
+	if (LayerName == kMovementCostLayerName)
+	{
+		MovementCostBinding.Reset();
+
+		// Agent planners point into the layer's values. Everything else built from movement costs is stale, and is built
+		// again from the next cost layer on first use.
+		AgentPaths.Reset();
+		HierarchicalPathfinder.Reset();
+		FlowFieldCache.Reset();
+		MovementRange.Reset();
+		Landmarks.Reset();
+		InfluenceMap.MarkAllChanged();
+
+		// Weighted distance fields point into the layer's values too, and have nothing left to add up.
+		TArray<FName> WeightedFields;
+		for (const auto& FieldKV : DistanceFields)
+		{
+			if (FieldKV.Value->IsWeighted())
+			{
+				WeightedFields.Add(FieldKV.Key);
+			}
+		}
+		for (FName FieldName : WeightedFields)
+		{
+			RemoveLayer(FieldName);
+		}
+	}
+	if (LayerName == MapSettings.VisionSettings.ElevationLayerName || LayerName == MapSettings.VisionSettings.OpacityLayerName)
+	{
+		// Missing vision layers count as flat and transparent from now on.
+		if (FogOfWar.IsInitialized())
+		{
+			FogOfWar.MarkAllChanged();
+		}
+		CoverMap.MarkAllChanged();
+	}
+
+	// A layer added later under the same name could reuse the address and the versions of this one.
+	QueryCache.Reset();
+	return HexLayers.Remove(LayerName) > 0;
+}
+
+void UHxlbHexMapComponent::ReportLayerTypeMismatch(const FHxlbHexLayerBase& Layer, const TCHAR* RequestedTypeName) const
+{
+	HXLB_LOG(LogHxlbRuntime, Error, TEXT("Hex layer %s holds %s values, but was requested as %s."), *Layer.GetName().ToString(), Layer.GetTypeName(), RequestedTypeName);
+}
+
+void UHxlbHexMapComponent::CompileCostLayer()
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(HXLB_CompileCostLayer);
+	
+	THxlbHexLayer<float>* CostLayer = FindOrAddLayer<float>(kMovementCostLayerName, MapSettings.MovementCostSettings.BaseCost);
+	if (!CostLayer || !DenseLayout.IsValid())
+	{
+		return;
+	}
+
+	TArray<const THxlbHexLayer<float>*> CostLayers;
+	GatherCostLayers(CostLayers);
+
+	// Most hexes have no hex data, so the whole map is compiled from layers in parallel first, and the few hexes with
+	// tags are patched afterward on the game thread.
+	TArrayView<float> Costs = CostLayer->GetMutableValues();
+	HxlbParallelForEachHex(DenseLayout, [this, &Costs, &CostLayers](FIntPoint HexCoord, int32 DenseIndex)
+	{
+		Costs[DenseIndex] = ComputeHexCost(DenseIndex, nullptr, CostLayers);
+	});
+	for (const auto& HexKV : HexData)
+	{
+		const int32 DenseIndex = DenseLayout.IndexOf(HexKV.Key);
+		if (DenseIndex != INDEX_NONE && HexKV.Value)
+		{
+			Costs[DenseIndex] = ComputeHexCost(DenseIndex, HexKV.Value, CostLayers);
+		}
+	}
+
+	MinMovementCost = TNumericLimits<float>::Max();
+	for (float Cost : Costs)
+	{
+		MinMovementCost = FMath::Min(MinMovementCost, Cost);
+	}
+	if (HxlbMovementCost::IsBlocked(MinMovementCost))
+	{
+		// Everything is blocked. Any positive value works.
+		MinMovementCost = MapSettings.MovementCostSettings.MinimumCost;
+	}
+	
+	CostLayer->MarkAllChanged();
+	CostLayer->CommitChanges();
+
+	for (const auto& IndexKV : TagIndexes)
+	{
+		FillTagIndex(IndexKV.Key, *IndexKV.Value);
+	}
+}
+
+void UHxlbHexMapComponent::RecompileHexCosts(TConstArrayView<FIntPoint> HexCoords)
+{
+	THxlbHexLayer<float>* CostLayer = FindLayer<float>(kMovementCostLayerName);
+	if (!CostLayer)
+	{
+		CompileCostLayer();
+		return;
+	}
+	
+	TArray<const THxlbHexLayer<float>*> CostLayers;
+	GatherCostLayers(CostLayers);
+
+	for (FIntPoint HexCoord : HexCoords)
+	{
+		const int32 DenseIndex = DenseLayout.IndexOf(HexCoord);
+		if (DenseIndex == INDEX_NONE)
+		{
+			continue;
+		}
+		
+		const float Cost = ComputeHexCost(DenseIndex, HexData.FindRef(HexCoord), CostLayers);
+		CostLayer->Set(DenseIndex, Cost);
+
+		// The minimum only has to stay a lower bound, so it is allowed to go down but never back up here.
+		MinMovementCost = FMath::Min(MinMovementCost, Cost);
+	}
+	CostLayer->CommitChanges();
+	RefreshHexTags(HexCoords);
+}
+
+FHxlbCostField UHxlbHexMapComponent::GetCostField() const
+{
+	const THxlbHexLayer<float>* CostLayer = FindLayer<float>(kMovementCostLayerName);
+	if (!CostLayer)
+	{
+		return FHxlbCostField();
+	}
+	return FHxlbCostField(DenseLayout, CostLayer->GetValues(), MinMovementCost);
+}
+
+const FHxlbHierarchicalPathfinder& UHxlbHexMapComponent::GetHierarchicalPathfinder()
+{
+	if (!HierarchicalPathfinder)
+	{
+		HierarchicalPathfinder = MakeUnique<FHxlbHierarchicalPathfinder>();
+		BindMovementCostLayer();
+		HierarchicalPathfinder->Build(GetCostField());
+	}
+	return *HierarchicalPathfinder;
+}
+
+const FHxlbLandmarks& UHxlbHexMapComponent::GetLandmarks()
+{
+	BindMovementCostLayer();
+	if (!Landmarks.IsBuilt())
+	{
+		Landmarks.Build(GetCostField());
+	}
+	else
+	{
+		Landmarks.Refresh(GetCostField());
+	}
+	return Landmarks;
+}
+
+TSharedRef<const FHxlbFlowField> UHxlbHexMapComponent::GetFlowField(TConstArrayView<FIntPoint> Goals)
+{
+	BindMovementCostLayer();
+	return FlowFieldCache.FindOrBuild(GetCostField(), Goals);
+}
+
+bool UHxlbHexMapComponent::SetAgentPath(int32 AgentId, FIntPoint Start, FIntPoint Goal)
+{
+	BindMovementCostLayer();
+	TUniquePtr<FHxlbIncrementalPathfinder>& Planner = AgentPaths.FindOrAdd(AgentId);
+	if (!Planner)
+	{
+		Planner = MakeUnique<FHxlbIncrementalPathfinder>();
+	}
+	if (Planner->IsValid() && Planner->GetGoal() == Goal)
+	{
+		return Planner->SetStart(Start);
+	}
+	return Planner->Init(GetCostField(), Start, Goal);
+}
+
+bool UHxlbHexMapComponent::RemoveAgentPath(int32 AgentId)
+{
+	return AgentPaths.Remove(AgentId) > 0;
+}
+
+EHxlbPathStatus UHxlbHexMapComponent::FindAgentPath(int32 AgentId, FHxlbPathResult& OutResult)
+{
+	if (const TUniquePtr<FHxlbIncrementalPathfinder>* Planner = AgentPaths.Find(AgentId))
+	{
+		return (*Planner)->FindPath(OutResult);
+	}
+	OutResult = FHxlbPathResult();
+	OutResult.Status = EHxlbPathStatus::InvalidQuery;
+	return OutResult.Status;
+}
+
+const FHxlbMovementRange& UHxlbHexMapComponent::GetMovementRange()
+{
+	if (!MovementRange.IsBuilt())
+	{
+		BindMovementCostLayer();
+		MovementRange.Build(GetCostField());
+	}
+	return MovementRange;
+}
+
+FHxlbVisionField UHxlbHexMapComponent::GetVisionField() const
+{
+	const THxlbHexLayer<float>* ElevationLayer = FindLayer<float>(MapSettings.VisionSettings.ElevationLayerName);
+	const THxlbHexLayer<float>* OpacityLayer = FindLayer<float>(MapSettings.VisionSettings.OpacityLayerName);
+	return FHxlbVisionField(
+		DenseLayout,
+		ElevationLayer ? ElevationLayer->GetValues() : TConstArrayView<float>(),
+		OpacityLayer ? OpacityLayer->GetValues() : TConstArrayView<float>()
+	);
+}
+
+const FHxlbFieldOfView& UHxlbHexMapComponent::GetFieldOfView(int32 MinRadius)
+{
+	if (FieldOfView.GetMaxRadius() < MinRadius)
+	{
+		FieldOfView.Init(MinRadius);
+	}
+	return FieldOfView;
+}
+
+FHxlbFogOfWar& UHxlbHexMapComponent::GetFogOfWar()
+{
+	if (!FogOfWar.IsInitialized())
+	{
+		FogOfWar.Init(DenseLayout);
+	}
+	return FogOfWar;
+}
+
+void UHxlbHexMapComponent::UpdateFogOfWar()
+{
+	BindVisionLayers();
+	
+	// Runs even when nothing changed, so that the changed hex lists always describe this update.
+	FHxlbFogOfWar& Fog = GetFogOfWar();
+	Fog.Update(GetFieldOfView(Fog.GetMaxObserverRadius()), GetVisionField());
+}
+
+const FHxlbCoverMap& UHxlbHexMapComponent::GetCoverMap()
+{
+	BindVisionLayers();
+
+	// Builds the map the first time, and rebuilds it if the settings changed.
+	CoverMap.Update(GetVisionField(), MapSettings.CoverSettings);
+	return CoverMap;
+}
+
+FHxlbOccupancyIndex& UHxlbHexMapComponent::GetOccupancy()
+{
+	if (!Occupancy.IsInitialized())
+	{
+		Occupancy.Init(DenseLayout);
+	}
+	return Occupancy;
+}
+
+FHxlbHexTimerWheel& UHxlbHexMapComponent::GetHexTimers()
+{
+	if (!HexTimers.IsInitialized())
+	{
+		HexTimers.Init(DenseLayout);
+	}
+	return HexTimers;
+}
+
+void UHxlbHexMapComponent::AdvanceHexTimers(int32 NumTicks, TArray<FHxlbHexTimer>& OutFired)
+{
+	const int32 FirstFired = OutFired.Num();
+	GetHexTimers().Advance(NumTicks, OutFired);
+
+	TArray<THxlbHexLayer<float>*, TInlineAllocator<4>> ChangedLayers;
+	THxlbHexLayer<float>* Layer = nullptr;
+	for (int32 FiredIndex = FirstFired; FiredIndex < OutFired.Num(); FiredIndex++)
+	{
+		const FHxlbHexTimer& Timer = OutFired[FiredIndex];
+		if (Timer.Action == EHxlbHexTimerAction::Notify)
+		{
+			continue;
+		}
+		
+		// Timers on the same layer tend to come in runs, so the last layer is checked before looking it up.
+		if (!Layer || Layer->GetName() != Timer.LayerName)
+		{
+			Layer = FindLayer<float>(Timer.LayerName);
+			if (!Layer)
+			{
+				HXLB_LOG(LogHxlbRuntime, Warning, TEXT("UHxlbHexMapComponent::AdvanceHexTimers(): Hex layer %s doesn't exist or doesn't hold floats."), *Timer.LayerName.ToString());
+				continue;
+			}
+			ChangedLayers.AddUnique(Layer);
+		}
+		const float OldValue = Layer->Get(Timer.DenseIndex);
+		Layer->Set(Timer.DenseIndex, Timer.Action == EHxlbHexTimerAction::AddToLayerValue ? OldValue + Timer.Value : Timer.Value);
+	}
+	for (THxlbHexLayer<float>* ChangedLayer : ChangedLayers)
+	{
+		ChangedLayer->CommitChanges();
+	}
+}
+
+TSharedRef<const FHxlbQueryResult> UHxlbHexMapComponent::QueryHexes(const FHxlbHexQuery& Query)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(HXLB_QueryHexes);
+
+	// The cached result is checked against the layers the query reads.
+	TArray<const FHxlbHexLayerBase*, TInlineAllocator<4>> Layers;
+	int32 FootprintRadius = Query.Radius;
+	switch (Query.Kind)
+	{
+	case EHxlbHexQueryKind::Reachable:
+		BindMovementCostLayer();
+		Layers.Add(FindLayerBase(kMovementCostLayerName));
+		break;
+	case EHxlbHexQueryKind::ReachableByCost:
+		BindMovementCostLayer();
+		Layers.Add(FindLayerBase(kMovementCostLayerName));
+
+		// Every step costs at least the minimum cost, so nothing further out can be reached.
+		FootprintRadius = FMath::FloorToInt(FMath::Min(Query.MaxCost / FMath::Max(MinMovementCost, UE_KINDA_SMALL_NUMBER), static_cast<float>(DenseLayout.Num())));
+		break;
+	case EHxlbHexQueryKind::Visible:
+		Layers.Add(FindLayer<float>(MapSettings.VisionSettings.ElevationLayerName));
+		Layers.Add(FindLayer<float>(MapSettings.VisionSettings.OpacityLayerName));
+		break;
+	default:
+		break;
+	}
+	
+	const THxlbHexLayer<int32>* FilterLayer = nullptr;
+	if (!Query.FilterLayerName.IsNone())
+	{
+		FilterLayer = FindLayer<int32>(Query.FilterLayerName);
+		Layers.Add(FilterLayer);
+	}
+
+	return QueryCache.FindOrCompute(Query, DenseLayout, FootprintRadius, Layers, [this, &Query, FilterLayer, FootprintRadius](FHxlbHexBitmap& OutHexes)
+	{
+		switch (Query.Kind)
+		{
+		case EHxlbHexQueryKind::Radius:
+		{
+			OutHexes.Init(DenseLayout.Num());
+			auto Shape = HxlbShapes::ClipToMap(HxlbShapes::Spans(FHxlbRadialRange(Query.Origin, Query.Radius)), DenseLayout);
+			HxlbShapes::ForEachIndex(Shape, DenseLayout, [&OutHexes](int32 DenseIndex) { OutHexes.Set(DenseIndex); });
+			break;
+		}
+		case EHxlbHexQueryKind::Reachable:
+			GetMovementRange().FindReachable(Query.Origin, Query.Radius, OutHexes);
+			break;
+		case EHxlbHexQueryKind::ReachableByCost:
+			FHxlbMovementRange::FindReachableWeighted(GetCostField(), Query.Origin, Query.MaxCost, OutHexes);
+			break;
+		case EHxlbHexQueryKind::Visible:
+		{
+			FHxlbVisionObserver Observer;
+			Observer.HexCoord = Query.Origin;
+			Observer.Radius = Query.Radius;
+			Observer.EyeHeight = Query.EyeHeight;
+			Observer.TargetHeight = Query.TargetHeight;
+			GetFieldOfView(Query.Radius).Compute(GetVisionField(), Observer, OutHexes);
+			break;
+		}
+		}
+		if (OutHexes.Num() != DenseLayout.Num())
+		{
+			return;
+		}
+
+		if (Query.MinRadius > 0)
+		{
+			auto Inside = HxlbShapes::ClipToMap(HxlbShapes::Spans(FHxlbRadialRange(Query.Origin, Query.MinRadius - 1)), DenseLayout);
+			HxlbShapes::ForEachIndex(Inside, DenseLayout, [&OutHexes](int32 DenseIndex) { OutHexes.Clear(DenseIndex); });
+		}
+		if (!Query.FilterLayerName.IsNone())
+		{
+			auto Footprint = HxlbShapes::ClipToMap(HxlbShapes::Spans(FHxlbRadialRange(Query.Origin, FootprintRadius)), DenseLayout);
+			HxlbShapes::ForEachIndex(Footprint, DenseLayout, [&OutHexes, FilterLayer, &Query](int32 DenseIndex)
+			{
+				if (!FilterLayer || !(FilterLayer->Get(DenseIndex) & Query.FilterMask))
+				{
+					OutHexes.Clear(DenseIndex);
+				}
+			});
+		}
+	});
+}
+
+const FHxlbHexBitmap& UHxlbHexMapComponent::GetTagIndex(const FGameplayTag& Tag)
+{
+	TUniquePtr<FHxlbHexBitmap>& Index = TagIndexes.FindOrAdd(Tag);
+	if (!Index)
+	{
+		Index = MakeUnique<FHxlbHexBitmap>();
+		FillTagIndex(Tag, *Index);
+	}
+	return *Index;
+}
+
+void UHxlbHexMapComponent::RefreshHexTags(TConstArrayView<FIntPoint> HexCoords)
+{
+	for (const auto& IndexKV : TagIndexes)
+	{
+		for (FIntPoint HexCoord : HexCoords)
+		{
+			const int32 DenseIndex = DenseLayout.IndexOf(HexCoord);
+			if (DenseIndex == INDEX_NONE)
+			{
+				continue;
+			}
+			
+			const UHxlbHex* Hex = HexData.FindRef(HexCoord);
+			IndexKV.Value->SetTo(DenseIndex, Hex && Hex->GameplayTags.HasTag(IndexKV.Key));
+		}
+	}
+}
+
+void UHxlbHexMapComponent::FillTagIndex(const FGameplayTag& Tag, FHxlbHexBitmap& Index) const
+{
+	// Refilled in place, so that queries holding on to the index keep a valid reference.
+	Index.Init(DenseLayout.Num());
+	for (const auto& HexKV : HexData)
+	{
+		const int32 DenseIndex = DenseLayout.IndexOf(HexKV.Key);
+		if (DenseIndex != INDEX_NONE && HexKV.Value && HexKV.Value->GameplayTags.HasTag(Tag))
+		{
+			Index.Set(DenseIndex);
+		}
+	}
+}
+
+FHxlbInfluenceMap& UHxlbHexMapComponent::GetInfluenceMap()
+{
+	if (!InfluenceMap.IsInitialized())
+	{
+		InfluenceMap.Init(DenseLayout);
+	}
+	return InfluenceMap;
+}
+
+void UHxlbHexMapComponent::UpdateInfluenceMap()
+{
+	BindMovementCostLayer();
+	GetInfluenceMap().Update(GetCostField());
+}
+
+const FHxlbRegionLabeling* UHxlbHexMapComponent::GetRegions(FName LayerName)
+{
+	THxlbHexLayer<int32>* Layer = FindLayer<int32>(LayerName);
+	if (!Layer)
+	{
+		return nullptr;
+	}
+	if (const TUniquePtr<FHxlbRegionLabeling>* Existing = RegionLabelings.Find(LayerName))
+	{
+		return Existing->Get();
+	}
+
+	BindRegionLayer(*Layer);
+	TUniquePtr<FHxlbRegionLabeling>& Labeling = RegionLabelings.Add(LayerName, MakeUnique<FHxlbRegionLabeling>());
+	Labeling->Build(DenseLayout, [Layer](int32 DenseIndex) { return static_cast<uint32>(Layer->Get(DenseIndex)); });
+	return Labeling.Get();
+}
+
+const FHxlbRegionBorders* UHxlbHexMapComponent::GetRegionBorders(FName LayerName)
+{
+	THxlbHexLayer<int32>* Layer = FindLayer<int32>(LayerName);
+	if (!Layer)
+	{
+		return nullptr;
+	}
+	if (const TUniquePtr<FHxlbRegionBorders>* Existing = RegionBorders.Find(LayerName))
+	{
+		return Existing->Get();
+	}
+
+	BindRegionLayer(*Layer);
+	TUniquePtr<FHxlbRegionBorders>& Borders = RegionBorders.Add(LayerName, MakeUnique<FHxlbRegionBorders>());
+	Borders->Build(DenseLayout, Layer->GetValues(), MapSettings.HexSize, Layer->GetDefaultValue());
+	return Borders.Get();
+}
+
+void UHxlbHexMapComponent::BindRegionLayer(THxlbHexLayer<int32>& Layer)
+{
+	// Labelings and borders of the same layer share one binding.
+	if (!RegionLabelings.Contains(Layer.GetName()) && !RegionBorders.Contains(Layer.GetName()))
+	{
+		Layer.OnChanged.AddUObject(this, &UHxlbHexMapComponent::OnRegionLayerChanged);
+	}
+}
+
+void UHxlbHexMapComponent::OnRegionLayerChanged(const FHxlbHexLayerBase& Layer, TConstArrayView<int32> ChangedIndices, bool bAllChanged)
+{
+	// Only int32 layers are ever bound here, see BindRegionLayer().
+	const THxlbHexLayer<int32>& TypedLayer = static_cast<const THxlbHexLayer<int32>&>(Layer);
+	
+	if (const TUniquePtr<FHxlbRegionLabeling>* Labeling = RegionLabelings.Find(Layer.GetName()))
+	{
+		auto KeyOf = [&TypedLayer](int32 DenseIndex) { return static_cast<uint32>(TypedLayer.Get(DenseIndex)); };
+		if (bAllChanged)
+		{
+			(*Labeling)->Build(DenseLayout, KeyOf);
+		}
+		else
+		{
+			(*Labeling)->Update(ChangedIndices, KeyOf);
+		}
+	}
+
+	if (const TUniquePtr<FHxlbRegionBorders>* Borders = RegionBorders.Find(Layer.GetName()))
+	{
+		if (bAllChanged)
+		{
+			(*Borders)->Build(DenseLayout, TypedLayer.GetValues(), MapSettings.HexSize, TypedLayer.GetDefaultValue());
+		}
+		else
+		{
+			(*Borders)->Update(TypedLayer.GetValues(), ChangedIndices);
+		}
+	}
 }
 
-UHxlbHexMapComponent::UHxlbHexMapComponent(const FObjectInitializer& Initializer): Super(Initializer)
+const FHxlbHexHierarchy& UHxlbHexMapComponent::GetHexHierarchy()
 {
-#if WITH_EDITORONLY_DATA
-	static ConstructorHelpers::FObjectFinder<UMaterialInterface> OverlayMaterial_Finder(TEXT("/HxLib/Materials/MI_DefaultHexOverlay.MI_DefaultHexOverlay"));
-	MapSettings.OverlaySettings.OverlayMaterial = OverlayMaterial_Finder.Object;
+	if (!HexHierarchy.IsBuilt())
+	{
+		HexHierarchy.Build(DenseLayout);
+	}
+	return HexHierarchy;
+}
+
+const FHxlbHexAggregate* UHxlbHexMapComponent::GetAggregate(FName LayerName, EHxlbAggregateOp Op)
+{
+	FHxlbHexLayerBase* Layer = FindLayerBase(LayerName);
+	if (!Layer || (!FindLayer<float>(LayerName) && !FindLayer<int32>(LayerName)))
+	{
+		return nullptr;
+	}
+
+	TArray<TUniquePtr<FHxlbHexAggregate>>* Aggregates = LayerAggregates.Find(LayerName);
+	if (!Aggregates)
+	{
+		Layer->OnChanged.AddUObject(this, &UHxlbHexMapComponent::OnAggregateLayerChanged);
+		Aggregates = &LayerAggregates.Add(LayerName);
+	}
+	for (const TUniquePtr<FHxlbHexAggregate>& Existing : *Aggregates)
+	{
+		if (Existing->GetOp() == Op)
+		{
+			return Existing.Get();
+		}
+	}
+
+	TUniquePtr<FHxlbHexAggregate>& Aggregate = Aggregates->Add_GetRef(MakeUnique<FHxlbHexAggregate>());
+	RefreshAggregate(*Aggregate, Op, *Layer, {}, true);
+	return Aggregate.Get();
+}
+
+void UHxlbHexMapComponent::RefreshAggregate(FHxlbHexAggregate& Aggregate, EHxlbAggregateOp Op, const FHxlbHexLayerBase& Layer, TConstArrayView<int32> ChangedIndices, bool bAllChanged)
+{
+	// Only float and int32 layers are ever bound, see GetAggregate().
+	const THxlbHexLayer<float>* FloatLayer = FindLayer<float>(Layer.GetName());
+	const THxlbHexLayer<int32>* IntLayer = FindLayer<int32>(Layer.GetName());
+	auto ValueOf = [FloatLayer, IntLayer](int32 DenseIndex)
+	{
+		return FloatLayer ? FloatLayer->Get(DenseIndex) : static_cast<float>(IntLayer->Get(DenseIndex));
+	};
 	
-	static ConstructorHelpers::FObjectFinder<UTextureRenderTarget2D> LandscapeRT_Finder(TEXT("/HxLib/RenderTargets/RT_DefaultHexOverlay_2K.RT_DefaultHexOverlay_2K"));
-	MapSettings.OverlaySettings.LandscapeHeightRT = LandscapeRT_Finder.Object;
+	if (bAllChanged)
+	{
+		Aggregate.Build(GetHexHierarchy(), Op, ValueOf);
+	}
+	else
+	{
+		Aggregate.Update(ChangedIndices, ValueOf);
+	}
+}
 
-	static ConstructorHelpers::FObjectFinder<UTextureRenderTarget2D> PerHexDataRT_Finder(TEXT("/HxLib/RenderTargets/RT_HexInfo_256.RT_HexInfo_256"));
-	MapSettings.OverlaySettings.PerHexDataRT = PerHexDataRT_Finder.Object;
-#endif
+void UHxlbHexMapComponent::OnAggregateLayerChanged(const FHxlbHexLayerBase& Layer, TConstArrayView<int32> ChangedIndices, bool bAllChanged)
+{
+	if (TArray<TUniquePtr<FHxlbHexAggregate>>* Aggregates = LayerAggregates.Find(Layer.GetName()))
+	{
+		for (const TUniquePtr<FHxlbHexAggregate>& Aggregate : *Aggregates)
+		{
+			RefreshAggregate(*Aggregate, Aggregate->GetOp(), Layer, ChangedIndices, bAllChanged);
+		}
+	}
 }
 
-void UHxlbHexMapComponent::InitGridData(FVector NewGridOrigin)
+const FHxlbDistanceField* UHxlbHexMapComponent::AddDistanceField(FName LayerName, TConstArrayView<FIntPoint> Sources, bool bWeighted)
 {
-	GridOrigin = HexMath::WorldToAxial(NewGridOrigin, MapSettings.HexSize, MapSettings.HexOrientation);
+	if (!DenseLayout.IsValid())
+	{
+		return nullptr;
+	}
+	
+	THxlbHexLayer<float>* Layer = FindOrAddLayer<float>(LayerName, FHxlbDistanceField::Unreachable);
+	if (!Layer)
+	{
+		return nullptr;
+	}
+	if (bWeighted)
+	{
+		BindMovementCostLayer();
+	}
+
+	TArray<int32> SourceIndices;
+	ToDenseIndices(Sources, SourceIndices);
+	TUniquePtr<FHxlbDistanceField>& Field = DistanceFields.FindOrAdd(LayerName);
+	if (!Field)
+	{
+		Field = MakeUnique<FHxlbDistanceField>();
+	}
+	RebuildDistanceField(LayerName, *Field, SourceIndices, bWeighted);
+	return Field.Get();
+}
+
+void UHxlbHexMapComponent::AddDistanceSources(FName LayerName, TConstArrayView<FIntPoint> Sources)
+{
+	if (TUniquePtr<FHxlbDistanceField>* Field = DistanceFields.Find(LayerName))
+	{
+		TArray<int32> SourceIndices;
+		ToDenseIndices(Sources, SourceIndices);
+		(*Field)->AddSources(SourceIndices);
+		WriteDistanceLayer(LayerName, **Field, false);
+	}
+}
+
+void UHxlbHexMapComponent::RemoveDistanceSources(FName LayerName, TConstArrayView<FIntPoint> Sources)
+{
+	if (TUniquePtr<FHxlbDistanceField>* Field = DistanceFields.Find(LayerName))
+	{
+		TArray<int32> SourceIndices;
+		ToDenseIndices(Sources, SourceIndices);
+		(*Field)->RemoveSources(SourceIndices);
+		WriteDistanceLayer(LayerName, **Field, false);
+	}
+}
+
+const FHxlbDistanceField* UHxlbHexMapComponent::GetDistanceField(FName LayerName) const
+{
+	const TUniquePtr<FHxlbDistanceField>* Field = DistanceFields.Find(LayerName);
+	return Field ? Field->Get() : nullptr;
+}
+
+void UHxlbHexMapComponent::ToDenseIndices(TConstArrayView<FIntPoint> HexCoords, TArray<int32>& OutDenseIndices) const
+{
+	OutDenseIndices.Reset(HexCoords.Num());
+	for (FIntPoint HexCoord : HexCoords)
+	{
+		const int32 DenseIndex = DenseLayout.IndexOf(HexCoord);
+		if (DenseIndex != INDEX_NONE)
+		{
+			OutDenseIndices.Add(DenseIndex);
+		}
+	}
+}
+
+void UHxlbHexMapComponent::RebuildDistanceField(FName LayerName, FHxlbDistanceField& Field, TConstArrayView<int32> SourceIndices, bool bWeighted)
+{
+	if (bWeighted)
+	{
+		Field.Build(GetCostField(), SourceIndices);
+	}
+	else
+	{
+		Field.Build(DenseLayout, SourceIndices);
+	}
+	WriteDistanceLayer(LayerName, Field, true);
+}
+
+void UHxlbHexMapComponent::WriteDistanceLayer(FName LayerName, const FHxlbDistanceField& Field, bool bAllChanged)
+{
+	THxlbHexLayer<float>* Layer = FindLayer<float>(LayerName);
+	if (!Layer)
+	{
+		return;
+	}
+	
+	if (bAllChanged)
+	{
+		TArrayView<float> Values = Layer->GetMutableValues();
+		FMemory::Memcpy(Values.GetData(), Field.GetDistances().GetData(), Values.Num() * sizeof(float));
+		Layer->MarkAllChanged();
+	}
+	else
+	{
+		for (int32 DenseIndex : Field.GetUpdatedHexes())
+		{
+			Layer->Set(DenseIndex, Field.GetDistance(DenseIndex));
+		}
+	}
+	Layer->CommitChanges();
+}
+
+const FHxlbHexStencil& UHxlbHexMapComponent::GetStencil()
+{
+	if (!Stencil.IsInitialized())
+	{
+		Stencil.Init(DenseLayout);
+	}
+	return Stencil;
+}
+
+void UHxlbHexMapComponent::GenerateMap(const FHxlbMapGenerator& Generator, int32 Seed)
+{
+	if (!DenseLayout.IsValid())
+	{
+		return;
+	}
+	
+	FHxlbMapGenContext Context(DenseLayout, HexLayers, Seed);
+	Generator.Run(Context);
+	for (FName LayerName : Context.GetWrittenLayers())
+	{
+		FindLayerBase(LayerName)->CommitChanges();
+	}
+	if (FindLayerBase(kMovementCostLayerName))
+	{
+		CompileCostLayer();
+	}
+}
+
+void UHxlbHexMapComponent::BindVisionLayers()
+{
+	for (FName LayerName : {MapSettings.VisionSettings.ElevationLayerName, MapSettings.VisionSettings.OpacityLayerName})
+	{
+		FHxlbHexLayerBase* Layer = FindLayerBase(LayerName);
+		if (Layer && !VisionLayerBindings.Contains(LayerName))
+		{
+			VisionLayerBindings.Add(LayerName, Layer->OnChanged.AddUObject(this, &UHxlbHexMapComponent::OnVisionLayerChanged));
+		}
+	}
+}
+
+void UHxlbHexMapComponent::OnVisionLayerChanged(const FHxlbHexLayerBase& Layer, TConstArrayView<int32> ChangedIndices, bool bAllChanged)
+{
+	if (bAllChanged)
+	{
+		FogOfWar.MarkAllChanged();
+		CoverMap.MarkAllChanged();
+	}
+	else
+	{
+		FogOfWar.MarkHexesChanged(ChangedIndices);
+		CoverMap.MarkHexesChanged(ChangedIndices);
+	}
+}
+
+void UHxlbHexMapComponent::BindMovementCostLayer()
+{
+	if (!GetCostField().IsValid())
+	{
+		CompileCostLayer();
+	}
+	
+	THxlbHexLayer<float>* CostLayer = FindLayer<float>(kMovementCostLayerName);
+	if (CostLayer && !MovementCostBinding.IsValid())
+	{
+		MovementCostBinding = CostLayer->OnChanged.AddUObject(this, &UHxlbHexMapComponent::OnMovementCostsChanged);
+	}
+}
+
+void UHxlbHexMapComponent::OnMovementCostsChanged(const FHxlbHexLayerBase& Layer, TConstArrayView<int32> ChangedIndices, bool bAllChanged)
+{
+	if (bAllChanged)
+	{
+		// Cached flow fields are cheap to drop and are rebuilt the next time someone asks for them.
+		FlowFieldCache.Reset();
+		MovementRange.Reset();
+		InfluenceMap.MarkAllChanged();
+
+		// The layout may have changed too, so the landmarks themselves are picked again.
+		Landmarks.Reset();
+	}
+	else
+	{
+		FlowFieldCache.MarkHexesChanged(ChangedIndices);
+		Landmarks.MarkDirty();
+		InfluenceMap.MarkHexesChanged(ChangedIndices);
+		if (MovementRange.IsBuilt())
+		{
+			MovementRange.UpdateHexes(GetCostField(), ChangedIndices);
+		}
+	}
+	for (const auto& AgentPathKV : AgentPaths)
+	{
+		FHxlbIncrementalPathfinder& Planner = *AgentPathKV.Value;
+		if (bAllChanged)
+		{
+			// Start over, since the layout may have changed too. Planners whose ends fell off the map stay invalid.
+			Planner.Init(GetCostField(), Planner.GetStart(), Planner.GetGoal());
+		}
+		else
+		{
+			Planner.UpdateCosts(GetCostField(), ChangedIndices);
+		}
+	}
+	for (const auto& FieldKV : DistanceFields)
+	{
+		// A cost change can shift distances anywhere downstream of it, so weighted fields are simply rebuilt, even for a
+		// single changed hex. They are not rebuilt lazily like the landmarks, since their layers are read directly.
+		if (FieldKV.Value->IsWeighted())
+		{
+			const TArray<int32> Sources(FieldKV.Value->GetSources());
+			RebuildDistanceField(FieldKV.Key, *FieldKV.Value, Sources, true);
+		}
+	}
+	
+	if (!HierarchicalPathfinder)
+	{
+		return;
+	}
+	
+	if (bAllChanged)
+	{
+		HierarchicalPathfinder->Build(GetCostField());
+	}
+	else
+	{
+		HierarchicalPathfinder->MarkHexesChanged(ChangedIndices);
+		HierarchicalPathfinder->Repair(GetCostField());
+	}
+}
+
+void UHxlbHexMapComponent::GatherCostLayers(TArray<const THxlbHexLayer<float>*>& OutCostLayers) const
+{
+	for (const FHxlbLayerMovementCost& LayerCost : MapSettings.MovementCostSettings.LayerCosts)
+	{
+		const THxlbHexLayer<float>* Layer = FindLayer<float>(LayerCost.LayerName);
+		if (!Layer)
+		{
+			HXLB_LOG(LogHxlbRuntime, Warning, TEXT("Movement cost references hex layer %s, which doesn't exist or doesn't hold floats."), *LayerCost.LayerName.ToString());
+		}
+		OutCostLayers.Add(Layer);
+	}
+}
+
+float UHxlbHexMapComponent::ComputeHexCost(int32 DenseIndex, const UHxlbHex* Hex, TConstArrayView<const THxlbHexLayer<float>*> CostLayers) const
+{
+	const FHxlbMovementCostSettings& Settings = MapSettings.MovementCostSettings;
+	float Cost = Settings.BaseCost;
+
+	// CostLayers lines up with Settings.LayerCosts, with nullptr for layers that are missing.
+	for (int32 LayerIndex = 0; LayerIndex < CostLayers.Num(); LayerIndex++)
+	{
+		if (!CostLayers[LayerIndex])
+		{
+			continue;
+		}
+		
+		const FHxlbLayerMovementCost& LayerCost = Settings.LayerCosts[LayerIndex];
+		const float Value = CostLayers[LayerIndex]->Get(DenseIndex);
+		if (LayerCost.bBlockAboveThreshold && Value >= LayerCost.BlockingThreshold)
+		{
+			return HxlbMovementCost::Blocked;
+		}
+		Cost += Value * LayerCost.CostPerUnit;
+	}
+
+	if (Hex)
+	{
+		for (const FHxlbTagMovementCost& TagCost : Settings.TagCosts)
+		{
+			if (!Hex->GameplayTags.HasTag(TagCost.Tag))
+			{
+				continue;
+			}
+			if (TagCost.bBlocksMovement)
+			{
+				return HxlbMovementCost::Blocked;
+			}
+			Cost += TagCost.AdditionalCost;
+		}
+	}
+	
+	return FMath::Max(Cost, Settings.MinimumCost);
 }
 
 bool UHxlbHexMapComponent::IsValidAxialCoord(FIntPoint AxialCoord)
@@ -88,23 +1081,9 @@ bool UHxlbHexMapComponent::IsValidAxialCoord(FIntPoint AxialCoord)
 			return false;
 		}
 		
-		// Check valid in landscape (note: this assumes 0,0 is in the center of the landscape)
-		if (LandscapeHalfLengthCm > 0)
+		if (!IsWithinLandscapeBounds(AxialCoord))
 		{
-			FVector WorldCoord = HexMath::AxialToWorld(AxialCoord, MapSettings.HexSize);
-			if (
-				WorldCoord.X < -LandscapeHalfLengthCm ||
-				WorldCoord.X > LandscapeHalfLengthCm ||
-				WorldCoord.Y < -LandscapeHalfLengthCm ||
-				WorldCoord.Y > LandscapeHalfLengthCm
-			)
-			{
-				return false;
-			}
-		}
-		else
-		{
-			HXLB_LOG(LogHxlbRuntime, Error, TEXT("LandscapeHalfLengthCm is not initialized. Skipping landscape bounds check."));
+			return false;
 		}
 	}
 	
@@ -134,6 +1113,24 @@ bool UHxlbHexMapComponent::IsValidAxialCoord(FIntPoint AxialCoord)
 	return false;
 }
 
+bool UHxlbHexMapComponent::IsWithinLandscapeBounds(FIntPoint AxialCoord) const
+{
+	// Check valid in landscape (note: this assumes 0,0 is in the center of the landscape)
+	if (LandscapeHalfLengthCm > 0)
+	{
+		FVector WorldCoord = HexMath::AxialToWorld(AxialCoord, MapSettings.HexSize);
+		return (
+			WorldCoord.X >= -LandscapeHalfLengthCm &&
+			WorldCoord.X <= LandscapeHalfLengthCm &&
+			WorldCoord.Y >= -LandscapeHalfLengthCm &&
+			WorldCoord.Y <= LandscapeHalfLengthCm
+		);
+	}
+
+	HXLB_LOG(LogHxlbRuntime, Error, TEXT("LandscapeHalfLengthCm is not initialized. Skipping landscape bounds check."));
+	return true;
+}
+
 UHxlbHexIteratorWrapper* UHxlbHexMapComponent::GetGridIterator(FIntPoint CameraCoord)
 {
 	switch (MapSettings.Shape)
@@ -229,6 +1226,11 @@ void UHxlbHexMapComponent::CommitBulkEdits()
 void UHxlbHexMapComponent::Update(FHxlbMapSettings& NewMapSettings, FHxlbHexMapUpdateOptions UpdateOptions)
 {
 	MapSettings = NewMapSettings;
+	// Cost settings may have changed even if the map shape didn't.
+	if (!RebuildDenseLayout() && FindLayerBase(kMovementCostLayerName))
+	{
+		CompileCostLayer();
+	}
 	
 	if (UpdateOptions.bForceLandscapeRTRefresh)
 	{
@@ -521,32 +1523,73 @@ void UHxlbHexMapComponent::RefreshGridlines()
 			// 3) only loop through valid hexes					| 29 us (RTF_R8, 4K)
 			TRACE_CPUPROFILER_EVENT_SCOPE(HXLB_HexCoordValidation);
 
-			auto Iterator = GetGridIterator(FIntPoint::ZeroValue);
-			int32 InvalidTextureCoords = 0;
-			int32 InvalidBufferIndices = 0;
-			while(Iterator && Iterator->Next())
+			// Validation runs in parallel over the dense layout. Each hex only writes to its own slot, and the slots are
+			// then compacted in dense order, so FullHexes comes out identical no matter how the work was scheduled.
+			static constexpr int32 kOutsideMap = -1;
+			static constexpr int32 kInvalidTextureCoord = -2;
+			static constexpr int32 kInvalidBufferIndex = -3;
+			
+			const bool bIsLandscapeMode = MapSettings.GridMode == EHexGridMode::Landscape;
+			const int32 SizeX = PerHexDataRT->SizeX;
+			const int32 SizeY = PerHexDataRT->SizeY;
+			
+			TArray<int32> HexBufferIndices;
+			HexBufferIndices.SetNumUninitialized(DenseLayout.Num());
+			
+			HxlbParallelForEachHex(DenseLayout, [&](FIntPoint HexCoord, int32 DenseIndex)
 			{
-				FIntPoint HexCoord = Iterator->Get();
-				if (!IsValidAxialCoord(HexCoord))
+				if (bIsLandscapeMode && !IsWithinLandscapeBounds(HexCoord))
 				{
-					continue;
+					HexBufferIndices[DenseIndex] = kOutsideMap;
+					return;
 				}
 				FIntPoint TextureCoord;
-				if (!HexMath::AxialToTexture(HexCoord, PerHexDataRT->SizeX, PerHexDataRT->SizeY, TextureCoord))
+				if (!HexMath::AxialToTexture(HexCoord, SizeX, SizeY, TextureCoord))
 				{
-					InvalidTextureCoords++;
-					continue;
+					// In landscape mode, hexes that don't fit in the texture are outside of the map (see IsValidAxialCoord).
+					HexBufferIndices[DenseIndex] = bIsLandscapeMode ? kOutsideMap : kInvalidTextureCoord;
+					return;
 				}
 
-				int32 BufferIndex = HexMath::TextureToPixelBuffer(TextureCoord, PerHexDataRT->SizeX);
-				if (BufferIndex < 0 || BufferIndex >= PerHexDataRT->SizeX * PerHexDataRT->SizeY)
+				int32 BufferIndex = HexMath::TextureToPixelBuffer(TextureCoord, SizeX);
+				if (BufferIndex < 0 || BufferIndex >= SizeX * SizeY)
 				{
-					InvalidBufferIndices++;
-					continue;
+					HexBufferIndices[DenseIndex] = kInvalidBufferIndex;
+					return;
 				}
+				HexBufferIndices[DenseIndex] = BufferIndex;
+			});
+
+			int32 InvalidTextureCoords = 0;
+			int32 InvalidBufferIndices = 0;
+			FullHexes.Reserve(DenseLayout.Num());
+			
+			for (int32 RowIndex = 0; RowIndex < DenseLayout.NumRows(); RowIndex++)
+			{
+				const FHxlbHexRowSpan& Row = DenseLayout.GetRow(RowIndex);
+				int32 DenseIndex = DenseLayout.GetRowStart(RowIndex);
+				
+				for (int32 Q = Row.QMin; Q <= Row.QMax; Q++, DenseIndex++)
+				{
+					const int32 BufferIndex = HexBufferIndices[DenseIndex];
+					if (BufferIndex == kInvalidTextureCoord)
+					{
+						InvalidTextureCoords++;
+						continue;
+					}
+					if (BufferIndex == kInvalidBufferIndex)
+					{
+						InvalidBufferIndices++;
+						continue;
+					}
+					if (BufferIndex < 0)
+					{
+						continue;
+					}
 
-				HexInfoBuffer[BufferIndex].EdgeFlags = HxlbPackedData::FM_EdgeFlags;
-				FullHexes.Add(HexCoord);
+					HexInfoBuffer[BufferIndex].EdgeFlags = HxlbPackedData::FM_EdgeFlags;
+					FullHexes.Add(FIntPoint(Q, Row.R));
+				}
 			}
 
 			if (InvalidTextureCoords > 0)
@@ -0,0 +1,479 @@
+// Copyright © Mason Stevenson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the disclaimer
+// below) provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+// THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+// CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+// NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "Foundation/HxlbHexQueryBuilder.h"
+
+#include "Async/Async.h"
+#include "HexLibRuntimeLoggingDefs.h"
+#include "Macros/HexLibLoggingMacros.h"
+#include "Math/VectorRegister.h"
+
+using HexMath = UHxlbMath;
+
+namespace
+{
+	// Compares four values at a time. The last, partial group is compared from a padded copy so that nothing past the
+	// end of the layer is read.
+	template <typename CompareType>
+	FORCEINLINE uint64 CompareFloats(const float* Values, int32 Count, float Operand, CompareType&& Compare)
+	{
+		const VectorRegister4Float OperandVector = VectorSetFloat1(Operand);
+		uint64 Bits = 0;
+		int32 Index = 0;
+		for (; Index + 4 <= Count; Index += 4)
+		{
+			Bits |= static_cast<uint64>(VectorMaskBits(Compare(VectorLoad(Values + Index), OperandVector))) << Index;
+		}
+		if (Index < Count)
+		{
+			float Tail[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+			FMemory::Memcpy(Tail, Values + Index, (Count - Index) * sizeof(float));
+			const uint64 TailBits = VectorMaskBits(Compare(VectorLoad(Tail), OperandVector));
+			Bits |= (TailBits & ((static_cast<uint64>(1) << (Count - Index)) - 1)) << Index;
+		}
+		return Bits;
+	}
+
+	template <typename CompareType>
+	FORCEINLINE uint64 CompareInts(const int32* Values, int32 Count, int32 Operand, CompareType&& Compare)
+	{
+		const VectorRegister4Int OperandVector = VectorIntSet1(Operand);
+		uint64 Bits = 0;
+		int32 Index = 0;
+		for (; Index + 4 <= Count; Index += 4)
+		{
+			Bits |= static_cast<uint64>(VectorMaskBits(VectorCastIntToFloat(Compare(VectorIntLoad(Values + Index), OperandVector)))) << Index;
+		}
+		if (Index < Count)
+		{
+			int32 Tail[4] = {0, 0, 0, 0};
+			FMemory::Memcpy(Tail, Values + Index, (Count - Index) * sizeof(int32));
+			const uint64 TailBits = VectorMaskBits(VectorCastIntToFloat(Compare(VectorIntLoad(Tail), OperandVector)));
+			Bits |= (TailBits & ((static_cast<uint64>(1) << (Count - Index)) - 1)) << Index;
+		}
+		return Bits;
+	}
+
+	FORCEINLINE uint64 LowBits(int32 Count)
+	{
+		return Count >= FHxlbHexBitmap::kBitsPerWord ? ~static_cast<uint64>(0) : (static_cast<uint64>(1) << Count) - 1;
+	}
+
+	struct FRankedHex
+	{
+		float Key = 0.0f;
+		int32 DenseIndex = INDEX_NONE;
+
+		bool operator<(const FRankedHex& Other) const
+		{
+			return Key < Other.Key || (Key == Other.Key && DenseIndex < Other.DenseIndex);
+		}
+	};
+}
+
+FHxlbHexQueryBuilder& FHxlbHexQueryBuilder::InRadius(FIntPoint Origin, int32 Radius, int32 MinRadius)
+{
+	if (MinRadius <= 0)
+	{
+		return InShape(HxlbShapes::Spans(FHxlbRadialRange(Origin, Radius)));
+	}
+	return InShape(HxlbShapes::Subtract(
+		HxlbShapes::Spans(FHxlbRadialRange(Origin, Radius)),
+		HxlbShapes::Spans(FHxlbRadialRange(Origin, MinRadius - 1))
+	));
+}
+
+FHxlbHexQueryBuilder& FHxlbHexQueryBuilder::InSet(const FHxlbHexBitmap& Hexes)
+{
+	ResetSource(ESource::Set);
+	SourceSet = &Hexes;
+	if (Hexes.Num() != Layout->Num())
+	{
+		HXLB_LOG(LogHxlbRuntime, Error, TEXT("FHxlbHexQueryBuilder::InSet(): The set covers %d hexes, but the map has %d."), Hexes.Num(), Layout->Num());
+		bMatchesNothing = true;
+	}
+	return *this;
+}
+
+FHxlbHexQueryBuilder& FHxlbHexQueryBuilder::InQueryResult(const FHxlbQueryResult& Result)
+{
+	ResetSource(ESource::Runs);
+	SourceRuns.Append(Result.GetRuns());
+	return *this;
+}
+
+FHxlbHexQueryBuilder& FHxlbHexQueryBuilder::Where(const THxlbHexLayer<float>& Layer, EHxlbCompareOp Op, float Value)
+{
+	if (!CheckLayer(Layer))
+	{
+		return *this;
+	}
+	if (Op == EHxlbCompareOp::HasAnyBits || Op == EHxlbCompareOp::HasNoBits)
+	{
+		HXLB_LOG(LogHxlbRuntime, Error, TEXT("FHxlbHexQueryBuilder::Where(): Bit tests need an int32 layer, but %s holds floats."), *Layer.GetName().ToString());
+		bMatchesNothing = true;
+		return *this;
+	}
+
+	FColumnPredicate& Predicate = ColumnPredicates.AddDefaulted_GetRef();
+	Predicate.Op = Op;
+	Predicate.Floats = Layer.GetValues().GetData();
+	Predicate.FloatOperand = Value;
+	return *this;
+}
+
+FHxlbHexQueryBuilder& FHxlbHexQueryBuilder::Where(const THxlbHexLayer<int32>& Layer, EHxlbCompareOp Op, int32 Value)
+{
+	if (!CheckLayer(Layer))
+	{
+		return *this;
+	}
+
+	FColumnPredicate& Predicate = ColumnPredicates.AddDefaulted_GetRef();
+	Predicate.Op = Op;
+	Predicate.Ints = Layer.GetValues().GetData();
+	Predicate.IntOperand = Value;
+	return *this;
+}
+
+FHxlbHexQueryBuilder& FHxlbHexQueryBuilder::WhereIn(const FHxlbHexBitmap& Hexes)
+{
+	if (Hexes.Num() != Layout->Num())
+	{
+		// A set that doesn't cover the map has none of its hexes.
+		bMatchesNothing = true;
+		return *this;
+	}
+	SetPredicates.Add({Hexes.GetWords().GetData(), false});
+	return *this;
+}
+
+FHxlbHexQueryBuilder& FHxlbHexQueryBuilder::WhereNotIn(const FHxlbHexBitmap& Hexes)
+{
+	if (Hexes.Num() == Layout->Num())
+	{
+		SetPredicates.Add({Hexes.GetWords().GetData(), true});
+	}
+	return *this;
+}
+
+FHxlbHexQueryBuilder& FHxlbHexQueryBuilder::OrderByDistance(FIntPoint Origin)
+{
+	Order = EOrder::Distance;
+	OrderOrigin = Origin;
+	return *this;
+}
+
+FHxlbHexQueryBuilder& FHxlbHexQueryBuilder::OrderBy(const THxlbHexLayer<float>& Layer, bool bDescending)
+{
+	if (CheckLayer(Layer))
+	{
+		Order = bDescending ? EOrder::LayerDescending : EOrder::LayerAscending;
+		OrderValues = Layer.GetValues().GetData();
+	}
+	return *this;
+}
+
+FHxlbHexQueryBuilder& FHxlbHexQueryBuilder::Limit(int32 NewMaxResults)
+{
+	MaxResults = FMath::Max(0, NewMaxResults);
+	return *this;
+}
+
+int32 FHxlbHexQueryBuilder::Execute(FHxlbHexBitmap& OutHexes) const
+{
+	TArray<uint64> Words;
+	int32 FirstWord = 0;
+	Evaluate(Words, FirstWord);
+
+	OutHexes.Init(Layout->Num());
+	if (Words.IsEmpty())
+	{
+		return 0;
+	}
+	
+	TArrayView<uint64> TargetWords = OutHexes.GetMutableWords();
+	FMemory::Memcpy(&TargetWords[FirstWord], Words.GetData(), Words.Num() * sizeof(uint64));
+	
+	int32 NumMatches = 0;
+	for (uint64 Word : Words)
+	{
+		NumMatches += static_cast<int32>(FMath::CountBits(Word));
+	}
+	return NumMatches;
+}
+
+void FHxlbHexQueryBuilder::Execute(TArray<int32>& OutDenseIndices) const
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(HXLB_HexQuery);
+	
+	OutDenseIndices.Reset();
+	TArray<uint64> Words;
+	int32 FirstWord = 0;
+	Evaluate(Words, FirstWord);
+
+	if (Order == EOrder::None)
+	{
+		for (int32 WordIndex = 0; WordIndex < Words.Num(); WordIndex++)
+		{
+			uint64 Word = Words[WordIndex];
+			while (Word)
+			{
+				if (MaxResults > 0 && OutDenseIndices.Num() == MaxResults)
+				{
+					return;
+				}
+				OutDenseIndices.Add((FirstWord + WordIndex) * FHxlbHexBitmap::kBitsPerWord + static_cast<int32>(FMath::CountTrailingZeros64(Word)));
+				Word &= Word - 1;
+			}
+		}
+		return;
+	}
+
+	// With a limit, only the best MaxResults hexes are kept, in a heap whose top is the worst of them.
+	const auto WorstFirst = [](const FRankedHex& A, const FRankedHex& B) { return B < A; };
+	TArray<FRankedHex> Ranked;
+	for (int32 WordIndex = 0; WordIndex < Words.Num(); WordIndex++)
+	{
+		uint64 Word = Words[WordIndex];
+		while (Word)
+		{
+			FRankedHex Hex;
+			Hex.DenseIndex = (FirstWord + WordIndex) * FHxlbHexBitmap::kBitsPerWord + static_cast<int32>(FMath::CountTrailingZeros64(Word));
+			Word &= Word - 1;
+			switch (Order)
+			{
+			case EOrder::Distance:
+				Hex.Key = static_cast<float>(HexMath::AxialDistanceFast(Layout->CoordOf(Hex.DenseIndex), OrderOrigin));
+				break;
+			case EOrder::LayerAscending:
+				Hex.Key = OrderValues[Hex.DenseIndex];
+				break;
+			default:
+				Hex.Key = -OrderValues[Hex.DenseIndex];
+				break;
+			}
+			
+			if (MaxResults <= 0)
+			{
+				Ranked.Add(Hex);
+			}
+			else if (Ranked.Num() < MaxResults)
+			{
+				Ranked.HeapPush(Hex, WorstFirst);
+			}
+			else if (Hex < Ranked.HeapTop())
+			{
+				Ranked.HeapPopDiscard(WorstFirst, EAllowShrinking::No);
+				Ranked.HeapPush(Hex, WorstFirst);
+			}
+		}
+	}
+	
+	Ranked.Sort();
+	OutDenseIndices.Reserve(Ranked.Num());
+	for (const FRankedHex& Hex : Ranked)
+	{
+		OutDenseIndices.Add(Hex.DenseIndex);
+	}
+}
+
+TFuture<TArray<int32>> FHxlbHexQueryBuilder::ExecuteAsync() const
+{
+	return Async(EAsyncExecution::ThreadPool, [Query = *this]()
+	{
+		TArray<int32> DenseIndices;
+		Query.Execute(DenseIndices);
+		return DenseIndices;
+	});
+}
+
+void FHxlbHexQueryBuilder::ResetSource(ESource NewSource)
+{
+	Source = NewSource;
+	SourceRuns.Reset();
+	SourceSet = nullptr;
+}
+
+bool FHxlbHexQueryBuilder::CheckLayer(const FHxlbHexLayerBase& Layer)
+{
+	if (Layer.Num() != Layout->Num())
+	{
+		HXLB_LOG(LogHxlbRuntime, Error, TEXT("FHxlbHexQueryBuilder: Layer %s has %d values, but the map has %d hexes."), *Layer.GetName().ToString(), Layer.Num(), Layout->Num());
+		bMatchesNothing = true;
+		return false;
+	}
+	return true;
+}
+
+void FHxlbHexQueryBuilder::Evaluate(TArray<uint64>& OutWords, int32& OutFirstWord) const
+{
+	constexpr int32 kBitsPerWord = FHxlbHexBitmap::kBitsPerWord;
+	
+	OutWords.Reset();
+	OutFirstWord = 0;
+	const int32 NumHexes = Layout->Num();
+	if (bMatchesNothing || NumHexes == 0)
+	{
+		return;
+	}
+
+	// Candidates, over the words that the source touches.
+	switch (Source)
+	{
+	case ESource::WholeMap:
+	{
+		OutWords.Init(~static_cast<uint64>(0), FHxlbHexBitmap::NumWordsFor(NumHexes));
+		OutWords.Last() = LowBits(NumHexes - (OutWords.Num() - 1) * kBitsPerWord);
+		break;
+	}
+	case ESource::Runs:
+	{
+		if (SourceRuns.IsEmpty())
+		{
+			return;
+		}
+		const FHxlbDenseRun& LastRun = SourceRuns.Last();
+		OutFirstWord = SourceRuns[0].First / kBitsPerWord;
+		OutWords.SetNumZeroed((LastRun.First + LastRun.Num - 1) / kBitsPerWord - OutFirstWord + 1);
+		
+		const int32 FirstBit = OutFirstWord * kBitsPerWord;
+		for (const FHxlbDenseRun& Run : SourceRuns)
+		{
+			for (int32 Offset = 0; Offset < Run.Num; Offset += kBitsPerWord)
+			{
+				const int32 Count = FMath::Min(kBitsPerWord, Run.Num - Offset);
+				FHxlbHexBitmap::OrWordBits(OutWords, Run.First + Offset - FirstBit, LowBits(Count), Count);
+			}
+		}
+		break;
+	}
+	case ESource::Set:
+	{
+		TConstArrayView<uint64> SetWords = SourceSet->GetWords();
+		int32 EndWord = SetWords.Num();
+		while (OutFirstWord < EndWord && SetWords[OutFirstWord] == 0)
+		{
+			OutFirstWord++;
+		}
+		while (EndWord > OutFirstWord && SetWords[EndWord - 1] == 0)
+		{
+			EndWord--;
+		}
+		OutWords.Append(SetWords.Slice(OutFirstWord, EndWord - OutFirstWord));
+		break;
+	}
+	}
+	if (SetPredicates.IsEmpty() && ColumnPredicates.IsEmpty())
+	{
+		return;
+	}
+
+	// One task per block of words, so that no two tasks write the same word.
+	const int32 FirstWord = OutFirstWord;
+	ParallelFor(FMath::DivideAndRoundUp(OutWords.Num(), kWordsPerTask), [this, &OutWords, FirstWord, NumHexes](int32 TaskIndex)
+	{
+		const int32 EndWord = FMath::Min(OutWords.Num(), (TaskIndex + 1) * kWordsPerTask);
+		for (int32 WordIndex = TaskIndex * kWordsPerTask; WordIndex < EndWord; WordIndex++)
+		{
+			uint64 Word = OutWords[WordIndex];
+			for (const FSetPredicate& Predicate : SetPredicates)
+			{
+				if (!Word)
+				{
+					break;
+				}
+				const uint64 SetWord = Predicate.Words[FirstWord + WordIndex];
+				Word &= Predicate.bNegate ? ~SetWord : SetWord;
+			}
+			
+			const int32 FirstIndex = (FirstWord + WordIndex) * kBitsPerWord;
+			const int32 Count = FMath::Min(kBitsPerWord, NumHexes - FirstIndex);
+			for (const FColumnPredicate& Predicate : ColumnPredicates)
+			{
+				if (!Word)
+				{
+					break;
+				}
+				Word &= EvaluateColumn(Predicate, FirstIndex, Count);
+			}
+			OutWords[WordIndex] = Word;
+		}
+	}, OutWords.Num() <= kWordsPerTask ? EParallelForFlags::ForceSingleThread : EParallelForFlags::None);
+}
+
+uint64 FHxlbHexQueryBuilder::EvaluateColumn(const FColumnPredicate& Predicate, int32 FirstIndex, int32 Count)
+{
+	if (Predicate.Floats)
+	{
+		const float* Values = Predicate.Floats + FirstIndex;
+		switch (Predicate.Op)
+		{
+		case EHxlbCompareOp::Equal:
+			return CompareFloats(Values, Count, Predicate.FloatOperand, [](const VectorRegister4Float& A, const VectorRegister4Float& B) { return VectorCompareEQ(A, B); });
+		case EHxlbCompareOp::NotEqual:
+			return CompareFloats(Values, Count, Predicate.FloatOperand, [](const VectorRegister4Float& A, const VectorRegister4Float& B) { return VectorCompareNE(A, B); });
+		case EHxlbCompareOp::Less:
+			return CompareFloats(Values, Count, Predicate.FloatOperand, [](const VectorRegister4Float& A, const VectorRegister4Float& B) { return VectorCompareLT(A, B); });
+		case EHxlbCompareOp::LessOrEqual:
+			return CompareFloats(Values, Count, Predicate.FloatOperand, [](const VectorRegister4Float& A, const VectorRegister4Float& B) { return VectorCompareLE(A, B); });
+		case EHxlbCompareOp::Greater:
+			return CompareFloats(Values, Count, Predicate.FloatOperand, [](const VectorRegister4Float& A, const VectorRegister4Float& B) { return VectorCompareGT(A, B); });
+		case EHxlbCompareOp::GreaterOrEqual:
+			return CompareFloats(Values, Count, Predicate.FloatOperand, [](const VectorRegister4Float& A, const VectorRegister4Float& B) { return VectorCompareGE(A, B); });
+		default:
+			return 0;
+		}
+	}
+
+	const int32* Values = Predicate.Ints + FirstIndex;
+	switch (Predicate.Op)
+	{
+	case EHxlbCompareOp::Equal:
+		return CompareInts(Values, Count, Predicate.IntOperand, [](const VectorRegister4Int& A, const VectorRegister4Int& B) { return VectorIntCompareEQ(A, B); });
+	case EHxlbCompareOp::NotEqual:
+		return CompareInts(Values, Count, Predicate.IntOperand, [](const VectorRegister4Int& A, const VectorRegister4Int& B) { return VectorIntCompareNEQ(A, B); });
+	case EHxlbCompareOp::Less:
+		return CompareInts(Values, Count, Predicate.IntOperand, [](const VectorRegister4Int& A, const VectorRegister4Int& B) { return VectorIntCompareLT(A, B); });
+	case EHxlbCompareOp::LessOrEqual:
+		return CompareInts(Values, Count, Predicate.IntOperand, [](const VectorRegister4Int& A, const VectorRegister4Int& B) { return VectorIntCompareLE(A, B); });
+	case EHxlbCompareOp::Greater:
+		return CompareInts(Values, Count, Predicate.IntOperand, [](const VectorRegister4Int& A, const VectorRegister4Int& B) { return VectorIntCompareGT(A, B); });
+	case EHxlbCompareOp::GreaterOrEqual:
+		return CompareInts(Values, Count, Predicate.IntOperand, [](const VectorRegister4Int& A, const VectorRegister4Int& B) { return VectorIntCompareGE(A, B); });
+	case EHxlbCompareOp::HasAnyBits:
+		return CompareInts(Values, Count, Predicate.IntOperand, [](const VectorRegister4Int& A, const VectorRegister4Int& B) { return VectorIntCompareNEQ(VectorIntAnd(A, B), VectorIntSet1(0)); });
+	case EHxlbCompareOp::HasNoBits:
+		return CompareInts(Values, Count, Predicate.IntOperand, [](const VectorRegister4Int& A, const VectorRegister4Int& B) { return VectorIntCompareEQ(VectorIntAnd(A, B), VectorIntSet1(0)); });
+	default:
+		return 0;
+	}
+}
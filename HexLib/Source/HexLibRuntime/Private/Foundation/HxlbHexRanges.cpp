@@ -0,0 +1,177 @@
+// Copyright © Mason Stevenson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the disclaimer
+// below) provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+// THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+// CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+// NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "Foundation/HxlbHexRanges.h"
+
+using FLayout = FHxlbDenseLayout;
+
+FHxlbRadialRange::FHxlbRadialRange(FIntPoint NewOrigin, int32 NewRadius)
+{
+	if (NewRadius < 0)
+	{
+		return;
+	}
+
+	Origin = NewOrigin;
+	Radius = NewRadius;
+	RowBegin = 0;
+	RowEnd = 2 * Radius + 1;
+}
+
+FHxlbHexRowSpan FHxlbRadialRange::GetRow(int32 RowIndex) const
+{
+	const int32 R = RowBegin + RowIndex - Radius;
+	const int32 QMin = FMath::Max(-Radius, -R - Radius);
+	const int32 QMax = FMath::Min(Radius, -R + Radius);
+	return FHxlbHexRowSpan(HEX_R(Origin) + R, HEX_Q(Origin) + QMin, HEX_Q(Origin) + QMax);
+}
+
+FHxlbRadialRange FHxlbRadialRange::Slice(int32 NewRowBegin, int32 NewRowEnd) const
+{
+	FHxlbRadialRange Result = *this;
+	NewRowBegin = FMath::Clamp(NewRowBegin, 0, NumRows());
+	Result.RowBegin = RowBegin + NewRowBegin;
+	Result.RowEnd = RowBegin + FMath::Clamp(NewRowEnd, NewRowBegin, NumRows());
+	return Result;
+}
+
+int32 FHxlbRadialRange::CountBefore(int32 AbsoluteRow) const
+{
+	if (Radius < 0 || AbsoluteRow <= 0)
+	{
+		return 0;
+	}
+	
+	// Rows grow from Radius + 1 hexes up to 2 * Radius + 1 in the middle row, then shrink again symmetrically.
+	const int32 TopHalfRows = Radius + 1;
+	if (AbsoluteRow <= TopHalfRows)
+	{
+		return AbsoluteRow * (Radius + 1) + (AbsoluteRow * (AbsoluteRow - 1)) / 2;
+	}
+
+	const int32 Total = 3 * Radius * (Radius + 1) + 1;
+	return Total - CountBefore(2 * Radius + 1 - AbsoluteRow);
+}
+
+FHxlbRectangularRange::FHxlbRectangularRange(FIntPoint NewOrigin, int32 NewHalfWidth, int32 NewHalfHeight)
+{
+	// Matches FHxlbRectangularIterator, which treats anything smaller than 1x1 as an empty shape.
+	if (NewHalfWidth < 1 || NewHalfHeight < 1)
+	{
+		return;
+	}
+
+	Origin = NewOrigin;
+	HalfWidth = NewHalfWidth;
+	HalfHeight = NewHalfHeight;
+	RowBegin = 0;
+	RowEnd = 2 * HalfHeight + 1;
+}
+
+FHxlbHexRowSpan FHxlbRectangularRange::GetRow(int32 RowIndex) const
+{
+	// pointy algo
+	const int32 R = RowBegin + RowIndex - HalfHeight;
+	const int32 Shift = FLayout::FloorHalf(R);
+	return FHxlbHexRowSpan(HEX_R(Origin) + R, HEX_Q(Origin) - HalfWidth - Shift, HEX_Q(Origin) + HalfWidth - Shift);
+}
+
+FHxlbRectangularRange FHxlbRectangularRange::Slice(int32 NewRowBegin, int32 NewRowEnd) const
+{
+	FHxlbRectangularRange Result = *this;
+	NewRowBegin = FMath::Clamp(NewRowBegin, 0, NumRows());
+	Result.RowBegin = RowBegin + NewRowBegin;
+	Result.RowEnd = RowBegin + FMath::Clamp(NewRowEnd, NewRowBegin, NumRows());
+	return Result;
+}
+
+FHxlbChunkedRange::FHxlbChunkedRange(const FHxlbDenseLayout& NewLayout)
+	: FHxlbChunkedRange(NewLayout, 0, NewLayout.NumChunks())
+{
+}
+
+FHxlbChunkedRange::FHxlbChunkedRange(const FHxlbDenseLayout& NewLayout, int32 ChunkBegin, int32 ChunkEnd)
+{
+	Layout = &NewLayout;
+	ChunkBegin = FMath::Clamp(ChunkBegin, 0, NewLayout.NumChunks());
+	ChunkEnd = FMath::Clamp(ChunkEnd, ChunkBegin, NewLayout.NumChunks());
+	RowBegin = ChunkBegin * NewLayout.GetChunkSize();
+	RowEnd = ChunkEnd * NewLayout.GetChunkSize();
+}
+
+FHxlbHexRowSpan FHxlbChunkedRange::GetRow(int32 RowIndex) const
+{
+	if (!Layout)
+	{
+		return FHxlbHexRowSpan();
+	}
+	
+	const int32 AbsoluteRow = RowBegin + RowIndex;
+	return Layout->GetChunkRowSpan(AbsoluteRow / Layout->GetChunkSize(), AbsoluteRow % Layout->GetChunkSize());
+}
+
+int32 FHxlbChunkedRange::Num() const
+{
+	int32 Total = 0;
+	for (int32 RowIndex = 0; RowIndex < NumRows(); ++RowIndex)
+	{
+		Total += GetRow(RowIndex).Num();
+	}
+	return Total;
+}
+
+FHxlbChunkedRange FHxlbChunkedRange::Slice(int32 NewRowBegin, int32 NewRowEnd) const
+{
+	FHxlbChunkedRange Result = *this;
+	NewRowBegin = FMath::Clamp(NewRowBegin, 0, NumRows());
+	Result.RowBegin = RowBegin + NewRowBegin;
+	Result.RowEnd = RowBegin + FMath::Clamp(NewRowEnd, NewRowBegin, NumRows());
+	return Result;
+}
+
+FHxlbChunkedRange FHxlbChunkedRange::SliceChunks(int32 ChunkBegin, int32 ChunkEnd) const
+{
+	if (!Layout)
+	{
+		return *this;
+	}
+	return Slice(ChunkBegin * Layout->GetChunkSize(), ChunkEnd * Layout->GetChunkSize());
+}
+
+int32 FHxlbChunkedRange::NumChunks() const
+{
+	return Layout ? FMath::DivideAndRoundUp(NumRows(), Layout->GetChunkSize()) : 0;
+}
+
+int32 FHxlbChunkedRange::GetChunkIndex(int32 RowIndex) const
+{
+	return Layout ? (RowBegin + RowIndex) / Layout->GetChunkSize() : INDEX_NONE;
+}
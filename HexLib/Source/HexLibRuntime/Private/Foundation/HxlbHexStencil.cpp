@@ -0,0 +1,181 @@
+// Copyright © Mason Stevenson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the disclaimer
+// below) provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+// THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+// CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+// NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "Foundation/HxlbHexStencil.h"
+
+#include "Math/VectorRegister.h"
+
+void FHxlbHexStencil::Init(const FHxlbDenseLayout& NewLayout)
+{
+	Layout = &NewLayout;
+	RowInfos.Reset();
+	RowInfos.SetNum(Layout->NumRows());
+
+	// Dense index of (0, R) if the row extended that far, so that the index of (Q, R) is RowBase + Q.
+	auto RowBase = [this](int32 RowIndex)
+	{
+		return Layout->GetRowStart(RowIndex) - Layout->GetRow(RowIndex).QMin;
+	};
+	
+	for (int32 RowIndex = 0; RowIndex < Layout->NumRows(); RowIndex++)
+	{
+		const FHxlbHexRowSpan& Row = Layout->GetRow(RowIndex);
+		if (RowIndex == 0 || RowIndex == Layout->NumRows() - 1 || Row.IsEmpty())
+		{
+			continue;
+		}
+		const FHxlbHexRowSpan& RowAbove = Layout->GetRow(RowIndex - 1);
+		const FHxlbHexRowSpan& RowBelow = Layout->GetRow(RowIndex + 1);
+		if (RowAbove.IsEmpty() || RowBelow.IsEmpty())
+		{
+			continue;
+		}
+
+		// The row above holds the Q and Q + 1 neighbors, the row below the Q - 1 and Q neighbors.
+		FRowInfo& Info = RowInfos[RowIndex];
+		Info.InteriorQMin = FMath::Max3(Row.QMin + 1, RowAbove.QMin, RowBelow.QMin + 1);
+		Info.InteriorQMax = FMath::Min3(Row.QMax - 1, RowAbove.QMax - 1, RowBelow.QMax);
+		Info.UpOffset = RowBase(RowIndex - 1) - RowBase(RowIndex);
+		Info.DownOffset = RowBase(RowIndex + 1) - RowBase(RowIndex);
+	}
+}
+
+void FHxlbHexStencil::Reset()
+{
+	Layout = nullptr;
+	RowInfos.Reset();
+}
+
+void FHxlbHexStencil::Convolve(TConstArrayView<float> Source, TArrayView<float> Target, float CenterWeight, const float (&NeighborWeights)[6], EHxlbStencilEdge Edge, float EdgeValue) const
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(HXLB_StencilConvolve);
+	check(Source.Num() == Layout->Num() && Target.Num() == Layout->Num());
+
+	const float W0 = NeighborWeights[0], W1 = NeighborWeights[1], W2 = NeighborWeights[2];
+	const float W3 = NeighborWeights[3], W4 = NeighborWeights[4], W5 = NeighborWeights[5];
+	auto Kernel = [CenterWeight, W0, W1, W2, W3, W4, W5](int32 DenseIndex, float Center, const float (&Neighbors)[6])
+	{
+		return Center * CenterWeight + Neighbors[0] * W0 + Neighbors[1] * W1 + Neighbors[2] * W2
+			+ Neighbors[3] * W3 + Neighbors[4] * W4 + Neighbors[5] * W5;
+	};
+	
+	const VectorRegister4Float CenterWeights = VectorSetFloat1(CenterWeight);
+	VectorRegister4Float Weights[6];
+	for (int32 Direction = 0; Direction < 6; Direction++)
+	{
+		Weights[Direction] = VectorSetFloat1(NeighborWeights[Direction]);
+	}
+	
+	HxlbParallelForEachChunk(*Layout, [&](int32 ChunkIndex)
+	{
+		Layout->ForEachChunkSpan(ChunkIndex, [&](const FHxlbHexRowSpan& Span, int32 FirstIndex)
+		{
+			const FRowInfo& Row = RowInfos[Span.R - Layout->GetMinR()];
+			const int32 InteriorBegin = FMath::Clamp(Row.InteriorQMin, Span.QMin, Span.QMax + 1);
+			const int32 InteriorEnd = FMath::Clamp(Row.InteriorQMax + 1, InteriorBegin, Span.QMax + 1);
+			
+			for (int32 Q = Span.QMin; Q < InteriorBegin; ++Q)
+			{
+				ApplyEdgeHex(Source, Target, FIntPoint(Q, Span.R), FirstIndex + (Q - Span.QMin), Kernel, Edge, EdgeValue);
+			}
+
+			// Four hexes at a time. Each neighbor of the four is at the same offset, so they are plain unaligned loads.
+			const float* In = Source.GetData();
+			float* Out = Target.GetData();
+			const int32 Offsets[6] = {1, Row.UpOffset + 1, Row.UpOffset, -1, Row.DownOffset - 1, Row.DownOffset};
+			int32 DenseIndex = FirstIndex + (InteriorBegin - Span.QMin);
+			const int32 EndIndex = FirstIndex + (InteriorEnd - Span.QMin);
+			for (; DenseIndex + 4 <= EndIndex; DenseIndex += 4)
+			{
+				VectorRegister4Float Sum = VectorMultiply(VectorLoad(In + DenseIndex), CenterWeights);
+				for (int32 Direction = 0; Direction < 6; Direction++)
+				{
+					Sum = VectorMultiplyAdd(VectorLoad(In + DenseIndex + Offsets[Direction]), Weights[Direction], Sum);
+				}
+				VectorStore(Sum, Out + DenseIndex);
+			}
+			ApplyInterior(Source, Target, Row, DenseIndex, EndIndex, Kernel);
+			
+			for (int32 Q = InteriorEnd; Q <= Span.QMax; ++Q)
+			{
+				ApplyEdgeHex(Source, Target, FIntPoint(Q, Span.R), FirstIndex + (Q - Span.QMin), Kernel, Edge, EdgeValue);
+			}
+		});
+	});
+}
+
+uint64 FHxlbHexStencil::ReadRowBits(const FHxlbHexBitmap& Bitmap, int32 RowIndex, int32 QStart, int32 Count) const
+{
+	if (RowIndex < 0 || RowIndex >= Layout->NumRows())
+	{
+		return 0;
+	}
+	
+	const FHxlbHexRowSpan& Row = Layout->GetRow(RowIndex);
+	const int32 First = FMath::Max(QStart, Row.QMin);
+	const int32 Last = FMath::Min(QStart + Count - 1, Row.QMax);
+	if (First > Last)
+	{
+		return 0;
+	}
+	const uint64 Bits = Bitmap.ReadBits(Layout->GetRowStart(RowIndex) + (First - Row.QMin), Last - First + 1);
+	return Bits << (First - QStart);
+}
+
+void FHxlbHexStencil::Dilate(const FHxlbHexBitmap& Source, FHxlbHexBitmap& Target) const
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(HXLB_StencilDilate);
+	
+	Target.Init(Layout->Num());
+
+	// Blocks are two bits short of a word so that reading Q - 1 to Q + 1 still fits in one.
+	constexpr int32 BlockSize = FHxlbHexBitmap::kBitsPerWord - 2;
+	for (int32 RowIndex = 0; RowIndex < Layout->NumRows(); RowIndex++)
+	{
+		const FHxlbHexRowSpan& Row = Layout->GetRow(RowIndex);
+		for (int32 QStart = Row.QMin; QStart <= Row.QMax; QStart += BlockSize)
+		{
+			const int32 Count = FMath::Min(BlockSize, Row.QMax - QStart + 1);
+			const uint64 Mask = (static_cast<uint64>(1) << Count) - 1;
+
+			// Bit i stands for hex (QStart + i, R). Its neighbors are Q +- 1 in its own row, Q and Q + 1 in the row
+			// above and Q - 1 and Q in the row below.
+			const uint64 Wide = ReadRowBits(Source, RowIndex, QStart - 1, Count + 2);
+			uint64 Bits = Wide | (Wide >> 1) | (Wide >> 2);
+			const uint64 Above = ReadRowBits(Source, RowIndex - 1, QStart, Count + 1);
+			Bits |= Above | (Above >> 1);
+			const uint64 Below = ReadRowBits(Source, RowIndex + 1, QStart - 1, Count + 1);
+			Bits |= Below | (Below >> 1);
+			
+			Target.OrBits(Layout->GetRowStart(RowIndex) + (QStart - Row.QMin), Bits & Mask, Count);
+		}
+	}
+}
@@ -0,0 +1,250 @@
+// Copyright © Mason Stevenson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the disclaimer
+// below) provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+// THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+// CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+// NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "Foundation/HxlbHexTimerWheel.h"
+
+namespace
+{
+	FORCEINLINE int64 MakeTimerHandle(int32 SlotIndex, uint32 Serial)
+	{
+		return (static_cast<int64>(Serial & 0x7fffffffU) << 32) | static_cast<int64>(SlotIndex + 1);
+	}
+}
+
+void FHxlbHexTimerWheel::Init(const FHxlbDenseLayout& NewLayout)
+{
+	Reset();
+	Layout = &NewLayout;
+	BucketHeads.Init(INDEX_NONE, kOverflowBucket + 1);
+}
+
+void FHxlbHexTimerWheel::Reset()
+{
+	Layout = nullptr;
+	CurrentTick = 0;
+	NextSequence = 0;
+	NumScheduled = 0;
+	BucketHeads.Reset();
+	Slots.Reset();
+	FirstFreeSlot = INDEX_NONE;
+	DueSlots.Reset();
+}
+
+int64 FHxlbHexTimerWheel::Schedule(const FHxlbHexTimer& Timer, int32 DelayTicks)
+{
+	if (!Layout || Timer.DenseIndex < 0 || Timer.DenseIndex >= Layout->Num())
+	{
+		return 0;
+	}
+
+	int32 SlotIndex = FirstFreeSlot;
+	if (SlotIndex != INDEX_NONE)
+	{
+		FirstFreeSlot = Slots[SlotIndex].Next;
+	}
+	else
+	{
+		SlotIndex = Slots.AddDefaulted();
+	}
+
+	FSlot& Slot = Slots[SlotIndex];
+	Slot.Timer = Timer;
+	Slot.DueTick = CurrentTick + FMath::Max(1, DelayTicks);
+	Slot.Sequence = NextSequence++;
+	Slot.Chunk = Layout->ChunkOfIndex(Timer.DenseIndex);
+	Link(SlotIndex);
+	NumScheduled++;
+	return MakeTimerHandle(SlotIndex, Slot.Serial);
+}
+
+bool FHxlbHexTimerWheel::Cancel(int64 Handle)
+{
+	const int32 SlotIndex = FindSlot(Handle);
+	if (SlotIndex == INDEX_NONE)
+	{
+		return false;
+	}
+	Unlink(SlotIndex);
+	Release(SlotIndex);
+	return true;
+}
+
+int64 FHxlbHexTimerWheel::GetRemainingTicks(int64 Handle) const
+{
+	const int32 SlotIndex = FindSlot(Handle);
+	return SlotIndex != INDEX_NONE ? Slots[SlotIndex].DueTick - CurrentTick : INDEX_NONE;
+}
+
+void FHxlbHexTimerWheel::Advance(int32 NumTicks, TArray<FHxlbHexTimer>& OutFired)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(HXLB_AdvanceHexTimers);
+	
+	DueSlots.Reset();
+	for (int32 Step = 0; Step < NumTicks; Step++)
+	{
+		if (NumScheduled == DueSlots.Num())
+		{
+			// Nothing left in the wheel, so the buckets that would come around are all empty.
+			CurrentTick += NumTicks - Step;
+			break;
+		}
+		CurrentTick++;
+
+		// Top down, so that timers cascading out of a higher level can cascade again right away. Overflowing timers are
+		// looked at whenever the top level moves on, which is before their remaining delay can drop below its span.
+		static constexpr int64 kTopBucketSpan = static_cast<int64>(1) << (kSlotBits * (kNumLevels - 1));
+		if ((CurrentTick & (kTopBucketSpan - 1)) == 0)
+		{
+			Cascade(kOverflowBucket);
+		}
+		for (int32 Level = kNumLevels - 1; Level > 0; Level--)
+		{
+			const int32 Shift = kSlotBits * Level;
+			if ((CurrentTick & ((static_cast<int64>(1) << Shift) - 1)) == 0)
+			{
+				Cascade(Level * kSlotsPerLevel + static_cast<int32>((CurrentTick >> Shift) & (kSlotsPerLevel - 1)));
+			}
+		}
+
+		// Everything left in the bucket of this tick is due now. Slots are released once the batch has been sorted.
+		const int32 Bucket = static_cast<int32>(CurrentTick & (kSlotsPerLevel - 1));
+		for (int32 SlotIndex = BucketHeads[Bucket]; SlotIndex != INDEX_NONE; SlotIndex = Slots[SlotIndex].Next)
+		{
+			check(Slots[SlotIndex].DueTick == CurrentTick);
+			Slots[SlotIndex].Bucket = INDEX_NONE;
+			DueSlots.Add(SlotIndex);
+		}
+		BucketHeads[Bucket] = INDEX_NONE;
+	}
+	
+	DueSlots.Sort([this](int32 SlotA, int32 SlotB)
+	{
+		const FSlot& A = Slots[SlotA];
+		const FSlot& B = Slots[SlotB];
+		if (A.Chunk != B.Chunk)
+		{
+			return A.Chunk < B.Chunk;
+		}
+		if (A.Timer.DenseIndex != B.Timer.DenseIndex)
+		{
+			return A.Timer.DenseIndex < B.Timer.DenseIndex;
+		}
+		return A.DueTick != B.DueTick ? A.DueTick < B.DueTick : A.Sequence < B.Sequence;
+	});
+	
+	OutFired.Reserve(OutFired.Num() + DueSlots.Num());
+	for (const int32 SlotIndex : DueSlots)
+	{
+		OutFired.Add(Slots[SlotIndex].Timer);
+		Release(SlotIndex);
+	}
+	DueSlots.Reset();
+}
+
+int32 FHxlbHexTimerWheel::FindSlot(int64 Handle) const
+{
+	const int32 SlotIndex = static_cast<int32>(Handle & 0xffffffff) - 1;
+	if (!Slots.IsValidIndex(SlotIndex))
+	{
+		return INDEX_NONE;
+	}
+	const FSlot& Slot = Slots[SlotIndex];
+	return Slot.Bucket != INDEX_NONE && MakeTimerHandle(SlotIndex, Slot.Serial) == Handle ? SlotIndex : INDEX_NONE;
+}
+
+int32 FHxlbHexTimerWheel::BucketOf(int64 DueTick) const
+{
+	const int64 Delay = DueTick - CurrentTick;
+	for (int32 Level = 0; Level < kNumLevels; Level++)
+	{
+		const int32 Shift = kSlotBits * Level;
+		if (Delay < (static_cast<int64>(1) << (Shift + kSlotBits)))
+		{
+			return Level * kSlotsPerLevel + static_cast<int32>((DueTick >> Shift) & (kSlotsPerLevel - 1));
+		}
+	}
+	return kOverflowBucket;
+}
+
+void FHxlbHexTimerWheel::Link(int32 SlotIndex)
+{
+	FSlot& Slot = Slots[SlotIndex];
+	Slot.Bucket = BucketOf(Slot.DueTick);
+	Slot.Prev = INDEX_NONE;
+	Slot.Next = BucketHeads[Slot.Bucket];
+	if (Slot.Next != INDEX_NONE)
+	{
+		Slots[Slot.Next].Prev = SlotIndex;
+	}
+	BucketHeads[Slot.Bucket] = SlotIndex;
+}
+
+void FHxlbHexTimerWheel::Unlink(int32 SlotIndex)
+{
+	FSlot& Slot = Slots[SlotIndex];
+	if (Slot.Prev != INDEX_NONE)
+	{
+		Slots[Slot.Prev].Next = Slot.Next;
+	}
+	else
+	{
+		BucketHeads[Slot.Bucket] = Slot.Next;
+	}
+	if (Slot.Next != INDEX_NONE)
+	{
+		Slots[Slot.Next].Prev = Slot.Prev;
+	}
+	Slot.Bucket = INDEX_NONE;
+}
+
+void FHxlbHexTimerWheel::Release(int32 SlotIndex)
+{
+	FSlot& Slot = Slots[SlotIndex];
+	Slot.Timer = FHxlbHexTimer();
+	Slot.Bucket = INDEX_NONE;
+	Slot.Serial++;
+	Slot.Prev = INDEX_NONE;
+	Slot.Next = FirstFreeSlot;
+	FirstFreeSlot = SlotIndex;
+	NumScheduled--;
+}
+
+void FHxlbHexTimerWheel::Cascade(int32 Bucket)
+{
+	int32 SlotIndex = BucketHeads[Bucket];
+	BucketHeads[Bucket] = INDEX_NONE;
+	while (SlotIndex != INDEX_NONE)
+	{
+		const int32 Next = Slots[SlotIndex].Next;
+		Link(SlotIndex);
+		SlotIndex = Next;
+	}
+}
@@ -0,0 +1,272 @@
+// Copyright © Mason Stevenson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the disclaimer
+// below) provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+// THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+// CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+// NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "Foundation/HxlbOccupancyIndex.h"
+
+#include "Async/ParallelFor.h"
+#include "Foundation/HxlbHexRanges.h"
+#include "Foundation/HxlbHexShapes.h"
+
+using HexMath = UHxlbMath;
+
+void FHxlbOccupancyIndex::Init(const FHxlbDenseLayout& NewLayout)
+{
+	Layout = &NewLayout;
+	Heads.Init(INDEX_NONE, Layout->Num());
+	Counts.Init(0, Layout->Num());
+	Slots.Reset();
+	FirstFreeSlot = INDEX_NONE;
+	SlotOfEntity.Reset();
+}
+
+void FHxlbOccupancyIndex::Reset()
+{
+	Layout = nullptr;
+	Heads.Reset();
+	Counts.Reset();
+	Slots.Reset();
+	FirstFreeSlot = INDEX_NONE;
+	SlotOfEntity.Reset();
+}
+
+bool FHxlbOccupancyIndex::SetEntity(int32 EntityId, int32 DenseIndex)
+{
+	if (!IsInitialized() || DenseIndex < 0 || DenseIndex >= Layout->Num())
+	{
+		return false;
+	}
+
+	if (const int32* ExistingSlot = SlotOfEntity.Find(EntityId))
+	{
+		if (Slots[*ExistingSlot].DenseIndex != DenseIndex)
+		{
+			Unlink(*ExistingSlot);
+			Link(*ExistingSlot, DenseIndex);
+		}
+		return true;
+	}
+
+	int32 SlotIndex = FirstFreeSlot;
+	if (SlotIndex != INDEX_NONE)
+	{
+		FirstFreeSlot = Slots[SlotIndex].Next;
+	}
+	else
+	{
+		SlotIndex = Slots.AddDefaulted();
+	}
+	Slots[SlotIndex].EntityId = EntityId;
+	Link(SlotIndex, DenseIndex);
+	SlotOfEntity.Add(EntityId, SlotIndex);
+	return true;
+}
+
+bool FHxlbOccupancyIndex::RemoveEntity(int32 EntityId)
+{
+	int32 SlotIndex = INDEX_NONE;
+	if (!SlotOfEntity.RemoveAndCopyValue(EntityId, SlotIndex))
+	{
+		return false;
+	}
+
+	Unlink(SlotIndex);
+	Slots[SlotIndex] = FSlot();
+	Slots[SlotIndex].Next = FirstFreeSlot;
+	FirstFreeSlot = SlotIndex;
+	return true;
+}
+
+void FHxlbOccupancyIndex::RemoveAll()
+{
+	if (IsInitialized())
+	{
+		Init(*Layout);
+	}
+}
+
+int32 FHxlbOccupancyIndex::FindEntity(int32 EntityId) const
+{
+	const int32* SlotIndex = SlotOfEntity.Find(EntityId);
+	return SlotIndex ? Slots[*SlotIndex].DenseIndex : INDEX_NONE;
+}
+
+void FHxlbOccupancyIndex::FindInRadius(FIntPoint Center, int32 Radius, TArray<int32>& OutEntities) const
+{
+	OutEntities.Reset();
+	ForEachEntityInRadius(Center, Radius, [&OutEntities](int32 EntityId, int32 DenseIndex, int32 Distance)
+	{
+		OutEntities.Add(EntityId);
+		return true;
+	});
+}
+
+void FHxlbOccupancyIndex::FindNearest(FIntPoint Center, int32 Count, int32 MaxRadius, TArray<int32>& OutEntities) const
+{
+	OutEntities.Reset();
+	if (Count <= 0)
+	{
+		return;
+	}
+	
+	ForEachEntityInRadius(Center, MaxRadius, [&OutEntities, Count](int32 EntityId, int32 DenseIndex, int32 Distance)
+	{
+		OutEntities.Add(EntityId);
+		return OutEntities.Num() < Count;
+	});
+}
+
+void FHxlbOccupancyIndex::ResolveAreaEffects(TConstArrayView<FHxlbAreaEffect> Effects, TArray<FHxlbAreaEffectHit>& OutHits) const
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(HXLB_ResolveAreaEffects);
+	
+	OutHits.Reset();
+	if (!IsInitialized() || NumEntities() == 0)
+	{
+		return;
+	}
+
+	TArray<TArray<FHxlbAreaEffectHit>> HitsOf;
+	HitsOf.SetNum(Effects.Num());
+	ParallelFor(Effects.Num(), [this, &Effects, &HitsOf](int32 EffectIndex)
+	{
+		ResolveAreaEffect(Effects[EffectIndex], HitsOf[EffectIndex]);
+	});
+	
+	int32 NumHits = 0;
+	for (const TArray<FHxlbAreaEffectHit>& Hits : HitsOf)
+	{
+		NumHits += Hits.Num();
+	}
+	OutHits.Reserve(NumHits);
+	for (const TArray<FHxlbAreaEffectHit>& Hits : HitsOf)
+	{
+		OutHits.Append(Hits);
+	}
+}
+
+void FHxlbOccupancyIndex::ResolveAreaEffect(const FHxlbAreaEffect& Effect, TArray<FHxlbAreaEffectHit>& OutHits) const
+{
+	switch (Effect.Shape)
+	{
+	case EHxlbAreaShape::Radial:
+		{
+			auto Shape = HxlbShapes::Spans(FHxlbRadialRange(Effect.Origin, Effect.Radius));
+			CollectHits(Shape, Effect.EffectId, OutHits);
+			break;
+		}
+	case EHxlbAreaShape::Ring:
+		{
+			auto Shape = HxlbShapes::Subtract(
+				HxlbShapes::Spans(FHxlbRadialRange(Effect.Origin, Effect.Radius)),
+				HxlbShapes::Spans(FHxlbRadialRange(Effect.Origin, Effect.InnerRadius - 1))
+			);
+			CollectHits(Shape, Effect.EffectId, OutHits);
+			break;
+		}
+	case EHxlbAreaShape::Rectangle:
+		{
+			auto Shape = HxlbShapes::Spans(FHxlbRectangularRange(Effect.Origin, Effect.HalfWidth, Effect.HalfHeight));
+			CollectHits(Shape, Effect.EffectId, OutHits);
+			break;
+		}
+	default:
+		break;
+	}
+}
+
+template <typename ShapeType>
+void FHxlbOccupancyIndex::CollectHits(ShapeType& Shape, int32 EffectId, TArray<FHxlbAreaEffectHit>& OutHits) const
+{
+	HxlbShapes::ForEachIndex(Shape, *Layout, [this, EffectId, &OutHits](int32 DenseIndex)
+	{
+		if (Counts[DenseIndex] == 0)
+		{
+			return;
+		}
+		
+		const FIntPoint HexCoord = Layout->CoordOf(DenseIndex);
+		for (int32 SlotIndex = Heads[DenseIndex]; SlotIndex != INDEX_NONE; SlotIndex = Slots[SlotIndex].Next)
+		{
+			FHxlbAreaEffectHit& Hit = OutHits.AddDefaulted_GetRef();
+			Hit.EffectId = EffectId;
+			Hit.EntityId = Slots[SlotIndex].EntityId;
+			Hit.HexCoord = HexCoord;
+		}
+	});
+}
+
+int32 FHxlbOccupancyIndex::GetMaxUsefulRadius(FIntPoint Center) const
+{
+	// Distance is convex along a row, so the farthest hex of each row is one of its ends.
+	int32 MaxRadius = -1;
+	for (int32 RowIndex = 0; IsInitialized() && RowIndex < Layout->NumRows(); RowIndex++)
+	{
+		const FHxlbHexRowSpan& Row = Layout->GetRow(RowIndex);
+		if (!Row.IsEmpty())
+		{
+			MaxRadius = FMath::Max(MaxRadius, HexMath::AxialDistanceFast(Center, FIntPoint(Row.QMin, Row.R)));
+			MaxRadius = FMath::Max(MaxRadius, HexMath::AxialDistanceFast(Center, FIntPoint(Row.QMax, Row.R)));
+		}
+	}
+	return MaxRadius;
+}
+
+void FHxlbOccupancyIndex::Link(int32 SlotIndex, int32 DenseIndex)
+{
+	FSlot& Slot = Slots[SlotIndex];
+	Slot.DenseIndex = DenseIndex;
+	Slot.Prev = INDEX_NONE;
+	Slot.Next = Heads[DenseIndex];
+	if (Slot.Next != INDEX_NONE)
+	{
+		Slots[Slot.Next].Prev = SlotIndex;
+	}
+	Heads[DenseIndex] = SlotIndex;
+	Counts[DenseIndex]++;
+}
+
+void FHxlbOccupancyIndex::Unlink(int32 SlotIndex)
+{
+	const FSlot& Slot = Slots[SlotIndex];
+	if (Slot.Prev != INDEX_NONE)
+	{
+		Slots[Slot.Prev].Next = Slot.Next;
+	}
+	else
+	{
+		Heads[Slot.DenseIndex] = Slot.Next;
+	}
+	if (Slot.Next != INDEX_NONE)
+	{
+		Slots[Slot.Next].Prev = Slot.Prev;
+	}
+	Counts[Slot.DenseIndex]--;
+}
@@ -0,0 +1,257 @@
+// Copyright © Mason Stevenson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the disclaimer
+// below) provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+// THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+// CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+// NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "Foundation/HxlbQueryCache.h"
+
+#include "Algo/BinarySearch.h"
+#include "Algo/Unique.h"
+#include "Foundation/HxlbHexRanges.h"
+#include "Foundation/HxlbHexShapes.h"
+
+bool FHxlbQueryResult::Contains(int32 DenseIndex) const
+{
+	const int32 RunIndex = Algo::UpperBoundBy(Runs, DenseIndex, [](const FHxlbDenseRun& Run) { return Run.First; }) - 1;
+	return RunIndex >= 0 && DenseIndex < Runs[RunIndex].First + Runs[RunIndex].Num;
+}
+
+void FHxlbQueryResult::ToBitmap(FHxlbHexBitmap& OutBitmap) const
+{
+	for (const FHxlbDenseRun& Run : Runs)
+	{
+		for (int32 Offset = 0; Offset < Run.Num; Offset += FHxlbHexBitmap::kBitsPerWord)
+		{
+			const int32 Count = FMath::Min(FHxlbHexBitmap::kBitsPerWord, Run.Num - Offset);
+			const uint64 Bits = Count == FHxlbHexBitmap::kBitsPerWord ? ~static_cast<uint64>(0) : (static_cast<uint64>(1) << Count) - 1;
+			OutBitmap.OrBits(Run.First + Offset, Bits, Count);
+		}
+	}
+}
+
+void FHxlbQueryResult::ToCoords(const FHxlbDenseLayout& Layout, TArray<FIntPoint>& OutCoords) const
+{
+	OutCoords.Reserve(OutCoords.Num() + NumHexes);
+	for (const FHxlbDenseRun& Run : Runs)
+	{
+		// Runs never leave their row, so only the first hex has to be looked up.
+		const FIntPoint First = Layout.CoordOf(Run.First);
+		for (int32 Offset = 0; Offset < Run.Num; Offset++)
+		{
+			OutCoords.Add(FIntPoint(HEX_Q(First) + Offset, HEX_R(First)));
+		}
+	}
+}
+
+TSharedRef<const FHxlbQueryResult> FHxlbQueryCache::FindOrCompute(
+	const FHxlbHexQuery& Query,
+	const FHxlbDenseLayout& Layout,
+	int32 FootprintRadius,
+	TConstArrayView<const FHxlbHexLayerBase*> Layers,
+	TFunctionRef<void(FHxlbHexBitmap&)> Compute)
+{
+	UseCounter++;
+	if (FEntry* Entry = Entries.Find(Query))
+	{
+		Entry->LastUsed = UseCounter;
+		if (IsUpToDate(*Entry, Layers))
+		{
+			Stats.Hits++;
+			return Entry->Result;
+		}
+
+		Stats.Invalidations++;
+		Fill(*Entry, Query, Layout, FootprintRadius, Layers, Compute);
+		return Entry->Result;
+	}
+
+	Stats.Misses++;
+	if (Entries.Num() >= FMath::Max(1, MaxEntries))
+	{
+		EvictOldest();
+	}
+	FEntry& Entry = Entries.Add(Query);
+	Entry.LastUsed = UseCounter;
+	Fill(Entry, Query, Layout, FootprintRadius, Layers, Compute);
+	return Entry.Result;
+}
+
+SIZE_T FHxlbQueryCache::GetAllocatedSize() const
+{
+	SIZE_T Size = Entries.GetAllocatedSize() + Scratch.GetWords().Num() * sizeof(uint64);
+	for (const auto& EntryKV : Entries)
+	{
+		const FEntry& Entry = EntryKV.Value;
+		Size += sizeof(FHxlbQueryResult) + Entry.Result->GetAllocatedSize() + Entry.Chunks.GetAllocatedSize();
+		Size += Entry.Layers.GetAllocatedSize() + Entry.LayerVersions.GetAllocatedSize() + Entry.ChunkVersions.GetAllocatedSize();
+	}
+	return Size;
+}
+
+bool FHxlbQueryCache::IsUpToDate(FEntry& Entry, TConstArrayView<const FHxlbHexLayerBase*> Layers) const
+{
+	if (Entry.Layers.Num() != Layers.Num())
+	{
+		return false;
+	}
+	
+	const int32 NumChunks = Entry.Chunks.Num();
+	for (int32 LayerIndex = 0; LayerIndex < Layers.Num(); LayerIndex++)
+	{
+		const FHxlbHexLayerBase* Layer = Layers[LayerIndex];
+		if (Layer != Entry.Layers[LayerIndex])
+		{
+			return false;
+		}
+		if (!Layer || Layer->GetVersion() == Entry.LayerVersions[LayerIndex])
+		{
+			continue;
+		}
+
+		// The layer changed somewhere. Only changes under the footprint matter.
+		const uint32* ChunkVersions = &Entry.ChunkVersions[LayerIndex * NumChunks];
+		for (int32 ChunkIndex = 0; ChunkIndex < NumChunks; ChunkIndex++)
+		{
+			if (Layer->GetChunkVersion(Entry.Chunks[ChunkIndex]) != ChunkVersions[ChunkIndex])
+			{
+				return false;
+			}
+		}
+
+		// Spares the scan next time, until the layer changes again.
+		Entry.LayerVersions[LayerIndex] = Layer->GetVersion();
+	}
+	return true;
+}
+
+void FHxlbQueryCache::Fill(
+	FEntry& Entry,
+	const FHxlbHexQuery& Query,
+	const FHxlbDenseLayout& Layout,
+	int32 FootprintRadius,
+	TConstArrayView<const FHxlbHexLayerBase*> Layers,
+	TFunctionRef<void(FHxlbHexBitmap&)> Compute)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(HXLB_QueryCacheFill);
+	
+	Scratch.Reset();
+	Compute(Scratch);
+	const bool bHasBits = Layout.IsValid() && Scratch.Num() == Layout.Num();
+
+	// Handed out results are never modified, so every fill gets a result of its own.
+	TSharedRef<FHxlbQueryResult> Result = MakeShared<FHxlbQueryResult>();
+	Entry.Chunks.Reset();
+
+	auto Footprint = HxlbShapes::ClipToMap(HxlbShapes::Spans(FHxlbRadialRange(Query.Origin, FMath::Max(0, FootprintRadius))), Layout);
+	HxlbShapes::ForEachSpan(Footprint, [this, &Entry, &Layout, &Result, bHasBits](const FHxlbHexRowSpan& Span)
+	{
+		// Within a row, every chunk covers a run of consecutive hexes, so this hops from one chunk to the next.
+		const int32 LocalRow = (Span.R - Layout.GetMinR()) % Layout.GetChunkSize();
+		for (int32 Q = Span.QMin; Q <= Span.QMax; )
+		{
+			const int32 Chunk = Layout.ChunkOf(FIntPoint(Q, Span.R));
+			Entry.Chunks.Add(Chunk);
+			Q = Layout.GetChunkRowSpan(Chunk, LocalRow).QMax + 1;
+		}
+		if (!bHasBits)
+		{
+			return;
+		}
+
+		const int32 FirstIndex = Layout.IndexOf(FIntPoint(Span.QMin, Span.R));
+		const int32 NumInSpan = Span.Num();
+		const int32 FirstRun = Result->Runs.Num();
+		for (int32 Offset = 0; Offset < NumInSpan; Offset += FHxlbHexBitmap::kBitsPerWord)
+		{
+			uint64 Bits = Scratch.ReadBits(FirstIndex + Offset, FMath::Min(FHxlbHexBitmap::kBitsPerWord, NumInSpan - Offset));
+			int32 BitIndex = FirstIndex + Offset;
+			while (Bits)
+			{
+				const int32 Skipped = static_cast<int32>(FMath::CountTrailingZeros64(Bits));
+				Bits >>= Skipped;
+				BitIndex += Skipped;
+				const int32 Length = static_cast<int32>(FMath::CountTrailingZeros64(~Bits));
+				Bits = Length < FHxlbHexBitmap::kBitsPerWord ? Bits >> Length : 0;
+
+				// Runs that cross a word boundary continue the previous run.
+				FHxlbDenseRun* LastRun = Result->Runs.Num() > FirstRun ? &Result->Runs.Last() : nullptr;
+				if (LastRun && LastRun->First + LastRun->Num == BitIndex)
+				{
+					LastRun->Num += Length;
+				}
+				else
+				{
+					Result->Runs.Add({BitIndex, Length});
+				}
+				Result->NumHexes += Length;
+				BitIndex += Length;
+			}
+		}
+	});
+	Result->Runs.Shrink();
+
+	// Chunks are hit once per row they cover.
+	Entry.Chunks.Sort();
+	Entry.Chunks.SetNum(Algo::Unique(Entry.Chunks));
+	
+	const int32 NumChunks = Entry.Chunks.Num();
+	Entry.Layers.Reset();
+	Entry.Layers.Append(Layers);
+	Entry.LayerVersions.SetNumUninitialized(Layers.Num());
+	Entry.ChunkVersions.SetNumUninitialized(Layers.Num() * NumChunks);
+	for (int32 LayerIndex = 0; LayerIndex < Layers.Num(); LayerIndex++)
+	{
+		const FHxlbHexLayerBase* Layer = Layers[LayerIndex];
+		Entry.LayerVersions[LayerIndex] = Layer ? Layer->GetVersion() : 0;
+		for (int32 ChunkIndex = 0; ChunkIndex < NumChunks; ChunkIndex++)
+		{
+			Entry.ChunkVersions[LayerIndex * NumChunks + ChunkIndex] = Layer ? Layer->GetChunkVersion(Entry.Chunks[ChunkIndex]) : 0;
+		}
+	}
+	Entry.Result = Result;
+}
+
+void FHxlbQueryCache::EvictOldest()
+{
+	const FHxlbHexQuery* Oldest = nullptr;
+	uint64 OldestUse = TNumericLimits<uint64>::Max();
+	for (const auto& EntryKV : Entries)
+	{
+		if (EntryKV.Value.LastUsed < OldestUse)
+		{
+			Oldest = &EntryKV.Key;
+			OldestUse = EntryKV.Value.LastUsed;
+		}
+	}
+	if (Oldest)
+	{
+		Entries.Remove(FHxlbHexQuery(*Oldest));
+		Stats.Evictions++;
+	}
+}
@@ -0,0 +1,201 @@
+// Copyright © Mason Stevenson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the disclaimer
+// below) provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+// THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+// CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+// NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "FunctionLibraries/HxlbAnalysisFunctions.h"
+
+#include "HexLibRuntimeLoggingDefs.h"
+#include "Foundation/HxlbHexMap.h"
+#include "Macros/HexLibLoggingMacros.h"
+
+void UHxlbAnalysisFunctions::SetInfluenceSource(UHxlbHexMapComponent* HexMap, int32 SourceId, FHxlbInfluenceSource Source)
+{
+	if (HexMap)
+	{
+		HexMap->GetInfluenceMap().SetSource(SourceId, Source);
+	}
+}
+
+void UHxlbAnalysisFunctions::RemoveInfluenceSource(UHxlbHexMapComponent* HexMap, int32 SourceId)
+{
+	if (HexMap)
+	{
+		HexMap->GetInfluenceMap().RemoveSource(SourceId);
+	}
+}
+
+void UHxlbAnalysisFunctions::UpdateInfluenceMap(UHxlbHexMapComponent* HexMap)
+{
+	if (!HexMap)
+	{
+		HXLB_LOG(LogHxlbRuntime, Error, TEXT("UHxlbAnalysisFunctions::UpdateInfluenceMap(): HexMap is null."));
+		return;
+	}
+	HexMap->UpdateInfluenceMap();
+}
+
+float UHxlbAnalysisFunctions::GetInfluence(UHxlbHexMapComponent* HexMap, int32 Faction, FIntPoint HexCoord)
+{
+	return HexMap ? HexMap->GetInfluenceMap().GetInfluence(Faction, HexMap->GetDenseLayout().IndexOf(HexCoord)) : 0.0f;
+}
+
+float UHxlbAnalysisFunctions::GetThreat(UHxlbHexMapComponent* HexMap, int32 Faction, FIntPoint HexCoord)
+{
+	return HexMap ? HexMap->GetInfluenceMap().GetOpposingInfluence(Faction, HexMap->GetDenseLayout().IndexOf(HexCoord)) : 0.0f;
+}
+
+int32 UHxlbAnalysisFunctions::GetHexRegion(UHxlbHexMapComponent* HexMap, FName LayerName, FIntPoint HexCoord)
+{
+	const FHxlbRegionLabeling* Regions = HexMap ? HexMap->GetRegions(LayerName) : nullptr;
+	const int32 DenseIndex = HexMap ? HexMap->GetDenseLayout().IndexOf(HexCoord) : INDEX_NONE;
+	return Regions && DenseIndex != INDEX_NONE ? Regions->GetRegion(DenseIndex) : INDEX_NONE;
+}
+
+int32 UHxlbAnalysisFunctions::GetRegionSize(UHxlbHexMapComponent* HexMap, FName LayerName, int32 RegionId)
+{
+	const FHxlbRegionLabeling* Regions = HexMap ? HexMap->GetRegions(LayerName) : nullptr;
+	return Regions ? Regions->GetRegionSize(RegionId) : 0;
+}
+
+TArray<FIntPoint> UHxlbAnalysisFunctions::GetRegionHexes(UHxlbHexMapComponent* HexMap, FName LayerName, FIntPoint HexCoord)
+{
+	TArray<FIntPoint> Hexes;
+	const FHxlbRegionLabeling* Regions = HexMap ? HexMap->GetRegions(LayerName) : nullptr;
+	if (!Regions)
+	{
+		HXLB_LOG(LogHxlbRuntime, Warning, TEXT("UHxlbAnalysisFunctions::GetRegionHexes(): No int32 layer named %s."), *LayerName.ToString());
+		return Hexes;
+	}
+
+	TArray<int32> Indices;
+	Regions->GetRegionHexes(HexMap->GetDenseLayout().IndexOf(HexCoord), Indices);
+	for (int32 DenseIndex : Indices)
+	{
+		Hexes.Add(HexMap->GetDenseLayout().CoordOf(DenseIndex));
+	}
+	return Hexes;
+}
+
+TArray<FHxlbBorderLoop> UHxlbAnalysisFunctions::GetRegionBorderLoops(UHxlbHexMapComponent* HexMap, FName LayerName, int32 RegionId)
+{
+	TArray<FHxlbBorderLoop> Loops;
+	const FHxlbRegionBorders* Borders = HexMap ? HexMap->GetRegionBorders(LayerName) : nullptr;
+	if (!Borders)
+	{
+		HXLB_LOG(LogHxlbRuntime, Warning, TEXT("UHxlbAnalysisFunctions::GetRegionBorderLoops(): No int32 layer named %s."), *LayerName.ToString());
+		return Loops;
+	}
+
+	if (const FHxlbRegionBorder* Border = Borders->GetBorder(RegionId))
+	{
+		for (int32 LoopIndex = 0; LoopIndex < Border->NumLoops(); LoopIndex++)
+		{
+			const TConstArrayView<FVector> Loop = Border->GetLoop(LoopIndex);
+			Loops.AddDefaulted_GetRef().Points.Append(Loop.GetData(), Loop.Num());
+		}
+	}
+	return Loops;
+}
+
+FIntPoint UHxlbAnalysisFunctions::GetSuperHex(FIntPoint HexCoord, int32 Level)
+{
+	return FHxlbHexHierarchy::AncestorOf(HexCoord, Level);
+}
+
+FIntPoint UHxlbAnalysisFunctions::GetSuperHexCenter(FIntPoint SuperHexCoord, int32 Level)
+{
+	return FHxlbHexHierarchy::LeafCenterOf(SuperHexCoord, Level);
+}
+
+float UHxlbAnalysisFunctions::GetAggregateValue(UHxlbHexMapComponent* HexMap, FName LayerName, EHxlbAggregateOp Op, FIntPoint SuperHexCoord, int32 Level)
+{
+	const FHxlbHexAggregate* Aggregate = HexMap ? HexMap->GetAggregate(LayerName, Op) : nullptr;
+	if (!Aggregate)
+	{
+		HXLB_LOG(LogHxlbRuntime, Warning, TEXT("UHxlbAnalysisFunctions::GetAggregateValue(): No float or int32 layer named %s."), *LayerName.ToString());
+		return 0.0f;
+	}
+
+	const FHxlbHexHierarchy& Hierarchy = HexMap->GetHexHierarchy();
+	if (Level < 0 || Level >= Hierarchy.NumLevels())
+	{
+		return 0.0f;
+	}
+	const int32 DenseIndex = Hierarchy.GetLayout(Level).IndexOf(SuperHexCoord);
+	return DenseIndex != INDEX_NONE ? Aggregate->GetValue(Level, DenseIndex) : 0.0f;
+}
+
+void UHxlbAnalysisFunctions::AddDistanceField(UHxlbHexMapComponent* HexMap, FName LayerName, const TArray<FIntPoint>& Sources, bool bWeighted)
+{
+	if (HexMap)
+	{
+		HexMap->AddDistanceField(LayerName, Sources, bWeighted);
+	}
+}
+
+void UHxlbAnalysisFunctions::AddDistanceSources(UHxlbHexMapComponent* HexMap, FName LayerName, const TArray<FIntPoint>& Sources)
+{
+	if (HexMap)
+	{
+		HexMap->AddDistanceSources(LayerName, Sources);
+	}
+}
+
+void UHxlbAnalysisFunctions::RemoveDistanceSources(UHxlbHexMapComponent* HexMap, FName LayerName, const TArray<FIntPoint>& Sources)
+{
+	if (HexMap)
+	{
+		HexMap->RemoveDistanceSources(LayerName, Sources);
+	}
+}
+
+float UHxlbAnalysisFunctions::GetDistanceToNearestSource(UHxlbHexMapComponent* HexMap, FName LayerName, FIntPoint HexCoord)
+{
+	const FHxlbDistanceField* Field = HexMap ? HexMap->GetDistanceField(LayerName) : nullptr;
+	const int32 DenseIndex = Field ? HexMap->GetDenseLayout().IndexOf(HexCoord) : INDEX_NONE;
+	if (DenseIndex == INDEX_NONE || Field->GetNearestSource(DenseIndex) == INDEX_NONE)
+	{
+		return -1.0f;
+	}
+	return Field->GetDistance(DenseIndex);
+}
+
+bool UHxlbAnalysisFunctions::GetNearestSource(UHxlbHexMapComponent* HexMap, FName LayerName, FIntPoint HexCoord, FIntPoint& OutSourceCoord)
+{
+	const FHxlbDistanceField* Field = HexMap ? HexMap->GetDistanceField(LayerName) : nullptr;
+	const int32 DenseIndex = Field ? HexMap->GetDenseLayout().IndexOf(HexCoord) : INDEX_NONE;
+	const int32 Source = DenseIndex != INDEX_NONE ? Field->GetNearestSource(DenseIndex) : INDEX_NONE;
+	if (Source == INDEX_NONE)
+	{
+		return false;
+	}
+	OutSourceCoord = HexMap->GetDenseLayout().CoordOf(Source);
+	return true;
+}
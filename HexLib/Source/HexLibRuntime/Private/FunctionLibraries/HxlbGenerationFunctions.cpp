@@ -0,0 +1,89 @@
+// Copyright © Mason Stevenson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the disclaimer
+// below) provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+// THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+// CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+// NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "FunctionLibraries/HxlbGenerationFunctions.h"
+
+#include "HexLibRuntimeLoggingDefs.h"
+#include "Analysis/HxlbVoronoiPartition.h"
+#include "Foundation/HxlbHexMap.h"
+#include "Macros/HexLibLoggingMacros.h"
+
+void UHxlbGenerationFunctions::GenerateMap(UHxlbHexMapComponent* HexMap, const FHxlbMapGenSettings& Settings)
+{
+	if (!HexMap)
+	{
+		HXLB_LOG(LogHxlbRuntime, Error, TEXT("UHxlbGenerationFunctions::GenerateMap(): HexMap is null."));
+		return;
+	}
+	HexMap->GenerateMap(FHxlbMapGenerator::FromSettings(Settings), Settings.Seed);
+}
+
+void UHxlbGenerationFunctions::GenerateRegions(UHxlbHexMapComponent* HexMap, FName RegionLayerName, const FHxlbRegionGenSettings& Settings, int32 Seed)
+{
+	if (!HexMap)
+	{
+		HXLB_LOG(LogHxlbRuntime, Error, TEXT("UHxlbGenerationFunctions::GenerateRegions(): HexMap is null."));
+		return;
+	}
+	// Same stream as in FHxlbMapGenerator::FromSettings(), so that both place the same regions.
+	FHxlbMapGenerator Generator;
+	Generator.AddStage(MakeShared<FHxlbRegionStage>(RegionLayerName, Settings, 5));
+	HexMap->GenerateMap(Generator, Seed);
+}
+
+TArray<int32> UHxlbGenerationFunctions::GetAdjacentRegions(UHxlbHexMapComponent* HexMap, FName RegionLayerName, int32 RegionId)
+{
+	TArray<int32> Regions;
+	const THxlbHexLayer<int32>* Layer = HexMap ? HexMap->FindLayer<int32>(RegionLayerName) : nullptr;
+	if (!Layer)
+	{
+		return Regions;
+	}
+
+	FHxlbRegionAdjacency Adjacency;
+	Adjacency.Build(HexMap->GetDenseLayout(), Layer->GetValues(), 0);
+	for (const FHxlbRegionLink& Link : Adjacency.GetNeighbors(RegionId))
+	{
+		Regions.Add(Link.Region);
+	}
+	return Regions;
+}
+
+bool UHxlbGenerationFunctions::HasRiverEdge(UHxlbHexMapComponent* HexMap, FName RiverLayerName, FIntPoint HexCoord, int32 DirectionIndex)
+{
+	const THxlbHexLayer<uint8>* Rivers = HexMap ? HexMap->FindLayer<uint8>(RiverLayerName) : nullptr;
+	const int32 DenseIndex = Rivers ? HexMap->GetDenseLayout().IndexOf(HexCoord) : INDEX_NONE;
+	if (DenseIndex == INDEX_NONE || DirectionIndex < 0 || DirectionIndex >= 6)
+	{
+		return false;
+	}
+	return (Rivers->Get(DenseIndex) & (1 << DirectionIndex)) != 0;
+}
@@ -0,0 +1,91 @@
+// Copyright © Mason Stevenson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the disclaimer
+// below) provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+// THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+// CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+// NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "FunctionLibraries/HxlbHexTimerFunctions.h"
+
+#include "Foundation/HxlbHexMap.h"
+
+int64 UHxlbHexTimerFunctions::ScheduleHexEvent(UHxlbHexMapComponent* HexMap, FIntPoint HexCoord, int32 DelayTicks, int32 EventType, float Value)
+{
+	if (!HexMap)
+	{
+		return 0;
+	}
+	
+	FHxlbHexTimer Timer;
+	Timer.DenseIndex = HexMap->GetDenseLayout().IndexOf(HexCoord);
+	Timer.EventType = EventType;
+	Timer.Value = Value;
+	return HexMap->GetHexTimers().Schedule(Timer, DelayTicks);
+}
+
+int64 UHxlbHexTimerFunctions::ScheduleLayerChange(UHxlbHexMapComponent* HexMap, FName LayerName, FIntPoint HexCoord, int32 DelayTicks, float Value, bool bAdd)
+{
+	if (!HexMap)
+	{
+		return 0;
+	}
+	
+	FHxlbHexTimer Timer;
+	Timer.DenseIndex = HexMap->GetDenseLayout().IndexOf(HexCoord);
+	Timer.Value = Value;
+	Timer.Action = bAdd ? EHxlbHexTimerAction::AddToLayerValue : EHxlbHexTimerAction::SetLayerValue;
+	Timer.LayerName = LayerName;
+	return HexMap->GetHexTimers().Schedule(Timer, DelayTicks);
+}
+
+bool UHxlbHexTimerFunctions::CancelHexTimer(UHxlbHexMapComponent* HexMap, int64 Handle)
+{
+	return HexMap && HexMap->GetHexTimers().Cancel(Handle);
+}
+
+TArray<FHxlbHexTimerFired> UHxlbHexTimerFunctions::AdvanceHexTimers(UHxlbHexMapComponent* HexMap, int32 NumTicks)
+{
+	TArray<FHxlbHexTimerFired> Fired;
+	if (!HexMap)
+	{
+		return Fired;
+	}
+	
+	TArray<FHxlbHexTimer> Timers;
+	HexMap->AdvanceHexTimers(NumTicks, Timers);
+	
+	const FHxlbDenseLayout& Layout = HexMap->GetDenseLayout();
+	Fired.Reserve(Timers.Num());
+	for (const FHxlbHexTimer& Timer : Timers)
+	{
+		FHxlbHexTimerFired& Entry = Fired.AddDefaulted_GetRef();
+		Entry.HexCoord = Layout.CoordOf(Timer.DenseIndex);
+		Entry.EventType = Timer.EventType;
+		Entry.Value = Timer.Value;
+	}
+	return Fired;
+}
@@ -0,0 +1,100 @@
+// Copyright © Mason Stevenson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the disclaimer
+// below) provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+// THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+// CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+// NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "FunctionLibraries/HxlbOccupancyFunctions.h"
+
+#include "Foundation/HxlbHexMap.h"
+
+bool UHxlbOccupancyFunctions::SetEntityHex(UHxlbHexMapComponent* HexMap, int32 EntityId, FIntPoint HexCoord)
+{
+	const int32 DenseIndex = HexMap ? HexMap->GetDenseLayout().IndexOf(HexCoord) : INDEX_NONE;
+	return DenseIndex != INDEX_NONE && HexMap->GetOccupancy().SetEntity(EntityId, DenseIndex);
+}
+
+bool UHxlbOccupancyFunctions::RemoveEntity(UHxlbHexMapComponent* HexMap, int32 EntityId)
+{
+	return HexMap && HexMap->GetOccupancy().RemoveEntity(EntityId);
+}
+
+bool UHxlbOccupancyFunctions::GetEntityHex(UHxlbHexMapComponent* HexMap, int32 EntityId, FIntPoint& OutHexCoord)
+{
+	const int32 DenseIndex = HexMap ? HexMap->GetOccupancy().FindEntity(EntityId) : INDEX_NONE;
+	if (DenseIndex == INDEX_NONE)
+	{
+		return false;
+	}
+	OutHexCoord = HexMap->GetDenseLayout().CoordOf(DenseIndex);
+	return true;
+}
+
+TArray<int32> UHxlbOccupancyFunctions::GetEntitiesOnHex(UHxlbHexMapComponent* HexMap, FIntPoint HexCoord)
+{
+	TArray<int32> Entities;
+	const int32 DenseIndex = HexMap ? HexMap->GetDenseLayout().IndexOf(HexCoord) : INDEX_NONE;
+	if (DenseIndex != INDEX_NONE)
+	{
+		HexMap->GetOccupancy().ForEachEntityAt(DenseIndex, [&Entities](int32 EntityId)
+		{
+			Entities.Add(EntityId);
+		});
+	}
+	return Entities;
+}
+
+TArray<int32> UHxlbOccupancyFunctions::GetEntitiesInRadius(UHxlbHexMapComponent* HexMap, FIntPoint HexCoord, int32 Radius)
+{
+	TArray<int32> Entities;
+	if (HexMap)
+	{
+		HexMap->GetOccupancy().FindInRadius(HexCoord, Radius, Entities);
+	}
+	return Entities;
+}
+
+TArray<int32> UHxlbOccupancyFunctions::GetNearestEntities(UHxlbHexMapComponent* HexMap, FIntPoint HexCoord, int32 Count, int32 MaxRadius)
+{
+	TArray<int32> Entities;
+	if (HexMap)
+	{
+		HexMap->GetOccupancy().FindNearest(HexCoord, Count, MaxRadius, Entities);
+	}
+	return Entities;
+}
+
+TArray<FHxlbAreaEffectHit> UHxlbOccupancyFunctions::ResolveAreaEffects(UHxlbHexMapComponent* HexMap, const TArray<FHxlbAreaEffect>& Effects)
+{
+	TArray<FHxlbAreaEffectHit> Hits;
+	if (HexMap)
+	{
+		HexMap->GetOccupancy().ResolveAreaEffects(Effects, Hits);
+	}
+	return Hits;
+}
@@ -0,0 +1,202 @@
+// Copyright © Mason Stevenson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the disclaimer
+// below) provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+// THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+// CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+// NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "FunctionLibraries/HxlbPathfindingFunctions.h"
+
+#include "HexLibRuntimeLoggingDefs.h"
+#include "Foundation/HxlbHexMap.h"
+#include "Macros/HexLibLoggingMacros.h"
+
+FHxlbPathResult UHxlbPathfindingFunctions::FindPath(UHxlbHexMapComponent* HexMap, FIntPoint Start, FIntPoint Goal, FHxlbPathQueryParams Params)
+{
+	FHxlbPathResult Result;
+	Result.Status = EHxlbPathStatus::InvalidQuery;
+	
+	if (!HexMap)
+	{
+		HXLB_LOG(LogHxlbRuntime, Error, TEXT("UHxlbPathfindingFunctions::FindPath(): HexMap is null."));
+		return Result;
+	}
+	if (!HexMap->GetCostField().IsValid())
+	{
+		HexMap->CompileCostLayer();
+	}
+
+	const FHxlbLandmarks* Landmarks = Params.bUseLandmarks ? &HexMap->GetLandmarks() : nullptr;
+	FHxlbPathfinder::FindPath(HexMap->GetCostField(), Start, Goal, Params, Result, Landmarks);
+	return Result;
+}
+
+int64 UHxlbPathfindingFunctions::GetLandmarkMemoryPerLandmark(UHxlbHexMapComponent* HexMap)
+{
+	return HexMap ? static_cast<int64>(HexMap->GetLandmarks().GetAllocatedSizePerLandmark()) : 0;
+}
+
+FHxlbPathResult UHxlbPathfindingFunctions::FindPathHierarchical(UHxlbHexMapComponent* HexMap, FIntPoint Start, FIntPoint Goal)
+{
+	FHxlbPathResult Result;
+	Result.Status = EHxlbPathStatus::InvalidQuery;
+	
+	if (!HexMap)
+	{
+		HXLB_LOG(LogHxlbRuntime, Error, TEXT("UHxlbPathfindingFunctions::FindPathHierarchical(): HexMap is null."));
+		return Result;
+	}
+
+	const FHxlbHierarchicalPathfinder& Pathfinder = HexMap->GetHierarchicalPathfinder();
+	Pathfinder.FindPath(HexMap->GetCostField(), Start, Goal, Result);
+	return Result;
+}
+
+TArray<FHxlbPathResult> UHxlbPathfindingFunctions::PlanGroupPaths(UHxlbHexMapComponent* HexMap, const TArray<FHxlbAgentPathRequest>& Requests, FHxlbCooperativePathParams Params)
+{
+	TArray<FHxlbPathResult> Results;
+	if (!HexMap)
+	{
+		HXLB_LOG(LogHxlbRuntime, Error, TEXT("UHxlbPathfindingFunctions::PlanGroupPaths(): HexMap is null."));
+		return Results;
+	}
+	if (!HexMap->GetCostField().IsValid())
+	{
+		HexMap->CompileCostLayer();
+	}
+
+	FHxlbCooperativePlanner Planner;
+	Planner.PlanGroup(HexMap->GetCostField(), Requests, Params, Results);
+	if (Planner.GetNumConflicts() > 0)
+	{
+		HXLB_LOG(LogHxlbRuntime, Warning, TEXT("UHxlbPathfindingFunctions::PlanGroupPaths(): %d states are claimed by more than one agent. Do several agents share a start hex?"), Planner.GetNumConflicts());
+	}
+	return Results;
+}
+
+bool UHxlbPathfindingFunctions::SetAgentPath(UHxlbHexMapComponent* HexMap, int32 AgentId, FIntPoint Start, FIntPoint Goal)
+{
+	if (!HexMap)
+	{
+		HXLB_LOG(LogHxlbRuntime, Error, TEXT("UHxlbPathfindingFunctions::SetAgentPath(): HexMap is null."));
+		return false;
+	}
+	return HexMap->SetAgentPath(AgentId, Start, Goal);
+}
+
+FHxlbPathResult UHxlbPathfindingFunctions::GetAgentPath(UHxlbHexMapComponent* HexMap, int32 AgentId)
+{
+	FHxlbPathResult Result;
+	if (!HexMap)
+	{
+		HXLB_LOG(LogHxlbRuntime, Error, TEXT("UHxlbPathfindingFunctions::GetAgentPath(): HexMap is null."));
+		Result.Status = EHxlbPathStatus::InvalidQuery;
+		return Result;
+	}
+	HexMap->FindAgentPath(AgentId, Result);
+	return Result;
+}
+
+bool UHxlbPathfindingFunctions::RemoveAgentPath(UHxlbHexMapComponent* HexMap, int32 AgentId)
+{
+	if (!HexMap)
+	{
+		HXLB_LOG(LogHxlbRuntime, Error, TEXT("UHxlbPathfindingFunctions::RemoveAgentPath(): HexMap is null."));
+		return false;
+	}
+	return HexMap->RemoveAgentPath(AgentId);
+}
+
+bool UHxlbPathfindingFunctions::GetFlowFieldNextHex(UHxlbHexMapComponent* HexMap, const TArray<FIntPoint>& Goals, FIntPoint HexCoord, FIntPoint& OutNextHex)
+{
+	OutNextHex = HexCoord;
+	if (!HexMap)
+	{
+		HXLB_LOG(LogHxlbRuntime, Error, TEXT("UHxlbPathfindingFunctions::GetFlowFieldNextHex(): HexMap is null."));
+		return false;
+	}
+
+	return HexMap->GetFlowField(Goals)->GetNextHex(HexCoord, OutNextHex);
+}
+
+TArray<FIntPoint> UHxlbPathfindingFunctions::GetMovementRange(UHxlbHexMapComponent* HexMap, FIntPoint Origin, float MaxCost, bool bUniformCost)
+{
+	TArray<FIntPoint> Hexes;
+	if (!HexMap)
+	{
+		HXLB_LOG(LogHxlbRuntime, Error, TEXT("UHxlbPathfindingFunctions::GetMovementRange(): HexMap is null."));
+		return Hexes;
+	}
+
+	const FHxlbMovementRange& MovementRange = HexMap->GetMovementRange();
+	FHxlbHexBitmap Reachable;
+	if (bUniformCost)
+	{
+		MovementRange.FindReachable(Origin, FMath::FloorToInt32(MaxCost), Reachable);
+	}
+	else
+	{
+		FHxlbMovementRange::FindReachableWeighted(HexMap->GetCostField(), Origin, MaxCost, Reachable);
+	}
+	Reachable.ToCoords(HexMap->GetDenseLayout(), Hexes);
+	return Hexes;
+}
+
+void UHxlbPathfindingFunctions::CompileMovementCosts(UHxlbHexMapComponent* HexMap)
+{
+	if (HexMap)
+	{
+		HexMap->CompileCostLayer();
+	}
+}
+
+void UHxlbPathfindingFunctions::UpdateMovementCosts(UHxlbHexMapComponent* HexMap, const TArray<FIntPoint>& HexCoords)
+{
+	if (HexMap)
+	{
+		HexMap->RecompileHexCosts(HexCoords);
+	}
+}
+
+bool UHxlbPathfindingFunctions::GetMovementCost(UHxlbHexMapComponent* HexMap, FIntPoint HexCoord, float& OutCost)
+{
+	OutCost = 0.0f;
+	if (!HexMap)
+	{
+		return false;
+	}
+	
+	const FHxlbCostField CostField = HexMap->GetCostField();
+	const int32 DenseIndex = CostField.IsValid() ? CostField.GetLayout().IndexOf(HexCoord) : INDEX_NONE;
+	if (DenseIndex == INDEX_NONE)
+	{
+		return false;
+	}
+	
+	OutCost = CostField.GetCost(DenseIndex);
+	return true;
+}
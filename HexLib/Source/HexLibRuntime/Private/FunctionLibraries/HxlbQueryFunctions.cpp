@@ -0,0 +1,124 @@
+// Copyright © Mason Stevenson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the disclaimer
+// below) provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+// THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+// CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+// NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "FunctionLibraries/HxlbQueryFunctions.h"
+
+#include "HexLibRuntimeLoggingDefs.h"
+#include "Foundation/HxlbHexMap.h"
+#include "Macros/HexLibLoggingMacros.h"
+
+TArray<FIntPoint> UHxlbQueryFunctions::QueryHexes(UHxlbHexMapComponent* HexMap, const FHxlbHexQuery& Query)
+{
+	TArray<FIntPoint> Hexes;
+	if (HexMap)
+	{
+		HexMap->QueryHexes(Query)->ToCoords(HexMap->GetDenseLayout(), Hexes);
+	}
+	return Hexes;
+}
+
+bool UHxlbQueryFunctions::IsHexInQuery(UHxlbHexMapComponent* HexMap, const FHxlbHexQuery& Query, FIntPoint HexCoord)
+{
+	const int32 DenseIndex = HexMap ? HexMap->GetDenseLayout().IndexOf(HexCoord) : INDEX_NONE;
+	return DenseIndex != INDEX_NONE && HexMap->QueryHexes(Query)->Contains(DenseIndex);
+}
+
+FHxlbQueryCacheStats UHxlbQueryFunctions::GetQueryCacheStats(UHxlbHexMapComponent* HexMap)
+{
+	return HexMap ? HexMap->GetQueryCache().GetStats() : FHxlbQueryCacheStats();
+}
+
+void UHxlbQueryFunctions::ResetQueryCacheStats(UHxlbHexMapComponent* HexMap)
+{
+	if (HexMap)
+	{
+		HexMap->GetQueryCache().ResetStats();
+	}
+}
+
+TArray<FIntPoint> UHxlbQueryFunctions::FindHexesNear(
+	UHxlbHexMapComponent* HexMap,
+	FIntPoint Origin,
+	int32 Radius,
+	const TArray<FHxlbLayerCondition>& LayerConditions,
+	const FGameplayTagContainer& RequiredTags,
+	const FGameplayTagContainer& ExcludedTags,
+	bool bNearestFirst,
+	int32 MaxResults
+)
+{
+	TArray<FIntPoint> Hexes;
+	if (!HexMap)
+	{
+		return Hexes;
+	}
+	
+	const FHxlbDenseLayout& Layout = HexMap->GetDenseLayout();
+	FHxlbHexQueryBuilder Query(Layout);
+	Query.InRadius(Origin, Radius);
+	for (const FHxlbLayerCondition& Condition : LayerConditions)
+	{
+		if (const THxlbHexLayer<float>* FloatLayer = HexMap->FindLayer<float>(Condition.LayerName))
+		{
+			Query.Where(*FloatLayer, Condition.Op, Condition.Value);
+		}
+		else if (const THxlbHexLayer<int32>* IntLayer = HexMap->FindLayer<int32>(Condition.LayerName))
+		{
+			Query.Where(*IntLayer, Condition.Op, FMath::RoundToInt32(Condition.Value));
+		}
+		else
+		{
+			HXLB_LOG(LogHxlbRuntime, Warning, TEXT("UHxlbQueryFunctions::FindHexesNear(): No float or int32 hex layer named %s."), *Condition.LayerName.ToString());
+			return Hexes;
+		}
+	}
+	for (const FGameplayTag& Tag : RequiredTags)
+	{
+		Query.WhereIn(HexMap->GetTagIndex(Tag));
+	}
+	for (const FGameplayTag& Tag : ExcludedTags)
+	{
+		Query.WhereNotIn(HexMap->GetTagIndex(Tag));
+	}
+	if (bNearestFirst)
+	{
+		Query.OrderByDistance(Origin);
+	}
+
+	TArray<int32> DenseIndices;
+	Query.Limit(MaxResults).Execute(DenseIndices);
+	Hexes.Reserve(DenseIndices.Num());
+	for (int32 DenseIndex : DenseIndices)
+	{
+		Hexes.Add(Layout.CoordOf(DenseIndex));
+	}
+	return Hexes;
+}
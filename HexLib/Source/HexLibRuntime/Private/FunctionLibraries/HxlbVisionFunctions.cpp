@@ -0,0 +1,148 @@
+// Copyright © Mason Stevenson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the disclaimer
+// below) provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+// THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+// CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+// NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "FunctionLibraries/HxlbVisionFunctions.h"
+
+#include "HexLibRuntimeLoggingDefs.h"
+#include "Foundation/HxlbHexMap.h"
+#include "Macros/HexLibLoggingMacros.h"
+
+TArray<FIntPoint> UHxlbVisionFunctions::GetVisibleHexes(UHxlbHexMapComponent* HexMap, FHxlbVisionObserver Observer)
+{
+	return GetVisibleHexesForObservers(HexMap, {Observer});
+}
+
+TArray<FIntPoint> UHxlbVisionFunctions::GetVisibleHexesForObservers(UHxlbHexMapComponent* HexMap, const TArray<FHxlbVisionObserver>& Observers)
+{
+	TArray<FIntPoint> Hexes;
+	if (!HexMap)
+	{
+		HXLB_LOG(LogHxlbRuntime, Error, TEXT("UHxlbVisionFunctions::GetVisibleHexes(): HexMap is null."));
+		return Hexes;
+	}
+
+	int32 MaxRadius = 0;
+	for (const FHxlbVisionObserver& Observer : Observers)
+	{
+		MaxRadius = FMath::Max(MaxRadius, Observer.Radius);
+	}
+
+	FHxlbHexBitmap Visible;
+	HexMap->GetFieldOfView(MaxRadius).ComputeUnion(HexMap->GetVisionField(), Observers, Visible);
+	Visible.ToCoords(HexMap->GetDenseLayout(), Hexes);
+	return Hexes;
+}
+
+void UHxlbVisionFunctions::SetVisionObserver(UHxlbHexMapComponent* HexMap, int32 PlayerId, int32 ObserverId, FHxlbVisionObserver Observer)
+{
+	if (HexMap)
+	{
+		HexMap->GetFogOfWar().SetObserver(PlayerId, ObserverId, Observer);
+	}
+}
+
+void UHxlbVisionFunctions::RemoveVisionObserver(UHxlbHexMapComponent* HexMap, int32 PlayerId, int32 ObserverId)
+{
+	if (HexMap)
+	{
+		HexMap->GetFogOfWar().RemoveObserver(PlayerId, ObserverId);
+	}
+}
+
+void UHxlbVisionFunctions::UpdateFogOfWar(UHxlbHexMapComponent* HexMap)
+{
+	if (!HexMap)
+	{
+		HXLB_LOG(LogHxlbRuntime, Error, TEXT("UHxlbVisionFunctions::UpdateFogOfWar(): HexMap is null."));
+		return;
+	}
+	HexMap->UpdateFogOfWar();
+}
+
+void UHxlbVisionFunctions::GetFogOfWarChanges(UHxlbHexMapComponent* HexMap, int32 PlayerId, TArray<FIntPoint>& OutBecameVisible, TArray<FIntPoint>& OutBecameHidden)
+{
+	OutBecameVisible.Reset();
+	OutBecameHidden.Reset();
+	if (!HexMap)
+	{
+		return;
+	}
+
+	const FHxlbDenseLayout& Layout = HexMap->GetDenseLayout();
+	for (int32 DenseIndex : HexMap->GetFogOfWar().GetBecameVisible(PlayerId))
+	{
+		OutBecameVisible.Add(Layout.CoordOf(DenseIndex));
+	}
+	for (int32 DenseIndex : HexMap->GetFogOfWar().GetBecameHidden(PlayerId))
+	{
+		OutBecameHidden.Add(Layout.CoordOf(DenseIndex));
+	}
+}
+
+bool UHxlbVisionFunctions::IsHexVisibleToPlayer(UHxlbHexMapComponent* HexMap, int32 PlayerId, FIntPoint HexCoord)
+{
+	return HexMap && HexMap->GetFogOfWar().IsVisible(PlayerId, HexMap->GetDenseLayout().IndexOf(HexCoord));
+}
+
+bool UHxlbVisionFunctions::WasHexSeenByPlayer(UHxlbHexMapComponent* HexMap, int32 PlayerId, FIntPoint HexCoord)
+{
+	return HexMap && HexMap->GetFogOfWar().WasSeen(PlayerId, HexMap->GetDenseLayout().IndexOf(HexCoord));
+}
+
+EHxlbCoverLevel UHxlbVisionFunctions::GetHexEdgeCover(UHxlbHexMapComponent* HexMap, FIntPoint HexCoord, int32 DirectionIndex)
+{
+	const int32 DenseIndex = HexMap ? HexMap->GetDenseLayout().IndexOf(HexCoord) : INDEX_NONE;
+	if (DenseIndex == INDEX_NONE || DirectionIndex < 0 || DirectionIndex >= 6)
+	{
+		return EHxlbCoverLevel::None;
+	}
+	return HexMap->GetCoverMap().GetCover(DenseIndex, DirectionIndex);
+}
+
+EHxlbCoverLevel UHxlbVisionFunctions::GetHexCoverAgainst(UHxlbHexMapComponent* HexMap, FIntPoint HexCoord, FIntPoint ThreatCoord)
+{
+	const int32 DenseIndex = HexMap ? HexMap->GetDenseLayout().IndexOf(HexCoord) : INDEX_NONE;
+	if (DenseIndex == INDEX_NONE)
+	{
+		return EHxlbCoverLevel::None;
+	}
+	return HexMap->GetCoverMap().GetCoverAgainst(DenseIndex, ThreatCoord);
+}
+
+int32 UHxlbVisionFunctions::CountHexExposures(UHxlbHexMapComponent* HexMap, FIntPoint HexCoord, const TArray<FIntPoint>& ThreatCoords, EHxlbCoverLevel MinCover)
+{
+	const int32 DenseIndex = HexMap ? HexMap->GetDenseLayout().IndexOf(HexCoord) : INDEX_NONE;
+	if (DenseIndex == INDEX_NONE)
+	{
+		return ThreatCoords.Num();
+	}
+	return HexMap->GetCoverMap().CountExposures(DenseIndex, ThreatCoords, MinCover);
+}
@@ -0,0 +1,408 @@
+// Copyright © Mason Stevenson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the disclaimer
+// below) provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+// THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+// CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+// NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "Generation/HxlbMapGeneration.h"
+
+#include "HexLibRuntimeLoggingDefs.h"
+#include "Analysis/HxlbRegionBorders.h"
+#include "Analysis/HxlbVoronoiPartition.h"
+#include "Async/ParallelFor.h"
+#include "FunctionLibraries/HxlbMath.h"
+#include "Macros/HexLibLoggingMacros.h"
+
+using HexMath = UHxlbMath;
+
+namespace
+{
+	float ValueNoise(int32 Seed, uint32 Stream, float X, float Y)
+	{
+		const int32 X0 = FMath::FloorToInt32(X);
+		const int32 Y0 = FMath::FloorToInt32(Y);
+		const float FracX = X - X0;
+		const float FracY = Y - Y0;
+		
+		// Quintic fade, so that the noise has no visible creases along the lattice.
+		const float U = FracX * FracX * FracX * (FracX * (FracX * 6.0f - 15.0f) + 10.0f);
+		const float V = FracY * FracY * FracY * (FracY * (FracY * 6.0f - 15.0f) + 10.0f);
+		
+		constexpr float ToUnit = 1.0f / 4294967295.0f;
+		const float V00 = HxlbHexRandom::Hash(Seed, Stream, X0, Y0) * ToUnit;
+		const float V10 = HxlbHexRandom::Hash(Seed, Stream, X0 + 1, Y0) * ToUnit;
+		const float V01 = HxlbHexRandom::Hash(Seed, Stream, X0, Y0 + 1) * ToUnit;
+		const float V11 = HxlbHexRandom::Hash(Seed, Stream, X0 + 1, Y0 + 1) * ToUnit;
+		return FMath::Lerp(FMath::Lerp(V00, V10, U), FMath::Lerp(V01, V11, U), V);
+	}
+}
+
+float HxlbHexRandom::FractalNoise(int32 Seed, uint32 Stream, FIntPoint AxialCoord, float Frequency, int32 Octaves, float Lacunarity, float Persistence)
+{
+	// Center of the hex for a hex size of 1, see UHxlbMath::AxialToWorld().
+	static const float Sqrt3 = FMath::Sqrt(3.0f);
+	const float X = Sqrt3 * (HEX_Q(AxialCoord) + 0.5f * HEX_R(AxialCoord));
+	const float Y = 1.5f * HEX_R(AxialCoord);
+
+	float Sum = 0.0f;
+	float AmplitudeSum = 0.0f;
+	float Amplitude = 1.0f;
+	float OctaveFrequency = Frequency;
+	for (int32 Octave = 0; Octave < Octaves; Octave++)
+	{
+		Sum += Amplitude * ValueNoise(Seed, Stream * 16 + Octave, X * OctaveFrequency, Y * OctaveFrequency);
+		AmplitudeSum += Amplitude;
+		Amplitude *= Persistence;
+		OctaveFrequency *= Lacunarity;
+	}
+	return AmplitudeSum > 0.0f ? FMath::Clamp(Sum / AmplitudeSum, 0.0f, 1.0f) : 0.0f;
+}
+
+void FHxlbNoiseStage::Run(FHxlbMapGenContext& Context) const
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(HXLB_MapGenNoise);
+	
+	THxlbHexLayer<float>* Layer = Context.WriteLayer<float>(LayerName);
+	if (!Layer)
+	{
+		HXLB_LOG(LogHxlbRuntime, Error, TEXT("FHxlbNoiseStage::Run(): Layer %s is not a float layer."), *LayerName.ToString());
+		return;
+	}
+
+	TArrayView<float> Values = Layer->GetMutableValues();
+	const int32 Seed = Context.GetSeed();
+	Context.ForEachHex([this, &Values, Seed](FIntPoint AxialCoord, int32 DenseIndex)
+	{
+		const float Noise = HxlbHexRandom::FractalNoise(Seed, Stream, AxialCoord, Settings.Frequency, Settings.Octaves, Settings.Lacunarity, Settings.Persistence);
+		Values[DenseIndex] = FMath::Lerp(Settings.MinValue, Settings.MaxValue, Noise);
+	});
+}
+
+void FHxlbBiomeStage::Run(FHxlbMapGenContext& Context) const
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(HXLB_MapGenBiomes);
+	
+	const THxlbHexLayer<float>* Elevation = Context.FindLayer<float>(ElevationLayerName);
+	const THxlbHexLayer<float>* Moisture = Context.FindLayer<float>(MoistureLayerName);
+	THxlbHexLayer<int32>* Layer = Context.WriteLayer<int32>(LayerName);
+	if (!Layer)
+	{
+		HXLB_LOG(LogHxlbRuntime, Error, TEXT("FHxlbBiomeStage::Run(): Layer %s is not an int32 layer."), *LayerName.ToString());
+		return;
+	}
+
+	TArrayView<int32> Biomes = Layer->GetMutableValues();
+	Context.ForEachHex([this, &Biomes, Elevation, Moisture](FIntPoint AxialCoord, int32 DenseIndex)
+	{
+		const float Height = Elevation ? Elevation->Get(DenseIndex) : 0.0f;
+		const float Wetness = Moisture ? Moisture->Get(DenseIndex) : 0.0f;
+		
+		int32 Biome = DefaultBiome;
+		for (const FHxlbBiomeRule& Rule : Rules)
+		{
+			if (Height >= Rule.MinElevation && Height < Rule.MaxElevation && Wetness >= Rule.MinMoisture && Wetness < Rule.MaxMoisture)
+			{
+				Biome = Rule.Biome;
+				break;
+			}
+		}
+		Biomes[DenseIndex] = Biome;
+	});
+}
+
+void FHxlbRiverStage::Run(FHxlbMapGenContext& Context) const
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(HXLB_MapGenRivers);
+	
+	const FHxlbDenseLayout& Layout = Context.GetLayout();
+	const THxlbHexLayer<float>* Elevation = Context.FindLayer<float>(ElevationLayerName);
+	THxlbHexLayer<uint8>* Layer = Context.WriteLayer<uint8>(LayerName);
+	if (!Layer)
+	{
+		HXLB_LOG(LogHxlbRuntime, Error, TEXT("FHxlbRiverStage::Run(): Layer %s is not a uint8 layer."), *LayerName.ToString());
+		return;
+	}
+
+	TArrayView<uint8> EdgeBits = Layer->GetMutableValues();
+	for (uint8& Bits : EdgeBits)
+	{
+		Bits = 0;
+	}
+	if (!Elevation || NumRivers <= 0)
+	{
+		return;
+	}
+	const TConstArrayView<float> Heights = Elevation->GetValues();
+	const int32 Seed = Context.GetSeed();
+
+	// The sources are the candidates with the smallest hashes, which doesn't depend on the order they are found in.
+	TArray<TPair<uint32, int32>> Sources;
+	for (int32 DenseIndex = 0; DenseIndex < Layout.Num(); DenseIndex++)
+	{
+		if (Heights[DenseIndex] >= SourceMinElevation && Heights[DenseIndex] >= SeaLevel)
+		{
+			const FIntPoint AxialCoord = Layout.CoordOf(DenseIndex);
+			Sources.Emplace(HxlbHexRandom::Hash(Seed, Stream, HEX_Q(AxialCoord), HEX_R(AxialCoord)), DenseIndex);
+		}
+	}
+	Sources.Sort([](const TPair<uint32, int32>& A, const TPair<uint32, int32>& B)
+	{
+		return A.Key != B.Key ? A.Key < B.Key : A.Value < B.Value;
+	});
+	Sources.SetNum(FMath::Min(Sources.Num(), NumRivers));
+
+	// Corner C of a hex is shared with its neighbors in directions C - 2 and C - 1, and edge D of a hex runs from its
+	// corner D + 1 to its corner D + 2. Returns false if the corner touches water or the edge of the map.
+	auto SampleCorner = [this, &Layout, Heights](FIntPoint HexCoord, int32 Corner, float& OutHeight)
+	{
+		const FIntPoint Touching[3] = {
+			HexCoord,
+			HexCoord + HexMath::DirectionIndexToAxial((Corner + 4) % 6),
+			HexCoord + HexMath::DirectionIndexToAxial((Corner + 5) % 6)
+		};
+		
+		bool bInland = true;
+		int32 NumInside = 0;
+		float Sum = 0.0f;
+		for (const FIntPoint& AxialCoord : Touching)
+		{
+			const int32 DenseIndex = Layout.IndexOf(AxialCoord);
+			if (DenseIndex == INDEX_NONE)
+			{
+				bInland = false;
+				continue;
+			}
+			Sum += Heights[DenseIndex];
+			NumInside++;
+			bInland &= Heights[DenseIndex] >= SeaLevel;
+		}
+		OutHeight = NumInside > 0 ? Sum / NumInside : 0.0f;
+		return bInland;
+	};
+
+	// Each river is a list of (Q, R, Direction) edges.
+	TArray<TArray<FIntVector>> RiverEdges;
+	RiverEdges.SetNum(Sources.Num());
+	ParallelFor(Sources.Num(), [&Sources, &RiverEdges, &Layout, &SampleCorner](int32 RiverIndex)
+	{
+		FIntPoint HexCoord = Layout.CoordOf(Sources[RiverIndex].Value);
+		int32 Corner = static_cast<int32>(Sources[RiverIndex].Key % 6);
+		float Height;
+		if (!SampleCorner(HexCoord, Corner, Height))
+		{
+			return;
+		}
+
+		TSet<int64> Visited;
+		Visited.Add(FHxlbRegionBorders::CornerKey(HexCoord, Corner));
+		for (int32 Step = 0; Step < Layout.Num(); Step++)
+		{
+			// The three edges that meet at the corner, as the hex and direction of the edge and the corner it leads to.
+			const FIntPoint Across = HexCoord + HexMath::DirectionIndexToAxial((Corner + 5) % 6);
+			const FIntVector Edges[3] = {
+				FIntVector(HEX_Q(HexCoord), HEX_R(HexCoord), (Corner + 5) % 6),
+				FIntVector(HEX_Q(HexCoord), HEX_R(HexCoord), (Corner + 4) % 6),
+				FIntVector(HEX_Q(Across), HEX_R(Across), (Corner + 3) % 6)
+			};
+			const TPair<FIntPoint, int32> NextCorners[3] = {
+				{HexCoord, (Corner + 1) % 6},
+				{HexCoord, (Corner + 5) % 6},
+				{Across, (Corner + 5) % 6}
+			};
+
+			int32 Best = INDEX_NONE;
+			float BestHeight = Height;
+			bool bBestInland = false;
+			for (int32 Option = 0; Option < 3; Option++)
+			{
+				float NextHeight;
+				const bool bInland = SampleCorner(NextCorners[Option].Key, NextCorners[Option].Value, NextHeight);
+				if (NextHeight < BestHeight && !Visited.Contains(FHxlbRegionBorders::CornerKey(NextCorners[Option].Key, NextCorners[Option].Value)))
+				{
+					Best = Option;
+					BestHeight = NextHeight;
+					bBestInland = bInland;
+				}
+			}
+			if (Best == INDEX_NONE)
+			{
+				// Local minimum.
+				break;
+			}
+
+			RiverEdges[RiverIndex].Add(Edges[Best]);
+			HexCoord = NextCorners[Best].Key;
+			Corner = NextCorners[Best].Value;
+			Height = BestHeight;
+			Visited.Add(FHxlbRegionBorders::CornerKey(HexCoord, Corner));
+			if (!bBestInland)
+			{
+				break;
+			}
+		}
+	}, Context.bForceSingleThread ? EParallelForFlags::ForceSingleThread : EParallelForFlags::None);
+
+	// Both hexes along a river edge get the bit, so either side can be asked.
+	for (const TArray<FIntVector>& Edges : RiverEdges)
+	{
+		for (const FIntVector& Edge : Edges)
+		{
+			const FIntPoint HexCoord(Edge.X, Edge.Y);
+			if (const int32 DenseIndex = Layout.IndexOf(HexCoord); DenseIndex != INDEX_NONE)
+			{
+				EdgeBits[DenseIndex] |= 1 << Edge.Z;
+			}
+			if (const int32 NeighborIndex = Layout.NeighborIndex(HexCoord, Edge.Z); NeighborIndex != INDEX_NONE)
+			{
+				EdgeBits[NeighborIndex] |= 1 << ((Edge.Z + 3) % 6);
+			}
+		}
+	}
+}
+
+void FHxlbResourceStage::Run(FHxlbMapGenContext& Context) const
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(HXLB_MapGenResources);
+	
+	const THxlbHexLayer<int32>* BiomeLayer = Context.FindLayer<int32>(BiomeLayerName);
+	THxlbHexLayer<int32>* Layer = Context.WriteLayer<int32>(LayerName);
+	if (!Layer)
+	{
+		HXLB_LOG(LogHxlbRuntime, Error, TEXT("FHxlbResourceStage::Run(): Layer %s is not an int32 layer."), *LayerName.ToString());
+		return;
+	}
+
+	TArrayView<int32> Resources = Layer->GetMutableValues();
+	const int32 Seed = Context.GetSeed();
+	Context.ForEachHex([this, &Resources, BiomeLayer, Seed](FIntPoint AxialCoord, int32 DenseIndex)
+	{
+		const int32 Biome = BiomeLayer ? BiomeLayer->Get(DenseIndex) : 0;
+		
+		int32 Resource = 0;
+		for (int32 RuleIndex = 0; RuleIndex < Rules.Num(); RuleIndex++)
+		{
+			const FHxlbResourceRule& Rule = Rules[RuleIndex];
+			if ((Rule.Biomes.IsEmpty() || Rule.Biomes.Contains(Biome))
+				&& HxlbHexRandom::FRand(Seed, (Stream << 8) + RuleIndex, AxialCoord) < Rule.Chance)
+			{
+				Resource = Rule.Resource;
+				break;
+			}
+		}
+		Resources[DenseIndex] = Resource;
+	});
+}
+
+void FHxlbRegionStage::Run(FHxlbMapGenContext& Context) const
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(HXLB_MapGenRegions);
+	
+	const THxlbHexLayer<float>* CostLayer = Settings.CostLayerName.IsNone() ? nullptr : Context.FindLayer<float>(Settings.CostLayerName);
+	if (!Settings.CostLayerName.IsNone() && !CostLayer)
+	{
+		HXLB_LOG(LogHxlbRuntime, Warning, TEXT("FHxlbRegionStage::Run(): Cost layer %s doesn't exist or doesn't hold floats, regions ignore terrain."), *Settings.CostLayerName.ToString());
+	}
+	THxlbHexLayer<int32>* Layer = Context.WriteLayer<int32>(LayerName);
+	if (!Layer)
+	{
+		HXLB_LOG(LogHxlbRuntime, Error, TEXT("FHxlbRegionStage::Run(): Layer %s is not an int32 layer."), *LayerName.ToString());
+		return;
+	}
+
+	// Distinct seeds, drawn by attempt number so that they don't depend on anything but the seed and the layout.
+	const FHxlbDenseLayout& Layout = Context.GetLayout();
+	const int32 NumRegions = FMath::Min(Settings.NumRegions, Layout.Num());
+	TArray<int32> Seeds;
+	for (int32 Attempt = 0; Seeds.Num() < NumRegions && Attempt < NumRegions * 16; Attempt++)
+	{
+		Seeds.AddUnique(static_cast<int32>(HxlbHexRandom::Hash(Context.GetSeed(), Stream, Attempt, 0) % static_cast<uint32>(Layout.Num())));
+	}
+
+	FHxlbVoronoiPartition Partition;
+	if (CostLayer)
+	{
+		TArray<float> Costs(CostLayer->GetValues());
+		for (float& Cost : Costs)
+		{
+			Cost = FMath::Max(Cost, Settings.MinimumCost);
+		}
+		Partition.Build(FHxlbCostField(Layout, Costs, Settings.MinimumCost), Seeds, Settings.LloydIterations);
+	}
+	else
+	{
+		Partition.Build(Layout, Seeds, Settings.LloydIterations);
+	}
+
+	// Unreached hexes are INDEX_NONE, which becomes 0.
+	TArrayView<int32> RegionIds = Layer->GetMutableValues();
+	Context.ForEachHex([&RegionIds, &Partition](FIntPoint AxialCoord, int32 DenseIndex)
+	{
+		RegionIds[DenseIndex] = Partition.GetRegion(DenseIndex) + 1;
+	});
+}
+
+FHxlbMapGenerator FHxlbMapGenerator::FromSettings(const FHxlbMapGenSettings& Settings)
+{
+	// Streams are fixed per stage, so that turning one stage off doesn't change what the others generate.
+	FHxlbMapGenerator Generator;
+	if (!Settings.ElevationLayerName.IsNone())
+	{
+		Generator.AddStage(MakeShared<FHxlbNoiseStage>(Settings.ElevationLayerName, Settings.ElevationNoise, 1));
+	}
+	if (!Settings.MoistureLayerName.IsNone())
+	{
+		Generator.AddStage(MakeShared<FHxlbNoiseStage>(Settings.MoistureLayerName, Settings.MoistureNoise, 2));
+	}
+	if (!Settings.BiomeLayerName.IsNone())
+	{
+		Generator.AddStage(MakeShared<FHxlbBiomeStage>(Settings.BiomeLayerName, Settings.ElevationLayerName, Settings.MoistureLayerName, Settings.BiomeRules, Settings.DefaultBiome));
+	}
+	if (!Settings.RiverLayerName.IsNone())
+	{
+		Generator.AddStage(MakeShared<FHxlbRiverStage>(Settings.RiverLayerName, Settings.ElevationLayerName, Settings.NumRivers, Settings.RiverSourceMinElevation, Settings.SeaLevel, 3));
+	}
+	if (!Settings.ResourceLayerName.IsNone())
+	{
+		Generator.AddStage(MakeShared<FHxlbResourceStage>(Settings.ResourceLayerName, Settings.BiomeLayerName, Settings.ResourceRules, 4));
+	}
+	if (!Settings.RegionLayerName.IsNone())
+	{
+		Generator.AddStage(MakeShared<FHxlbRegionStage>(Settings.RegionLayerName, Settings.RegionSettings, 5));
+	}
+	return Generator;
+}
+
+void FHxlbMapGenerator::Run(FHxlbMapGenContext& Context) const
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(HXLB_GenerateMap);
+	
+	for (const TSharedRef<const FHxlbMapGenStage>& Stage : Stages)
+	{
+		Stage->Run(Context);
+	}
+}
@@ -0,0 +1,423 @@
+// Copyright © Mason Stevenson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the disclaimer
+// below) provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+// THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+// CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+// NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "Navigation/HxlbCooperativePathfinding.h"
+
+#include "Algo/Reverse.h"
+#include "FunctionLibraries/HxlbMath.h"
+
+using HexMath = UHxlbMath;
+
+void FHxlbSpaceTimeTable::Reset()
+{
+	if (NumUsed > 0)
+	{
+		// Every byte of kEmptyKey is 0xFF.
+		FMemory::Memset(Keys.GetData(), 0xFF, Keys.Num() * sizeof(uint64));
+		NumUsed = 0;
+	}
+}
+
+int32 FHxlbSpaceTimeTable::Find(uint64 Key) const
+{
+	if (NumUsed == 0)
+	{
+		return INDEX_NONE;
+	}
+	
+	const uint32 Mask = Keys.Num() - 1;
+	for (uint32 Slot = HashKey(Key) & Mask; ; Slot = (Slot + 1) & Mask)
+	{
+		if (Keys[Slot] == Key)
+		{
+			return Values[Slot];
+		}
+		if (Keys[Slot] == kEmptyKey)
+		{
+			return INDEX_NONE;
+		}
+	}
+}
+
+int32& FHxlbSpaceTimeTable::FindOrAdd(uint64 Key, int32 Value)
+{
+	// Kept at most half full, so probes stay short.
+	if ((NumUsed + 1) * 2 > Keys.Num())
+	{
+		Grow();
+	}
+	
+	const uint32 Mask = Keys.Num() - 1;
+	uint32 Slot = HashKey(Key) & Mask;
+	while (Keys[Slot] != kEmptyKey)
+	{
+		if (Keys[Slot] == Key)
+		{
+			return Values[Slot];
+		}
+		Slot = (Slot + 1) & Mask;
+	}
+	
+	Keys[Slot] = Key;
+	Values[Slot] = Value;
+	NumUsed++;
+	return Values[Slot];
+}
+
+void FHxlbSpaceTimeTable::Grow()
+{
+	TArray<uint64> OldKeys = MoveTemp(Keys);
+	TArray<int32> OldValues = MoveTemp(Values);
+	
+	const int32 NewCapacity = FMath::Max(64, OldKeys.Num() * 2);
+	Keys.Init(kEmptyKey, NewCapacity);
+	Values.SetNumUninitialized(NewCapacity);
+	NumUsed = 0;
+	
+	for (int32 Slot = 0; Slot < OldKeys.Num(); Slot++)
+	{
+		if (OldKeys[Slot] != kEmptyKey)
+		{
+			FindOrAdd(OldKeys[Slot], OldValues[Slot]);
+		}
+	}
+}
+
+void FHxlbCooperativePlanner::Reset()
+{
+	Reservations.Reset();
+	AgentReservations.Reset();
+	NumConflicts = 0;
+}
+
+void FHxlbCooperativePlanner::PlanGroup(const FHxlbCostField& CostField, TConstArrayView<FHxlbAgentPathRequest> Requests, const FHxlbCooperativePathParams& Params, TArray<FHxlbPathResult>& OutResults)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(HXLB_PlanGroup);
+	
+	Reset();
+	OutResults.Reset();
+	OutResults.SetNum(Requests.Num());
+	if (!CostField.IsValid())
+	{
+		for (FHxlbPathResult& Result : OutResults)
+		{
+			Result.Status = EHxlbPathStatus::InvalidQuery;
+		}
+		return;
+	}
+
+	// Nobody plans through a hex that another agent is standing on right now.
+	const FHxlbDenseLayout& Layout = CostField.GetLayout();
+	for (int32 AgentId = 0; AgentId < Requests.Num(); AgentId++)
+	{
+		const int32 StartIndex = Layout.IndexOf(Requests[AgentId].Start);
+		if (StartIndex != INDEX_NONE)
+		{
+			Reserve(AgentId, StartIndex, 0);
+		}
+	}
+
+	TArray<int32> Order;
+	Order.Reserve(Requests.Num());
+	for (int32 AgentId = 0; AgentId < Requests.Num(); AgentId++)
+	{
+		Order.Add(AgentId);
+	}
+	Order.StableSort([&Requests](int32 A, int32 B)
+	{
+		return Requests[A].Priority > Requests[B].Priority;
+	});
+	TArray<int32> Rank;
+	Rank.SetNum(Requests.Num());
+	for (int32 OrderIndex = 0; OrderIndex < Order.Num(); OrderIndex++)
+	{
+		Rank[Order[OrderIndex]] = OrderIndex;
+	}
+
+	// Agents still to plan, the next one on top.
+	TArray<int32> Pending;
+	Pending.Reserve(Requests.Num());
+	for (int32 OrderIndex = Order.Num() - 1; OrderIndex >= 0; OrderIndex--)
+	{
+		Pending.Add(Order[OrderIndex]);
+	}
+	
+	int32 NumRepairs = 0;
+	while (!Pending.IsEmpty())
+	{
+		const int32 AgentId = Pending.Pop();
+		const int32 NumConflictsBefore = NumConflicts;
+		PlanAgent(CostField, AgentId, Requests[AgentId], Params, OutResults[AgentId]);
+		if (Blockers.IsEmpty() || NumRepairs + Blockers.Num() > Requests.Num())
+		{
+			continue;
+		}
+
+		// The agent is boxed in at its start by paths planned before it, so those paths make way: they are taken back,
+		// the agent is planned again, then they are planned again around it, in order of priority. Everyone else keeps
+		// their path. The number of repairs is bounded, and conflicts left after that are counted.
+		NumConflicts = NumConflictsBefore;
+		NumRepairs += Blockers.Num();
+		Blockers.Sort([&Rank](int32 A, int32 B)
+		{
+			return Rank[A] > Rank[B];
+		});
+		for (int32 Blocker : Blockers)
+		{
+			ReleaseAgent(Blocker);
+			Reserve(Blocker, Layout.IndexOf(Requests[Blocker].Start), 0);
+			Pending.Add(Blocker);
+		}
+		Pending.Add(AgentId);
+	}
+}
+
+EHxlbPathStatus FHxlbCooperativePlanner::PlanAgent(const FHxlbCostField& CostField, int32 AgentId, const FHxlbAgentPathRequest& Request, const FHxlbCooperativePathParams& Params, FHxlbPathResult& OutResult)
+{
+	OutResult.Path.Reset();
+	OutResult.Cost = 0.0f;
+	OutResult.NumExpanded = 0;
+	OutResult.Status = EHxlbPathStatus::InvalidQuery;
+
+	if (!CostField.IsValid())
+	{
+		return OutResult.Status;
+	}
+	
+	const FHxlbDenseLayout& Layout = CostField.GetLayout();
+	const int32 StartIndex = Layout.IndexOf(Request.Start);
+	const int32 GoalIndex = Layout.IndexOf(Request.Goal);
+	if (StartIndex == INDEX_NONE || GoalIndex == INDEX_NONE)
+	{
+		return OutResult.Status;
+	}
+
+	// The agent plans against everyone else, not against its own previous plan.
+	ReleaseAgent(AgentId);
+	Blockers.Reset();
+
+	const int32 Window = FMath::Max(1, Params.Window);
+	const float WaitCost = FMath::Max(0.0f, Params.WaitCost);
+	const float HeuristicScale = CostField.GetMinCost();
+	auto Heuristic = [&Request, HeuristicScale](FIntPoint HexCoord)
+	{
+		return HexMath::AxialDistanceFast(HexCoord, Request.Goal) * HeuristicScale;
+	};
+	
+	NodeIndices.Reset();
+	Nodes.Reset();
+	Heap.Reset();
+	
+	Nodes.Add(FNode{StartIndex, 0, 0.0f, INDEX_NONE, false});
+	NodeIndices.FindOrAdd(FHxlbSpaceTimeTable::PackKey(StartIndex, 0), 0);
+	Heap.Push(Heuristic(Request.Start), 0);
+
+	// For partial paths: the explored state closest to the goal where the agent can stay, and the cheapest way to it.
+	int32 BestNode = INDEX_NONE;
+	float BestHeuristic = TNumericLimits<float>::Max();
+	
+	int32 EndNode = INDEX_NONE;
+	int32 NumExpanded = 0;
+	while (!Heap.IsEmpty())
+	{
+		const int32 NodeIndex = Heap.Pop().Index;
+		if (Nodes[NodeIndex].bClosed)
+		{
+			continue;
+		}
+		Nodes[NodeIndex].bClosed = true;
+		const FNode Node = Nodes[NodeIndex];
+
+		if (Node.DenseIndex == GoalIndex && CanHold(AgentId, GoalIndex, Node.Tick, Window))
+		{
+			EndNode = NodeIndex;
+			OutResult.Status = EHxlbPathStatus::Found;
+			break;
+		}
+		if (Node.Tick >= Window)
+		{
+			// The cheapest way to the goal as far as the window can tell.
+			EndNode = NodeIndex;
+			OutResult.Status = EHxlbPathStatus::Partial;
+			break;
+		}
+
+		const FIntPoint HexCoord = Layout.CoordOf(Node.DenseIndex);
+		const float NodeHeuristic = Heuristic(HexCoord);
+		const bool bIsCloser = NodeHeuristic < BestHeuristic || (NodeHeuristic == BestHeuristic && Node.Cost < Nodes[BestNode].Cost);
+		if (bIsCloser && CanHold(AgentId, Node.DenseIndex, Node.Tick, Window))
+		{
+			BestNode = NodeIndex;
+			BestHeuristic = NodeHeuristic;
+		}
+		
+		if (NumExpanded >= Params.MaxExpansionsPerAgent)
+		{
+			break;
+		}
+		NumExpanded++;
+
+		// Directions 0 to 5 move to a neighbor, 6 waits in place.
+		for (int32 Direction = 0; Direction <= 6; Direction++)
+		{
+			const FIntPoint NextCoord = Direction < 6 ? HexCoord + HexMath::DirectionIndexToAxial(Direction) : HexCoord;
+			const int32 NextIndex = Direction < 6 ? Layout.IndexOf(NextCoord) : Node.DenseIndex;
+			if (NextIndex == INDEX_NONE || (Direction < 6 && CostField.IsBlocked(NextIndex)))
+			{
+				continue;
+			}
+			if (!CanMove(AgentId, Node.DenseIndex, NextIndex, Node.Tick + 1))
+			{
+				continue;
+			}
+
+			const float NextCost = Node.Cost + (Direction < 6 ? CostField.GetCost(NextIndex) : WaitCost);
+			const int32 NextNode = NodeIndices.FindOrAdd(FHxlbSpaceTimeTable::PackKey(NextIndex, Node.Tick + 1), Nodes.Num());
+			if (NextNode == Nodes.Num())
+			{
+				Nodes.Add(FNode{NextIndex, Node.Tick + 1, NextCost, NodeIndex, false});
+			}
+			else if (Nodes[NextNode].bClosed || NextCost >= Nodes[NextNode].Cost)
+			{
+				continue;
+			}
+			else
+			{
+				Nodes[NextNode].Cost = NextCost;
+				Nodes[NextNode].Parent = NodeIndex;
+			}
+			Heap.Push(NextCost + Heuristic(NextCoord), NextNode);
+		}
+	}
+
+	OutResult.NumExpanded = NumExpanded;
+	if (EndNode == INDEX_NONE)
+	{
+		// Out of expansions, or boxed in. Head for the closest state found, or wait in place.
+		EndNode = BestNode != INDEX_NONE ? BestNode : 0;
+		OutResult.Status = EndNode != 0 ? EHxlbPathStatus::Partial : EHxlbPathStatus::NoPath;
+	}
+
+	OutResult.Cost = Nodes[EndNode].Cost;
+	for (int32 NodeIndex = EndNode; NodeIndex != INDEX_NONE; NodeIndex = Nodes[NodeIndex].Parent)
+	{
+		OutResult.Path.Add(Layout.CoordOf(Nodes[NodeIndex].DenseIndex));
+	}
+	Algo::Reverse(OutResult.Path);
+	
+	ReservePath(AgentId, EndNode, Window);
+	return OutResult.Status;
+}
+
+bool FHxlbCooperativePlanner::CanMove(int32 AgentId, int32 FromIndex, int32 ToIndex, int32 Tick) const
+{
+	const int32 Holder = GetReservation(ToIndex, Tick);
+	if (Holder != INDEX_NONE && Holder != AgentId)
+	{
+		return false;
+	}
+	if (FromIndex == ToIndex)
+	{
+		return true;
+	}
+
+	// Two agents can't pass through each other by swapping hexes.
+	const int32 Leaving = GetReservation(ToIndex, Tick - 1);
+	return Leaving == INDEX_NONE || Leaving == AgentId || GetReservation(FromIndex, Tick) != Leaving;
+}
+
+bool FHxlbCooperativePlanner::CanHold(int32 AgentId, int32 DenseIndex, int32 Tick, int32 Window) const
+{
+	for (int32 LaterTick = Tick + 1; LaterTick <= Window; LaterTick++)
+	{
+		const int32 Holder = GetReservation(DenseIndex, LaterTick);
+		if (Holder != INDEX_NONE && Holder != AgentId)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool FHxlbCooperativePlanner::Reserve(int32 AgentId, int32 DenseIndex, int32 Tick)
+{
+	const uint64 Key = FHxlbSpaceTimeTable::PackKey(DenseIndex, Tick);
+	int32& Holder = Reservations.FindOrAdd(Key, AgentId);
+	if (Holder == INDEX_NONE)
+	{
+		Holder = AgentId;
+	}
+	if (Holder != AgentId)
+	{
+		// The state stays with the agent that reserved it first. Two agents that start on the same hex can't be helped.
+		NumConflicts++;
+		if (Tick > 0)
+		{
+			Blockers.AddUnique(Holder);
+		}
+		return false;
+	}
+	AgentReservations.FindOrAdd(AgentId).Add(Key);
+	return true;
+}
+
+void FHxlbCooperativePlanner::ReleaseAgent(int32 AgentId)
+{
+	TArray<uint64>* Keys = AgentReservations.Find(AgentId);
+	if (!Keys)
+	{
+		return;
+	}
+	for (uint64 Key : *Keys)
+	{
+		int32& Holder = Reservations.FindOrAdd(Key, INDEX_NONE);
+		if (Holder == AgentId)
+		{
+			Holder = INDEX_NONE;
+		}
+	}
+	Keys->Reset();
+}
+
+void FHxlbCooperativePlanner::ReservePath(int32 AgentId, int32 EndNode, int32 Window)
+{
+	for (int32 NodeIndex = EndNode; NodeIndex != INDEX_NONE; NodeIndex = Nodes[NodeIndex].Parent)
+	{
+		Reserve(AgentId, Nodes[NodeIndex].DenseIndex, Nodes[NodeIndex].Tick);
+	}
+
+	// Agents stay where their path ends.
+	const FNode& End = Nodes[EndNode];
+	for (int32 Tick = End.Tick + 1; Tick <= Window; Tick++)
+	{
+		Reserve(AgentId, End.DenseIndex, Tick);
+	}
+}
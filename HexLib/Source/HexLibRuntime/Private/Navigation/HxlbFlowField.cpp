@@ -0,0 +1,441 @@
+// Copyright © Mason Stevenson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the disclaimer
+// below) provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+// THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+// CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+// NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "Navigation/HxlbFlowField.h"
+
+#include "Async/ParallelFor.h"
+#include "FunctionLibraries/HxlbMath.h"
+#include "Navigation/HxlbSearchScratch.h"
+
+using HexMath = UHxlbMath;
+
+namespace
+{
+	// Every direction slot of the word set to kUnreachable.
+	constexpr uint64 kUnreachableWord = (static_cast<uint64>(1) << (FHxlbFlowField::kDirectionsPerWord * 3)) - 1;
+}
+
+void FHxlbFlowField::Build(const FHxlbCostField& CostField, TConstArrayView<FIntPoint> NewGoals)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(HXLB_BuildFlowField);
+	
+	Layout = nullptr;
+	Goals = TArray<FIntPoint>(NewGoals.GetData(), NewGoals.Num());
+	Integration.Reset();
+	Directions.Reset();
+	if (!CostField.IsValid())
+	{
+		return;
+	}
+
+	Layout = &CostField.GetLayout();
+	const int32 ChunkSize = Layout->GetChunkSize();
+	WordsPerChunk = FMath::DivideAndRoundUp(ChunkSize * ChunkSize, kDirectionsPerWord);
+	Integration.Init(kUnreached, Layout->Num());
+	Directions.Init(kUnreachableWord, WordsPerChunk * Layout->NumChunks());
+
+	TSet<int32> DirtyChunks;
+	for (FIntPoint Goal : Goals)
+	{
+		const int32 GoalIndex = Layout->IndexOf(Goal);
+		if (GoalIndex != INDEX_NONE)
+		{
+			Integration[GoalIndex] = 0.0f;
+			DirtyChunks.Add(Layout->ChunkOf(Goal));
+		}
+	}
+
+	TSet<int32> TouchedChunks;
+	Relax(CostField, DirtyChunks, TouchedChunks);
+	UpdateDirections(CostField, TouchedChunks);
+}
+
+void FHxlbFlowField::Update(const FHxlbCostField& CostField, TConstArrayView<int32> ChangedIndices)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(HXLB_UpdateFlowField);
+	
+	if (!IsValid() || !CostField.IsValid() || &CostField.GetLayout() != Layout || Integration.Num() != Layout->Num())
+	{
+		const TArray<FIntPoint> OldGoals = Goals;
+		Build(CostField, OldGoals);
+		return;
+	}
+
+	// The value of a hex doesn't depend on its own cost, only on the costs of the hexes after it. So everything whose
+	// path ran through a changed hex is reset, and is then recomputed from the hexes around it. This is done for cost
+	// decreases as well, which is wasteful but keeps the update from having to know the old costs.
+	TSet<int32> DirtyChunks;
+	TArray<int32> Stack;
+	TSet<int32> ResetIndices;
+	
+	auto PushUpstream = [this, &Stack](FIntPoint HexCoord)
+	{
+		for (int32 Direction = 0; Direction < 6; Direction++)
+		{
+			const FIntPoint NeighborCoord = HexCoord + HexMath::DirectionIndexToAxial(Direction);
+			const int32 NeighborIndex = Layout->IndexOf(NeighborCoord);
+			if (NeighborIndex == INDEX_NONE)
+			{
+				continue;
+			}
+			
+			// Directions point at the next hex, so the neighbor flows into this hex if it points back at it.
+			const uint8 NeighborDirection = GetDirectionUnchecked(NeighborCoord);
+			if (NeighborDirection < 6 && NeighborCoord + HexMath::DirectionIndexToAxial(NeighborDirection) == HexCoord)
+			{
+				Stack.Add(NeighborIndex);
+			}
+		}
+	};
+	
+	for (int32 ChangedIndex : ChangedIndices)
+	{
+		const FIntPoint HexCoord = Layout->CoordOf(ChangedIndex);
+		DirtyChunks.Add(Layout->ChunkOf(HexCoord));
+		AddNeighborChunks(Layout->ChunkOf(HexCoord), DirtyChunks);
+		PushUpstream(HexCoord);
+	}
+	
+	while (!Stack.IsEmpty())
+	{
+		const int32 DenseIndex = Stack.Pop(EAllowShrinking::No);
+		bool bAlreadyReset = false;
+		ResetIndices.Add(DenseIndex, &bAlreadyReset);
+		if (bAlreadyReset)
+		{
+			continue;
+		}
+
+		const FIntPoint HexCoord = Layout->CoordOf(DenseIndex);
+		Integration[DenseIndex] = kUnreached;
+		DirtyChunks.Add(Layout->ChunkOf(HexCoord));
+		PushUpstream(HexCoord);
+	}
+
+	TSet<int32> TouchedChunks;
+	Relax(CostField, DirtyChunks, TouchedChunks);
+	UpdateDirections(CostField, TouchedChunks);
+}
+
+uint8 FHxlbFlowField::GetDirection(FIntPoint HexCoord) const
+{
+	const int32 DenseIndex = IsValid() ? Layout->IndexOf(HexCoord) : INDEX_NONE;
+	return DenseIndex == INDEX_NONE ? kUnreachable : GetDirectionUnchecked(HexCoord);
+}
+
+uint8 FHxlbFlowField::GetDirectionUnchecked(FIntPoint HexCoord) const
+{
+	return GetPackedDirection(Layout->ChunkOf(HexCoord), Layout->ChunkLocalIndex(HexCoord));
+}
+
+bool FHxlbFlowField::GetNextHex(FIntPoint HexCoord, FIntPoint& OutNextHex) const
+{
+	const uint8 Direction = GetDirection(HexCoord);
+	if (Direction >= 6)
+	{
+		return false;
+	}
+	OutNextHex = HexCoord + HexMath::DirectionIndexToAxial(Direction);
+	return true;
+}
+
+float FHxlbFlowField::GetIntegratedCost(FIntPoint HexCoord) const
+{
+	const int32 DenseIndex = IsValid() ? Layout->IndexOf(HexCoord) : INDEX_NONE;
+	return DenseIndex == INDEX_NONE ? kUnreached : Integration[DenseIndex];
+}
+
+void FHxlbFlowField::Relax(const FHxlbCostField& CostField, TSet<int32>& DirtyChunks, TSet<int32>& OutTouchedChunks)
+{
+	const int32 ChunkColumns = Layout->GetChunkGridSize().X;
+	TArray<int32> Batch;
+	TArray<uint8> Changed;
+	
+	while (!DirtyChunks.IsEmpty())
+	{
+		for (int32 Phase = 0; Phase < 4; Phase++)
+		{
+			Batch.Reset();
+			for (int32 Chunk : DirtyChunks)
+			{
+				const int32 ChunkPhase = ((Chunk / ChunkColumns) & 1) * 2 + ((Chunk % ChunkColumns) & 1);
+				if (ChunkPhase == Phase)
+				{
+					Batch.Add(Chunk);
+				}
+			}
+			if (Batch.IsEmpty())
+			{
+				continue;
+			}
+			
+			Batch.Sort();
+			for (int32 Chunk : Batch)
+			{
+				DirtyChunks.Remove(Chunk);
+				OutTouchedChunks.Add(Chunk);
+			}
+
+			Changed.Init(0, Batch.Num());
+			ParallelFor(Batch.Num(), [this, &CostField, &Batch, &Changed](int32 BatchIndex)
+			{
+				Changed[BatchIndex] = RelaxChunk(CostField, Batch[BatchIndex]);
+			});
+			
+			for (int32 BatchIndex = 0; BatchIndex < Batch.Num(); BatchIndex++)
+			{
+				if (Changed[BatchIndex])
+				{
+					AddNeighborChunks(Batch[BatchIndex], DirtyChunks);
+				}
+			}
+		}
+	}
+}
+
+bool FHxlbFlowField::RelaxChunk(const FHxlbCostField& CostField, int32 Chunk)
+{
+	FHxlbSearchScratch& Scratch = FHxlbSearchScratch::GetForThisThread();
+	Scratch.Begin(Layout->GetChunkSize() * Layout->GetChunkSize());
+	bool bChanged = false;
+
+	// Pull values in across the chunk border, then seed the local search with every hex that has a value.
+	Layout->ForEachChunkSpan(Chunk, [&](const FHxlbHexRowSpan& Span, int32 FirstIndex)
+	{
+		for (int32 Offset = 0; Offset < Span.Num(); Offset++)
+		{
+			const int32 DenseIndex = FirstIndex + Offset;
+			const FIntPoint HexCoord = Span.Get(Offset);
+			float Best = Integration[DenseIndex];
+			
+			for (int32 Direction = 0; Direction < 6; Direction++)
+			{
+				const FIntPoint NeighborCoord = HexCoord + HexMath::DirectionIndexToAxial(Direction);
+				const int32 NeighborIndex = Layout->IndexOf(NeighborCoord);
+				if (NeighborIndex == INDEX_NONE || Integration[NeighborIndex] == kUnreached || CostField.IsBlocked(NeighborIndex) || Layout->ChunkOf(NeighborCoord) == Chunk)
+				{
+					continue;
+				}
+				Best = FMath::Min(Best, Integration[NeighborIndex] + CostField.GetCost(NeighborIndex));
+			}
+
+			if (Best < Integration[DenseIndex])
+			{
+				Integration[DenseIndex] = Best;
+				bChanged = true;
+			}
+			if (Best != kUnreached)
+			{
+				const int32 Local = Layout->ChunkLocalIndex(HexCoord);
+				Scratch.Open(Local, HexCoord, Best, INDEX_NONE);
+				Scratch.Heap.Push(Best, Local);
+			}
+		}
+	});
+
+	while (!Scratch.Heap.IsEmpty())
+	{
+		const FHxlbHeapNode Node = Scratch.Heap.Pop();
+		if (Scratch.IsClosed(Node.Index))
+		{
+			continue;
+		}
+		Scratch.Close(Node.Index);
+
+		// Neighbors reach the goal through this hex, which means entering it.
+		const FIntPoint HexCoord = Scratch.GetCoord(Node.Index);
+		const int32 DenseIndex = Layout->IndexOf(HexCoord);
+		if (CostField.IsBlocked(DenseIndex))
+		{
+			continue;
+		}
+		const float ThroughCost = Integration[DenseIndex] + CostField.GetCost(DenseIndex);
+		
+		for (int32 Direction = 0; Direction < 6; Direction++)
+		{
+			const FIntPoint NeighborCoord = HexCoord + HexMath::DirectionIndexToAxial(Direction);
+			const int32 NeighborIndex = Layout->IndexOf(NeighborCoord);
+			if (NeighborIndex == INDEX_NONE || ThroughCost >= Integration[NeighborIndex] || Layout->ChunkOf(NeighborCoord) != Chunk)
+			{
+				continue;
+			}
+			
+			Integration[NeighborIndex] = ThroughCost;
+			bChanged = true;
+			
+			const int32 NeighborLocal = Layout->ChunkLocalIndex(NeighborCoord);
+			Scratch.Open(NeighborLocal, NeighborCoord, ThroughCost, INDEX_NONE);
+			Scratch.Heap.Push(ThroughCost, NeighborLocal);
+		}
+	}
+	
+	return bChanged;
+}
+
+void FHxlbFlowField::UpdateDirections(const FHxlbCostField& CostField, const TSet<int32>& Chunks)
+{
+	const TArray<int32> ChunkList = Chunks.Array();
+	ParallelFor(ChunkList.Num(), [this, &CostField, &ChunkList](int32 ItemIndex)
+	{
+		const int32 Chunk = ChunkList[ItemIndex];
+		uint64* Words = &Directions[Chunk * WordsPerChunk];
+		for (int32 WordIndex = 0; WordIndex < WordsPerChunk; WordIndex++)
+		{
+			Words[WordIndex] = kUnreachableWord;
+		}
+		
+		Layout->ForEachChunkSpan(Chunk, [&](const FHxlbHexRowSpan& Span, int32 FirstIndex)
+		{
+			for (int32 Offset = 0; Offset < Span.Num(); Offset++)
+			{
+				const int32 DenseIndex = FirstIndex + Offset;
+				const FIntPoint HexCoord = Span.Get(Offset);
+				
+				uint64 Direction = kUnreachable;
+				if (Integration[DenseIndex] == 0.0f)
+				{
+					Direction = kGoal;
+				}
+				else if (Integration[DenseIndex] != kUnreached)
+				{
+					// Ties go to the lowest direction index, so the field is deterministic.
+					float BestCost = kUnreached;
+					for (int32 NeighborDirection = 0; NeighborDirection < 6; NeighborDirection++)
+					{
+						const int32 NeighborIndex = Layout->IndexOf(HexCoord + HexMath::DirectionIndexToAxial(NeighborDirection));
+						if (NeighborIndex == INDEX_NONE || Integration[NeighborIndex] == kUnreached || CostField.IsBlocked(NeighborIndex))
+						{
+							continue;
+						}
+						
+						const float Cost = Integration[NeighborIndex] + CostField.GetCost(NeighborIndex);
+						if (Cost < BestCost)
+						{
+							BestCost = Cost;
+							Direction = NeighborDirection;
+						}
+					}
+				}
+
+				const int32 Local = Layout->ChunkLocalIndex(HexCoord);
+				const int32 Shift = (Local % kDirectionsPerWord) * 3;
+				uint64& Word = Words[Local / kDirectionsPerWord];
+				Word = (Word & ~(static_cast<uint64>(7) << Shift)) | (Direction << Shift);
+			}
+		});
+	});
+}
+
+void FHxlbFlowField::AddNeighborChunks(int32 Chunk, TSet<int32>& OutChunks) const
+{
+	const FIntPoint ChunkGridSize = Layout->GetChunkGridSize();
+	const int32 ChunkColumn = Chunk % ChunkGridSize.X;
+	const int32 ChunkRow = Chunk / ChunkGridSize.X;
+	
+	for (int32 Row = FMath::Max(0, ChunkRow - 1); Row <= FMath::Min(ChunkGridSize.Y - 1, ChunkRow + 1); Row++)
+	{
+		for (int32 Column = FMath::Max(0, ChunkColumn - 1); Column <= FMath::Min(ChunkGridSize.X - 1, ChunkColumn + 1); Column++)
+		{
+			const int32 Neighbor = Row * ChunkGridSize.X + Column;
+			if (Neighbor != Chunk && Layout->NumHexesInChunk(Neighbor) > 0)
+			{
+				OutChunks.Add(Neighbor);
+			}
+		}
+	}
+}
+
+TSharedRef<const FHxlbFlowField> FHxlbFlowFieldCache::FindOrBuild(const FHxlbCostField& CostField, TConstArrayView<FIntPoint> Goals)
+{
+	TArray<FIntPoint> SortedGoals(Goals.GetData(), Goals.Num());
+	SortedGoals.Sort([](const FIntPoint& A, const FIntPoint& B) { return A.Y < B.Y || (A.Y == B.Y && A.X < B.X); });
+	
+	UseCounter++;
+	for (FEntry& Entry : Entries)
+	{
+		if (Entry.SortedGoals != SortedGoals)
+		{
+			continue;
+		}
+		
+		Entry.LastUsed = UseCounter;
+		if (Entry.bNeedsRebuild)
+		{
+			Entry.Field->Build(CostField, SortedGoals);
+		}
+		else if (!Entry.PendingChanges.IsEmpty())
+		{
+			Entry.Field->Update(CostField, Entry.PendingChanges.Array());
+		}
+		Entry.PendingChanges.Reset();
+		Entry.bNeedsRebuild = false;
+		return Entry.Field;
+	}
+
+	if (Entries.Num() >= FMath::Max(1, MaxFields))
+	{
+		int32 Oldest = 0;
+		for (int32 EntryIndex = 1; EntryIndex < Entries.Num(); EntryIndex++)
+		{
+			if (Entries[EntryIndex].LastUsed < Entries[Oldest].LastUsed)
+			{
+				Oldest = EntryIndex;
+			}
+		}
+		Entries.RemoveAtSwap(Oldest);
+	}
+
+	FEntry& Entry = Entries.AddDefaulted_GetRef();
+	Entry.SortedGoals = MoveTemp(SortedGoals);
+	Entry.LastUsed = UseCounter;
+	Entry.Field->Build(CostField, Entry.SortedGoals);
+	return Entry.Field;
+}
+
+void FHxlbFlowFieldCache::MarkHexesChanged(TConstArrayView<int32> DenseIndices)
+{
+	for (FEntry& Entry : Entries)
+	{
+		if (Entry.bNeedsRebuild)
+		{
+			continue;
+		}
+		
+		Entry.PendingChanges.Append(DenseIndices);
+
+		// Past a point, resetting everything downstream of the changes costs more than starting over.
+		if (Entry.PendingChanges.Num() > Entry.Field->GetGoals().Num() + 4096)
+		{
+			Entry.PendingChanges.Reset();
+			Entry.bNeedsRebuild = true;
+		}
+	}
+}
@@ -0,0 +1,600 @@
+// Copyright © Mason Stevenson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the disclaimer
+// below) provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+// THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+// CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+// NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "Navigation/HxlbHierarchicalPathfinding.h"
+
+#include "Algo/Reverse.h"
+#include "Async/ParallelFor.h"
+#include "Foundation/HxlbHexRanges.h"
+#include "FunctionLibraries/HxlbMath.h"
+#include "Navigation/HxlbSearchScratch.h"
+
+using HexMath = UHxlbMath;
+
+namespace
+{
+	// Searches the hexes of a single chunk, starting from Source, using chunk-local indices in the scratch. Forward
+	// searches find the cost of going from Source to each hex, reverse searches the cost of going from each hex to
+	// Source. If TargetLocal is set, the search stops as soon as that hex is reached.
+	void SearchChunk(const FHxlbCostField& CostField, int32 Chunk, FIntPoint Source, bool bReverse, FHxlbSearchScratch& Scratch, int32 TargetLocal = INDEX_NONE, FIntPoint TargetCoord = FIntPoint::ZeroValue)
+	{
+		const FHxlbDenseLayout& Layout = CostField.GetLayout();
+		Scratch.Begin(Layout.GetChunkSize() * Layout.GetChunkSize());
+
+		const int32 SourceLocal = Layout.ChunkLocalIndex(Source);
+		Scratch.Open(SourceLocal, Source, 0.0f, INDEX_NONE);
+		Scratch.Heap.Push(0.0f, SourceLocal);
+		
+		const float HeuristicScale = TargetLocal != INDEX_NONE ? CostField.GetMinCost() : 0.0f;
+		
+		while (!Scratch.Heap.IsEmpty())
+		{
+			const FHxlbHeapNode Node = Scratch.Heap.Pop();
+			if (Scratch.IsClosed(Node.Index))
+			{
+				continue;
+			}
+			Scratch.Close(Node.Index);
+			if (Node.Index == TargetLocal)
+			{
+				return;
+			}
+
+			const FIntPoint HexCoord = Scratch.GetCoord(Node.Index);
+			const float CostSoFar = Scratch.GetCost(Node.Index);
+
+			// Going backward, every step from a neighbor into this hex costs this hex.
+			const float ReverseStepCost = bReverse ? CostField.GetCost(Layout.IndexOf(HexCoord)) : 0.0f;
+			
+			for (int32 Direction = 0; Direction < 6; Direction++)
+			{
+				const FIntPoint NeighborCoord = HexCoord + HexMath::DirectionIndexToAxial(Direction);
+				const int32 NeighborIndex = Layout.IndexOf(NeighborCoord);
+				if (NeighborIndex == INDEX_NONE || CostField.IsBlocked(NeighborIndex) || Layout.ChunkOf(NeighborCoord) != Chunk)
+				{
+					continue;
+				}
+				
+				const int32 NeighborLocal = Layout.ChunkLocalIndex(NeighborCoord);
+				const float NeighborCost = CostSoFar + (bReverse ? ReverseStepCost : CostField.GetCost(NeighborIndex));
+				if (Scratch.IsClosed(NeighborLocal) || NeighborCost >= Scratch.GetCost(NeighborLocal))
+				{
+					continue;
+				}
+
+				Scratch.Open(NeighborLocal, NeighborCoord, NeighborCost, Node.Index);
+				Scratch.Heap.Push(NeighborCost + HexMath::AxialDistanceFast(NeighborCoord, TargetCoord) * HeuristicScale, NeighborLocal);
+			}
+		}
+	}
+}
+
+void FHxlbHierarchicalPathfinder::Reset()
+{
+	bIsBuilt = false;
+	Layout = nullptr;
+	Nodes.Reset();
+	FreeNodes.Reset();
+	NodeOfHex.Reset();
+	ChunkNodes.Reset();
+	Entrances.Reset();
+	DirtyChunks.Reset();
+}
+
+void FHxlbHierarchicalPathfinder::Build(const FHxlbCostField& CostField)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(HXLB_BuildHierarchicalPathfinder);
+	
+	Reset();
+	if (!CostField.IsValid())
+	{
+		return;
+	}
+	
+	Layout = &CostField.GetLayout();
+	const int32 NumChunks = Layout->NumChunks();
+	ChunkNodes.SetNum(NumChunks);
+
+	// Each pair of chunks is scanned from its lower chunk, which is also what Repair() does. That way a repair that
+	// doesn't change passability ends up with exactly the same entrances.
+	TArray<TMap<int32, TArray<FEntrance>>> EntrancesByChunk;
+	EntrancesByChunk.SetNum(NumChunks);
+	HxlbParallelForEachChunk(*Layout, [this, &CostField, &EntrancesByChunk](int32 Chunk)
+	{
+		ComputeEntrances(CostField, Chunk, /*bOnlyHigherChunks=*/true, EntrancesByChunk[Chunk]);
+	});
+
+	TArray<int32> AllChunks;
+	AllChunks.Reserve(NumChunks);
+	for (int32 Chunk = 0; Chunk < NumChunks; Chunk++)
+	{
+		for (auto& EntranceKV : EntrancesByChunk[Chunk])
+		{
+			SetEntrances(Chunk, EntranceKV.Key, MoveTemp(EntranceKV.Value));
+		}
+		AllChunks.Add(Chunk);
+	}
+	
+	RebuildIntraEdges(CostField, AllChunks);
+	bIsBuilt = true;
+}
+
+void FHxlbHierarchicalPathfinder::MarkHexesChanged(TConstArrayView<int32> DenseIndices)
+{
+	if (!bIsBuilt)
+	{
+		return;
+	}
+	for (int32 DenseIndex : DenseIndices)
+	{
+		DirtyChunks.Add(Layout->ChunkOfIndex(DenseIndex));
+	}
+}
+
+void FHxlbHierarchicalPathfinder::Repair(const FHxlbCostField& CostField)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(HXLB_RepairHierarchicalPathfinder);
+	
+	if (!bIsBuilt || DirtyChunks.IsEmpty())
+	{
+		return;
+	}
+	if (!CostField.IsValid() || &CostField.GetLayout() != Layout || ChunkNodes.Num() != Layout->NumChunks())
+	{
+		Build(CostField);
+		return;
+	}
+
+	TArray<int32> Dirty = DirtyChunks.Array();
+	Dirty.Sort();
+	DirtyChunks.Reset();
+
+	// Intra-chunk edges are rebuilt for every dirty chunk, plus the neighbors whose entrances changed.
+	TSet<int32> ChunksToRebuild(Dirty);
+	TSet<uint64> VisitedPairs;
+	TMap<int32, TMap<int32, TArray<FEntrance>>> ScannedChunks;
+	
+	const FIntPoint ChunkGridSize = Layout->GetChunkGridSize();
+	for (int32 Chunk : Dirty)
+	{
+		const int32 ChunkColumn = Chunk % ChunkGridSize.X;
+		const int32 ChunkRow = Chunk / ChunkGridSize.X;
+
+		// Hex neighbors are at most one step away in offset space, so only the 8 surrounding chunks can share a border.
+		for (int32 RowOffset = -1; RowOffset <= 1; RowOffset++)
+		{
+			for (int32 ColumnOffset = -1; ColumnOffset <= 1; ColumnOffset++)
+			{
+				const int32 NeighborRow = ChunkRow + RowOffset;
+				const int32 NeighborColumn = ChunkColumn + ColumnOffset;
+				if ((RowOffset == 0 && ColumnOffset == 0) || NeighborRow < 0 || NeighborRow >= ChunkGridSize.Y || NeighborColumn < 0 || NeighborColumn >= ChunkGridSize.X)
+				{
+					continue;
+				}
+				
+				const int32 Neighbor = NeighborRow * ChunkGridSize.X + NeighborColumn;
+				const int32 LowChunk = FMath::Min(Chunk, Neighbor);
+				const int32 HighChunk = FMath::Max(Chunk, Neighbor);
+				
+				bool bAlreadyVisited = false;
+				VisitedPairs.Add(MakePairKey(LowChunk, HighChunk), &bAlreadyVisited);
+				if (bAlreadyVisited || Layout->NumHexesInChunk(Neighbor) == 0)
+				{
+					continue;
+				}
+				
+				TMap<int32, TArray<FEntrance>>* Scanned = ScannedChunks.Find(LowChunk);
+				if (!Scanned)
+				{
+					Scanned = &ScannedChunks.Add(LowChunk);
+					ComputeEntrances(CostField, LowChunk, /*bOnlyHigherChunks=*/true, *Scanned);
+				}
+
+				TArray<FEntrance> NewEntrances;
+				Scanned->RemoveAndCopyValue(HighChunk, NewEntrances);
+				if (SetEntrances(LowChunk, HighChunk, MoveTemp(NewEntrances)))
+				{
+					ChunksToRebuild.Add(Neighbor);
+				}
+			}
+		}
+	}
+
+	TArray<int32> RebuildList = ChunksToRebuild.Array();
+	RebuildList.Sort();
+	RebuildIntraEdges(CostField, RebuildList);
+}
+
+void FHxlbHierarchicalPathfinder::ComputeEntrances(const FHxlbCostField& CostField, int32 Chunk, bool bOnlyHigherChunks, TMap<int32, TArray<FEntrance>>& OutEntrances) const
+{
+	const FHxlbDenseLayout& ChunkLayout = CostField.GetLayout();
+	
+	// Every passable pair of hexes facing each other across the border, in scan order.
+	TMap<int32, TArray<FEntrance>> Candidates;
+	ChunkLayout.ForEachChunkSpan(Chunk, [&](const FHxlbHexRowSpan& Span, int32 FirstIndex)
+	{
+		for (int32 Offset = 0; Offset < Span.Num(); Offset++)
+		{
+			const int32 DenseIndex = FirstIndex + Offset;
+			if (CostField.IsBlocked(DenseIndex))
+			{
+				continue;
+			}
+
+			const FIntPoint HexCoord = Span.Get(Offset);
+			for (int32 Direction = 0; Direction < 6; Direction++)
+			{
+				const FIntPoint NeighborCoord = HexCoord + HexMath::DirectionIndexToAxial(Direction);
+				const int32 NeighborIndex = ChunkLayout.IndexOf(NeighborCoord);
+				if (NeighborIndex == INDEX_NONE || CostField.IsBlocked(NeighborIndex))
+				{
+					continue;
+				}
+				
+				const int32 NeighborChunk = ChunkLayout.ChunkOf(NeighborCoord);
+				if (NeighborChunk == Chunk || (bOnlyHigherChunks && NeighborChunk < Chunk))
+				{
+					continue;
+				}
+				
+				FEntrance Entrance;
+				Entrance.LowIndex = NeighborChunk > Chunk ? DenseIndex : NeighborIndex;
+				Entrance.HighIndex = NeighborChunk > Chunk ? NeighborIndex : DenseIndex;
+				Candidates.FindOrAdd(NeighborChunk).Add(Entrance);
+			}
+		}
+	});
+
+	// Group the candidates into runs that follow the border, and keep the middle of each run.
+	for (const auto& CandidateKV : Candidates)
+	{
+		const TArray<FEntrance>& Pairs = CandidateKV.Value;
+		TArray<FEntrance>& Result = OutEntrances.FindOrAdd(CandidateKV.Key);
+
+		int32 RunStart = 0;
+		for (int32 PairIndex = 1; PairIndex <= Pairs.Num(); PairIndex++)
+		{
+			bool bContinuesRun = false;
+			if (PairIndex < Pairs.Num() && PairIndex - RunStart < kMaxEntranceWidth)
+			{
+				const FEntrance& Previous = Pairs[PairIndex - 1];
+				const FEntrance& Current = Pairs[PairIndex];
+				bContinuesRun = HexMath::AxialDistanceFast(ChunkLayout.CoordOf(Previous.LowIndex), ChunkLayout.CoordOf(Current.LowIndex)) <= 1
+					&& HexMath::AxialDistanceFast(ChunkLayout.CoordOf(Previous.HighIndex), ChunkLayout.CoordOf(Current.HighIndex)) <= 1;
+			}
+			
+			if (!bContinuesRun)
+			{
+				Result.Add(Pairs[(RunStart + PairIndex - 1) / 2]);
+				RunStart = PairIndex;
+			}
+		}
+	}
+}
+
+bool FHxlbHierarchicalPathfinder::SetEntrances(int32 LowChunk, int32 HighChunk, TArray<FEntrance>&& NewEntrances)
+{
+	const uint64 PairKey = MakePairKey(LowChunk, HighChunk);
+	TArray<FEntrance>* OldEntrances = Entrances.Find(PairKey);
+	if (OldEntrances ? *OldEntrances == NewEntrances : NewEntrances.IsEmpty())
+	{
+		return false;
+	}
+
+	// Acquire the new nodes before releasing the old ones, so that nodes shared by both don't get recycled.
+	for (const FEntrance& Entrance : NewEntrances)
+	{
+		const int32 LowNode = AcquireNode(Entrance.LowIndex, LowChunk);
+		const int32 HighNode = AcquireNode(Entrance.HighIndex, HighChunk);
+		Nodes[LowNode].InterEdges.Add(HighNode);
+		Nodes[HighNode].InterEdges.Add(LowNode);
+	}
+	if (OldEntrances)
+	{
+		for (const FEntrance& Entrance : *OldEntrances)
+		{
+			const int32 LowNode = NodeOfHex.FindChecked(Entrance.LowIndex);
+			const int32 HighNode = NodeOfHex.FindChecked(Entrance.HighIndex);
+			Nodes[LowNode].InterEdges.RemoveSingle(HighNode);
+			Nodes[HighNode].InterEdges.RemoveSingle(LowNode);
+			ReleaseNode(LowNode);
+			ReleaseNode(HighNode);
+		}
+	}
+
+	if (NewEntrances.IsEmpty())
+	{
+		Entrances.Remove(PairKey);
+	}
+	else
+	{
+		Entrances.Add(PairKey, MoveTemp(NewEntrances));
+	}
+	return true;
+}
+
+int32 FHxlbHierarchicalPathfinder::AcquireNode(int32 DenseIndex, int32 Chunk)
+{
+	if (const int32* Existing = NodeOfHex.Find(DenseIndex))
+	{
+		Nodes[*Existing].NumEntrances++;
+		return *Existing;
+	}
+
+	const int32 NodeIndex = FreeNodes.IsEmpty() ? Nodes.AddDefaulted() : FreeNodes.Pop(EAllowShrinking::No);
+	FNode& Node = Nodes[NodeIndex];
+	Node.Coord = Layout->CoordOf(DenseIndex);
+	Node.DenseIndex = DenseIndex;
+	Node.Chunk = Chunk;
+	Node.NumEntrances = 1;
+	
+	NodeOfHex.Add(DenseIndex, NodeIndex);
+	ChunkNodes[Chunk].Add(NodeIndex);
+	return NodeIndex;
+}
+
+void FHxlbHierarchicalPathfinder::ReleaseNode(int32 NodeIndex)
+{
+	FNode& Node = Nodes[NodeIndex];
+	if (--Node.NumEntrances > 0)
+	{
+		return;
+	}
+
+	// Intra-chunk edges of other nodes may still point here. The chunk is rebuilt before the repair finishes.
+	NodeOfHex.Remove(Node.DenseIndex);
+	ChunkNodes[Node.Chunk].Remove(NodeIndex);
+	Node = FNode();
+	FreeNodes.Add(NodeIndex);
+}
+
+void FHxlbHierarchicalPathfinder::RebuildIntraEdges(const FHxlbCostField& CostField, TConstArrayView<int32> Chunks)
+{
+	// Each task only writes to the nodes of its own chunk.
+	ParallelFor(Chunks.Num(), [this, &CostField, Chunks](int32 ItemIndex)
+	{
+		const int32 Chunk = Chunks[ItemIndex];
+		FHxlbSearchScratch& Scratch = FHxlbSearchScratch::GetForThisThread();
+		
+		for (int32 NodeIndex : ChunkNodes[Chunk])
+		{
+			FNode& Node = Nodes[NodeIndex];
+			Node.IntraEdges.Reset();
+			
+			SearchChunk(CostField, Chunk, Node.Coord, /*bReverse=*/false, Scratch);
+			for (int32 OtherIndex : ChunkNodes[Chunk])
+			{
+				const int32 OtherLocal = Layout->ChunkLocalIndex(Nodes[OtherIndex].Coord);
+				if (OtherIndex != NodeIndex && Scratch.IsOpened(OtherLocal))
+				{
+					Node.IntraEdges.Add(FIntraEdge{OtherIndex, Scratch.GetCost(OtherLocal)});
+				}
+			}
+		}
+	});
+}
+
+int32 FHxlbHierarchicalPathfinder::NumEdges() const
+{
+	int32 NumEdges = 0;
+	for (const auto& NodeKV : NodeOfHex)
+	{
+		NumEdges += Nodes[NodeKV.Value].InterEdges.Num() + Nodes[NodeKV.Value].IntraEdges.Num();
+	}
+	return NumEdges;
+}
+
+EHxlbPathStatus FHxlbHierarchicalPathfinder::FindPath(const FHxlbCostField& CostField, FIntPoint Start, FIntPoint Goal, FHxlbPathResult& OutResult) const
+{
+	OutResult.Path.Reset();
+	OutResult.Cost = 0.0f;
+	OutResult.NumExpanded = 0;
+	OutResult.Status = EHxlbPathStatus::InvalidQuery;
+
+	if (!bIsBuilt || !CostField.IsValid() || &CostField.GetLayout() != Layout)
+	{
+		return OutResult.Status;
+	}
+	
+	const int32 StartIndex = Layout->IndexOf(Start);
+	const int32 GoalIndex = Layout->IndexOf(Goal);
+	if (StartIndex == INDEX_NONE || GoalIndex == INDEX_NONE)
+	{
+		return OutResult.Status;
+	}
+	
+	OutResult.Status = EHxlbPathStatus::NoPath;
+	if (CostField.IsBlocked(GoalIndex))
+	{
+		return OutResult.Status;
+	}
+	
+	const int32 StartChunk = Layout->ChunkOf(Start);
+	const int32 GoalChunk = Layout->ChunkOf(Goal);
+	FHxlbSearchScratch& Scratch = FHxlbSearchScratch::GetForThisThread();
+
+	// Temporarily connect the start and the goal to the nodes of their chunks.
+	TArray<FIntraEdge, TInlineAllocator<32>> StartEdges;
+	float DirectCost = TNumericLimits<float>::Max();
+	SearchChunk(CostField, StartChunk, Start, /*bReverse=*/false, Scratch);
+	for (int32 NodeIndex : ChunkNodes[StartChunk])
+	{
+		const int32 NodeLocal = Layout->ChunkLocalIndex(Nodes[NodeIndex].Coord);
+		if (Scratch.IsOpened(NodeLocal))
+		{
+			StartEdges.Add(FIntraEdge{NodeIndex, Scratch.GetCost(NodeLocal)});
+		}
+	}
+	if (StartChunk == GoalChunk)
+	{
+		DirectCost = Scratch.GetCost(Layout->ChunkLocalIndex(Goal));
+	}
+	
+	TArray<FIntraEdge, TInlineAllocator<32>> GoalEdges;
+	SearchChunk(CostField, GoalChunk, Goal, /*bReverse=*/true, Scratch);
+	for (int32 NodeIndex : ChunkNodes[GoalChunk])
+	{
+		const int32 NodeLocal = Layout->ChunkLocalIndex(Nodes[NodeIndex].Coord);
+		if (Scratch.IsOpened(NodeLocal))
+		{
+			GoalEdges.Add(FIntraEdge{NodeIndex, Scratch.GetCost(NodeLocal)});
+		}
+	}
+
+	// A* over the abstract graph. The start and the goal get the two node indices past the end of the graph.
+	const int32 StartNode = Nodes.Num();
+	const int32 GoalNode = StartNode + 1;
+	const float HeuristicScale = CostField.GetMinCost();
+	
+	Scratch.Begin(Nodes.Num() + 2);
+	Scratch.Open(StartNode, Start, 0.0f, INDEX_NONE);
+	Scratch.Heap.Push(HexMath::AxialDistanceFast(Start, Goal) * HeuristicScale, StartNode);
+
+	auto Relax = [&](int32 FromNode, float FromCost, int32 ToNode, FIntPoint ToCoord, float EdgeCost)
+	{
+		const float ToCost = FromCost + EdgeCost;
+		if (Scratch.IsClosed(ToNode) || ToCost >= Scratch.GetCost(ToNode))
+		{
+			return;
+		}
+		Scratch.Open(ToNode, ToCoord, ToCost, FromNode);
+		Scratch.Heap.Push(ToCost + HexMath::AxialDistanceFast(ToCoord, Goal) * HeuristicScale, ToNode);
+	};
+
+	bool bFoundGoal = false;
+	while (!Scratch.Heap.IsEmpty())
+	{
+		const FHxlbHeapNode HeapNode = Scratch.Heap.Pop();
+		if (Scratch.IsClosed(HeapNode.Index))
+		{
+			continue;
+		}
+		Scratch.Close(HeapNode.Index);
+		OutResult.NumExpanded++;
+		
+		if (HeapNode.Index == GoalNode)
+		{
+			bFoundGoal = true;
+			break;
+		}
+
+		const float CostSoFar = Scratch.GetCost(HeapNode.Index);
+		if (HeapNode.Index == StartNode)
+		{
+			for (const FIntraEdge& Edge : StartEdges)
+			{
+				Relax(StartNode, CostSoFar, Edge.TargetNode, Nodes[Edge.TargetNode].Coord, Edge.Cost);
+			}
+			if (!HxlbMovementCost::IsBlocked(DirectCost))
+			{
+				Relax(StartNode, CostSoFar, GoalNode, Goal, DirectCost);
+			}
+			continue;
+		}
+
+		const FNode& Node = Nodes[HeapNode.Index];
+		for (const FIntraEdge& Edge : Node.IntraEdges)
+		{
+			Relax(HeapNode.Index, CostSoFar, Edge.TargetNode, Nodes[Edge.TargetNode].Coord, Edge.Cost);
+		}
+		for (int32 TargetNode : Node.InterEdges)
+		{
+			Relax(HeapNode.Index, CostSoFar, TargetNode, Nodes[TargetNode].Coord, CostField.GetCost(Nodes[TargetNode].DenseIndex));
+		}
+		if (Node.Chunk == GoalChunk)
+		{
+			for (const FIntraEdge& Edge : GoalEdges)
+			{
+				if (Edge.TargetNode == HeapNode.Index)
+				{
+					Relax(HeapNode.Index, CostSoFar, GoalNode, Goal, Edge.Cost);
+				}
+			}
+		}
+	}
+
+	if (!bFoundGoal)
+	{
+		return OutResult.Status;
+	}
+
+	// Pull the abstract path out of the scratch before the refinement reuses it.
+	TArray<FIntPoint, TInlineAllocator<64>> Waypoints;
+	for (int32 NodeIndex = GoalNode; NodeIndex != INDEX_NONE; NodeIndex = Scratch.GetParent(NodeIndex))
+	{
+		Waypoints.Add(Scratch.GetCoord(NodeIndex));
+	}
+	Algo::Reverse(Waypoints);
+
+	// Refine every abstract edge. Inter-chunk edges are a single step, intra-chunk edges a search inside of the chunk.
+	TArray<FIntPoint, TInlineAllocator<64>> Segment;
+	OutResult.Path.Add(Start);
+	for (int32 WaypointIndex = 1; WaypointIndex < Waypoints.Num(); WaypointIndex++)
+	{
+		const FIntPoint From = Waypoints[WaypointIndex - 1];
+		const FIntPoint To = Waypoints[WaypointIndex];
+		if (From == To)
+		{
+			continue;
+		}
+		
+		const int32 FromChunk = Layout->ChunkOf(From);
+		if (FromChunk != Layout->ChunkOf(To))
+		{
+			OutResult.Path.Add(To);
+			OutResult.Cost += CostField.GetCost(Layout->IndexOf(To));
+			continue;
+		}
+
+		const int32 ToLocal = Layout->ChunkLocalIndex(To);
+		SearchChunk(CostField, FromChunk, From, /*bReverse=*/false, Scratch, ToLocal, To);
+		if (!Scratch.IsClosed(ToLocal))
+		{
+			// Costs changed since the last Repair().
+			OutResult.Path.Reset();
+			OutResult.Cost = 0.0f;
+			return OutResult.Status;
+		}
+		
+		Segment.Reset();
+		for (int32 Local = ToLocal; Scratch.GetParent(Local) != INDEX_NONE; Local = Scratch.GetParent(Local))
+		{
+			Segment.Add(Scratch.GetCoord(Local));
+		}
+		Algo::Reverse(Segment);
+		
+		OutResult.Path.Append(Segment);
+		OutResult.Cost += Scratch.GetCost(ToLocal);
+	}
+
+	OutResult.Status = EHxlbPathStatus::Found;
+	return OutResult.Status;
+}
@@ -0,0 +1,340 @@
+// Copyright © Mason Stevenson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the disclaimer
+// below) provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+// THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+// CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+// NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "Navigation/HxlbIncrementalPathfinding.h"
+
+#include "FunctionLibraries/HxlbMath.h"
+
+using HexMath = UHxlbMath;
+
+namespace HxlbIncrementalPathfinding
+{
+	inline constexpr float Unreachable = TNumericLimits<float>::Max();
+
+	FORCEINLINE float AddCosts(float A, float B)
+	{
+		return A == Unreachable || B == Unreachable ? Unreachable : A + B;
+	}
+}
+
+using HxlbIncrementalPathfinding::Unreachable;
+using HxlbIncrementalPathfinding::AddCosts;
+
+bool FHxlbIncrementalPathfinder::Init(const FHxlbCostField& NewCostField, FIntPoint NewStart, FIntPoint NewGoal)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(HXLB_InitIncrementalPath);
+	
+	Reset();
+	if (!NewCostField.IsValid())
+	{
+		return false;
+	}
+	
+	const FHxlbDenseLayout& Layout = NewCostField.GetLayout();
+	const int32 NewStartIndex = Layout.IndexOf(NewStart);
+	const int32 NewGoalIndex = Layout.IndexOf(NewGoal);
+	if (NewStartIndex == INDEX_NONE || NewGoalIndex == INDEX_NONE)
+	{
+		return false;
+	}
+
+	CostField = NewCostField;
+	Start = NewStart;
+	Goal = NewGoal;
+	StartIndex = NewStartIndex;
+	GoalIndex = NewGoalIndex;
+	HeuristicScale = CostField.GetMinCost();
+	KeyModifier = 0.0f;
+
+	const int32 NumHexes = Layout.Num();
+	CostToGoal.Init(Unreachable, NumHexes);
+	Lookahead.Init(Unreachable, NumHexes);
+	QueuedKeys.SetNumUninitialized(NumHexes);
+	bQueued.Init(false, NumHexes);
+
+	Lookahead[GoalIndex] = 0.0f;
+	UpdateVertex(GoalIndex);
+	return true;
+}
+
+void FHxlbIncrementalPathfinder::Reset()
+{
+	CostField = FHxlbCostField();
+	StartIndex = INDEX_NONE;
+	GoalIndex = INDEX_NONE;
+	KeyModifier = 0.0f;
+	CostToGoal.Reset();
+	Lookahead.Reset();
+	QueuedKeys.Reset();
+	bQueued.Reset();
+	Queue.Reset();
+}
+
+bool FHxlbIncrementalPathfinder::SetStart(FIntPoint NewStart)
+{
+	if (!IsValid())
+	{
+		return false;
+	}
+	const int32 NewStartIndex = CostField.GetLayout().IndexOf(NewStart);
+	if (NewStartIndex == INDEX_NONE)
+	{
+		return false;
+	}
+
+	// Every key in the queue is now too high by at most this much. Lowering the bound for new keys instead keeps the
+	// order of the queue valid.
+	KeyModifier += HexMath::AxialDistanceFast(Start, NewStart) * HeuristicScale;
+	Start = NewStart;
+	StartIndex = NewStartIndex;
+	return true;
+}
+
+void FHxlbIncrementalPathfinder::UpdateCosts(const FHxlbCostField& NewCostField, TConstArrayView<int32> ChangedIndices)
+{
+	if (!IsValid())
+	{
+		return;
+	}
+	if (!NewCostField.IsValid() || &NewCostField.GetLayout() != &CostField.GetLayout() || NewCostField.GetMinCost() < HeuristicScale)
+	{
+		Init(NewCostField, Start, Goal);
+		return;
+	}
+	
+	TRACE_CPUPROFILER_EVENT_SCOPE(HXLB_UpdateIncrementalPathCosts);
+	
+	CostField = NewCostField;
+	const FHxlbDenseLayout& Layout = CostField.GetLayout();
+	for (const int32 ChangedIndex : ChangedIndices)
+	{
+		// The cost of a hex is the cost of every edge into it, so the neighbors are the hexes whose lookahead changes.
+		const FIntPoint HexCoord = Layout.CoordOf(ChangedIndex);
+		for (int32 Direction = 0; Direction < 6; Direction++)
+		{
+			const int32 NeighborIndex = Layout.IndexOf(HexCoord + HexMath::DirectionIndexToAxial(Direction));
+			if (NeighborIndex != INDEX_NONE)
+			{
+				UpdateVertex(NeighborIndex);
+			}
+		}
+	}
+}
+
+EHxlbPathStatus FHxlbIncrementalPathfinder::FindPath(FHxlbPathResult& OutResult)
+{
+	OutResult.Path.Reset();
+	OutResult.Cost = 0.0f;
+	OutResult.NumExpanded = 0;
+	OutResult.Status = EHxlbPathStatus::InvalidQuery;
+	
+	if (!IsValid())
+	{
+		return OutResult.Status;
+	}
+	
+	CompactQueue();
+	OutResult.NumExpanded = ComputeShortestPath();
+	if (CostToGoal[StartIndex] == Unreachable)
+	{
+		OutResult.Status = EHxlbPathStatus::NoPath;
+		return OutResult.Status;
+	}
+
+	// Every hex on the way has its cost to the goal settled, so the cheapest neighbor is always the next step.
+	const FHxlbDenseLayout& Layout = CostField.GetLayout();
+	int32 CurrentIndex = StartIndex;
+	FIntPoint CurrentCoord = Start;
+	OutResult.Path.Add(CurrentCoord);
+	
+	while (CurrentIndex != GoalIndex && OutResult.Path.Num() <= Layout.Num())
+	{
+		int32 NextIndex = INDEX_NONE;
+		FIntPoint NextCoord = CurrentCoord;
+		float NextCost = Unreachable;
+		for (int32 Direction = 0; Direction < 6; Direction++)
+		{
+			const FIntPoint NeighborCoord = CurrentCoord + HexMath::DirectionIndexToAxial(Direction);
+			const int32 NeighborIndex = Layout.IndexOf(NeighborCoord);
+			if (NeighborIndex == INDEX_NONE)
+			{
+				continue;
+			}
+			const float NeighborCost = AddCosts(EdgeCost(NeighborIndex), CostToGoal[NeighborIndex]);
+			if (NeighborCost < NextCost)
+			{
+				NextIndex = NeighborIndex;
+				NextCoord = NeighborCoord;
+				NextCost = NeighborCost;
+			}
+		}
+		if (NextIndex == INDEX_NONE)
+		{
+			break;
+		}
+		
+		OutResult.Cost += CostField.GetCost(NextIndex);
+		OutResult.Path.Add(NextCoord);
+		CurrentIndex = NextIndex;
+		CurrentCoord = NextCoord;
+	}
+
+	if (CurrentIndex != GoalIndex)
+	{
+		OutResult.Path.Reset();
+		OutResult.Cost = 0.0f;
+		OutResult.Status = EHxlbPathStatus::NoPath;
+		return OutResult.Status;
+	}
+	
+	OutResult.Status = EHxlbPathStatus::Found;
+	return OutResult.Status;
+}
+
+float FHxlbIncrementalPathfinder::Heuristic(int32 DenseIndex) const
+{
+	return HexMath::AxialDistanceFast(Start, CostField.GetLayout().CoordOf(DenseIndex)) * HeuristicScale;
+}
+
+float FHxlbIncrementalPathfinder::EdgeCost(int32 ToIndex) const
+{
+	return CostField.IsBlocked(ToIndex) ? Unreachable : CostField.GetCost(ToIndex);
+}
+
+FHxlbIncrementalPathfinder::FKey FHxlbIncrementalPathfinder::CalculateKey(int32 DenseIndex) const
+{
+	const float Cost = FMath::Min(CostToGoal[DenseIndex], Lookahead[DenseIndex]);
+	return FKey{AddCosts(Cost, Heuristic(DenseIndex) + KeyModifier), Cost};
+}
+
+void FHxlbIncrementalPathfinder::UpdateVertex(int32 DenseIndex)
+{
+	if (DenseIndex != GoalIndex)
+	{
+		const FHxlbDenseLayout& Layout = CostField.GetLayout();
+		const FIntPoint HexCoord = Layout.CoordOf(DenseIndex);
+		float Best = Unreachable;
+		for (int32 Direction = 0; Direction < 6; Direction++)
+		{
+			const int32 NeighborIndex = Layout.IndexOf(HexCoord + HexMath::DirectionIndexToAxial(Direction));
+			if (NeighborIndex != INDEX_NONE)
+			{
+				Best = FMath::Min(Best, AddCosts(EdgeCost(NeighborIndex), CostToGoal[NeighborIndex]));
+			}
+		}
+		Lookahead[DenseIndex] = Best;
+	}
+
+	// Entries aren't removed from the queue. Requeuing replaces the key, which makes the old entry stale.
+	bQueued[DenseIndex] = CostToGoal[DenseIndex] != Lookahead[DenseIndex];
+	if (bQueued[DenseIndex])
+	{
+		QueuedKeys[DenseIndex] = CalculateKey(DenseIndex);
+		Queue.HeapPush(FQueueEntry{QueuedKeys[DenseIndex], DenseIndex}, FQueueEntryLess());
+	}
+}
+
+bool FHxlbIncrementalPathfinder::PeekQueue(FQueueEntry& OutEntry)
+{
+	while (!Queue.IsEmpty())
+	{
+		const FQueueEntry& Top = Queue.HeapTop();
+		if (bQueued[Top.Index] && !(Top.Key < QueuedKeys[Top.Index]) && !(QueuedKeys[Top.Index] < Top.Key))
+		{
+			OutEntry = Top;
+			return true;
+		}
+		Queue.HeapPopDiscard(FQueueEntryLess());
+	}
+	return false;
+}
+
+void FHxlbIncrementalPathfinder::CompactQueue()
+{
+	if (Queue.Num() <= CostField.GetLayout().Num() * 2)
+	{
+		return;
+	}
+	
+	Queue.Reset();
+	for (int32 DenseIndex = 0; DenseIndex < bQueued.Num(); DenseIndex++)
+	{
+		if (bQueued[DenseIndex])
+		{
+			Queue.Add(FQueueEntry{QueuedKeys[DenseIndex], DenseIndex});
+		}
+	}
+	Queue.Heapify(FQueueEntryLess());
+}
+
+int32 FHxlbIncrementalPathfinder::ComputeShortestPath()
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(HXLB_ComputeIncrementalPath);
+	
+	const FHxlbDenseLayout& Layout = CostField.GetLayout();
+	int32 NumExpanded = 0;
+	
+	FQueueEntry Top;
+	while (PeekQueue(Top) && (Top.Key < CalculateKey(StartIndex) || Lookahead[StartIndex] != CostToGoal[StartIndex]))
+	{
+		const int32 Index = Top.Index;
+		const FKey NewKey = CalculateKey(Index);
+		if (Top.Key < NewKey)
+		{
+			// Queued before the start moved.
+			UpdateVertex(Index);
+			continue;
+		}
+		
+		Queue.HeapPopDiscard(FQueueEntryLess());
+		bQueued[Index] = false;
+		NumExpanded++;
+
+		const bool bBecameUnreachable = CostToGoal[Index] < Lookahead[Index];
+		CostToGoal[Index] = bBecameUnreachable ? Unreachable : Lookahead[Index];
+		if (bBecameUnreachable)
+		{
+			// Underconsistent: the hex got more expensive. Every hex that went through it has to look again.
+			UpdateVertex(Index);
+		}
+		
+		const FIntPoint HexCoord = Layout.CoordOf(Index);
+		for (int32 Direction = 0; Direction < 6; Direction++)
+		{
+			const int32 NeighborIndex = Layout.IndexOf(HexCoord + HexMath::DirectionIndexToAxial(Direction));
+			if (NeighborIndex != INDEX_NONE)
+			{
+				UpdateVertex(NeighborIndex);
+			}
+		}
+	}
+	return NumExpanded;
+}
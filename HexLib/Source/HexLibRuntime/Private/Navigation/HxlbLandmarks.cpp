@@ -0,0 +1,149 @@
+// Copyright © Mason Stevenson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the disclaimer
+// below) provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+// THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+// CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+// NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "Navigation/HxlbLandmarks.h"
+
+#include "Analysis/HxlbDistanceField.h"
+#include "Async/ParallelFor.h"
+
+void FHxlbLandmarks::Build(const FHxlbCostField& CostField, int32 NumLandmarks)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(HXLB_BuildLandmarks);
+	
+	Reset();
+	if (!CostField.IsValid() || NumLandmarks <= 0)
+	{
+		return;
+	}
+	PickLandmarks(CostField, NumLandmarks);
+	BuildTables(CostField);
+}
+
+void FHxlbLandmarks::Reset()
+{
+	Landmarks.Reset();
+	Distances.Reset();
+	bDirty = false;
+}
+
+void FHxlbLandmarks::Refresh(const FHxlbCostField& CostField)
+{
+	if (bDirty && IsBuilt() && CostField.IsValid())
+	{
+		TRACE_CPUPROFILER_EVENT_SCOPE(HXLB_RefreshLandmarks);
+		BuildTables(CostField);
+	}
+}
+
+float FHxlbLandmarks::GetLowerBound(const FHxlbCostField& CostField, int32 FromIndex, int32 ToIndex) const
+{
+	const int32 NumLandmarks = Landmarks.Num();
+	const float* From = &Distances[FromIndex * NumLandmarks];
+	const float* To = &Distances[ToIndex * NumLandmarks];
+
+	// Cost(X, L) = Cost(L, X) - Cost(X) + Cost(L), so the second bound only differs from the first by the costs of the
+	// ends. Blocked hexes have no finite cost, but can still be where a search starts.
+	const float FromCost = CostField.IsBlocked(FromIndex) ? 0.0f : CostField.GetCost(FromIndex);
+	const float ToCost = CostField.IsBlocked(ToIndex) ? 0.0f : CostField.GetCost(ToIndex);
+	
+	float Bound = 0.0f;
+	for (int32 LandmarkIndex = 0; LandmarkIndex < NumLandmarks; LandmarkIndex++)
+	{
+		if (From[LandmarkIndex] == FHxlbDistanceField::Unreachable || To[LandmarkIndex] == FHxlbDistanceField::Unreachable)
+		{
+			continue;
+		}
+		const float Forward = To[LandmarkIndex] - From[LandmarkIndex];
+		const float Backward = (From[LandmarkIndex] - FromCost) - (To[LandmarkIndex] - ToCost);
+		Bound = FMath::Max3(Bound, Forward, Backward);
+	}
+	return Bound;
+}
+
+void FHxlbLandmarks::PickLandmarks(const FHxlbCostField& CostField, int32 NumLandmarks)
+{
+	const FHxlbDenseLayout& Layout = CostField.GetLayout();
+	auto FarthestPassableHex = [&CostField, &Layout](const FHxlbDistanceField& Steps)
+	{
+		int32 Farthest = INDEX_NONE;
+		for (int32 DenseIndex = 0; DenseIndex < Layout.Num(); DenseIndex++)
+		{
+			const float Distance = Steps.GetDistance(DenseIndex);
+			if (!CostField.IsBlocked(DenseIndex) && Distance > 0.0f && Distance != FHxlbDistanceField::Unreachable
+				&& (Farthest == INDEX_NONE || Distance > Steps.GetDistance(Farthest)))
+			{
+				Farthest = DenseIndex;
+			}
+		}
+		return Farthest;
+	};
+
+	// Start from the hex farthest from the middle of the map, then keep adding the hex farthest from every landmark so
+	// far.
+	FHxlbDistanceField Steps;
+	Steps.Build(Layout, {Layout.Num() / 2});
+	int32 Next = FarthestPassableHex(Steps);
+	if (Next == INDEX_NONE)
+	{
+		return;
+	}
+	
+	Steps.Build(Layout, {Next});
+	while (Next != INDEX_NONE && Landmarks.Num() < NumLandmarks)
+	{
+		Landmarks.Add(Next);
+		Steps.AddSources({Next});
+		Next = FarthestPassableHex(Steps);
+	}
+}
+
+void FHxlbLandmarks::BuildTables(const FHxlbCostField& CostField)
+{
+	const int32 NumLandmarks = Landmarks.Num();
+	const int32 NumHexes = CostField.GetLayout().Num();
+	TArray<FHxlbDistanceField> Fields;
+	Fields.SetNum(NumLandmarks);
+	ParallelFor(NumLandmarks, [this, &CostField, &Fields](int32 LandmarkIndex)
+	{
+		Fields[LandmarkIndex].Build(CostField, {Landmarks[LandmarkIndex]});
+	});
+
+	Distances.SetNumUninitialized(NumHexes * NumLandmarks);
+	for (int32 LandmarkIndex = 0; LandmarkIndex < NumLandmarks; LandmarkIndex++)
+	{
+		TConstArrayView<float> FieldDistances = Fields[LandmarkIndex].GetDistances();
+		for (int32 DenseIndex = 0; DenseIndex < NumHexes; DenseIndex++)
+		{
+			Distances[DenseIndex * NumLandmarks + LandmarkIndex] = FieldDistances[DenseIndex];
+		}
+	}
+	bDirty = false;
+}
@@ -0,0 +1,353 @@
+// Copyright © Mason Stevenson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the disclaimer
+// below) provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+// THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+// CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+// NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "Navigation/HxlbMovementRange.h"
+
+#include "Async/ParallelFor.h"
+#include "FunctionLibraries/HxlbMath.h"
+#include "Navigation/HxlbSearchScratch.h"
+
+using HexMath = UHxlbMath;
+
+namespace
+{
+	constexpr int32 kBitsPerWord = FHxlbHexBitmap::kBitsPerWord;
+	
+	// Rows of the hexes around a query origin, with one bit per axial Q. Aligning rows on Q means that the neighbors of
+	// a hex in the rows above and below are at the same bit and one bit over, so a step of the search is a handful of
+	// shifts per word. The first and last rows are always empty so that the search never has to check for them.
+	struct FRangeWindow
+	{
+		void Init(int32 NewNumRows, int32 NewWordsPerRow)
+		{
+			NumRows = NewNumRows;
+			WordsPerRow = NewWordsPerRow;
+			const int32 NumWords = NumRows * WordsPerRow;
+			for (TArray<uint64>* Words : {&Passable, &Visited, &Frontier, &Next})
+			{
+				Words->SetNumUninitialized(NumWords, EAllowShrinking::No);
+				FMemory::Memzero(Words->GetData(), NumWords * sizeof(uint64));
+			}
+		}
+
+		TArrayView<uint64> Row(TArray<uint64>& Words, int32 RowIndex)
+		{
+			return TArrayView<uint64>(Words.GetData() + RowIndex * WordsPerRow, WordsPerRow);
+		}
+		
+		int32 NumRows = 0;
+		int32 WordsPerRow = 0;
+		TArray<uint64> Passable;
+		TArray<uint64> Visited;
+		TArray<uint64> Frontier;
+		TArray<uint64> Next;
+	};
+
+	// Bit Q - 1 moved to Q.
+	FORCEINLINE uint64 FromLowerQ(const uint64* Row, int32 Word)
+	{
+		return (Row[Word] << 1) | (Word > 0 ? Row[Word - 1] >> (kBitsPerWord - 1) : 0);
+	}
+
+	// Bit Q + 1 moved to Q.
+	FORCEINLINE uint64 FromHigherQ(const uint64* Row, int32 Word, int32 WordsPerRow)
+	{
+		return (Row[Word] >> 1) | (Word + 1 < WordsPerRow ? Row[Word + 1] << (kBitsPerWord - 1) : 0);
+	}
+
+	// Copies Count bits between a row of the layout and a row of the window, 64 at a time.
+	template <typename FuncType>
+	void ForEachBitBlock(int32 Count, FuncType&& Func)
+	{
+		for (int32 Offset = 0; Offset < Count; Offset += kBitsPerWord)
+		{
+			Func(Offset, FMath::Min(kBitsPerWord, Count - Offset));
+		}
+	}
+}
+
+void FHxlbMovementRange::Build(const FHxlbCostField& CostField)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(HXLB_BuildMovementRange);
+	
+	Reset();
+	if (!CostField.IsValid())
+	{
+		return;
+	}
+
+	Layout = &CostField.GetLayout();
+	Passable.Init(Layout->Num());
+
+	// One task per block of words, so that no two tasks write the same word.
+	constexpr int32 kWordsPerTask = 64;
+	TArrayView<uint64> Words = Passable.GetMutableWords();
+	const int32 NumHexes = Layout->Num();
+	ParallelFor(FMath::DivideAndRoundUp(Words.Num(), kWordsPerTask), [&Words, &CostField, NumHexes](int32 TaskIndex)
+	{
+		const int32 LastWord = FMath::Min(Words.Num(), (TaskIndex + 1) * kWordsPerTask);
+		for (int32 WordIndex = TaskIndex * kWordsPerTask; WordIndex < LastWord; WordIndex++)
+		{
+			uint64 Word = 0;
+			const int32 FirstIndex = WordIndex * kBitsPerWord;
+			const int32 NumBits = FMath::Min(kBitsPerWord, NumHexes - FirstIndex);
+			for (int32 Bit = 0; Bit < NumBits; Bit++)
+			{
+				Word |= static_cast<uint64>(!CostField.IsBlocked(FirstIndex + Bit)) << Bit;
+			}
+			Words[WordIndex] = Word;
+		}
+	});
+}
+
+void FHxlbMovementRange::UpdateHexes(const FHxlbCostField& CostField, TConstArrayView<int32> DenseIndices)
+{
+	if (!IsBuilt() || !CostField.IsValid() || Passable.Num() != CostField.GetLayout().Num())
+	{
+		Build(CostField);
+		return;
+	}
+	
+	for (int32 DenseIndex : DenseIndices)
+	{
+		Passable.SetTo(DenseIndex, !CostField.IsBlocked(DenseIndex));
+	}
+}
+
+void FHxlbMovementRange::Reset()
+{
+	Layout = nullptr;
+	Passable.Init(0);
+}
+
+int32 FHxlbMovementRange::FindReachable(FIntPoint Origin, int32 MaxSteps, FHxlbHexBitmap& OutReachable) const
+{
+	const int32 OriginIndex = IsBuilt() ? Layout->IndexOf(Origin) : INDEX_NONE;
+	OutReachable.Init(IsBuilt() ? Layout->Num() : 0);
+	if (OriginIndex == INDEX_NONE)
+	{
+		return 0;
+	}
+
+	// Everything within MaxSteps lies inside of the axial bounding box of the range, clipped to the rows of the map.
+	MaxSteps = FMath::Max(0, MaxSteps);
+	const int32 QLow = HEX_Q(Origin) - MaxSteps;
+	const int32 Width = 2 * MaxSteps + 1;
+	const int32 RLow = FMath::Max(HEX_R(Origin) - MaxSteps, Layout->GetMinR());
+	const int32 RHigh = FMath::Min(HEX_R(Origin) + MaxSteps, Layout->GetMaxR());
+	const int32 NumRows = RHigh - RLow + 1;
+	const int32 WordsPerRow = FHxlbHexBitmap::NumWordsFor(Width);
+
+	static thread_local FRangeWindow Window;
+	Window.Init(NumRows + 2, WordsPerRow);
+
+	// Bits of the window row that overlap the map row, as (first window bit, first dense index, count).
+	auto GetOverlap = [this, QLow, Width, RLow](int32 WindowRow, int32& OutWindowBit, int32& OutDenseIndex) -> int32
+	{
+		const int32 LayoutRow = RLow + WindowRow - 1 - Layout->GetMinR();
+		const FHxlbHexRowSpan& Span = Layout->GetRow(LayoutRow);
+		const int32 QFirst = FMath::Max(Span.QMin, QLow);
+		const int32 QLast = FMath::Min(Span.QMax, QLow + Width - 1);
+		OutWindowBit = QFirst - QLow;
+		OutDenseIndex = Layout->GetRowStart(LayoutRow) + QFirst - Span.QMin;
+		return FMath::Max(0, QLast - QFirst + 1);
+	};
+
+	for (int32 WindowRow = 1; WindowRow <= NumRows; WindowRow++)
+	{
+		int32 WindowBit, DenseIndex;
+		const int32 Count = GetOverlap(WindowRow, WindowBit, DenseIndex);
+		TArrayView<uint64> PassableRow = Window.Row(Window.Passable, WindowRow);
+		ForEachBitBlock(Count, [&](int32 Offset, int32 BlockSize)
+		{
+			FHxlbHexBitmap::OrWordBits(PassableRow, WindowBit + Offset, Passable.ReadBits(DenseIndex + Offset, BlockSize), BlockSize);
+		});
+	}
+
+	const int32 OriginRow = HEX_R(Origin) - RLow + 1;
+	Window.Row(Window.Visited, OriginRow)[MaxSteps / kBitsPerWord] |= static_cast<uint64>(1) << (MaxSteps % kBitsPerWord);
+	Window.Row(Window.Frontier, OriginRow)[MaxSteps / kBitsPerWord] |= static_cast<uint64>(1) << (MaxSteps % kBitsPerWord);
+
+	// The frontier grows by at most one row in each direction per step.
+	int32 ActiveFirst = OriginRow;
+	int32 ActiveLast = OriginRow;
+	for (int32 Step = 0; Step < MaxSteps; Step++)
+	{
+		const int32 First = FMath::Max(1, ActiveFirst - 1);
+		const int32 Last = FMath::Min(NumRows, ActiveLast + 1);
+		int32 NewFirst = INDEX_NONE;
+		int32 NewLast = INDEX_NONE;
+
+		for (int32 WindowRow = First; WindowRow <= Last; WindowRow++)
+		{
+			const uint64* Above = Window.Frontier.GetData() + (WindowRow - 1) * WordsPerRow;
+			const uint64* Center = Above + WordsPerRow;
+			const uint64* Below = Center + WordsPerRow;
+			const int32 RowStart = WindowRow * WordsPerRow;
+			uint64 RowBits = 0;
+			
+			for (int32 Word = 0; Word < WordsPerRow; Word++)
+			{
+				// Neighbors of (Q, R) are (Q +- 1, R), (Q, R - 1), (Q + 1, R - 1), (Q - 1, R + 1) and (Q, R + 1).
+				const uint64 Expanded = FromLowerQ(Center, Word) | FromHigherQ(Center, Word, WordsPerRow)
+					| Above[Word] | FromHigherQ(Above, Word, WordsPerRow)
+					| Below[Word] | FromLowerQ(Below, Word);
+				const uint64 NewBits = Expanded & Window.Passable[RowStart + Word] & ~Window.Visited[RowStart + Word];
+				Window.Next[RowStart + Word] = NewBits;
+				RowBits |= NewBits;
+			}
+			
+			if (RowBits)
+			{
+				NewFirst = NewFirst == INDEX_NONE ? WindowRow : NewFirst;
+				NewLast = WindowRow;
+			}
+		}
+
+		if (NewFirst == INDEX_NONE)
+		{
+			break;
+		}
+
+		// Rows outside of [First, Last] had no frontier before this step and still don't.
+		for (int32 WordIndex = First * WordsPerRow; WordIndex < (Last + 1) * WordsPerRow; WordIndex++)
+		{
+			Window.Frontier[WordIndex] = Window.Next[WordIndex];
+			Window.Visited[WordIndex] |= Window.Next[WordIndex];
+		}
+		ActiveFirst = NewFirst;
+		ActiveLast = NewLast;
+	}
+
+	int32 NumReachable = 0;
+	TArrayView<uint64> OutWords = OutReachable.GetMutableWords();
+	for (int32 WindowRow = 1; WindowRow <= NumRows; WindowRow++)
+	{
+		int32 WindowBit, DenseIndex;
+		const int32 Count = GetOverlap(WindowRow, WindowBit, DenseIndex);
+		const TArrayView<uint64> VisitedRow = Window.Row(Window.Visited, WindowRow);
+		ForEachBitBlock(Count, [&](int32 Offset, int32 BlockSize)
+		{
+			const uint64 Bits = FHxlbHexBitmap::ReadWordBits(VisitedRow, WindowBit + Offset, BlockSize);
+			FHxlbHexBitmap::OrWordBits(OutWords, DenseIndex + Offset, Bits, BlockSize);
+			NumReachable += static_cast<int32>(FMath::CountBits(Bits));
+		});
+	}
+	return NumReachable;
+}
+
+int32 FHxlbMovementRange::FindReachableWeighted(const FHxlbCostField& CostField, FIntPoint Origin, float MaxCost, FHxlbHexBitmap& OutReachable)
+{
+	const int32 OriginIndex = CostField.IsValid() ? CostField.GetLayout().IndexOf(Origin) : INDEX_NONE;
+	OutReachable.Init(CostField.IsValid() ? CostField.GetLayout().Num() : 0);
+	if (OriginIndex == INDEX_NONE || MaxCost < 0.0f)
+	{
+		return 0;
+	}
+	const FHxlbDenseLayout& Layout = CostField.GetLayout();
+
+	// Every step costs at least MinCost, so with buckets that wide nothing popped from a bucket can improve anything else
+	// in the same bucket, and every hex is final when it's popped. Budgets that would need too many buckets use wider
+	// ones instead, and hexes that improve within the bucket being processed are simply processed again.
+	const float BucketWidth = FMath::Max3(CostField.GetMinCost(), MaxCost / kMaxBuckets, UE_KINDA_SMALL_NUMBER);
+	const int32 NumBuckets = FMath::FloorToInt32(MaxCost / BucketWidth) + 1;
+	
+	static thread_local TArray<TArray<FHxlbHeapNode>> Buckets;
+	if (Buckets.Num() < NumBuckets)
+	{
+		Buckets.SetNum(NumBuckets);
+	}
+
+	FHxlbSearchScratch& Scratch = FHxlbSearchScratch::GetForThisThread();
+	Scratch.Begin(Layout.Num());
+	Scratch.Open(OriginIndex, Origin, 0.0f, INDEX_NONE);
+	Buckets[0].Add(FHxlbHeapNode{0.0f, OriginIndex});
+
+	int32 NumReachable = 0;
+	for (int32 BucketIndex = 0; BucketIndex < NumBuckets; BucketIndex++)
+	{
+		TArray<FHxlbHeapNode>& Bucket = Buckets[BucketIndex];
+		while (!Bucket.IsEmpty())
+		{
+			const FHxlbHeapNode Node = Bucket.Pop(EAllowShrinking::No);
+			if (Node.Key > Scratch.GetCost(Node.Index))
+			{
+				continue;
+			}
+			if (!OutReachable.Get(Node.Index))
+			{
+				OutReachable.Set(Node.Index);
+				NumReachable++;
+			}
+
+			const FIntPoint HexCoord = Scratch.GetCoord(Node.Index);
+			for (int32 Direction = 0; Direction < 6; Direction++)
+			{
+				const FIntPoint NeighborCoord = HexCoord + HexMath::DirectionIndexToAxial(Direction);
+				const int32 NeighborIndex = Layout.IndexOf(NeighborCoord);
+				if (NeighborIndex == INDEX_NONE || CostField.IsBlocked(NeighborIndex))
+				{
+					continue;
+				}
+				
+				const float NeighborCost = Node.Key + CostField.GetCost(NeighborIndex);
+				if (NeighborCost > MaxCost || NeighborCost >= Scratch.GetCost(NeighborIndex))
+				{
+					continue;
+				}
+				Scratch.Open(NeighborIndex, NeighborCoord, NeighborCost, Node.Index);
+				const int32 NeighborBucket = FMath::Clamp(FMath::FloorToInt32(NeighborCost / BucketWidth), BucketIndex, NumBuckets - 1);
+				Buckets[NeighborBucket].Add(FHxlbHeapNode{NeighborCost, NeighborIndex});
+			}
+		}
+	}
+	return NumReachable;
+}
+
+void FHxlbMovementRange::FindReachableBatch(const FHxlbCostField& CostField, TConstArrayView<FHxlbMovementRangeQuery> Queries, TFunctionRef<void(int32, const FHxlbHexBitmap&)> Func) const
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(HXLB_FindReachableBatch);
+	
+	ParallelFor(Queries.Num(), [this, &CostField, &Queries, &Func](int32 QueryIndex)
+	{
+		static thread_local FHxlbHexBitmap Reachable;
+		const FHxlbMovementRangeQuery& Query = Queries[QueryIndex];
+		if (Query.bUniformCost)
+		{
+			FindReachable(Query.Origin, FMath::FloorToInt32(Query.MaxCost), Reachable);
+		}
+		else
+		{
+			FindReachableWeighted(CostField, Query.Origin, Query.MaxCost, Reachable);
+		}
+		Func(QueryIndex, Reachable);
+	});
+}
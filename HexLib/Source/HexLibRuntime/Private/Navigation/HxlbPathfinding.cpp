@@ -0,0 +1,164 @@
+// Copyright © Mason Stevenson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the disclaimer
+// below) provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+// THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+// CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+// NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "Navigation/HxlbPathfinding.h"
+
+#include "Algo/Reverse.h"
+#include "FunctionLibraries/HxlbMath.h"
+#include "Navigation/HxlbSearchScratch.h"
+
+using HexMath = UHxlbMath;
+
+EHxlbPathStatus FHxlbPathfinder::FindPath(const FHxlbCostField& CostField, FIntPoint Start, FIntPoint Goal, const FHxlbPathQueryParams& Params, FHxlbPathResult& OutResult, const FHxlbLandmarks* Landmarks)
+{
+	OutResult.Path.Reset();
+	OutResult.Cost = 0.0f;
+	OutResult.NumExpanded = 0;
+	OutResult.Status = EHxlbPathStatus::InvalidQuery;
+	
+	if (!CostField.IsValid())
+	{
+		return OutResult.Status;
+	}
+	
+	const FHxlbDenseLayout& Layout = CostField.GetLayout();
+	const int32 StartIndex = Layout.IndexOf(Start);
+	if (StartIndex == INDEX_NONE || !Layout.Contains(Goal))
+	{
+		return OutResult.Status;
+	}
+
+	const int32 GoalTolerance = FMath::Max(0, Params.GoalTolerance);
+	const float MaxCost = Params.MaxCost > 0.0f ? Params.MaxCost : TNumericLimits<float>::Max();
+	const float HeuristicWeight = FMath::Max(1.0f, Params.HeuristicWeight);
+	const float HeuristicScale = CostField.GetMinCost() * HeuristicWeight;
+
+	// Landmark bounds are to the goal itself, so they would overestimate with a goal tolerance.
+	const int32 GoalIndex = Layout.IndexOf(Goal);
+	const FHxlbLandmarks* GoalLandmarks = Landmarks && GoalTolerance == 0 && Landmarks->IsUsableWith(CostField) ? Landmarks : nullptr;
+	auto Heuristic = [&](FIntPoint HexCoord, int32 DenseIndex) -> float
+	{
+		const float HexBound = FMath::Max(0, HexMath::AxialDistanceFast(HexCoord, Goal) - GoalTolerance) * HeuristicScale;
+		if (!GoalLandmarks)
+		{
+			return HexBound;
+		}
+		return FMath::Max(HexBound, GoalLandmarks->GetLowerBound(CostField, DenseIndex, GoalIndex) * HeuristicWeight);
+	};
+
+	FHxlbSearchScratch& Scratch = FHxlbSearchScratch::GetForThisThread();
+	Scratch.Begin(Layout.Num());
+	Scratch.Open(StartIndex, Start, 0.0f, INDEX_NONE);
+	Scratch.Heap.Push(Heuristic(Start, StartIndex), StartIndex);
+
+	// For partial paths: the explored hex closest to the goal, and the cheapest way to it.
+	int32 BestIndex = StartIndex;
+	int32 BestDistance = HexMath::AxialDistanceFast(Start, Goal);
+	
+	int32 EndIndex = INDEX_NONE;
+	int32 NumExpanded = 0;
+	
+	while (!Scratch.Heap.IsEmpty())
+	{
+		const FHxlbHeapNode Node = Scratch.Heap.Pop();
+		if (Scratch.IsClosed(Node.Index))
+		{
+			// Stale entry, the hex has already been expanded through a cheaper path.
+			continue;
+		}
+		Scratch.Close(Node.Index);
+
+		const FIntPoint HexCoord = Scratch.GetCoord(Node.Index);
+		const float CostSoFar = Scratch.GetCost(Node.Index);
+		const int32 Distance = HexMath::AxialDistanceFast(HexCoord, Goal);
+		
+		if (Distance <= GoalTolerance)
+		{
+			EndIndex = Node.Index;
+			break;
+		}
+		if (Distance < BestDistance || (Distance == BestDistance && CostSoFar < Scratch.GetCost(BestIndex)))
+		{
+			BestIndex = Node.Index;
+			BestDistance = Distance;
+		}
+		
+		if (Params.MaxExpansions > 0 && NumExpanded >= Params.MaxExpansions)
+		{
+			break;
+		}
+		NumExpanded++;
+		
+		for (int32 Direction = 0; Direction < 6; Direction++)
+		{
+			const FIntPoint NeighborCoord = HexCoord + HexMath::DirectionIndexToAxial(Direction);
+			const int32 NeighborIndex = Layout.IndexOf(NeighborCoord);
+			if (NeighborIndex == INDEX_NONE || Scratch.IsClosed(NeighborIndex) || CostField.IsBlocked(NeighborIndex))
+			{
+				continue;
+			}
+
+			const float NeighborCost = CostSoFar + CostField.GetCost(NeighborIndex);
+			if (NeighborCost > MaxCost || NeighborCost >= Scratch.GetCost(NeighborIndex))
+			{
+				continue;
+			}
+			
+			Scratch.Open(NeighborIndex, NeighborCoord, NeighborCost, Node.Index);
+			Scratch.Heap.Push(NeighborCost + Heuristic(NeighborCoord, NeighborIndex), NeighborIndex);
+		}
+	}
+	
+	OutResult.NumExpanded = NumExpanded;
+	if (EndIndex != INDEX_NONE)
+	{
+		OutResult.Status = EHxlbPathStatus::Found;
+	}
+	else if (Params.bAllowPartialPath && BestIndex != StartIndex)
+	{
+		EndIndex = BestIndex;
+		OutResult.Status = EHxlbPathStatus::Partial;
+	}
+	else
+	{
+		OutResult.Status = EHxlbPathStatus::NoPath;
+		return OutResult.Status;
+	}
+
+	OutResult.Cost = Scratch.GetCost(EndIndex);
+	for (int32 Index = EndIndex; Index != INDEX_NONE; Index = Scratch.GetParent(Index))
+	{
+		OutResult.Path.Add(Scratch.GetCoord(Index));
+	}
+	Algo::Reverse(OutResult.Path);
+	
+	return OutResult.Status;
+}
@@ -0,0 +1,63 @@
+// Copyright © Mason Stevenson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the disclaimer
+// below) provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+// THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+// CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+// NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "Navigation/HxlbSearchScratch.h"
+
+FHxlbSearchScratch& FHxlbSearchScratch::GetForThisThread()
+{
+	static thread_local FHxlbSearchScratch Scratch;
+	return Scratch;
+}
+
+void FHxlbSearchScratch::Begin(int32 NumHexes)
+{
+	Heap.Reset();
+	
+	if (OpenStamps.Num() < NumHexes)
+	{
+		// Growing invalidates every stamp, so start over from generation 1.
+		Generation = 0;
+		OpenStamps.Init(0, NumHexes);
+		ClosedStamps.Init(0, NumHexes);
+		Costs.SetNumUninitialized(NumHexes);
+		Parents.SetNumUninitialized(NumHexes);
+		Coords.SetNumUninitialized(NumHexes);
+	}
+
+	Generation++;
+	if (Generation == 0)
+	{
+		// The counter wrapped around. Stale stamps could now collide with new ones, so clear them.
+		FMemory::Memzero(OpenStamps.GetData(), OpenStamps.Num() * sizeof(uint32));
+		FMemory::Memzero(ClosedStamps.GetData(), ClosedStamps.Num() * sizeof(uint32));
+		Generation = 1;
+	}
+}
@@ -0,0 +1,738 @@
+// Copyright © Mason Stevenson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the disclaimer
+// below) provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+// THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+// CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+// NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "HexLibRuntimeLoggingDefs.h"
+#include "Analysis/HxlbDistanceField.h"
+#include "Analysis/HxlbHexAggregate.h"
+#include "Analysis/HxlbInfluenceMap.h"
+#include "Analysis/HxlbRegionBorders.h"
+#include "Analysis/HxlbRegionLabeling.h"
+#include "Containers/Array.h"
+#include "Containers/UnrealString.h"
+#include "Foundation/HxlbDenseLayout.h"
+#include "Foundation/HxlbHexHierarchy.h"
+#include "FunctionLibraries/HxlbMath.h"
+#include "Macros/HexLibLoggingMacros.h"
+#include "Math/RandomStream.h"
+#include "Misc/AutomationTest.h"
+#include "Navigation/HxlbCostField.h"
+
+#if WITH_EDITOR
+
+class FAnalysisTestSuite
+{
+public:
+	FAnalysisTestSuite(FAutomationTestBase* NewTestFramework): TestFramework(NewTestFramework)
+	{
+		// This constructor is run before each test.
+		Layout.InitHexagonal(20, 8);
+		Costs.Init(1.0f, Layout.Num());
+	}
+
+	void Test_InfluenceFalloff()
+	{
+		FHxlbInfluenceMap Influence;
+		Influence.Init(Layout);
+
+		FHxlbInfluenceSource Source;
+		Source.Strength = 4.0f;
+		Source.Radius = 3;
+		Influence.SetSource(0, Source);
+
+		Source.Faction = 1;
+		Source.HexCoord = FIntPoint(2, 0);
+		Source.Falloff = EHxlbInfluenceFalloff::Exponential;
+		Influence.SetSource(1, Source);
+		Influence.Update(GetCostField());
+		
+		TestFramework->TestEqual(TEXT("Full strength at the source"), Influence.GetInfluence(0, Layout.IndexOf(FIntPoint(0, 0))), 4.0f);
+		TestFramework->TestEqual(TEXT("Linear falloff"), Influence.GetInfluence(0, Layout.IndexOf(FIntPoint(0, 2))), 2.0f);
+		TestFramework->TestEqual(TEXT("Edge of the range"), Influence.GetInfluence(0, Layout.IndexOf(FIntPoint(-3, 0))), 1.0f);
+		TestFramework->TestEqual(TEXT("Past the range"), Influence.GetInfluence(0, Layout.IndexOf(FIntPoint(-4, 0))), 0.0f);
+		TestFramework->TestEqual(TEXT("Exponential falloff"), Influence.GetInfluence(1, Layout.IndexOf(FIntPoint(0, 0))), 1.0f);
+		TestFramework->TestEqual(TEXT("Threat is the other factions' influence"), Influence.GetOpposingInfluence(1, Layout.IndexOf(FIntPoint(1, 0))), 3.0f);
+		TestFramework->TestEqual(TEXT("Unknown factions have no influence"), Influence.GetInfluence(7, 0), 0.0f);
+		TestFramework->TestFalse(TEXT("Up to date"), Influence.NeedsUpdate());
+	}
+
+	void Test_InfluenceSpreadsAroundWalls()
+	{
+		// A wall along Q = 2, with a gap at R = 3.
+		for (int32 R = -20; R <= 20; R++)
+		{
+			const int32 Index = Layout.IndexOf(FIntPoint(2, R));
+			if (Index != INDEX_NONE && R != 3)
+			{
+				Costs[Index] = HxlbMovementCost::Blocked;
+			}
+		}
+
+		FHxlbInfluenceMap Influence;
+		Influence.Init(Layout);
+		FHxlbInfluenceSource Source;
+		Source.Radius = 8;
+		Source.Falloff = EHxlbInfluenceFalloff::Constant;
+		Influence.SetSource(0, Source);
+		
+		Source.Faction = 1;
+		Source.bBlockedByTerrain = false;
+		Influence.SetSource(1, Source);
+		Influence.Update(GetCostField());
+
+		TestFramework->TestEqual(TEXT("Walls get nothing"), Influence.GetInfluence(0, Layout.IndexOf(FIntPoint(2, 0))), 0.0f);
+		TestFramework->TestEqual(TEXT("Reaches around the wall"), Influence.GetInfluence(0, Layout.IndexOf(FIntPoint(3, 0))), 1.0f);
+		TestFramework->TestEqual(TEXT("Too far around the wall"), Influence.GetInfluence(0, Layout.IndexOf(FIntPoint(3, -4))), 0.0f);
+		TestFramework->TestEqual(TEXT("Ignores the wall"), Influence.GetInfluence(1, Layout.IndexOf(FIntPoint(3, -4))), 1.0f);
+
+		// Closing the gap.
+		const int32 Gap = Layout.IndexOf(FIntPoint(2, 3));
+		Costs[Gap] = HxlbMovementCost::Blocked;
+		Influence.MarkHexesChanged({Gap});
+		Influence.Update(GetCostField());
+		TestFramework->TestEqual(TEXT("Gap closed"), Influence.GetInfluence(0, Layout.IndexOf(FIntPoint(3, 0))), 0.0f);
+		TestFramework->TestEqual(TEXT("Unaffected faction"), Influence.GetInfluence(1, Layout.IndexOf(FIntPoint(3, 0))), 1.0f);
+	}
+
+	void Test_InfluenceUpdateMatchesRebuild()
+	{
+		FRandomStream Random(34);
+		for (int32 Index = 0; Index < Layout.Num(); Index++)
+		{
+			Costs[Index] = Random.FRand() < 0.2f ? HxlbMovementCost::Blocked : 1.0f;
+		}
+		
+		TArray<FHxlbInfluenceSource> Sources;
+		for (int32 SourceId = 0; SourceId < 40; SourceId++)
+		{
+			Sources.Add(MakeRandomSource(Random));
+		}
+
+		FHxlbInfluenceMap Influence;
+		Influence.Init(Layout);
+		for (int32 SourceId = 0; SourceId < Sources.Num(); SourceId++)
+		{
+			Influence.SetSource(SourceId, Sources[SourceId]);
+		}
+		Influence.Update(GetCostField());
+		TestFramework->TestEqual(TEXT("First update touches every chunk"), Influence.GetUpdatedChunks().Num(), Layout.NumChunks());
+
+		for (int32 Round = 0; Round < 6; Round++)
+		{
+			for (int32 Move = 0; Move < 3; Move++)
+			{
+				const int32 SourceId = Random.RandHelper(Sources.Num());
+				Sources[SourceId] = MakeRandomSource(Random);
+				Influence.SetSource(SourceId, Sources[SourceId]);
+			}
+			
+			TArray<int32> ChangedIndices;
+			for (int32 Change = 0; Change < 5; Change++)
+			{
+				const int32 Index = Random.RandHelper(Layout.Num());
+				Costs[Index] = HxlbMovementCost::IsBlocked(Costs[Index]) ? 1.0f : HxlbMovementCost::Blocked;
+				ChangedIndices.Add(Index);
+			}
+			Influence.MarkHexesChanged(ChangedIndices);
+			if (Round == 3)
+			{
+				Influence.RemoveSource(Sources.Num() - 1);
+				Sources.Pop();
+			}
+			Influence.Update(GetCostField());
+
+			FHxlbInfluenceMap Rebuilt;
+			Rebuilt.Init(Layout);
+			for (int32 SourceId = 0; SourceId < Sources.Num(); SourceId++)
+			{
+				Rebuilt.SetSource(SourceId, Sources[SourceId]);
+			}
+			Rebuilt.Update(GetCostField());
+			
+			for (int32 Faction = 0; Faction < 3; Faction++)
+			{
+				int32 NumMismatches = 0;
+				for (int32 Index = 0; Index < Layout.Num(); Index++)
+				{
+					if (!FMath::IsNearlyEqual(Influence.GetInfluence(Faction, Index), Rebuilt.GetInfluence(Faction, Index), 1.e-4f))
+					{
+						NumMismatches++;
+					}
+				}
+				TestFramework->TestEqual(FString::Printf(TEXT("Round %d, faction %d"), Round, Faction), NumMismatches, 0);
+			}
+		}
+	}
+
+	void Test_RegionsSplitAndMerge()
+	{
+		// Two halves of the map, split by a line of water along Q = 0.
+		TArray<uint32> Keys;
+		Keys.Init(1, Layout.Num());
+		for (int32 Index = 0; Index < Layout.Num(); Index++)
+		{
+			Keys[Index] = HEX_Q(Layout.CoordOf(Index)) == 0 ? 0 : 1;
+		}
+		auto KeyOf = [&Keys](int32 DenseIndex) { return Keys[DenseIndex]; };
+		
+		FHxlbRegionLabeling Regions;
+		Regions.Build(Layout, KeyOf);
+		const int32 West = Layout.IndexOf(FIntPoint(-5, 0));
+		const int32 East = Layout.IndexOf(FIntPoint(5, 0));
+		TestFramework->TestEqual(TEXT("Two land masses"), Regions.NumRegions(), 2);
+		TestFramework->TestFalse(TEXT("Split by water"), Regions.IsSameRegion(West, East));
+		TestFramework->TestEqual(TEXT("Water isn't a region"), Regions.GetRegion(Layout.IndexOf(FIntPoint(0, 3))), INDEX_NONE);
+		TestFramework->TestEqual(TEXT("Halves are the same size"), Regions.GetRegionSize(Regions.GetRegion(West)), Regions.GetRegionSize(Regions.GetRegion(East)));
+
+		// A bridge joins them.
+		const int32 Bridge = Layout.IndexOf(FIntPoint(0, 0));
+		Keys[Bridge] = 1;
+		Regions.Update({Bridge}, KeyOf);
+		TestFramework->TestEqual(TEXT("One land mass"), Regions.NumRegions(), 1);
+		TestFramework->TestTrue(TEXT("Joined by the bridge"), Regions.IsSameRegion(West, East));
+		TestFramework->TestEqual(TEXT("Size of the joined region"), Regions.GetRegionSize(Regions.GetRegion(West)), Layout.Num() - 40);
+
+		TArray<int32> RegionHexes;
+		Regions.GetRegionHexes(West, RegionHexes);
+		TestFramework->TestEqual(TEXT("Region hexes"), RegionHexes.Num(), Layout.Num() - 40);
+
+		// Changing the key of the bridge splits them again.
+		Keys[Bridge] = 2;
+		Regions.Update({Bridge}, KeyOf);
+		TestFramework->TestEqual(TEXT("Split again"), Regions.NumRegions(), 3);
+		TestFramework->TestFalse(TEXT("Bridge belongs to neither"), Regions.IsSameRegion(West, Bridge) || Regions.IsSameRegion(East, Bridge));
+		TestFramework->TestEqual(TEXT("Key of the bridge"), Regions.GetRegionKey(Regions.GetRegion(Bridge)), 2u);
+		TestFramework->TestEqual(TEXT("Size of the bridge"), Regions.GetRegionSize(Regions.GetRegion(Bridge)), 1);
+	}
+
+	void Test_RegionsUpdateMatchesRebuild()
+	{
+		FRandomStream Random(35);
+		TArray<uint32> Keys;
+		Keys.SetNum(Layout.Num());
+		for (int32 Index = 0; Index < Layout.Num(); Index++)
+		{
+			Keys[Index] = Random.FRand() < 0.4f ? 0 : Random.RandRange(1, 2);
+		}
+		auto KeyOf = [&Keys](int32 DenseIndex) { return Keys[DenseIndex]; };
+
+		FHxlbRegionLabeling Regions;
+		Regions.Build(Layout, KeyOf);
+		for (int32 Round = 0; Round < 20; Round++)
+		{
+			TArray<int32> ChangedIndices;
+			for (int32 Change = 0; Change < 25; Change++)
+			{
+				const int32 Index = Random.RandHelper(Layout.Num());
+				Keys[Index] = Random.FRand() < 0.5f ? 0 : Random.RandRange(1, 2);
+				ChangedIndices.Add(Index);
+			}
+			Regions.Update(ChangedIndices, KeyOf);
+
+			FHxlbRegionLabeling Rebuilt;
+			Rebuilt.Build(Layout, KeyOf);
+			TestFramework->TestEqual(FString::Printf(TEXT("Round %d: number of regions"), Round), Regions.NumRegions(), Rebuilt.NumRegions());
+
+			// Ids differ, but the partition must be the same: every rebuilt region maps onto exactly one updated region.
+			TMap<int32, int32> RebuiltToUpdated;
+			int32 NumMismatches = 0;
+			for (int32 Index = 0; Index < Layout.Num(); Index++)
+			{
+				const int32 UpdatedId = Regions.GetRegion(Index);
+				const int32 RebuiltId = Rebuilt.GetRegion(Index);
+				if ((UpdatedId == INDEX_NONE) != (RebuiltId == INDEX_NONE))
+				{
+					NumMismatches++;
+					continue;
+				}
+				if (RebuiltId == INDEX_NONE)
+				{
+					continue;
+				}
+				
+				const int32& Mapped = RebuiltToUpdated.FindOrAdd(RebuiltId, UpdatedId);
+				if (Mapped != UpdatedId || Regions.GetRegionSize(UpdatedId) != Rebuilt.GetRegionSize(RebuiltId)
+					|| Regions.GetRegionKey(UpdatedId) != Keys[Index])
+				{
+					NumMismatches++;
+				}
+			}
+			TestFramework->TestEqual(FString::Printf(TEXT("Round %d: labels"), Round), NumMismatches, 0);
+		}
+	}
+
+	void Test_BorderCornerKeys()
+	{
+		// Corners at the same place must have the same key, and corners at different places different keys.
+		TMap<int64, FVector> PositionOfKey;
+		int32 NumMismatches = 0;
+		for (int32 Index = 0; Index < Layout.Num(); Index++)
+		{
+			const FIntPoint HexCoord = Layout.CoordOf(Index);
+			if (UHxlbMath::AxialLength(HexCoord) > 3)
+			{
+				continue;
+			}
+			for (int32 Corner = 0; Corner < 6; Corner++)
+			{
+				const FVector Position = UHxlbMath::GetHexCorner(UHxlbMath::AxialToWorld(HexCoord, 100.0), 100.0, Corner);
+				const FVector& Known = PositionOfKey.FindOrAdd(FHxlbRegionBorders::CornerKey(HexCoord, Corner), Position);
+				NumMismatches += Known.Equals(Position, 0.01) ? 0 : 1;
+			}
+		}
+		TestFramework->TestEqual(TEXT("Shared corners have the same key"), NumMismatches, 0);
+
+		// A hexagon of radius 3 has 6 * 4 * 4 corners.
+		TestFramework->TestEqual(TEXT("Distinct corners have distinct keys"), PositionOfKey.Num(), 96);
+	}
+
+	void Test_BorderLoops()
+	{
+		// A ring of hexes around an empty center, and a single hex elsewhere.
+		TArray<int32> RegionIds;
+		RegionIds.Init(INDEX_NONE, Layout.Num());
+		for (int32 Index = 0; Index < Layout.Num(); Index++)
+		{
+			const int32 Distance = UHxlbMath::AxialLength(Layout.CoordOf(Index));
+			if (Distance == 1 || Distance == 2)
+			{
+				RegionIds[Index] = 1;
+			}
+		}
+		RegionIds[Layout.IndexOf(FIntPoint(8, 0))] = 2;
+		
+		FHxlbRegionBorders Borders;
+		Borders.Build(Layout, RegionIds, 100.0);
+		TestFramework->TestEqual(TEXT("Both regions were built"), Borders.GetUpdatedRegions().Num(), 2);
+
+		const FHxlbRegionBorder* Single = Borders.GetBorder(2);
+		TestFramework->TestTrue(TEXT("Single hex has a border"), Single && Single->NumLoops() == 1 && Single->GetLoop(0).Num() == 6);
+		
+		const FHxlbRegionBorder* Ring = Borders.GetBorder(1);
+		if (!TestFramework->TestTrue(TEXT("Ring has an outer border and a hole"), Ring && Ring->NumLoops() == 2))
+		{
+			return;
+		}
+		TestFramework->TestEqual(TEXT("Outer border"), Ring->GetLoop(0).Num() + Ring->GetLoop(1).Num(), 36);
+
+		// Outer borders wind one way and holes the other.
+		for (int32 LoopIndex = 0; LoopIndex < 2; LoopIndex++)
+		{
+			TConstArrayView<FVector> Loop = Ring->GetLoop(LoopIndex);
+			double Area = 0.0;
+			bool bConnected = true;
+			for (int32 Point = 0; Point < Loop.Num(); Point++)
+			{
+				const FVector& Next = Loop[(Point + 1) % Loop.Num()];
+				Area += Loop[Point].X * Next.Y - Next.X * Loop[Point].Y;
+				bConnected &= FMath::IsNearlyEqual(FVector::Dist(Loop[Point], Next), 100.0, 0.01);
+			}
+			TestFramework->TestTrue(TEXT("Consecutive points are one edge apart"), bConnected);
+			TestFramework->TestTrue(TEXT("Winding"), Loop.Num() == 30 ? Area > 0.0 : Area < 0.0);
+		}
+	}
+
+	void Test_BordersUpdateMatchesRebuild()
+	{
+		FRandomStream Random(36);
+		TArray<int32> RegionIds;
+		RegionIds.SetNum(Layout.Num());
+		for (int32 Index = 0; Index < Layout.Num(); Index++)
+		{
+			RegionIds[Index] = Random.RandRange(-1, 4);
+		}
+
+		FHxlbRegionBorders Borders;
+		Borders.Build(Layout, RegionIds, 100.0);
+		for (int32 Round = 0; Round < 10; Round++)
+		{
+			TArray<int32> ChangedIndices;
+			for (int32 Change = 0; Change < 40; Change++)
+			{
+				const int32 Index = Random.RandHelper(Layout.Num());
+				RegionIds[Index] = Round == 9 && RegionIds[Index] == 3 ? 0 : Random.RandRange(-1, 4);
+				ChangedIndices.Add(Index);
+			}
+			if (Round == 9)
+			{
+				// Takes a whole region away.
+				for (int32 Index = 0; Index < Layout.Num(); Index++)
+				{
+					if (RegionIds[Index] == 3)
+					{
+						RegionIds[Index] = 0;
+						ChangedIndices.Add(Index);
+					}
+				}
+			}
+			Borders.Update(RegionIds, ChangedIndices);
+
+			FHxlbRegionBorders Rebuilt;
+			Rebuilt.Build(Layout, RegionIds, 100.0);
+			TestFramework->TestEqual(FString::Printf(TEXT("Round %d: number of regions"), Round), Borders.GetBorders().Num(), Rebuilt.GetBorders().Num());
+			for (const auto& BorderKV : Rebuilt.GetBorders())
+			{
+				const FHxlbRegionBorder* Updated = Borders.GetBorder(BorderKV.Key);
+				const bool bSame = Updated
+					&& Updated->Edges.Num() == BorderKV.Value.Edges.Num()
+					&& Updated->Edges.Includes(BorderKV.Value.Edges)
+					&& Updated->NumLoops() == BorderKV.Value.NumLoops()
+					&& Updated->Vertices.Num() == BorderKV.Value.Vertices.Num();
+				TestFramework->TestTrue(FString::Printf(TEXT("Round %d: region %d"), Round, BorderKV.Key), bSame);
+			}
+		}
+		TestFramework->TestNull(TEXT("Removed region has no border"), Borders.GetBorder(3));
+		TestFramework->TestTrue(TEXT("Removed region was updated"), Borders.GetUpdatedRegions().Contains(3));
+	}
+
+	void Test_HierarchyPartitionsHexes()
+	{
+		FHxlbHexHierarchy Hierarchy;
+		Hierarchy.Build(Layout);
+		TestFramework->TestTrue(TEXT("Has coarser levels"), Hierarchy.NumLevels() > 2);
+		TestFramework->TestEqual(TEXT("Single top level hex"), Hierarchy.GetLayout(Hierarchy.NumLevels() - 1).Num(), 1);
+
+		for (int32 Level = 0; Level + 1 < Hierarchy.NumLevels(); Level++)
+		{
+			const FHxlbDenseLayout& LevelLayout = Hierarchy.GetLayout(Level);
+			const FHxlbDenseLayout& ParentLayout = Hierarchy.GetLayout(Level + 1);
+			int32 NumBadParents = 0;
+			int32 NumFarCenters = 0;
+			for (int32 Index = 0; Index < LevelLayout.Num(); Index++)
+			{
+				const FIntPoint Coord = LevelLayout.CoordOf(Index);
+				const FIntPoint Parent = FHxlbHexHierarchy::ParentOf(Coord);
+				NumBadParents += ParentLayout.CoordOf(Hierarchy.GetParent(Level, Index)) != Parent;
+				NumFarCenters += UHxlbMath::AxialDistanceFast(FHxlbHexHierarchy::CenterOf(Parent), Coord) > 1;
+			}
+			TestFramework->TestEqual(FString::Printf(TEXT("Level %d: parents"), Level), NumBadParents, 0);
+			TestFramework->TestEqual(FString::Printf(TEXT("Level %d: next to parent center"), Level), NumFarCenters, 0);
+
+			int32 NumChildren = 0;
+			int32 NumLeaves = 0;
+			for (int32 Index = 0; Index < ParentLayout.Num(); Index++)
+			{
+				TestFramework->TestTrue(TEXT("At most seven children"), Hierarchy.GetChildren(Level + 1, Index).Num() <= 7);
+				NumChildren += Hierarchy.GetChildren(Level + 1, Index).Num();
+				NumLeaves += Hierarchy.GetLeafCount(Level + 1, Index);
+			}
+			TestFramework->TestEqual(FString::Printf(TEXT("Level %d: every hex has one parent"), Level), NumChildren, LevelLayout.Num());
+			TestFramework->TestEqual(FString::Printf(TEXT("Level %d: every leaf is counted once"), Level), NumLeaves, Layout.Num());
+		}
+
+		for (const FIntPoint Parent : {FIntPoint(0, 0), FIntPoint(3, -5), FIntPoint(-7, 2)})
+		{
+			TestFramework->TestEqual(TEXT("CenterOf round trip"), FHxlbHexHierarchy::ParentOf(FHxlbHexHierarchy::CenterOf(Parent)), Parent);
+			TestFramework->TestEqual(TEXT("LeafCenterOf round trip"), FHxlbHexHierarchy::AncestorOf(FHxlbHexHierarchy::LeafCenterOf(Parent, 3), 3), Parent);
+		}
+	}
+
+	void Test_AggregatesMatchLeaves()
+	{
+		FRandomStream Random(37);
+		TArray<float> Values;
+		for (int32 Index = 0; Index < Layout.Num(); Index++)
+		{
+			Values.Add(static_cast<float>(Random.RandRange(0, 4)));
+		}
+		
+		FHxlbHexHierarchy Hierarchy;
+		Hierarchy.Build(Layout);
+		for (EHxlbAggregateOp Op : {EHxlbAggregateOp::Sum, EHxlbAggregateOp::Mean, EHxlbAggregateOp::Min, EHxlbAggregateOp::Max, EHxlbAggregateOp::Dominant})
+		{
+			FHxlbHexAggregate Aggregate;
+			Aggregate.Build(Hierarchy, Op, [&Values](int32 LeafIndex) { return Values[LeafIndex]; });
+			
+			int32 NumWrong = 0;
+			for (int32 Level = 1; Level < Hierarchy.NumLevels(); Level++)
+			{
+				for (int32 Index = 0; Index < Hierarchy.GetLayout(Level).Num(); Index++)
+				{
+					NumWrong += !FMath::IsNearlyEqual(Aggregate.GetValue(Level, Index), AggregateFromLeaves(Hierarchy, Op, Values, Level, Index), 1.e-3f);
+				}
+			}
+			TestFramework->TestEqual(FString::Printf(TEXT("Op %d: matches leaves"), static_cast<int32>(Op)), NumWrong, 0);
+		}
+
+		FHxlbHexAggregate Max;
+		Max.Build(Hierarchy, EHxlbAggregateOp::Max, [&Values](int32 LeafIndex) { return Values[LeafIndex]; });
+		TArray<int32> Found;
+		Max.FindLeaves([](float Value) { return Value >= 4.0f; }, Found);
+		int32 NumExpected = 0;
+		for (float Value : Values)
+		{
+			NumExpected += Value >= 4.0f;
+		}
+		TestFramework->TestEqual(TEXT("FindLeaves finds every match"), Found.Num(), NumExpected);
+	}
+
+	void Test_AggregateUpdateMatchesRebuild()
+	{
+		FRandomStream Random(38);
+		TArray<float> Values;
+		for (int32 Index = 0; Index < Layout.Num(); Index++)
+		{
+			Values.Add(static_cast<float>(Random.RandRange(0, 4)));
+		}
+		auto ValueOf = [&Values](int32 LeafIndex) { return Values[LeafIndex]; };
+		
+		FHxlbHexHierarchy Hierarchy;
+		Hierarchy.Build(Layout);
+		for (EHxlbAggregateOp Op : {EHxlbAggregateOp::Sum, EHxlbAggregateOp::Mean, EHxlbAggregateOp::Min, EHxlbAggregateOp::Max, EHxlbAggregateOp::Dominant})
+		{
+			FHxlbHexAggregate Aggregate;
+			Aggregate.Build(Hierarchy, Op, ValueOf);
+			for (int32 Round = 0; Round < 5; Round++)
+			{
+				TArray<int32> ChangedIndices;
+				for (int32 Change = 0; Change < 30; Change++)
+				{
+					const int32 Index = Random.RandHelper(Layout.Num());
+					Values[Index] = static_cast<float>(Random.RandRange(0, 4));
+					ChangedIndices.Add(Index);
+				}
+				Aggregate.Update(ChangedIndices, ValueOf);
+
+				FHxlbHexAggregate Rebuilt;
+				Rebuilt.Build(Hierarchy, Op, ValueOf);
+				int32 NumWrong = 0;
+				for (int32 Level = 0; Level < Hierarchy.NumLevels(); Level++)
+				{
+					for (int32 Index = 0; Index < Hierarchy.GetLayout(Level).Num(); Index++)
+					{
+						NumWrong += !FMath::IsNearlyEqual(Aggregate.GetValue(Level, Index), Rebuilt.GetValue(Level, Index), 1.e-3f);
+					}
+				}
+				TestFramework->TestEqual(FString::Printf(TEXT("Op %d, round %d: matches rebuild"), static_cast<int32>(Op), Round), NumWrong, 0);
+			}
+		}
+	}
+
+	void Test_DistanceFieldMatchesAxialDistance()
+	{
+		FRandomStream Random(40);
+		TArray<int32> Sources;
+		for (int32 Count = 0; Count < 6; Count++)
+		{
+			Sources.Add(Random.RandHelper(Layout.Num()));
+		}
+		FHxlbDistanceField Field;
+		Field.Build(Layout, Sources);
+
+		int32 NumWrongDistances = 0;
+		int32 NumWrongSources = 0;
+		for (int32 Index = 0; Index < Layout.Num(); Index++)
+		{
+			int32 Expected = MAX_int32;
+			int32 ExpectedSource = INDEX_NONE;
+			for (int32 Source : Field.GetSources())
+			{
+				// Sources are sorted, so the first one at the smallest distance wins ties.
+				const int32 Distance = UHxlbMath::AxialDistance(Layout.CoordOf(Index), Layout.CoordOf(Source));
+				if (Distance < Expected)
+				{
+					Expected = Distance;
+					ExpectedSource = Source;
+				}
+			}
+			NumWrongDistances += Field.GetDistance(Index) != static_cast<float>(Expected);
+			NumWrongSources += Field.GetNearestSource(Index) != ExpectedSource;
+		}
+		TestFramework->TestEqual(TEXT("Distances are hex distances"), NumWrongDistances, 0);
+		TestFramework->TestEqual(TEXT("Nearest sources"), NumWrongSources, 0);
+		
+		FHxlbDistanceField Empty;
+		Empty.Build(Layout, {});
+		TestFramework->TestEqual(TEXT("No sources"), Empty.GetDistance(0), FHxlbDistanceField::Unreachable);
+	}
+
+	void Test_DistanceFieldUpdatesMatchRebuild()
+	{
+		FRandomStream Random(41);
+		for (int32 Index = 0; Index < Layout.Num(); Index++)
+		{
+			Costs[Index] = Random.FRand() < 0.15f ? HxlbMovementCost::Blocked : static_cast<float>(Random.RandRange(1, 4));
+		}
+
+		for (const bool bWeighted : {false, true})
+		{
+			FHxlbDistanceField Field;
+			bWeighted ? Field.Build(GetCostField(), {}) : Field.Build(Layout, {});
+			for (int32 Round = 0; Round < 12; Round++)
+			{
+				TArray<int32> Changed;
+				for (int32 Count = 0; Count < 3; Count++)
+				{
+					Changed.Add(Round % 3 == 2 && !Field.GetSources().IsEmpty()
+						? Field.GetSources()[Random.RandHelper(Field.GetSources().Num())]
+						: Random.RandHelper(Layout.Num()));
+				}
+				Round % 3 == 2 ? Field.RemoveSources(Changed) : Field.AddSources(Changed);
+
+				FHxlbDistanceField Rebuilt;
+				bWeighted ? Rebuilt.Build(GetCostField(), Field.GetSources()) : Rebuilt.Build(Layout, Field.GetSources());
+				int32 NumWrong = 0;
+				for (int32 Index = 0; Index < Layout.Num(); Index++)
+				{
+					NumWrong += Field.GetDistance(Index) != Rebuilt.GetDistance(Index) || Field.GetNearestSource(Index) != Rebuilt.GetNearestSource(Index);
+				}
+				TestFramework->TestEqual(FString::Printf(TEXT("Weighted %d, round %d: matches rebuild"), bWeighted, Round), NumWrong, 0);
+			}
+		}
+	}
+
+	// IMPORTANT! Be sure to register your fn inside your AutomationTest class below!
+
+private:
+	FHxlbCostField GetCostField() const
+	{
+		return FHxlbCostField(Layout, Costs, 1.0f);
+	}
+
+	FHxlbInfluenceSource MakeRandomSource(FRandomStream& Random) const
+	{
+		FHxlbInfluenceSource Source;
+		Source.Faction = Random.RandHelper(3);
+		Source.HexCoord = Layout.CoordOf(Random.RandHelper(Layout.Num()));
+		Source.Strength = Random.FRandRange(0.5f, 3.0f);
+		Source.Radius = Random.RandRange(1, 9);
+		Source.Falloff = static_cast<EHxlbInfluenceFalloff>(Random.RandHelper(3));
+		Source.bBlockedByTerrain = Random.FRand() < 0.7f;
+		return Source;
+	}
+	
+	static float AggregateFromLeaves(const FHxlbHexHierarchy& Hierarchy, EHxlbAggregateOp Op, const TArray<float>& Values, int32 Level, int32 Index)
+	{
+		TArray<float> Leaves;
+		Hierarchy.ForEachLeaf(Level, Index, [&Leaves, &Values](int32 LeafIndex) { Leaves.Add(Values[LeafIndex]); });
+		if (Leaves.IsEmpty())
+		{
+			return 0.0f;
+		}
+		
+		float Result = Op == EHxlbAggregateOp::Min || Op == EHxlbAggregateOp::Max ? Leaves[0] : 0.0f;
+		int32 Counts[5] = {0, 0, 0, 0, 0};
+		for (float Leaf : Leaves)
+		{
+			Result = Op == EHxlbAggregateOp::Min ? FMath::Min(Result, Leaf) : Op == EHxlbAggregateOp::Max ? FMath::Max(Result, Leaf) : Result + Leaf;
+			Counts[FMath::RoundToInt32(Leaf)]++;
+		}
+		if (Op == EHxlbAggregateOp::Mean)
+		{
+			Result /= Leaves.Num();
+		}
+		if (Op == EHxlbAggregateOp::Dominant)
+		{
+			int32 Best = 0;
+			for (int32 Category = 1; Category < 5; Category++)
+			{
+				Best = Counts[Category] > Counts[Best] ? Category : Best;
+			}
+			Result = static_cast<float>(Best);
+		}
+		return Result;
+	}
+	
+	FAutomationTestBase* TestFramework;
+	FHxlbDenseLayout Layout;
+	TArray<float> Costs;
+};
+
+#define REGISTER_TEST_SUITE_FN(TargetTestName) Tests.Add(TEXT(#TargetTestName), &FAnalysisTestSuite::TargetTestName)
+
+class FHxlbAnalysisTests: public FAutomationTestBase
+{
+public:
+	typedef void (FAnalysisTestSuite::*TestFunction)();
+	
+	FHxlbAnalysisTests(const FString& TestName): FAutomationTestBase(TestName, false)
+	{
+		REGISTER_TEST_SUITE_FN(Test_InfluenceFalloff);
+		REGISTER_TEST_SUITE_FN(Test_InfluenceSpreadsAroundWalls);
+		REGISTER_TEST_SUITE_FN(Test_InfluenceUpdateMatchesRebuild);
+		REGISTER_TEST_SUITE_FN(Test_RegionsSplitAndMerge);
+		REGISTER_TEST_SUITE_FN(Test_RegionsUpdateMatchesRebuild);
+		REGISTER_TEST_SUITE_FN(Test_BorderCornerKeys);
+		REGISTER_TEST_SUITE_FN(Test_BorderLoops);
+		REGISTER_TEST_SUITE_FN(Test_BordersUpdateMatchesRebuild);
+		REGISTER_TEST_SUITE_FN(Test_HierarchyPartitionsHexes);
+		REGISTER_TEST_SUITE_FN(Test_AggregatesMatchLeaves);
+		REGISTER_TEST_SUITE_FN(Test_AggregateUpdateMatchesRebuild);
+		REGISTER_TEST_SUITE_FN(Test_DistanceFieldMatchesAxialDistance);
+		REGISTER_TEST_SUITE_FN(Test_DistanceFieldUpdatesMatchRebuild);
+	}
+	
+	virtual EAutomationTestFlags GetTestFlags() const override
+	{
+		return EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter;
+	}
+	virtual bool IsStressTest() const { return false; }
+	virtual uint32 GetRequiredDeviceNum() const override { return 1; }
+
+protected:
+	virtual FString GetBeautifiedTestName() const override
+	{
+		// This string is what the editor uses to organize your test in the Automated tests browser.
+		return "HexEngine.Runtime.AnalysisTests";
+	}
+	virtual void GetTests(TArray<FString>& OutBeautifiedNames, TArray<FString>& OutTestCommands) const override
+	{
+		TArray<FString> TargetTestNames;
+		Tests.GetKeys(TargetTestNames);
+		for (const FString& TargetTestName : TargetTestNames)
+		{
+			OutBeautifiedNames.Add(TargetTestName);
+			OutTestCommands.Add(TargetTestName);
+		}
+	}
+	virtual bool RunTest(const FString& Parameters) override
+	{
+		TestFunction* CurrentTest = Tests.Find(Parameters);
+		if (!CurrentTest || !*CurrentTest)
+		{
+			HXLB_LOG(LogHxlbRuntime, Error, TEXT("Cannot find test: %s"), *Parameters);
+			return false;
+		}
+
+		FAnalysisTestSuite Suite(this);
+		(Suite.**CurrentTest)(); // Run the current test from the test suite.
+
+		return true;
+	}
+
+	TMap<FString, TestFunction> Tests;
+};
+
+namespace
+{
+	FHxlbAnalysisTests FHxlbAnalysisTestsInstance(TEXT("FHxlbAnalysisTests"));
+}
+
+#endif //WITH_EDITOR
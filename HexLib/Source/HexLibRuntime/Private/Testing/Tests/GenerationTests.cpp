@@ -0,0 +1,364 @@
+// Copyright © Mason Stevenson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the disclaimer
+// below) provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+// THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+// CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+// NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "HexLibRuntimeLoggingDefs.h"
+#include "Analysis/HxlbVoronoiPartition.h"
+#include "Containers/Array.h"
+#include "Containers/UnrealString.h"
+#include "Foundation/HxlbDenseLayout.h"
+#include "FunctionLibraries/HxlbMath.h"
+#include "Generation/HxlbMapGeneration.h"
+#include "Macros/HexLibLoggingMacros.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_EDITOR
+
+class FGenerationTestSuite
+{
+public:
+	FGenerationTestSuite(FAutomationTestBase* NewTestFramework): TestFramework(NewTestFramework)
+	{
+		// This constructor is run before each test.
+		Layout.InitHexagonal(40, 8);
+
+		Settings.Seed = 1234;
+		Settings.ElevationNoise.Frequency = 0.08f;
+		Settings.SeaLevel = 0.4f;
+		Settings.RiverSourceMinElevation = 0.55f;
+		Settings.NumRivers = 6;
+		
+		FHxlbBiomeRule& Water = Settings.BiomeRules.AddDefaulted_GetRef();
+		Water.Biome = 1;
+		Water.MaxElevation = Settings.SeaLevel;
+		FHxlbBiomeRule& Forest = Settings.BiomeRules.AddDefaulted_GetRef();
+		Forest.Biome = 2;
+		Forest.MinMoisture = 0.5f;
+		Settings.DefaultBiome = 3;
+
+		FHxlbResourceRule& Fish = Settings.ResourceRules.AddDefaulted_GetRef();
+		Fish.Resource = 10;
+		Fish.Biomes = {1};
+		Fish.Chance = 0.3f;
+		FHxlbResourceRule& Wood = Settings.ResourceRules.AddDefaulted_GetRef();
+		Wood.Resource = 20;
+		Wood.Biomes = {2};
+		Wood.Chance = 0.5f;
+	}
+
+	void Test_SameSeedSameMap()
+	{
+		TMap<FName, TSharedRef<FHxlbHexLayerBase>> Parallel;
+		TMap<FName, TSharedRef<FHxlbHexLayerBase>> SingleThreaded;
+		Generate(Parallel, Settings.Seed, false);
+		Generate(SingleThreaded, Settings.Seed, true);
+
+		TestFramework->TestTrue(TEXT("Elevation"), SameValues<float>(Parallel, SingleThreaded, Settings.ElevationLayerName));
+		TestFramework->TestTrue(TEXT("Moisture"), SameValues<float>(Parallel, SingleThreaded, Settings.MoistureLayerName));
+		TestFramework->TestTrue(TEXT("Biomes"), SameValues<int32>(Parallel, SingleThreaded, Settings.BiomeLayerName));
+		TestFramework->TestTrue(TEXT("Rivers"), SameValues<uint8>(Parallel, SingleThreaded, Settings.RiverLayerName));
+		TestFramework->TestTrue(TEXT("Resources"), SameValues<int32>(Parallel, SingleThreaded, Settings.ResourceLayerName));
+
+		TMap<FName, TSharedRef<FHxlbHexLayerBase>> OtherSeed;
+		Generate(OtherSeed, Settings.Seed + 1, false);
+		TestFramework->TestFalse(TEXT("Another seed gives another map"), SameValues<float>(Parallel, OtherSeed, Settings.ElevationLayerName));
+	}
+
+	void Test_StagesFollowSettings()
+	{
+		TMap<FName, TSharedRef<FHxlbHexLayerBase>> Layers;
+		Generate(Layers, Settings.Seed, false);
+		const TConstArrayView<float> Elevation = GetValues<float>(Layers, Settings.ElevationLayerName);
+		const TConstArrayView<float> Moisture = GetValues<float>(Layers, Settings.MoistureLayerName);
+		const TConstArrayView<int32> Biomes = GetValues<int32>(Layers, Settings.BiomeLayerName);
+		const TConstArrayView<int32> Resources = GetValues<int32>(Layers, Settings.ResourceLayerName);
+
+		int32 NumOutOfRange = 0;
+		int32 NumWrongBiomes = 0;
+		int32 NumWrongResources = 0;
+		int32 NumWater = 0;
+		int32 NumFish = 0;
+		for (int32 Index = 0; Index < Layout.Num(); Index++)
+		{
+			NumOutOfRange += Elevation[Index] < 0.0f || Elevation[Index] > 1.0f;
+			
+			const int32 Expected = Elevation[Index] < Settings.SeaLevel ? 1 : Moisture[Index] >= 0.5f ? 2 : 3;
+			NumWrongBiomes += Biomes[Index] != Expected;
+			
+			NumWrongResources += Resources[Index] != 0 && Resources[Index] != (Biomes[Index] == 1 ? 10 : 20);
+			NumWrongResources += Resources[Index] != 0 && Biomes[Index] == 3;
+			NumWater += Biomes[Index] == 1;
+			NumFish += Resources[Index] == 10;
+		}
+		TestFramework->TestEqual(TEXT("Noise stays in range"), NumOutOfRange, 0);
+		TestFramework->TestEqual(TEXT("Biomes follow the rules"), NumWrongBiomes, 0);
+		TestFramework->TestEqual(TEXT("Resources follow the rules"), NumWrongResources, 0);
+		TestFramework->TestTrue(TEXT("Map has water and land"), NumWater > 0 && NumWater < Layout.Num());
+		TestFramework->TestTrue(TEXT("Resources are scattered with the rule's chance"), FMath::Abs(static_cast<float>(NumFish) / NumWater - Fish().Chance) < 0.1f);
+	}
+
+	void Test_RiversRunAlongEdges()
+	{
+		TMap<FName, TSharedRef<FHxlbHexLayerBase>> Layers;
+		Generate(Layers, Settings.Seed, false);
+		const TConstArrayView<float> Elevation = GetValues<float>(Layers, Settings.ElevationLayerName);
+		const TConstArrayView<uint8> Rivers = GetValues<uint8>(Layers, Settings.RiverLayerName);
+
+		int32 NumRiverEdges = 0;
+		int32 NumOneSided = 0;
+		int32 NumUnderwater = 0;
+		for (int32 Index = 0; Index < Layout.Num(); Index++)
+		{
+			for (int32 Direction = 0; Direction < 6; Direction++)
+			{
+				if (!(Rivers[Index] & (1 << Direction)))
+				{
+					continue;
+				}
+				NumRiverEdges++;
+				
+				const int32 Neighbor = Layout.NeighborIndex(Layout.CoordOf(Index), Direction);
+				if (Neighbor == INDEX_NONE)
+				{
+					continue;
+				}
+				NumOneSided += !(Rivers[Neighbor] & (1 << ((Direction + 3) % 6)));
+				NumUnderwater += Elevation[Index] < Settings.SeaLevel && Elevation[Neighbor] < Settings.SeaLevel;
+			}
+		}
+		TestFramework->TestTrue(TEXT("Has rivers"), NumRiverEdges > 0);
+		TestFramework->TestEqual(TEXT("Both sides of a river edge know about it"), NumOneSided, 0);
+		TestFramework->TestEqual(TEXT("Rivers stop at the sea"), NumUnderwater, 0);
+	}
+
+	void Test_VoronoiRegionsMatchNearestSeed()
+	{
+		const TArray<int32> Seeds = {Layout.IndexOf(FIntPoint(0, 0)), Layout.IndexOf(FIntPoint(20, -5)), Layout.IndexOf(FIntPoint(-30, 10)), Layout.IndexOf(FIntPoint(5, 25)), Layout.IndexOf(FIntPoint(-3, -31))};
+		FHxlbVoronoiPartition Partition;
+		Partition.Build(Layout, Seeds);
+
+		int32 NumWrong = 0;
+		int32 TotalSize = 0;
+		for (int32 Index = 0; Index < Layout.Num(); Index++)
+		{
+			int32 Expected = INDEX_NONE;
+			int32 BestDistance = MAX_int32;
+			for (int32 RegionIndex = 0; RegionIndex < Seeds.Num(); RegionIndex++)
+			{
+				const int32 Distance = UHxlbMath::AxialDistance(Layout.CoordOf(Index), Layout.CoordOf(Seeds[RegionIndex]));
+				if (Distance < BestDistance || (Distance == BestDistance && Seeds[RegionIndex] < Seeds[Expected]))
+				{
+					Expected = RegionIndex;
+					BestDistance = Distance;
+				}
+			}
+			NumWrong += Partition.GetRegion(Index) != Expected;
+		}
+		for (int32 RegionIndex = 0; RegionIndex < Seeds.Num(); RegionIndex++)
+		{
+			TotalSize += Partition.GetRegionSize(RegionIndex);
+		}
+		TestFramework->TestEqual(TEXT("Every hex is in the region of its nearest seed"), NumWrong, 0);
+		TestFramework->TestEqual(TEXT("Region sizes add up"), TotalSize, Layout.Num());
+
+		// Relaxation makes regions more compact: the hexes end up closer to the seeds of their regions, on average.
+		FHxlbVoronoiPartition Relaxed;
+		Relaxed.Build(Layout, Seeds, 10);
+		auto SpreadAroundSeeds = [this](const FHxlbVoronoiPartition& Regions)
+		{
+			int64 Sum = 0;
+			for (int32 Index = 0; Index < Layout.Num(); Index++)
+			{
+				const int32 Distance = UHxlbMath::AxialDistance(Layout.CoordOf(Index), Layout.CoordOf(Regions.GetSeeds()[Regions.GetRegion(Index)]));
+				Sum += Distance * Distance;
+			}
+			return Sum;
+		};
+		int32 NumSeedsOutside = 0;
+		for (int32 RegionIndex = 0; RegionIndex < Seeds.Num(); RegionIndex++)
+		{
+			NumSeedsOutside += Relaxed.GetRegion(Relaxed.GetSeeds()[RegionIndex]) != RegionIndex;
+		}
+		TestFramework->TestTrue(TEXT("Relaxation converges"), Relaxed.GetNumIterations() > 0 && Relaxed.GetNumIterations() < 10);
+		TestFramework->TestEqual(TEXT("Seeds stay inside their regions"), NumSeedsOutside, 0);
+		TestFramework->TestTrue(TEXT("Relaxed regions are more compact"), SpreadAroundSeeds(Relaxed) < SpreadAroundSeeds(Partition));
+	}
+
+	void Test_RegionAdjacencyMatchesEdges()
+	{
+		Settings.RegionLayerName = TEXT("Region");
+		Settings.RegionSettings.NumRegions = 9;
+		TMap<FName, TSharedRef<FHxlbHexLayerBase>> Layers;
+		Generate(Layers, Settings.Seed, false);
+		const TConstArrayView<int32> Regions = GetValues<int32>(Layers, Settings.RegionLayerName);
+
+		TSet<int32> SeenRegions;
+		TSet<TPair<int32, int32>> ExpectedPairs;
+		for (int32 Index = 0; Index < Layout.Num(); Index++)
+		{
+			SeenRegions.Add(Regions[Index]);
+			for (int32 Direction = 0; Direction < 6; Direction++)
+			{
+				const int32 Neighbor = Layout.NeighborIndex(Layout.CoordOf(Index), Direction);
+				if (Neighbor != INDEX_NONE && Regions[Neighbor] != Regions[Index])
+				{
+					ExpectedPairs.Add(TPair<int32, int32>(Regions[Index], Regions[Neighbor]));
+				}
+			}
+		}
+		TestFramework->TestEqual(TEXT("Every region has hexes"), SeenRegions.Num(), 9);
+		TestFramework->TestFalse(TEXT("Every hex has a region"), SeenRegions.Contains(0));
+
+		FHxlbRegionAdjacency Adjacency;
+		Adjacency.Build(Layout, Regions, 0);
+		int32 NumLinks = 0;
+		int32 NumWrong = 0;
+		for (const auto& LinksKV : Adjacency.GetLinks())
+		{
+			for (const FHxlbRegionLink& Link : LinksKV.Value)
+			{
+				NumLinks++;
+				NumWrong += !ExpectedPairs.Contains(TPair<int32, int32>(LinksKV.Key, Link.Region)) || Link.NumSharedEdges <= 0;
+				NumWrong += !Adjacency.AreNeighbors(Link.Region, LinksKV.Key);
+			}
+		}
+		TestFramework->TestEqual(TEXT("Links are shared borders"), NumWrong, 0);
+		TestFramework->TestEqual(TEXT("Every shared border is linked"), NumLinks, ExpectedPairs.Num());
+
+		TMap<FName, TSharedRef<FHxlbHexLayerBase>> SingleThreaded;
+		Generate(SingleThreaded, Settings.Seed, true);
+		TestFramework->TestTrue(TEXT("Regions don't depend on threading"), SameValues<int32>(Layers, SingleThreaded, Settings.RegionLayerName));
+	}
+
+	// IMPORTANT! Be sure to register your fn inside your AutomationTest class below!
+
+private:
+	void Generate(TMap<FName, TSharedRef<FHxlbHexLayerBase>>& OutLayers, int32 Seed, bool bForceSingleThread) const
+	{
+		FHxlbMapGenContext Context(Layout, OutLayers, Seed);
+		Context.bForceSingleThread = bForceSingleThread;
+		FHxlbMapGenerator::FromSettings(Settings).Run(Context);
+	}
+
+	template <typename ValueType>
+	static TConstArrayView<ValueType> GetValues(const TMap<FName, TSharedRef<FHxlbHexLayerBase>>& Layers, FName LayerName)
+	{
+		return static_cast<const THxlbHexLayer<ValueType>&>(Layers.FindChecked(LayerName).Get()).GetValues();
+	}
+
+	template <typename ValueType>
+	static bool SameValues(const TMap<FName, TSharedRef<FHxlbHexLayerBase>>& LayersA, const TMap<FName, TSharedRef<FHxlbHexLayerBase>>& LayersB, FName LayerName)
+	{
+		const TConstArrayView<ValueType> ValuesA = GetValues<ValueType>(LayersA, LayerName);
+		const TConstArrayView<ValueType> ValuesB = GetValues<ValueType>(LayersB, LayerName);
+		if (ValuesA.Num() != ValuesB.Num())
+		{
+			return false;
+		}
+		for (int32 Index = 0; Index < ValuesA.Num(); Index++)
+		{
+			if (ValuesA[Index] != ValuesB[Index])
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	const FHxlbResourceRule& Fish() const { return Settings.ResourceRules[0]; }
+	
+	FAutomationTestBase* TestFramework;
+	FHxlbDenseLayout Layout;
+	FHxlbMapGenSettings Settings;
+};
+
+#define REGISTER_TEST_SUITE_FN(TargetTestName) Tests.Add(TEXT(#TargetTestName), &FGenerationTestSuite::TargetTestName)
+
+class FHxlbGenerationTests: public FAutomationTestBase
+{
+public:
+	typedef void (FGenerationTestSuite::*TestFunction)();
+	
+	FHxlbGenerationTests(const FString& TestName): FAutomationTestBase(TestName, false)
+	{
+		REGISTER_TEST_SUITE_FN(Test_SameSeedSameMap);
+		REGISTER_TEST_SUITE_FN(Test_StagesFollowSettings);
+		REGISTER_TEST_SUITE_FN(Test_RiversRunAlongEdges);
+		REGISTER_TEST_SUITE_FN(Test_VoronoiRegionsMatchNearestSeed);
+		REGISTER_TEST_SUITE_FN(Test_RegionAdjacencyMatchesEdges);
+	}
+	
+	virtual EAutomationTestFlags GetTestFlags() const override
+	{
+		return EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter;
+	}
+	virtual bool IsStressTest() const { return false; }
+	virtual uint32 GetRequiredDeviceNum() const override { return 1; }
+
+protected:
+	virtual FString GetBeautifiedTestName() const override
+	{
+		// This string is what the editor uses to organize your test in the Automated tests browser.
+		return "HexEngine.Runtime.GenerationTests";
+	}
+	virtual void GetTests(TArray<FString>& OutBeautifiedNames, TArray<FString>& OutTestCommands) const override
+	{
+		TArray<FString> TargetTestNames;
+		Tests.GetKeys(TargetTestNames);
+		for (const FString& TargetTestName : TargetTestNames)
+		{
+			OutBeautifiedNames.Add(TargetTestName);
+			OutTestCommands.Add(TargetTestName);
+		}
+	}
+	virtual bool RunTest(const FString& Parameters) override
+	{
+		TestFunction* CurrentTest = Tests.Find(Parameters);
+		if (!CurrentTest || !*CurrentTest)
+		{
+			HXLB_LOG(LogHxlbRuntime, Error, TEXT("Cannot find test: %s"), *Parameters);
+			return false;
+		}
+
+		FGenerationTestSuite Suite(this);
+		(Suite.**CurrentTest)(); // Run the current test from the test suite.
+
+		return true;
+	}
+
+	TMap<FString, TestFunction> Tests;
+};
+
+namespace
+{
+	FHxlbGenerationTests FHxlbGenerationTestsInstance(TEXT("FHxlbGenerationTests"));
+}
+
+#endif //WITH_EDITOR
@@ -0,0 +1,1098 @@
+// Copyright © Mason Stevenson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the disclaimer
+// below) provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+// THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+// CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+// NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "HexLibRuntimeLoggingDefs.h"
+#include "Algo/StableSort.h"
+#include "Containers/Array.h"
+#include "Containers/UnrealString.h"
+#include "Foundation/HxlbDenseLayout.h"
+#include "Foundation/HxlbHexBitmap.h"
+#include "Foundation/HxlbHexIterators.h"
+#include "Foundation/HxlbHexLayers.h"
+#include "Foundation/HxlbHexQueryBuilder.h"
+#include "Foundation/HxlbHexRanges.h"
+#include "Foundation/HxlbHexShapes.h"
+#include "Foundation/HxlbHexStencil.h"
+#include "Foundation/HxlbHexTimerWheel.h"
+#include "Foundation/HxlbOccupancyIndex.h"
+#include "Foundation/HxlbQueryCache.h"
+#include "Macros/HexLibLoggingMacros.h"
+#include "Math/RandomStream.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_EDITOR
+
+class FHexRangeTestSuite
+{
+public:
+	FHexRangeTestSuite(FAutomationTestBase* NewTestFramework): TestFramework(NewTestFramework)
+	{
+		// This constructor is run before each test.
+	}
+
+	~FHexRangeTestSuite()
+	{
+		// This destructor is run after each test.
+	}
+
+	void Test_RadialRangeMatchesIterator()
+	{
+		for (int32 Radius = 0; Radius <= 5; Radius++)
+		{
+			FHxlbRadialRange Range(FIntPoint(3, -2), Radius);
+			TSet<FIntPoint> Expected = CollectIterator(FHxlbRadialIterator(FIntPoint(3, -2), Radius));
+			TArray<FIntPoint> Actual = CollectRange(Range);
+
+			TestFramework->TestEqual(FString::Printf(TEXT("Radial Num() (radius %d)"), Radius), Range.Num(), Expected.Num());
+			TestFramework->TestEqual(FString::Printf(TEXT("Radial count (radius %d)"), Radius), Actual.Num(), Expected.Num());
+			for (FIntPoint HexCoord : Actual)
+			{
+				TestFramework->TestTrue(FString::Printf(TEXT("Radial contains (%d, %d)"), HexCoord.X, HexCoord.Y), Expected.Contains(HexCoord));
+			}
+		}
+	}
+
+	void Test_RectangularRangeMatchesIterator()
+	{
+		FHxlbRectangularRange Range(FIntPoint(-1, 4), 3, 2);
+		TSet<FIntPoint> Expected = CollectIterator(FHxlbRectangularIterator(FIntPoint(-1, 4), 3, 2));
+		TArray<FIntPoint> Actual = CollectRange(Range);
+
+		TestFramework->TestEqual(TEXT("Rectangular Num()"), Range.Num(), Expected.Num());
+		TestFramework->TestEqual(TEXT("Rectangular count"), Actual.Num(), Expected.Num());
+		for (FIntPoint HexCoord : Actual)
+		{
+			TestFramework->TestTrue(FString::Printf(TEXT("Rectangular contains (%d, %d)"), HexCoord.X, HexCoord.Y), Expected.Contains(HexCoord));
+		}
+	}
+
+	void Test_SplitByRowsCoversRange()
+	{
+		FHxlbRadialRange Range(FIntPoint::ZeroValue, 20);
+		TArray<FHxlbRadialRange> Parts = HxlbHexRanges::SplitByRows(Range, 7);
+
+		TestFramework->TestTrue(TEXT("Split produced parts"), Parts.Num() > 1 && Parts.Num() <= 7);
+		
+		TArray<FIntPoint> Joined;
+		for (const FHxlbRadialRange& Part : Parts)
+		{
+			Joined.Append(CollectRange(Part));
+			TestFramework->TestTrue(TEXT("Part is roughly balanced"), Part.Num() <= Range.Num() / 7 + 2 * 20 + 1);
+		}
+		TestFramework->TestTrue(TEXT("Split parts rejoin to the full range"), Joined == CollectRange(Range));
+	}
+
+	void Test_DenseLayoutRoundTrip()
+	{
+		FHxlbDenseLayout Layout;
+		Layout.InitRectangular(9, 6, 4);
+
+		FHxlbRectangularRange Range(FIntPoint::ZeroValue, 9, 6);
+		TestFramework->TestEqual(TEXT("Layout Num()"), Layout.Num(), Range.Num());
+
+		for (int32 Index = 0; Index < Layout.Num(); Index++)
+		{
+			TestFramework->TestEqual(TEXT("IndexOf(CoordOf(Index))"), Layout.IndexOf(Layout.CoordOf(Index)), Index);
+		}
+		TestFramework->TestEqual(TEXT("Outside hex has no index"), Layout.IndexOf(FIntPoint(100, 0)), static_cast<int32>(INDEX_NONE));
+
+		int32 ChunkedTotal = 0;
+		for (int32 ChunkIndex = 0; ChunkIndex < Layout.NumChunks(); ChunkIndex++)
+		{
+			Layout.ForEachChunkSpan(ChunkIndex, [&](const FHxlbHexRowSpan& Span, int32 FirstIndex)
+			{
+				for (int32 Offset = 0; Offset < Span.Num(); Offset++)
+				{
+					TestFramework->TestEqual(TEXT("Chunk span index"), Layout.IndexOf(Span.Get(Offset)), FirstIndex + Offset);
+					TestFramework->TestEqual(TEXT("ChunkOf"), Layout.ChunkOf(Span.Get(Offset)), ChunkIndex);
+				}
+				ChunkedTotal += Span.Num();
+			});
+		}
+		TestFramework->TestEqual(TEXT("Chunks cover the layout"), ChunkedTotal, Layout.Num());
+	}
+
+	void Test_ParallelForEachHexVisitsOnce()
+	{
+		FHxlbDenseLayout Layout;
+		Layout.InitHexagonal(60);
+
+		// Each slot is only ever touched by the task that owns its hex, so no synchronization is needed here.
+		TArray<int32> VisitCounts;
+		VisitCounts.SetNumZeroed(Layout.Num());
+		TArray<FIntPoint> VisitedCoords;
+		VisitedCoords.SetNumZeroed(Layout.Num());
+
+		// Small batches so the test actually exercises splitting rows by index.
+		HxlbParallelForEachHex(Layout, [&](FIntPoint HexCoord, int32 DenseIndex)
+		{
+			VisitCounts[DenseIndex]++;
+			VisitedCoords[DenseIndex] = HexCoord;
+		}, /*MinBatchSize=*/37);
+
+		for (int32 Index = 0; Index < Layout.Num(); Index++)
+		{
+			if (VisitCounts[Index] != 1 || Layout.IndexOf(VisitedCoords[Index]) != Index)
+			{
+				TestFramework->AddError(FString::Printf(TEXT("Dense index %d was not visited exactly once."), Index));
+				break;
+			}
+		}
+	}
+
+	void Test_ShapeCombinatorsMatchSetOperations()
+	{
+		const FHxlbRadialRange Radial(FIntPoint(2, -1), 4);
+		const FHxlbRectangularRange Rectangle(FIntPoint(-1, 1), 3, 2);
+		const TSet<FIntPoint> A = CollectIterator(FHxlbRadialIterator(FIntPoint(2, -1), 4));
+		const TSet<FIntPoint> B = CollectIterator(FHxlbRectangularIterator(FIntPoint(-1, 1), 3, 2));
+
+		auto Union = HxlbShapes::Union(HxlbShapes::Spans(Radial), HxlbShapes::Spans(Rectangle));
+		auto Intersect = HxlbShapes::Intersect(HxlbShapes::Spans(Radial), HxlbShapes::Spans(Rectangle));
+		auto Subtract = HxlbShapes::Subtract(HxlbShapes::Spans(Radial), HxlbShapes::Spans(Rectangle));
+
+		TestShapeEquals(TEXT("Union"), Union, A.Union(B));
+		TestShapeEquals(TEXT("Intersect"), Intersect, A.Intersect(B));
+		TestShapeEquals(TEXT("Subtract"), Subtract, A.Difference(B));
+
+		auto Ring = HxlbShapes::Subtract(HxlbShapes::Spans(FHxlbRadialRange(FIntPoint::ZeroValue, 3)), HxlbShapes::Spans(FHxlbRadialRange(FIntPoint::ZeroValue, 2)));
+		TestShapeEquals(TEXT("Ring"), Ring, CollectIterator(FHxlbRingIterator(FIntPoint::ZeroValue, 3)));
+	}
+
+	void Test_ShapeClipToMapAndExclude()
+	{
+		FHxlbDenseLayout Layout;
+		Layout.InitRectangular(5, 3);
+
+		TSet<FIntPoint> Excluded;
+		Excluded.Add(FIntPoint(0, 0));
+		Excluded.Add(FIntPoint(1, 0));
+		Excluded.Add(FIntPoint(-2, 3));
+
+		auto Shape = HxlbShapes::Exclude(HxlbShapes::ClipToMap(HxlbShapes::Spans(FHxlbRadialRange(FIntPoint(-3, 1), 6)), Layout), Excluded);
+		TSet<FIntPoint> Expected;
+		for (FIntPoint HexCoord : CollectIterator(FHxlbRadialIterator(FIntPoint(-3, 1), 6)))
+		{
+			if (Layout.Contains(HexCoord) && !Excluded.Contains(HexCoord))
+			{
+				Expected.Add(HexCoord);
+			}
+		}
+		TestShapeEquals(TEXT("Clipped radius minus excluded"), Shape, Expected);
+
+		// Dense indices come out in layout order, one contiguous run per span.
+		auto IndexedShape = HxlbShapes::ClipToMap(HxlbShapes::Spans(FHxlbRadialRange(FIntPoint(-3, 1), 6)), Layout);
+		int32 LastIndex = INDEX_NONE;
+		bool bIsSorted = true;
+		HxlbShapes::ForEachIndex(IndexedShape, Layout, [&](int32 DenseIndex)
+		{
+			bIsSorted &= DenseIndex > LastIndex;
+			LastIndex = DenseIndex;
+		});
+		TestFramework->TestTrue(TEXT("Dense indices are ascending"), bIsSorted);
+	}
+
+	// Mirrors the selection tool: a drag previews the whole shape under the cursor, and releasing adds the preview to the
+	// selection. Dragging over hexes that are already selected must still preview them.
+	void Test_DragPreviewOverSelectedHexes()
+	{
+		FHxlbDenseLayout Layout;
+		Layout.InitHexagonal(6);
+		TSet<FIntPoint> Selected = CollectIterator(FHxlbRadialIterator(FIntPoint(0, 0), 3));
+		const int32 NumSelected = Selected.Num();
+
+		for (int32 Radius = 0; Radius <= 3; Radius++)
+		{
+			auto Hexagon = HxlbShapes::ClipToMap(HxlbShapes::Spans(FHxlbRadialRange(FIntPoint(0, 0), Radius)), Layout);
+			TSet<FIntPoint> Preview = CollectIterator(HxlbShapes::MakeIterator(MoveTemp(Hexagon)));
+			TestFramework->TestEqual(TEXT("Hexagon preview keeps selected hexes"), Preview.Num(), 3 * Radius * (Radius + 1) + 1);
+
+			auto Ring = HxlbShapes::ClipToMap(
+				HxlbShapes::Subtract(
+					HxlbShapes::Spans(FHxlbRadialRange(FIntPoint(0, 0), Radius)),
+					HxlbShapes::Spans(FHxlbRadialRange(FIntPoint(0, 0), Radius - 1))),
+				Layout);
+			TSet<FIntPoint> RingPreview = CollectIterator(HxlbShapes::MakeIterator(MoveTemp(Ring)));
+			TestFramework->TestEqual(TEXT("Ring preview keeps selected hexes"), RingPreview.Num(), Radius == 0 ? 1 : 6 * Radius);
+
+			// Committing an already-selected preview leaves the selection as it was.
+			Selected.Append(Preview);
+			Selected.Append(RingPreview);
+			TestFramework->TestEqual(TEXT("Selection is unchanged"), Selected.Num(), NumSelected);
+		}
+
+		// A ring entirely outside of the map previews nothing; the drag itself goes on.
+		auto OutsideRing = HxlbShapes::ClipToMap(
+			HxlbShapes::Subtract(
+				HxlbShapes::Spans(FHxlbRadialRange(FIntPoint(0, 0), 8)),
+				HxlbShapes::Spans(FHxlbRadialRange(FIntPoint(0, 0), 7))),
+			Layout);
+		TestFramework->TestEqual(TEXT("Ring outside of the map"), CollectIterator(HxlbShapes::MakeIterator(MoveTemp(OutsideRing))).Num(), 0);
+	}
+
+	void Test_HexBitmapBits()
+	{
+		FHxlbDenseLayout Layout;
+		Layout.InitHexagonal(6);
+		FHxlbHexBitmap Bitmap(Layout.Num());
+
+		// Reads and writes that straddle a word boundary.
+		Bitmap.OrBits(60, 0b101101, 6);
+		TestFramework->TestTrue(TEXT("Bits read back"), Bitmap.ReadBits(60, 6) == 0b101101);
+		TestFramework->TestTrue(TEXT("Bits read back at an offset"), Bitmap.ReadBits(62, 4) == 0b1011);
+		TestFramework->TestEqual(TEXT("Bit count"), Bitmap.CountSetBits(), 4);
+		TestFramework->TestTrue(TEXT("Single bits"), Bitmap.Get(60) && !Bitmap.Get(61) && Bitmap.Get(65));
+
+		Bitmap.Reset();
+		TestFramework->TestTrue(TEXT("Reset clears"), Bitmap.IsEmpty());
+
+		TSet<FIntPoint> Expected;
+		for (FIntPoint HexCoord : {FIntPoint(0, 0), FIntPoint(-6, 6), FIntPoint(6, -6), FIntPoint(3, 1)})
+		{
+			Bitmap.Set(Layout.IndexOf(HexCoord));
+			Expected.Add(HexCoord);
+		}
+		TArray<FIntPoint> Coords;
+		Bitmap.ToCoords(Layout, Coords);
+		TestFramework->TestTrue(TEXT("Coords round trip"), TSet<FIntPoint>(Coords).Difference(Expected).IsEmpty() && Coords.Num() == Expected.Num());
+
+		FHxlbHexBitmap Other(Layout.Num());
+		Other.Set(Layout.IndexOf(FIntPoint(0, 0)));
+		Other.Set(Layout.IndexOf(FIntPoint(1, 0)));
+		FHxlbHexBitmap Combined = Bitmap;
+		Combined &= Other;
+		TestFramework->TestEqual(TEXT("Intersection"), Combined.CountSetBits(), 1);
+		Combined = Bitmap;
+		Combined |= Other;
+		TestFramework->TestEqual(TEXT("Union"), Combined.CountSetBits(), 5);
+		Combined.AndNot(Bitmap);
+		TestFramework->TestTrue(TEXT("Difference"), Combined.CountSetBits() == 1 && Combined.Get(Layout.IndexOf(FIntPoint(1, 0))));
+	}
+
+	void Test_StencilMatchesNeighborLookup()
+	{
+		FHxlbDenseLayout Layout;
+		Layout.InitHexagonal(70, 16);
+		FHxlbHexStencil Stencil;
+		Stencil.Init(Layout);
+		
+		FRandomStream Random(39);
+		TArray<int32> Values;
+		TArray<float> FloatValues;
+		for (int32 Index = 0; Index < Layout.Num(); Index++)
+		{
+			Values.Add(Random.RandRange(0, 100));
+			FloatValues.Add(Random.FRand());
+		}
+
+		// Each neighbor gets its own weight, so that neighbors in the wrong order don't add up to the same thing.
+		TArray<int32> Result;
+		Result.SetNumZeroed(Layout.Num());
+		Stencil.Apply<int32>(Values, Result, [](int32 DenseIndex, int32 Center, const int32 (&Neighbors)[6])
+		{
+			return Center + Neighbors[0] * 2 + Neighbors[1] * 3 + Neighbors[2] * 5 + Neighbors[3] * 7 + Neighbors[4] * 11 + Neighbors[5] * 13;
+		}, EHxlbStencilEdge::Constant, -1);
+
+		const float Weights[6] = {0.1f, 0.2f, 0.3f, 0.4f, 0.5f, 0.6f};
+		TArray<float> Blurred;
+		Blurred.SetNumZeroed(Layout.Num());
+		Stencil.Convolve(FloatValues, Blurred, 0.5f, Weights);
+
+		int32 NumWrong = 0;
+		int32 NumWrongBlurred = 0;
+		const int32 Factors[6] = {2, 3, 5, 7, 11, 13};
+		for (int32 Index = 0; Index < Layout.Num(); Index++)
+		{
+			int32 Expected = Values[Index];
+			float ExpectedBlurred = FloatValues[Index] * 0.5f;
+			for (int32 Direction = 0; Direction < 6; Direction++)
+			{
+				const int32 Neighbor = Layout.NeighborIndex(Layout.CoordOf(Index), Direction);
+				Expected += (Neighbor != INDEX_NONE ? Values[Neighbor] : -1) * Factors[Direction];
+				ExpectedBlurred += (Neighbor != INDEX_NONE ? FloatValues[Neighbor] : FloatValues[Index]) * Weights[Direction];
+			}
+			NumWrong += Result[Index] != Expected;
+			NumWrongBlurred += !FMath::IsNearlyEqual(Blurred[Index], ExpectedBlurred, 1.e-4f);
+		}
+		TestFramework->TestEqual(TEXT("Kernel sees the right neighbors"), NumWrong, 0);
+		TestFramework->TestEqual(TEXT("Convolution sees the right neighbors"), NumWrongBlurred, 0);
+	}
+
+	void Test_StencilDilate()
+	{
+		FHxlbDenseLayout Layout;
+		Layout.InitHexagonal(70, 16);
+		FHxlbHexStencil Stencil;
+		Stencil.Init(Layout);
+
+		FRandomStream Random(40);
+		FHxlbHexBitmap Source(Layout.Num());
+		for (int32 Count = 0; Count < 200; Count++)
+		{
+			Source.Set(Random.RandHelper(Layout.Num()));
+		}
+		FHxlbHexBitmap Dilated;
+		Stencil.Dilate(Source, Dilated);
+
+		int32 NumWrong = 0;
+		for (int32 Index = 0; Index < Layout.Num(); Index++)
+		{
+			bool bExpected = Source.Get(Index);
+			for (int32 Direction = 0; Direction < 6; Direction++)
+			{
+				const int32 Neighbor = Layout.NeighborIndex(Layout.CoordOf(Index), Direction);
+				bExpected |= Neighbor != INDEX_NONE && Source.Get(Neighbor);
+			}
+			NumWrong += Dilated.Get(Index) != bExpected;
+		}
+		TestFramework->TestEqual(TEXT("Dilation matches neighbor lookups"), NumWrong, 0);
+	}
+
+	void Test_StencilActiveStepsMatchFullSteps()
+	{
+		FHxlbDenseLayout Layout;
+		Layout.InitHexagonal(40, 16);
+		FHxlbHexStencil Stencil;
+		Stencil.Init(Layout);
+
+		// Fire: 0 is fuel, 1 is burning and 2 is burnt out. Fuel next to fire catches fire.
+		enum { Fuel, Burning, Burnt };
+		TArray<uint8> Start;
+		Start.Init(Fuel, Layout.Num());
+		Start[Layout.IndexOf(FIntPoint(0, 0))] = Burning;
+		for (int32 R = -40; R <= 40; R++)
+		{
+			// A firebreak across the whole map.
+			if (Layout.Contains(FIntPoint(10, R)))
+			{
+				Start[Layout.IndexOf(FIntPoint(10, R))] = Burnt;
+			}
+		}
+		auto Fire = [](int32 DenseIndex, uint8 Center, const uint8 (&Neighbors)[6]) -> uint8
+		{
+			if (Center != Fuel)
+			{
+				return Burnt;
+			}
+			for (uint8 Neighbor : Neighbors)
+			{
+				if (Neighbor == Burning)
+				{
+					return Burning;
+				}
+			}
+			return Fuel;
+		};
+
+		THxlbStencilBuffers<uint8> Full;
+		THxlbStencilBuffers<uint8> Sparse;
+		Full.Init(Start);
+		Sparse.Init(Start);
+		
+		int32 NumMismatchedSteps = 0;
+		for (int32 Step = 0; Step < 30; Step++)
+		{
+			// Only burning hexes and their neighbors can change.
+			FHxlbHexBitmap BurningHexes(Layout.Num());
+			for (int32 Index = 0; Index < Layout.Num(); Index++)
+			{
+				BurningHexes.SetTo(Index, Sparse.GetCurrent()[Index] == Burning);
+			}
+			FHxlbHexBitmap Active;
+			Stencil.Dilate(BurningHexes, Active);
+
+			// Fully stepping every other step checks that switching between the two keeps the buffers in sync.
+			Full.Step(Stencil, Fire, EHxlbStencilEdge::Constant, Fuel);
+			if (Step % 7 == 3)
+			{
+				Sparse.Step(Stencil, Fire, EHxlbStencilEdge::Constant, Fuel);
+			}
+			else
+			{
+				Sparse.StepActive(Stencil, Active, Fire, EHxlbStencilEdge::Constant, Fuel);
+			}
+
+			for (int32 Index = 0; Index < Layout.Num(); Index++)
+			{
+				if (Full.GetCurrent()[Index] != Sparse.GetCurrent()[Index])
+				{
+					NumMismatchedSteps++;
+					break;
+				}
+			}
+		}
+		TestFramework->TestEqual(TEXT("Sparse steps match full steps"), NumMismatchedSteps, 0);
+		TestFramework->TestEqual(TEXT("Firebreak holds"), static_cast<int32>(Full.GetCurrent()[Layout.IndexOf(FIntPoint(15, 0))]), static_cast<int32>(Fuel));
+		TestFramework->TestEqual(TEXT("Fire spreads"), static_cast<int32>(Full.GetCurrent()[Layout.IndexOf(FIntPoint(-5, 0))]), static_cast<int32>(Burnt));
+	}
+
+	void Test_OccupancyStaysConsistentUnderMoves()
+	{
+		FHxlbDenseLayout Layout;
+		Layout.InitHexagonal(12);
+		FHxlbOccupancyIndex Occupancy;
+		Occupancy.Init(Layout);
+
+		FRandomStream Random(41);
+		TMap<int32, int32> Expected;
+		for (int32 Op = 0; Op < 20000; Op++)
+		{
+			const int32 EntityId = Random.RandHelper(2000);
+			if (Random.FRand() < 0.1f)
+			{
+				TestFramework->TestEqual(TEXT("Removed"), Occupancy.RemoveEntity(EntityId), Expected.Remove(EntityId) > 0);
+			}
+			else
+			{
+				const int32 DenseIndex = Random.RandHelper(Layout.Num());
+				Occupancy.SetEntity(EntityId, DenseIndex);
+				Expected.Add(EntityId, DenseIndex);
+			}
+		}
+		TestFramework->TestFalse(TEXT("Off the map"), Occupancy.SetEntity(5000, Layout.Num()));
+
+		TestFramework->TestEqual(TEXT("Entity count"), Occupancy.NumEntities(), Expected.Num());
+		int32 NumWrong = 0;
+		for (const auto& EntityKV : Expected)
+		{
+			NumWrong += Occupancy.FindEntity(EntityKV.Key) != EntityKV.Value;
+		}
+		for (int32 DenseIndex = 0; DenseIndex < Layout.Num(); DenseIndex++)
+		{
+			int32 NumVisited = 0;
+			Occupancy.ForEachEntityAt(DenseIndex, [&](int32 EntityId)
+			{
+				NumVisited++;
+				const int32* ExpectedIndex = Expected.Find(EntityId);
+				NumWrong += !ExpectedIndex || *ExpectedIndex != DenseIndex;
+			});
+			NumWrong += NumVisited != Occupancy.NumEntitiesAt(DenseIndex);
+		}
+		TestFramework->TestEqual(TEXT("Entities are where they were put"), NumWrong, 0);
+	}
+
+	void Test_OccupancyRadiusAndNearest()
+	{
+		FHxlbDenseLayout Layout;
+		Layout.InitRectangular(20, 14);
+		FHxlbOccupancyIndex Occupancy;
+		Occupancy.Init(Layout);
+
+		FRandomStream Random(42);
+		for (int32 EntityId = 0; EntityId < 60; EntityId++)
+		{
+			Occupancy.SetEntity(EntityId, Random.RandHelper(Layout.Num()));
+		}
+		auto DistanceOf = [&](FIntPoint Center, int32 EntityId)
+		{
+			return UHxlbMath::AxialDistance(Center, Layout.CoordOf(Occupancy.FindEntity(EntityId)));
+		};
+
+		for (int32 Query = 0; Query < 20; Query++)
+		{
+			// Some centers are off the map.
+			const FIntPoint Center = Layout.CoordOf(Random.RandHelper(Layout.Num())) + FIntPoint(Random.RandRange(-8, 8), 0);
+			const int32 Radius = Random.RandRange(0, 6);
+
+			TArray<int32> InRadius;
+			Occupancy.FindInRadius(Center, Radius, InRadius);
+			int32 ExpectedNum = 0;
+			for (int32 EntityId = 0; EntityId < 60; EntityId++)
+			{
+				ExpectedNum += DistanceOf(Center, EntityId) <= Radius;
+			}
+			int32 NumOutOfOrder = 0;
+			for (int32 Index = 0; Index < InRadius.Num(); Index++)
+			{
+				NumOutOfOrder += DistanceOf(Center, InRadius[Index]) > Radius || (Index > 0 && DistanceOf(Center, InRadius[Index - 1]) > DistanceOf(Center, InRadius[Index]));
+			}
+			TestFramework->TestEqual(TEXT("Everything in the radius"), InRadius.Num(), ExpectedNum);
+			TestFramework->TestEqual(TEXT("Within the radius, nearest first"), NumOutOfOrder, 0);
+
+			TArray<int32> Distances;
+			for (int32 EntityId = 0; EntityId < 60; EntityId++)
+			{
+				Distances.Add(DistanceOf(Center, EntityId));
+			}
+			Distances.Sort();
+			TArray<int32> Nearest;
+			Occupancy.FindNearest(Center, 5, 1000, Nearest);
+			TestFramework->TestEqual(TEXT("Found enough"), Nearest.Num(), 5);
+			for (int32 Index = 0; Index < Nearest.Num(); Index++)
+			{
+				TestFramework->TestEqual(TEXT("Nearest distances"), DistanceOf(Center, Nearest[Index]), Distances[Index]);
+			}
+		}
+	}
+
+	void Test_AreaEffectsMatchPairwiseChecks()
+	{
+		FHxlbDenseLayout Layout;
+		Layout.InitHexagonal(15);
+		FHxlbOccupancyIndex Occupancy;
+		Occupancy.Init(Layout);
+
+		FRandomStream Random(42);
+		for (int32 EntityId = 0; EntityId < 400; EntityId++)
+		{
+			Occupancy.SetEntity(EntityId, Random.RandHelper(Layout.Num()));
+		}
+
+		TArray<FHxlbAreaEffect> Effects;
+		for (int32 EffectId = 0; EffectId < 30; EffectId++)
+		{
+			FHxlbAreaEffect& Effect = Effects.AddDefaulted_GetRef();
+			Effect.EffectId = EffectId;
+			Effect.Shape = static_cast<EHxlbAreaShape>(EffectId % 3);
+			Effect.Origin = FIntPoint(Random.RandRange(-18, 18), Random.RandRange(-18, 18));
+			Effect.Radius = Random.RandRange(0, 5);
+			Effect.InnerRadius = Random.RandRange(0, Effect.Radius);
+			Effect.HalfWidth = Random.RandRange(0, 4);
+			Effect.HalfHeight = Random.RandRange(0, 4);
+		}
+		TArray<FHxlbAreaEffectHit> Hits;
+		Occupancy.ResolveAreaEffects(Effects, Hits);
+
+		TSet<FIntPoint> Resolved;
+		for (const FHxlbAreaEffectHit& Hit : Hits)
+		{
+			Resolved.Add(FIntPoint(Hit.EffectId, Hit.EntityId));
+		}
+		TSet<FIntPoint> Expected;
+		for (const FHxlbAreaEffect& Effect : Effects)
+		{
+			const TSet<FIntPoint> Rectangle = CollectIterator(FHxlbRectangularIterator(Effect.Origin, Effect.HalfWidth, Effect.HalfHeight));
+			for (int32 EntityId = 0; EntityId < 400; EntityId++)
+			{
+				const FIntPoint HexCoord = Layout.CoordOf(Occupancy.FindEntity(EntityId));
+				const int32 Distance = UHxlbMath::AxialDistance(Effect.Origin, HexCoord);
+				const bool bHit = Effect.Shape == EHxlbAreaShape::Radial ? Distance <= Effect.Radius
+					: Effect.Shape == EHxlbAreaShape::Ring ? Distance <= Effect.Radius && Distance >= Effect.InnerRadius
+					: Rectangle.Contains(HexCoord);
+				if (bHit)
+				{
+					Expected.Add(FIntPoint(Effect.EffectId, EntityId));
+				}
+			}
+		}
+		TestFramework->TestEqual(TEXT("No duplicate hits"), Resolved.Num(), Hits.Num());
+		TestFramework->TestEqual(TEXT("Same hits as pairwise checks"), Resolved.Num(), Expected.Num());
+		TestFramework->TestEqual(TEXT("Same hits as pairwise checks"), Resolved.Intersect(Expected).Num(), Expected.Num());
+	}
+
+	// IMPORTANT! Be sure to register your fn inside your AutomationTest class below!
+
+	void Test_TimerWheelFiresOnTime()
+	{
+		FHxlbDenseLayout Layout;
+		Layout.InitHexagonal(12, 4);
+		FHxlbHexTimerWheel Timers;
+		Timers.Init(Layout);
+
+		// Delays that land in every level of the wheel, and a few past the top one.
+		FRandomStream Random(47);
+		TArray<int64> DueTicks;
+		TArray<int64> Handles;
+		for (int32 TimerIndex = 0; TimerIndex < 3000; TimerIndex++)
+		{
+			const int32 MaxDelays[] = {100, 5000, 300000, 20000000};
+			const int32 Delay = 1 + Random.RandHelper(TimerIndex % 100 == 0 ? MaxDelays[3] : MaxDelays[TimerIndex % 3]);
+			FHxlbHexTimer Timer;
+			Timer.DenseIndex = Random.RandHelper(Layout.Num());
+			Timer.EventType = TimerIndex;
+			Handles.Add(Timers.Schedule(Timer, Delay));
+			DueTicks.Add(Delay);
+		}
+		TArray<uint8> Canceled;
+		Canceled.Init(0, DueTicks.Num());
+		for (int32 TimerIndex = 0; TimerIndex < DueTicks.Num(); TimerIndex += 5)
+		{
+			Canceled[TimerIndex] = Timers.Cancel(Handles[TimerIndex]);
+		}
+		TestFramework->TestFalse(TEXT("Canceling twice"), Timers.Cancel(Handles[0]));
+		TestFramework->TestEqual(TEXT("Remaining ticks"), Timers.GetRemainingTicks(Handles[1]), DueTicks[1]);
+
+		// A stale handle must not cancel the timer that reused its slot.
+		FHxlbHexTimer Reused;
+		Reused.DenseIndex = 0;
+		Reused.EventType = DueTicks.Num();
+		const int64 ReusedHandle = Timers.Schedule(Reused, 10);
+		TestFramework->TestFalse(TEXT("Stale handle"), Timers.Cancel(Handles[0]));
+		TestFramework->TestTrue(TEXT("Reused slot is still scheduled"), Timers.IsScheduled(ReusedHandle));
+		DueTicks.Add(10);
+		Canceled.Add(0);
+
+		int32 NumFired = 0;
+		int32 NumWrong = 0;
+		TArray<FHxlbHexTimer> Fired;
+		while (Timers.Num() > 0)
+		{
+			// Tick by tick at first, then in large steps.
+			const int64 PreviousTick = Timers.GetCurrentTick();
+			Fired.Reset();
+			Timers.Advance(PreviousTick < 6000 ? 1 : 99991, Fired);
+			for (const FHxlbHexTimer& Timer : Fired)
+			{
+				const int64 DueTick = DueTicks[Timer.EventType];
+				NumWrong += Canceled[Timer.EventType] || DueTick <= PreviousTick || DueTick > Timers.GetCurrentTick();
+			}
+			NumFired += Fired.Num();
+		}
+		int32 NumCanceled = 0;
+		for (const uint8 bCanceled : Canceled)
+		{
+			NumCanceled += bCanceled;
+		}
+		TestFramework->TestEqual(TEXT("Timers fire at their tick"), NumWrong, 0);
+		TestFramework->TestEqual(TEXT("Every timer fires once"), NumFired, DueTicks.Num() - NumCanceled);
+		TestFramework->TestFalse(TEXT("Fired timers can't be canceled"), Timers.Cancel(Handles[1]));
+	}
+
+	void Test_TimerWheelBatchesByChunk()
+	{
+		FHxlbDenseLayout Layout;
+		Layout.InitHexagonal(20, 8);
+		FHxlbHexTimerWheel Timers;
+		Timers.Init(Layout);
+
+		FRandomStream Random(48);
+		for (int32 TimerIndex = 0; TimerIndex < 500; TimerIndex++)
+		{
+			FHxlbHexTimer Timer;
+			Timer.DenseIndex = Random.RandHelper(40);
+			Timer.EventType = TimerIndex;
+			Timers.Schedule(Timer, 3 + (TimerIndex % 2));
+		}
+		TArray<FHxlbHexTimer> Fired;
+		Timers.Advance(2, Fired);
+		TestFramework->TestEqual(TEXT("Nothing due yet"), Fired.Num(), 0);
+		Timers.Advance(2, Fired);
+		TestFramework->TestEqual(TEXT("One batch"), Fired.Num(), 500);
+
+		int32 NumOutOfOrder = 0;
+		for (int32 Index = 1; Index < Fired.Num(); Index++)
+		{
+			const FHxlbHexTimer& A = Fired[Index - 1];
+			const FHxlbHexTimer& B = Fired[Index];
+			const int32 ChunkA = Layout.ChunkOfIndex(A.DenseIndex);
+			const int32 ChunkB = Layout.ChunkOfIndex(B.DenseIndex);
+			NumOutOfOrder += ChunkA > ChunkB || (ChunkA == ChunkB && A.DenseIndex > B.DenseIndex);
+
+			// Same hex: ticks first, then scheduling order. Even event types are due a tick earlier.
+			NumOutOfOrder += A.DenseIndex == B.DenseIndex && (A.EventType % 2) == (B.EventType % 2) && A.EventType > B.EventType;
+			NumOutOfOrder += A.DenseIndex == B.DenseIndex && (A.EventType % 2) == 1 && (B.EventType % 2) == 0;
+		}
+		TestFramework->TestEqual(TEXT("Sorted by chunk, hex, tick and scheduling"), NumOutOfOrder, 0);
+	}
+
+	void Test_QueryCacheMatchesDirectQuery()
+	{
+		FHxlbDenseLayout Layout;
+		Layout.InitHexagonal(20, 8);
+		THxlbHexLayer<int32> TagLayer(TEXT("Tags"));
+		TagLayer.Resize(Layout);
+		FRandomStream Random(49);
+		for (int32 DenseIndex = 0; DenseIndex < Layout.Num(); DenseIndex++)
+		{
+			TagLayer.Set(DenseIndex, Random.RandHelper(4));
+		}
+		TagLayer.CommitChanges();
+
+		FHxlbQueryCache Cache;
+		const FHxlbHexLayerBase* Layers[] = {&TagLayer};
+		int32 NumComputed = 0;
+		for (int32 QueryIndex = 0; QueryIndex < 20; QueryIndex++)
+		{
+			FHxlbHexQuery Query;
+			Query.Origin = Layout.CoordOf(Random.RandHelper(Layout.Num()));
+			Query.Radius = Random.RandRange(0, 12);
+			Query.FilterMask = 1 + (QueryIndex % 3);
+
+			TSet<FIntPoint> Expected;
+			for (int32 DenseIndex = 0; DenseIndex < Layout.Num(); DenseIndex++)
+			{
+				const FIntPoint HexCoord = Layout.CoordOf(DenseIndex);
+				if (UHxlbMath::AxialDistance(HexCoord, Query.Origin) <= Query.Radius && (TagLayer.Get(DenseIndex) & Query.FilterMask))
+				{
+					Expected.Add(HexCoord);
+				}
+			}
+
+			for (int32 Repeat = 0; Repeat < 2; Repeat++)
+			{
+				TSharedRef<const FHxlbQueryResult> Result = Cache.FindOrCompute(Query, Layout, Query.Radius, Layers, [&](FHxlbHexBitmap& OutHexes)
+				{
+					NumComputed++;
+					ComputeFilteredRadius(Layout, TagLayer, Query, OutHexes);
+				});
+
+				TArray<FIntPoint> Coords;
+				Result->ToCoords(Layout, Coords);
+				TestFramework->TestEqual(TEXT("Result count"), Result->Num(), Expected.Num());
+				TestFramework->TestEqual(TEXT("Coord count"), Coords.Num(), Expected.Num());
+				
+				FHxlbHexBitmap Bitmap(Layout.Num());
+				Result->ToBitmap(Bitmap);
+				int32 NumMismatches = 0;
+				for (FIntPoint HexCoord : Coords)
+				{
+					NumMismatches += !Expected.Contains(HexCoord);
+				}
+				for (int32 DenseIndex = 0; DenseIndex < Layout.Num(); DenseIndex++)
+				{
+					const bool bExpected = Expected.Contains(Layout.CoordOf(DenseIndex));
+					NumMismatches += Result->Contains(DenseIndex) != bExpected;
+					NumMismatches += Bitmap.Get(DenseIndex) != bExpected;
+				}
+				TestFramework->TestEqual(TEXT("Result matches the direct query"), NumMismatches, 0);
+			}
+		}
+		TestFramework->TestEqual(TEXT("Each query computed once"), NumComputed, 20);
+		TestFramework->TestEqual(TEXT("Hits"), Cache.GetStats().Hits, static_cast<int64>(20));
+		TestFramework->TestEqual(TEXT("Misses"), Cache.GetStats().Misses, static_cast<int64>(20));
+	}
+
+	void Test_QueryCacheInvalidatesByChunk()
+	{
+		FHxlbDenseLayout Layout;
+		Layout.InitHexagonal(30, 8);
+		THxlbHexLayer<int32> TagLayer(TEXT("Tags"), 1);
+		TagLayer.Resize(Layout);
+		TagLayer.CommitChanges();
+
+		FHxlbQueryCache Cache;
+		const FHxlbHexLayerBase* Layers[] = {&TagLayer};
+		FHxlbHexQuery Query;
+		Query.Origin = FIntPoint(-20, 5);
+		Query.Radius = 4;
+		Query.MinRadius = 2;
+		int32 NumComputed = 0;
+		auto RunQuery = [&]()
+		{
+			return Cache.FindOrCompute(Query, Layout, Query.Radius, Layers, [&](FHxlbHexBitmap& OutHexes)
+			{
+				NumComputed++;
+				ComputeFilteredRadius(Layout, TagLayer, Query, OutHexes);
+			});
+		};
+		TSharedRef<const FHxlbQueryResult> First = RunQuery();
+		TestFramework->TestEqual(TEXT("Ring size"), First->Num(), 6 * (2 + 3 + 4));
+
+		// Far away, in chunks the footprint doesn't touch.
+		TagLayer.Set(Layout.IndexOf(FIntPoint(20, -5)), 0);
+		TagLayer.CommitChanges();
+		RunQuery();
+		RunQuery();
+		TestFramework->TestEqual(TEXT("Changes outside of the footprint keep the entry"), NumComputed, 1);
+
+		const FIntPoint Inside = Query.Origin + FIntPoint(3, 0);
+		TagLayer.Set(Layout.IndexOf(Inside), 0);
+		TagLayer.CommitChanges();
+		TSharedRef<const FHxlbQueryResult> Second = RunQuery();
+		TestFramework->TestEqual(TEXT("Changes inside of the footprint recompute"), NumComputed, 2);
+		TestFramework->TestEqual(TEXT("Recomputed result"), Second->Num(), First->Num() - 1);
+		TestFramework->TestFalse(TEXT("Changed hex is filtered out"), Second->Contains(Layout.IndexOf(Inside)));
+		TestFramework->TestTrue(TEXT("Handed out results are left alone"), First->Contains(Layout.IndexOf(Inside)));
+		TestFramework->TestEqual(TEXT("Invalidations"), Cache.GetStats().Invalidations, static_cast<int64>(1));
+		
+		Cache.MaxEntries = 2;
+		for (int32 Radius = 5; Radius < 8; Radius++)
+		{
+			Query.Radius = Radius;
+			RunQuery();
+		}
+		TestFramework->TestEqual(TEXT("Cache is capped"), Cache.Num(), 2);
+		TestFramework->TestEqual(TEXT("Evictions"), Cache.GetStats().Evictions, static_cast<int64>(2));
+	}
+
+	void Test_QueryBuilderMatchesScan()
+	{
+		FHxlbDenseLayout Layout;
+		Layout.InitHexagonal(40, 8);
+		THxlbHexLayer<int32> TerrainLayer(TEXT("Terrain"));
+		THxlbHexLayer<int32> FlagsLayer(TEXT("Flags"));
+		THxlbHexLayer<float> HeightLayer(TEXT("Height"));
+		TerrainLayer.Resize(Layout);
+		FlagsLayer.Resize(Layout);
+		HeightLayer.Resize(Layout);
+		FHxlbHexBitmap Tagged(Layout.Num());
+		FHxlbHexBitmap Blocked(Layout.Num());
+		FRandomStream Random(49);
+		for (int32 DenseIndex = 0; DenseIndex < Layout.Num(); DenseIndex++)
+		{
+			TerrainLayer.Set(DenseIndex, Random.RandHelper(3));
+			FlagsLayer.Set(DenseIndex, Random.RandHelper(8));
+			HeightLayer.Set(DenseIndex, Random.FRandRange(-1.0f, 1.0f));
+			if (Random.FRand() < 0.6f)
+			{
+				Tagged.Set(DenseIndex);
+			}
+			if (Random.FRand() < 0.2f)
+			{
+				Blocked.Set(DenseIndex);
+			}
+		}
+
+		for (int32 QueryIndex = 0; QueryIndex < 12; QueryIndex++)
+		{
+			const FIntPoint Origin = Layout.CoordOf(Random.RandHelper(Layout.Num()));
+			const int32 Radius = QueryIndex % 4 == 3 ? 200 : Random.RandRange(0, 25);
+			const int32 MinRadius = QueryIndex % 2 ? Random.RandRange(0, Radius) : 0;
+			const float MinHeight = Random.FRandRange(-1.0f, 0.5f);
+			
+			FHxlbHexQueryBuilder Query(Layout);
+			Query.InRadius(Origin, Radius, MinRadius)
+				.Where(TerrainLayer, EHxlbCompareOp::NotEqual, 1)
+				.Where(FlagsLayer, EHxlbCompareOp::HasAnyBits, 5)
+				.Where(HeightLayer, EHxlbCompareOp::GreaterOrEqual, MinHeight)
+				.WhereIn(Tagged)
+				.WhereNotIn(Blocked);
+
+			TArray<int32> Expected;
+			for (int32 DenseIndex = 0; DenseIndex < Layout.Num(); DenseIndex++)
+			{
+				const int32 Distance = UHxlbMath::AxialDistance(Layout.CoordOf(DenseIndex), Origin);
+				if (Distance <= Radius && Distance >= MinRadius && TerrainLayer.Get(DenseIndex) != 1 && (FlagsLayer.Get(DenseIndex) & 5)
+					&& HeightLayer.Get(DenseIndex) >= MinHeight && Tagged.Get(DenseIndex) && !Blocked.Get(DenseIndex))
+				{
+					Expected.Add(DenseIndex);
+				}
+			}
+
+			FHxlbHexBitmap Matches;
+			TestFramework->TestEqual(TEXT("Match count"), Query.Execute(Matches), Expected.Num());
+			TArray<int32> Actual;
+			Query.Execute(Actual);
+			TestFramework->TestTrue(TEXT("Unordered results are the scan, in dense order"), Actual == Expected);
+			int32 NumMismatches = 0;
+			for (int32 DenseIndex : Expected)
+			{
+				NumMismatches += !Matches.Get(DenseIndex);
+			}
+			TestFramework->TestEqual(TEXT("Bitmap matches the scan"), NumMismatches, 0);
+
+			// Nearest first, ties by dense index, then the first few.
+			Algo::StableSortBy(Expected, [&](int32 DenseIndex) { return UHxlbMath::AxialDistance(Layout.CoordOf(DenseIndex), Origin); });
+			Query.OrderByDistance(Origin).Execute(Actual);
+			TestFramework->TestTrue(TEXT("Ordered by distance"), Actual == Expected);
+			
+			const int32 MaxResults = Random.RandRange(1, 10);
+			Query.Limit(MaxResults);
+			TArray<int32> Limited = Query.ExecuteAsync().Get();
+			Expected.SetNum(FMath::Min(Expected.Num(), MaxResults));
+			TestFramework->TestTrue(TEXT("Limited to the nearest"), Limited == Expected);
+		}
+	}
+
+	void Test_QueryBuilderOrdersByLayer()
+	{
+		FHxlbDenseLayout Layout;
+		Layout.InitRectangular(15, 15, 8);
+		THxlbHexLayer<float> ScoreLayer(TEXT("Score"));
+		ScoreLayer.Resize(Layout);
+		FRandomStream Random(50);
+		for (int32 DenseIndex = 0; DenseIndex < Layout.Num(); DenseIndex++)
+		{
+			ScoreLayer.Set(DenseIndex, static_cast<float>(Random.RandHelper(10)));
+		}
+
+		TArray<int32> Best;
+		FHxlbHexQueryBuilder(Layout)
+			.Where(ScoreLayer, EHxlbCompareOp::Less, 9.0f)
+			.OrderBy(ScoreLayer, true)
+			.Limit(7)
+			.Execute(Best);
+		
+		TArray<int32> Expected;
+		for (int32 DenseIndex = 0; DenseIndex < Layout.Num(); DenseIndex++)
+		{
+			if (ScoreLayer.Get(DenseIndex) < 9.0f)
+			{
+				Expected.Add(DenseIndex);
+			}
+		}
+		Algo::StableSortBy(Expected, [&](int32 DenseIndex) { return -ScoreLayer.Get(DenseIndex); });
+		Expected.SetNum(7);
+		TestFramework->TestTrue(TEXT("Highest scores first"), Best == Expected);
+
+		THxlbHexLayer<float> WrongSize(TEXT("WrongSize"));
+		TArray<int32> None;
+		FHxlbHexQueryBuilder(Layout).Where(WrongSize, EHxlbCompareOp::Equal, 0.0f).Execute(None);
+		TestFramework->TestEqual(TEXT("Mismatched layers match nothing"), None.Num(), 0);
+	}
+
+private:
+	// Hexes within Query.Radius of the origin and at least Query.MinRadius away, whose tag bits match the filter.
+	static void ComputeFilteredRadius(const FHxlbDenseLayout& Layout, const THxlbHexLayer<int32>& TagLayer, const FHxlbHexQuery& Query, FHxlbHexBitmap& OutHexes)
+	{
+		OutHexes.Init(Layout.Num());
+		auto Shape = HxlbShapes::ClipToMap(HxlbShapes::Spans(FHxlbRadialRange(Query.Origin, Query.Radius)), Layout);
+		HxlbShapes::ForEachIndex(Shape, Layout, [&](int32 DenseIndex)
+		{
+			const bool bInRing = UHxlbMath::AxialDistance(Layout.CoordOf(DenseIndex), Query.Origin) >= Query.MinRadius;
+			if (bInRing && (TagLayer.Get(DenseIndex) & Query.FilterMask))
+			{
+				OutHexes.Set(DenseIndex);
+			}
+		});
+	}
+
+	TSet<FIntPoint> CollectIterator(FHxlbHexIterator&& Iterator)
+	{
+		TSet<FIntPoint> Result;
+		while (Iterator.Next())
+		{
+			Result.Add(Iterator.Get());
+		}
+		return Result;
+	}
+	
+	template <typename RangeType>
+	TArray<FIntPoint> CollectRange(const RangeType& Range)
+	{
+		TArray<FIntPoint> Result;
+		for (int32 RowIndex = 0; RowIndex < Range.NumRows(); RowIndex++)
+		{
+			const FHxlbHexRowSpan Row = Range.GetRow(RowIndex);
+			for (int32 Offset = 0; Offset < Row.Num(); Offset++)
+			{
+				Result.Add(Row.Get(Offset));
+			}
+		}
+		return Result;
+	}
+	
+	template <typename ShapeType>
+	void TestShapeEquals(const TCHAR* What, ShapeType& Shape, const TSet<FIntPoint>& Expected)
+	{
+		TArray<FIntPoint> Actual;
+		FHxlbHexRowSpan Previous(TNumericLimits<int32>::Lowest(), 0, -1);
+		bool bIsOrdered = true;
+		HxlbShapes::ForEachSpan(Shape, [&](const FHxlbHexRowSpan& Span)
+		{
+			bIsOrdered &= !Span.IsEmpty() && (Span.R > Previous.R || Span.QMin > Previous.QMax);
+			Previous = Span;
+			for (int32 Offset = 0; Offset < Span.Num(); Offset++)
+			{
+				Actual.Add(Span.Get(Offset));
+			}
+		});
+
+		TestFramework->TestTrue(FString::Printf(TEXT("%s spans are sorted and disjoint"), What), bIsOrdered);
+		TestFramework->TestEqual(FString::Printf(TEXT("%s count"), What), Actual.Num(), Expected.Num());
+		for (FIntPoint HexCoord : Actual)
+		{
+			TestFramework->TestTrue(FString::Printf(TEXT("%s contains (%d, %d)"), What, HexCoord.X, HexCoord.Y), Expected.Contains(HexCoord));
+		}
+	}
+	
+	FAutomationTestBase* TestFramework;
+};
+
+#define REGISTER_TEST_SUITE_FN(TargetTestName) Tests.Add(TEXT(#TargetTestName), &FHexRangeTestSuite::TargetTestName)
+
+class FHxlbHexRangeTests: public FAutomationTestBase
+{
+public:
+	typedef void (FHexRangeTestSuite::*TestFunction)();
+	
+	FHxlbHexRangeTests(const FString& TestName): FAutomationTestBase(TestName, false)
+	{
+		REGISTER_TEST_SUITE_FN(Test_RadialRangeMatchesIterator);
+		REGISTER_TEST_SUITE_FN(Test_RectangularRangeMatchesIterator);
+		REGISTER_TEST_SUITE_FN(Test_SplitByRowsCoversRange);
+		REGISTER_TEST_SUITE_FN(Test_DenseLayoutRoundTrip);
+		REGISTER_TEST_SUITE_FN(Test_ParallelForEachHexVisitsOnce);
+		REGISTER_TEST_SUITE_FN(Test_ShapeCombinatorsMatchSetOperations);
+		REGISTER_TEST_SUITE_FN(Test_ShapeClipToMapAndExclude);
+		REGISTER_TEST_SUITE_FN(Test_DragPreviewOverSelectedHexes);
+		REGISTER_TEST_SUITE_FN(Test_HexBitmapBits);
+		REGISTER_TEST_SUITE_FN(Test_StencilMatchesNeighborLookup);
+		REGISTER_TEST_SUITE_FN(Test_StencilDilate);
+		REGISTER_TEST_SUITE_FN(Test_StencilActiveStepsMatchFullSteps);
+		REGISTER_TEST_SUITE_FN(Test_OccupancyStaysConsistentUnderMoves);
+		REGISTER_TEST_SUITE_FN(Test_OccupancyRadiusAndNearest);
+		REGISTER_TEST_SUITE_FN(Test_AreaEffectsMatchPairwiseChecks);
+		REGISTER_TEST_SUITE_FN(Test_TimerWheelFiresOnTime);
+		REGISTER_TEST_SUITE_FN(Test_TimerWheelBatchesByChunk);
+		REGISTER_TEST_SUITE_FN(Test_QueryCacheMatchesDirectQuery);
+		REGISTER_TEST_SUITE_FN(Test_QueryCacheInvalidatesByChunk);
+		REGISTER_TEST_SUITE_FN(Test_QueryBuilderMatchesScan);
+		REGISTER_TEST_SUITE_FN(Test_QueryBuilderOrdersByLayer);
+	}
+	
+	virtual EAutomationTestFlags GetTestFlags() const override
+	{
+		return EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter;
+	}
+	virtual bool IsStressTest() const { return false; }
+	virtual uint32 GetRequiredDeviceNum() const override { return 1; }
+
+protected:
+	virtual FString GetBeautifiedTestName() const override
+	{
+		// This string is what the editor uses to organize your test in the Automated tests browser.
+		return "HexEngine.Runtime.HexRangeTests";
+	}
+	virtual void GetTests(TArray<FString>& OutBeautifiedNames, TArray<FString>& OutTestCommands) const override
+	{
+		TArray<FString> TargetTestNames;
+		Tests.GetKeys(TargetTestNames);
+		for (const FString& TargetTestName : TargetTestNames)
+		{
+			OutBeautifiedNames.Add(TargetTestName);
+			OutTestCommands.Add(TargetTestName);
+		}
+	}
+	virtual bool RunTest(const FString& Parameters) override
+	{
+		TestFunction* CurrentTest = Tests.Find(Parameters);
+		if (!CurrentTest || !*CurrentTest)
+		{
+			HXLB_LOG(LogHxlbRuntime, Error, TEXT("Cannot find test: %s"), *Parameters);
+			return false;
+		}
+
+		FHexRangeTestSuite Suite(this);
+		(Suite.**CurrentTest)(); // Run the current test from the test suite.
+
+		return true;
+	}
+
+	TMap<FString, TestFunction> Tests;
+};
+
+namespace
+{
+	FHxlbHexRangeTests FHxlbHexRangeTestsInstance(TEXT("FHxlbHexRangeTests"));
+}
+
+#endif //WITH_EDITOR
@@ -0,0 +1,1004 @@
+// Copyright © Mason Stevenson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the disclaimer
+// below) provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+// THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+// CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+// NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "HexLibRuntimeLoggingDefs.h"
+#include "Containers/Array.h"
+#include "Containers/UnrealString.h"
+#include "Foundation/HxlbDenseLayout.h"
+#include "Foundation/HxlbHexLayers.h"
+#include "FunctionLibraries/HxlbMath.h"
+#include "Macros/HexLibLoggingMacros.h"
+#include "Math/RandomStream.h"
+#include "Misc/AutomationTest.h"
+#include "Navigation/HxlbCooperativePathfinding.h"
+#include "Navigation/HxlbFlowField.h"
+#include "Navigation/HxlbHierarchicalPathfinding.h"
+#include "Navigation/HxlbIncrementalPathfinding.h"
+#include "Navigation/HxlbLandmarks.h"
+#include "Navigation/HxlbMovementRange.h"
+#include "Navigation/HxlbPathfinding.h"
+#include "Navigation/HxlbSearchScratch.h"
+
+#if WITH_EDITOR
+
+class FPathfindingTestSuite
+{
+public:
+	FPathfindingTestSuite(FAutomationTestBase* NewTestFramework): TestFramework(NewTestFramework)
+	{
+		// This constructor is run before each test.
+		Layout.InitHexagonal(8, 4);
+		CostLayer.Resize(Layout);
+		CostLayer.CommitChanges();
+	}
+
+	~FPathfindingTestSuite()
+	{
+		// This destructor is run after each test.
+	}
+
+	void Test_HeapPopsInOrder()
+	{
+		FHxlbNodeHeap Heap;
+		const float Keys[] = {5.0f, 1.0f, 3.0f, 1.0f, 4.0f, 2.0f, 0.5f};
+		for (int32 Index = 0; Index < UE_ARRAY_COUNT(Keys); Index++)
+		{
+			Heap.Push(Keys[Index], Index);
+		}
+
+		FHxlbHeapNode Previous = Heap.Pop();
+		while (!Heap.IsEmpty())
+		{
+			const FHxlbHeapNode Node = Heap.Pop();
+			TestFramework->TestTrue(TEXT("Heap pops by key, then by index"), Previous.Key < Node.Key || (Previous.Key == Node.Key && Previous.Index < Node.Index));
+			Previous = Node;
+		}
+	}
+
+	void Test_PathOnOpenMapIsStraight()
+	{
+		FHxlbPathResult Result;
+		const FIntPoint Start(-4, 0);
+		const FIntPoint Goal(3, 2);
+		FHxlbPathfinder::FindPath(GetCostField(), Start, Goal, FHxlbPathQueryParams(), Result);
+
+		const int32 Distance = UHxlbMath::AxialDistance(Start, Goal);
+		TestFramework->TestTrue(TEXT("Status"), Result.Status == EHxlbPathStatus::Found);
+		TestFramework->TestEqual(TEXT("Path length"), Result.Path.Num(), Distance + 1);
+		TestFramework->TestEqual(TEXT("Path cost"), Result.Cost, static_cast<float>(Distance));
+		TestFramework->TestTrue(TEXT("Path is connected"), IsConnected(Result.Path, Start, Result.Path.Last()));
+	}
+
+	void Test_PathMatchesDijkstra()
+	{
+		FillWithPseudoRandomCosts();
+
+		const FIntPoint Start(0, -7);
+		const FIntPoint Goal(1, 6);
+		CostLayer.Set(Layout.IndexOf(Start), 1.0f);
+		CostLayer.Set(Layout.IndexOf(Goal), 1.0f);
+		CostLayer.CommitChanges();
+
+		FHxlbPathResult Result;
+		FHxlbPathfinder::FindPath(GetCostField(), Start, Goal, FHxlbPathQueryParams(), Result);
+		const TArray<float> Reference = ReferenceCosts(Start);
+
+		TestFramework->TestTrue(TEXT("Status"), Result.Status == EHxlbPathStatus::Found);
+		TestFramework->TestTrue(TEXT("Path cost matches Dijkstra"), FMath::IsNearlyEqual(Result.Cost, Reference[Layout.IndexOf(Goal)]));
+		TestFramework->TestTrue(TEXT("Path is connected"), IsConnected(Result.Path, Start, Goal));
+	}
+
+	void Test_WallIsAvoided()
+	{
+		// Block all of row 0 except its leftmost hex.
+		const FHxlbHexRowSpan& Row = Layout.GetRow(-Layout.GetMinR());
+		for (int32 Q = Row.QMin + 1; Q <= Row.QMax; Q++)
+		{
+			CostLayer.Set(Layout.IndexOf(FIntPoint(Q, 0)), HxlbMovementCost::Blocked);
+		}
+		CostLayer.CommitChanges();
+
+		FHxlbPathResult Result;
+		FHxlbPathfinder::FindPath(GetCostField(), FIntPoint(2, -3), FIntPoint(0, 3), FHxlbPathQueryParams(), Result);
+		TestFramework->TestTrue(TEXT("Status"), Result.Status == EHxlbPathStatus::Found);
+		TestFramework->TestTrue(TEXT("Path goes through the gap"), Result.Path.Contains(FIntPoint(Row.QMin, 0)));
+
+		// Close the gap.
+		CostLayer.Set(Layout.IndexOf(FIntPoint(Row.QMin, 0)), HxlbMovementCost::Blocked);
+		CostLayer.CommitChanges();
+		FHxlbPathfinder::FindPath(GetCostField(), FIntPoint(2, -3), FIntPoint(0, 3), FHxlbPathQueryParams(), Result);
+		TestFramework->TestTrue(TEXT("No path through a closed wall"), Result.Status == EHxlbPathStatus::NoPath);
+
+		FHxlbPathQueryParams Params;
+		Params.bAllowPartialPath = true;
+		FHxlbPathfinder::FindPath(GetCostField(), FIntPoint(2, -3), FIntPoint(0, 3), Params, Result);
+		TestFramework->TestTrue(TEXT("Partial path"), Result.Status == EHxlbPathStatus::Partial);
+		TestFramework->TestEqual(TEXT("Partial path ends at the wall"), HEX_R(Result.Path.Last()), -1);
+	}
+
+	void Test_QueryLimits()
+	{
+		FHxlbPathResult Result;
+		FHxlbPathQueryParams Params;
+		Params.MaxCost = 3.0f;
+		FHxlbPathfinder::FindPath(GetCostField(), FIntPoint(0, 0), FIntPoint(5, 0), Params, Result);
+		TestFramework->TestTrue(TEXT("MaxCost"), Result.Status == EHxlbPathStatus::NoPath);
+
+		Params = FHxlbPathQueryParams();
+		Params.GoalTolerance = 2;
+		FHxlbPathfinder::FindPath(GetCostField(), FIntPoint(0, 0), FIntPoint(5, 0), Params, Result);
+		TestFramework->TestTrue(TEXT("GoalTolerance status"), Result.Status == EHxlbPathStatus::Found);
+		TestFramework->TestEqual(TEXT("GoalTolerance stops early"), Result.Path.Num(), 4);
+
+		FHxlbPathfinder::FindPath(GetCostField(), FIntPoint(0, 0), FIntPoint(50, 0), FHxlbPathQueryParams(), Result);
+		TestFramework->TestTrue(TEXT("Goal outside of the map"), Result.Status == EHxlbPathStatus::InvalidQuery);
+	}
+
+	void Test_LayerReportsChanges()
+	{
+		TArray<int32> Reported;
+		bool bReportedAll = false;
+		CostLayer.OnChanged.AddLambda([&](const FHxlbHexLayerBase& Layer, TConstArrayView<int32> ChangedIndices, bool bAllChanged)
+		{
+			Reported.Append(ChangedIndices.GetData(), ChangedIndices.Num());
+			bReportedAll |= bAllChanged;
+		});
+
+		const int32 ChunkIndex = Layout.ChunkOfIndex(10);
+		const uint32 ChunkVersion = CostLayer.GetChunkVersion(ChunkIndex);
+		
+		CostLayer.Set(10, 2.0f);
+		CostLayer.Set(10, 3.0f);
+		CostLayer.Set(11, 1.0f); // Unchanged, not reported.
+		CostLayer.CommitChanges();
+		
+		TestFramework->TestEqual(TEXT("Changed hexes are reported once"), Reported.Num(), 1);
+		TestFramework->TestTrue(TEXT("Chunk version was bumped"), CostLayer.GetChunkVersion(ChunkIndex) > ChunkVersion);
+		TestFramework->TestFalse(TEXT("Not a full change"), bReportedAll);
+
+		CostLayer.Fill(1.0f);
+		CostLayer.CommitChanges();
+		TestFramework->TestTrue(TEXT("Fill reports a full change"), bReportedAll);
+	}
+
+	void Test_HierarchicalPathIsValid()
+	{
+		Layout.InitHexagonal(20, 6);
+		CostLayer.Resize(Layout);
+		FillWithPseudoRandomCosts();
+
+		FHxlbHierarchicalPathfinder Pathfinder;
+		Pathfinder.Build(GetCostField());
+		TestFramework->TestTrue(TEXT("Graph has nodes"), Pathfinder.NumNodes() > 0);
+
+		const FIntPoint Endpoints[][2] = {{FIntPoint(-15, 2), FIntPoint(14, -3)}, {FIntPoint(0, -18), FIntPoint(2, 17)}, {FIntPoint(1, 1), FIntPoint(2, 1)}};
+		for (const auto& Query : Endpoints)
+		{
+			FHxlbPathResult Flat;
+			FHxlbPathResult Hierarchical;
+			FHxlbPathfinder::FindPath(GetCostField(), Query[0], Query[1], FHxlbPathQueryParams(), Flat);
+			Pathfinder.FindPath(GetCostField(), Query[0], Query[1], Hierarchical);
+
+			TestFramework->TestTrue(TEXT("Both find a path"), Flat.Status == Hierarchical.Status);
+			if (Hierarchical.Status != EHxlbPathStatus::Found)
+			{
+				continue;
+			}
+			
+			TestFramework->TestTrue(TEXT("Hierarchical path is connected"), IsConnected(Hierarchical.Path, Query[0], Query[1]));
+			TestFramework->TestTrue(TEXT("Hierarchical cost matches its path"), FMath::IsNearlyEqual(Hierarchical.Cost, PathCost(Hierarchical.Path), 0.01f));
+			TestFramework->TestTrue(TEXT("Hierarchical cost is close to optimal"), Hierarchical.Cost >= Flat.Cost - 0.01f && Hierarchical.Cost <= Flat.Cost * 1.5f);
+		}
+	}
+
+	void Test_HierarchicalRepairMatchesRebuild()
+	{
+		Layout.InitHexagonal(20, 6);
+		CostLayer.Resize(Layout);
+		FillWithPseudoRandomCosts();
+
+		FHxlbHierarchicalPathfinder Repaired;
+		Repaired.Build(GetCostField());
+		CostLayer.OnChanged.AddLambda([&](const FHxlbHexLayerBase& Layer, TConstArrayView<int32> ChangedIndices, bool bAllChanged)
+		{
+			Repaired.MarkHexesChanged(ChangedIndices);
+		});
+
+		// Wall off most of row 0, and make a few hexes elsewhere more expensive.
+		for (int32 Q = -20; Q <= 17; Q++)
+		{
+			CostLayer.Set(Layout.IndexOf(FIntPoint(Q, 0)), HxlbMovementCost::Blocked);
+		}
+		CostLayer.Set(Layout.IndexOf(FIntPoint(5, 5)), 9.0f);
+		CostLayer.Set(Layout.IndexOf(FIntPoint(-7, 12)), 9.0f);
+		CostLayer.CommitChanges();
+		
+		TestFramework->TestTrue(TEXT("Repair pending"), Repaired.NeedsRepair());
+		Repaired.Repair(GetCostField());
+
+		FHxlbHierarchicalPathfinder Rebuilt;
+		Rebuilt.Build(GetCostField());
+		TestFramework->TestEqual(TEXT("Same nodes"), Repaired.NumNodes(), Rebuilt.NumNodes());
+		TestFramework->TestEqual(TEXT("Same edges"), Repaired.NumEdges(), Rebuilt.NumEdges());
+
+		FHxlbPathResult RepairedResult;
+		FHxlbPathResult RebuiltResult;
+		Repaired.FindPath(GetCostField(), FIntPoint(0, -10), FIntPoint(0, 10), RepairedResult);
+		Rebuilt.FindPath(GetCostField(), FIntPoint(0, -10), FIntPoint(0, 10), RebuiltResult);
+		TestFramework->TestTrue(TEXT("Repaired graph finds the way around the wall"), RepairedResult.Status == EHxlbPathStatus::Found);
+		TestFramework->TestTrue(TEXT("Same cost as a rebuilt graph"), FMath::IsNearlyEqual(RepairedResult.Cost, RebuiltResult.Cost));
+		TestFramework->TestTrue(TEXT("Path is connected"), IsConnected(RepairedResult.Path, FIntPoint(0, -10), FIntPoint(0, 10)));
+	}
+
+	void Test_FlowFieldMatchesReference()
+	{
+		Layout.InitHexagonal(20, 6);
+		CostLayer.Resize(Layout);
+		FillWithPseudoRandomCosts();
+		
+		const TArray<FIntPoint> Goals = {FIntPoint(0, 0), FIntPoint(10, -5)};
+		CostLayer.Set(Layout.IndexOf(Goals[0]), 1.0f);
+		CostLayer.Set(Layout.IndexOf(Goals[1]), 1.0f);
+		CostLayer.CommitChanges();
+
+		FHxlbFlowField FlowField;
+		FlowField.Build(GetCostField(), Goals);
+		const TArray<float> Reference = ReferenceIntegration(Goals);
+		
+		int32 NumMismatches = 0;
+		int32 NumBrokenChains = 0;
+		for (int32 Index = 0; Index < Layout.Num(); Index++)
+		{
+			const FIntPoint HexCoord = Layout.CoordOf(Index);
+			const float Integrated = FlowField.GetIntegratedCost(HexCoord);
+			if (!FMath::IsNearlyEqual(Integrated, Reference[Index]))
+			{
+				NumMismatches++;
+			}
+			if (Integrated == FHxlbFlowField::kUnreached)
+			{
+				continue;
+			}
+			
+			// Following the directions has to end at a goal, and cost exactly what the integration field says.
+			FIntPoint Current = HexCoord;
+			FIntPoint Next;
+			float ChainCost = 0.0f;
+			int32 NumSteps = 0;
+			while (FlowField.GetNextHex(Current, Next) && NumSteps++ < Layout.Num())
+			{
+				ChainCost += CostLayer.Get(Layout.IndexOf(Next));
+				Current = Next;
+			}
+			if (!Goals.Contains(Current) || !FMath::IsNearlyEqual(ChainCost, Integrated, 0.01f))
+			{
+				NumBrokenChains++;
+			}
+		}
+		TestFramework->TestEqual(TEXT("Integration matches reference"), NumMismatches, 0);
+		TestFramework->TestEqual(TEXT("Directions lead to a goal"), NumBrokenChains, 0);
+		TestFramework->TestTrue(TEXT("Goal is marked"), FlowField.GetDirection(Goals[0]) == FHxlbFlowField::kGoal);
+		TestFramework->TestTrue(TEXT("Outside of the map is unreachable"), FlowField.GetDirection(FIntPoint(100, 0)) == FHxlbFlowField::kUnreachable);
+	}
+
+	void Test_FlowFieldUpdateMatchesRebuild()
+	{
+		Layout.InitHexagonal(20, 6);
+		CostLayer.Resize(Layout);
+		FillWithPseudoRandomCosts();
+		
+		const TArray<FIntPoint> Goals = {FIntPoint(0, -15)};
+		CostLayer.Set(Layout.IndexOf(Goals[0]), 1.0f);
+		CostLayer.CommitChanges();
+
+		FHxlbFlowField Updated;
+		Updated.Build(GetCostField(), Goals);
+		TArray<int32> Changes;
+		CostLayer.OnChanged.AddLambda([&](const FHxlbHexLayerBase& Layer, TConstArrayView<int32> ChangedIndices, bool bAllChanged)
+		{
+			Changes.Append(ChangedIndices.GetData(), ChangedIndices.Num());
+		});
+
+		// A wall with a gap, a few hexes that got more expensive and a few that got cheaper.
+		for (int32 Q = -20; Q <= 17; Q++)
+		{
+			CostLayer.Set(Layout.IndexOf(FIntPoint(Q, 0)), HxlbMovementCost::Blocked);
+		}
+		CostLayer.Set(Layout.IndexOf(FIntPoint(5, 5)), 9.0f);
+		CostLayer.Set(Layout.IndexOf(FIntPoint(-7, 12)), 9.0f);
+		for (int32 Q = -5; Q <= 5; Q++)
+		{
+			CostLayer.Set(Layout.IndexOf(FIntPoint(Q, -8)), 0.5f);
+		}
+		CostLayer.CommitChanges();
+		Updated.Update(GetCostField(), Changes);
+
+		FHxlbFlowField Rebuilt;
+		Rebuilt.Build(GetCostField(), Goals);
+		
+		int32 NumMismatches = 0;
+		for (int32 Index = 0; Index < Layout.Num(); Index++)
+		{
+			const FIntPoint HexCoord = Layout.CoordOf(Index);
+			if (!FMath::IsNearlyEqual(Updated.GetIntegratedCost(HexCoord), Rebuilt.GetIntegratedCost(HexCoord)) || Updated.GetDirection(HexCoord) != Rebuilt.GetDirection(HexCoord))
+			{
+				NumMismatches++;
+			}
+		}
+		TestFramework->TestEqual(TEXT("Updated field matches a rebuilt one"), NumMismatches, 0);
+		TestFramework->TestTrue(TEXT("Hexes below the wall go around it"), Updated.GetIntegratedCost(FIntPoint(0, 10)) < FHxlbFlowField::kUnreached);
+	}
+
+	void Test_FlowFieldCache()
+	{
+		FHxlbFlowFieldCache Cache;
+		Cache.MaxFields = 2;
+		
+		TSharedRef<const FHxlbFlowField> First = Cache.FindOrBuild(GetCostField(), {FIntPoint(1, 0), FIntPoint(0, 1)});
+		TSharedRef<const FHxlbFlowField> Same = Cache.FindOrBuild(GetCostField(), {FIntPoint(0, 1), FIntPoint(1, 0)});
+		TestFramework->TestTrue(TEXT("Goal order doesn't matter"), &First.Get() == &Same.Get());
+		
+		Cache.FindOrBuild(GetCostField(), {FIntPoint(2, 0)});
+		Cache.FindOrBuild(GetCostField(), {FIntPoint(3, 0)});
+		TestFramework->TestEqual(TEXT("Cache is bounded"), Cache.Num(), 2);
+		
+		CostLayer.Set(Layout.IndexOf(FIntPoint(2, 0)), HxlbMovementCost::Blocked);
+		const int32 ChangedIndex = Layout.IndexOf(FIntPoint(2, 0));
+		Cache.MarkHexesChanged(MakeArrayView(&ChangedIndex, 1));
+		TSharedRef<const FHxlbFlowField> Field = Cache.FindOrBuild(GetCostField(), {FIntPoint(3, 0)});
+		TestFramework->TestTrue(TEXT("Blocked hex is no longer on the way"), Field->GetDirection(FIntPoint(1, 0)) != 0);
+	}
+
+	void Test_MovementRangeMatchesReference()
+	{
+		// A hexagonal and a rectangular map, so that rows start at different Q.
+		for (int32 Shape = 0; Shape < 2; Shape++)
+		{
+			Shape == 0 ? Layout.InitHexagonal(40, 8) : Layout.InitRectangular(45, 20, 8);
+			CostLayer.Resize(Layout);
+			FillWithPseudoRandomCosts();
+			
+			FHxlbMovementRange MovementRange;
+			MovementRange.Build(GetCostField());
+
+			int32 NumMismatches = 0;
+			for (FIntPoint Origin : {FIntPoint(0, 0), FIntPoint(-30, 10), FIntPoint(12, -19)})
+			{
+				// 40 steps is wider than a single word.
+				for (int32 MaxSteps : {0, 1, 3, 12, 40})
+				{
+					FHxlbHexBitmap Reachable;
+					const int32 NumReachable = MovementRange.FindReachable(Origin, MaxSteps, Reachable);
+					const TArray<int32> Steps = ReferenceSteps(Origin);
+					int32 NumExpected = 0;
+					for (int32 Index = 0; Index < Layout.Num(); Index++)
+					{
+						NumExpected += Steps[Index] <= MaxSteps;
+						NumMismatches += Reachable.Get(Index) != (Steps[Index] <= MaxSteps);
+					}
+					NumMismatches += NumReachable != NumExpected;
+				}
+
+				for (float MaxCost : {0.0f, 2.5f, 9.0f, 30.0f})
+				{
+					FHxlbHexBitmap Reachable;
+					FHxlbMovementRange::FindReachableWeighted(GetCostField(), Origin, MaxCost, Reachable);
+					const TArray<float> Costs = ReferenceCosts(Origin);
+					for (int32 Index = 0; Index < Layout.Num(); Index++)
+					{
+						NumMismatches += Reachable.Get(Index) != (Costs[Index] <= MaxCost);
+					}
+				}
+			}
+			TestFramework->TestEqual(TEXT("Movement ranges match reference"), NumMismatches, 0);
+		}
+	}
+
+	void Test_MovementRangeBatch()
+	{
+		Layout.InitHexagonal(20, 6);
+		CostLayer.Resize(Layout);
+		FillWithPseudoRandomCosts();
+		
+		FHxlbMovementRange MovementRange;
+		MovementRange.Build(GetCostField());
+
+		TArray<FHxlbMovementRangeQuery> Queries;
+		for (int32 Index = 0; Index < Layout.Num(); Index += 7)
+		{
+			FHxlbMovementRangeQuery& Query = Queries.AddDefaulted_GetRef();
+			Query.Origin = Layout.CoordOf(Index);
+			Query.MaxCost = static_cast<float>(Index % 9);
+			Query.bUniformCost = Index % 2 == 0;
+		}
+
+		TArray<int32> Counts;
+		Counts.Init(0, Queries.Num());
+		MovementRange.FindReachableBatch(GetCostField(), Queries, [&Counts](int32 QueryIndex, const FHxlbHexBitmap& Reachable)
+		{
+			Counts[QueryIndex] = Reachable.CountSetBits();
+		});
+
+		int32 NumMismatches = 0;
+		for (int32 QueryIndex = 0; QueryIndex < Queries.Num(); QueryIndex++)
+		{
+			const FHxlbMovementRangeQuery& Query = Queries[QueryIndex];
+			FHxlbHexBitmap Reachable;
+			const int32 Expected = Query.bUniformCost
+				? MovementRange.FindReachable(Query.Origin, FMath::FloorToInt32(Query.MaxCost), Reachable)
+				: FHxlbMovementRange::FindReachableWeighted(GetCostField(), Query.Origin, Query.MaxCost, Reachable);
+			NumMismatches += Counts[QueryIndex] != Expected;
+		}
+		TestFramework->TestEqual(TEXT("Batch matches single queries"), NumMismatches, 0);
+
+		// Blocking a hex is picked up by an update.
+		const FIntPoint Blocked(1, 0);
+		CostLayer.Set(Layout.IndexOf(Blocked), HxlbMovementCost::Blocked);
+		const int32 BlockedIndex = Layout.IndexOf(Blocked);
+		MovementRange.UpdateHexes(GetCostField(), MakeArrayView(&BlockedIndex, 1));
+		FHxlbHexBitmap Reachable;
+		MovementRange.FindReachable(FIntPoint(0, 0), 3, Reachable);
+		TestFramework->TestFalse(TEXT("Blocked hex is not reachable"), Reachable.Get(BlockedIndex));
+	}
+
+	// IMPORTANT! Be sure to register your fn inside your AutomationTest class below!
+
+	void Test_CooperativeAgentsPassThroughGap()
+	{
+		// Block all of row 0 except its leftmost hex, and send two agents through the gap in opposite directions.
+		const FHxlbHexRowSpan& Row = Layout.GetRow(-Layout.GetMinR());
+		for (int32 Q = Row.QMin + 1; Q <= Row.QMax; Q++)
+		{
+			CostLayer.Set(Layout.IndexOf(FIntPoint(Q, 0)), HxlbMovementCost::Blocked);
+		}
+		CostLayer.CommitChanges();
+
+		TArray<FHxlbAgentPathRequest> Requests;
+		Requests.Add({FIntPoint(-6, -2), FIntPoint(-8, 2), 0});
+		Requests.Add({FIntPoint(-8, 2), FIntPoint(-6, -2), 0});
+		FHxlbCooperativePathParams Params;
+		Params.Window = 24;
+		
+		FHxlbCooperativePlanner Planner;
+		TArray<FHxlbPathResult> Results;
+		Planner.PlanGroup(GetCostField(), Requests, Params, Results);
+		TestFramework->TestTrue(TEXT("First agent arrives"), Results[0].Status == EHxlbPathStatus::Found);
+		TestFramework->TestTrue(TEXT("Second agent arrives"), Results[1].Status == EHxlbPathStatus::Found);
+		TestFramework->TestEqual(TEXT("No conflicts"), CountPlanConflicts(Requests, Results, Params.Window), 0);
+		TestFramework->TestTrue(TEXT("First agent goes straight through"), Results[0].Path.Contains(FIntPoint(Row.QMin, 0)) && Results[0].Path.Num() == 5);
+	}
+
+	void Test_CooperativeAgentInDeadEnd()
+	{
+		// A corridor along row 0 that ends at (5, 0), with an agent standing near its end. The agent planned first wants
+		// to go past it, into the end of the corridor.
+		for (int32 Index = 0; Index < Layout.Num(); Index++)
+		{
+			const FIntPoint HexCoord = Layout.CoordOf(Index);
+			const bool bInCorridor = HexCoord.Y == 0 && HexCoord.X >= -5 && HexCoord.X <= 5;
+			CostLayer.Set(Index, bInCorridor ? 1.0f : HxlbMovementCost::Blocked);
+		}
+		CostLayer.CommitChanges();
+
+		TArray<FHxlbAgentPathRequest> Requests;
+		Requests.Add({FIntPoint(-5, 0), FIntPoint(5, 0), 1});
+		Requests.Add({FIntPoint(3, 0), FIntPoint(3, 0), 0});
+		FHxlbCooperativePathParams Params;
+		
+		FHxlbCooperativePlanner Planner;
+		TArray<FHxlbPathResult> Results;
+		Planner.PlanGroup(GetCostField(), Requests, Params, Results);
+		TestFramework->TestEqual(TEXT("No conflicts"), CountPlanConflicts(Requests, Results, Params.Window), 0);
+		TestFramework->TestEqual(TEXT("No conflicts reported"), Planner.GetNumConflicts(), 0);
+		TestFramework->TestTrue(TEXT("First agent stops short of the other one"), Results[0].Status == EHxlbPathStatus::Partial && Results[0].Path.Last() == FIntPoint(2, 0));
+		TestFramework->TestTrue(TEXT("Second agent keeps its hex"), Results[1].Status == EHxlbPathStatus::Found);
+
+		// Planned on its own, an agent standing in the first one's path never takes a held hex, and the collision it
+		// can't avoid is reported.
+		FHxlbPathResult Result;
+		Planner.PlanAgent(GetCostField(), 2, {FIntPoint(-4, 0), FIntPoint(5, 0), 0}, Params, Result);
+		TestFramework->TestFalse(TEXT("Held hexes are avoided"), Result.Path.Contains(FIntPoint(3, 0)) || Result.Path.Contains(FIntPoint(2, 0)));
+		TestFramework->TestTrue(TEXT("Unavoidable collisions are reported"), Planner.GetNumConflicts() > 0);
+	}
+
+	void Test_CooperativeGroupHasNoConflicts()
+	{
+		FillWithPseudoRandomCosts();
+
+		FRandomStream Random(43);
+		TArray<int32> Free;
+		for (int32 Index = 0; Index < Layout.Num(); Index++)
+		{
+			if (CostLayer.Get(Index) != HxlbMovementCost::Blocked)
+			{
+				Free.Add(Index);
+			}
+		}
+		for (int32 Index = Free.Num() - 1; Index > 0; Index--)
+		{
+			Swap(Free[Index], Free[Random.RandHelper(Index + 1)]);
+		}
+		
+		// Starts are distinct, and so are goals.
+		TArray<FHxlbAgentPathRequest> Requests;
+		for (int32 AgentId = 0; AgentId < 50; AgentId++)
+		{
+			FHxlbAgentPathRequest& Request = Requests.AddDefaulted_GetRef();
+			Request.Start = Layout.CoordOf(Free[AgentId]);
+			Request.Goal = Layout.CoordOf(Free[Free.Num() - 1 - AgentId]);
+			Request.Priority = Random.RandRange(0, 3);
+		}
+		FHxlbCooperativePathParams Params;
+		Params.Window = 32;
+		
+		FHxlbCooperativePlanner Planner;
+		TArray<FHxlbPathResult> Results;
+		Planner.PlanGroup(GetCostField(), Requests, Params, Results);
+
+		int32 NumFound = 0;
+		int32 NumWrongGoals = 0;
+		for (int32 AgentId = 0; AgentId < Requests.Num(); AgentId++)
+		{
+			NumFound += Results[AgentId].Status == EHxlbPathStatus::Found;
+			NumWrongGoals += Results[AgentId].Status == EHxlbPathStatus::Found && Results[AgentId].Path.Last() != Requests[AgentId].Goal;
+		}
+		TestFramework->TestEqual(TEXT("No conflicts"), CountPlanConflicts(Requests, Results, Params.Window), 0);
+		TestFramework->TestEqual(TEXT("Found paths end at the goal"), NumWrongGoals, 0);
+		TestFramework->TestTrue(TEXT("Most agents arrive"), NumFound >= 40);
+	}
+
+	void Test_LandmarkBoundsAreAdmissible()
+	{
+		FillWithPseudoRandomCosts();
+		FHxlbLandmarks Landmarks;
+		Landmarks.Build(GetCostField(), 4);
+		TestFramework->TestEqual(TEXT("Landmark count"), Landmarks.Num(), 4);
+		TestFramework->TestEqual(TEXT("One float per hex per landmark"), static_cast<int32>(Landmarks.GetAllocatedSizePerLandmark()), Layout.Num() * static_cast<int32>(sizeof(float)));
+
+		FRandomStream Random(44);
+		int32 NumOverestimates = 0;
+		int32 NumTighter = 0;
+		for (int32 Query = 0; Query < 20; Query++)
+		{
+			const int32 From = Random.RandHelper(Layout.Num());
+			const TArray<float> Reference = ReferenceCosts(Layout.CoordOf(From));
+			for (int32 To = 0; To < Layout.Num(); To++)
+			{
+				if (Reference[To] == TNumericLimits<float>::Max())
+				{
+					continue;
+				}
+				const float Bound = Landmarks.GetLowerBound(GetCostField(), From, To);
+				NumOverestimates += Bound > Reference[To] + UE_KINDA_SMALL_NUMBER;
+				NumTighter += Bound > UHxlbMath::AxialDistance(Layout.CoordOf(From), Layout.CoordOf(To)) * GetCostField().GetMinCost();
+			}
+		}
+		TestFramework->TestEqual(TEXT("Bounds never overestimate"), NumOverestimates, 0);
+		TestFramework->TestTrue(TEXT("Bounds beat the hex distance"), NumTighter > 0);
+	}
+
+	void Test_LandmarkPathsMatchPlainPaths()
+	{
+		FillWithPseudoRandomCosts();
+		FHxlbLandmarks Landmarks;
+		Landmarks.Build(GetCostField());
+
+		FRandomStream Random(45);
+		for (int32 Round = 0; Round < 2; Round++)
+		{
+			int32 NumPlainExpanded = 0;
+			int32 NumLandmarkExpanded = 0;
+			for (int32 Query = 0; Query < 30; Query++)
+			{
+				const FIntPoint Start = Layout.CoordOf(Random.RandHelper(Layout.Num()));
+				const FIntPoint Goal = Layout.CoordOf(Random.RandHelper(Layout.Num()));
+				FHxlbPathResult Plain;
+				FHxlbPathResult WithLandmarks;
+				FHxlbPathfinder::FindPath(GetCostField(), Start, Goal, FHxlbPathQueryParams(), Plain);
+				FHxlbPathfinder::FindPath(GetCostField(), Start, Goal, FHxlbPathQueryParams(), WithLandmarks, &Landmarks);
+				
+				TestFramework->TestTrue(TEXT("Same status"), Plain.Status == WithLandmarks.Status);
+				TestFramework->TestTrue(TEXT("Same cost"), FMath::IsNearlyEqual(Plain.Cost, WithLandmarks.Cost, UE_KINDA_SMALL_NUMBER));
+				NumPlainExpanded += Plain.NumExpanded;
+				NumLandmarkExpanded += WithLandmarks.NumExpanded;
+			}
+			TestFramework->TestTrue(TEXT("Landmarks expand fewer hexes"), NumLandmarkExpanded < NumPlainExpanded);
+
+			// Lower a few costs, which makes the old tables overestimate until they are refreshed.
+			for (int32 Count = 0; Count < 20; Count++)
+			{
+				CostLayer.Set(Random.RandHelper(Layout.Num()), 1.0f);
+			}
+			CostLayer.CommitChanges();
+			Landmarks.MarkDirty();
+			TestFramework->TestFalse(TEXT("Dirty landmarks aren't used"), Landmarks.IsUsableWith(GetCostField()));
+			Landmarks.Refresh(GetCostField());
+		}
+	}
+
+	void Test_IncrementalPathsMatchPlainPaths()
+	{
+		Layout.InitHexagonal(20, 6);
+		CostLayer.Resize(Layout);
+		FillWithPseudoRandomCosts();
+
+		FIntPoint Start(-14, 2);
+		const FIntPoint Goal(14, -3);
+		CostLayer.Set(Layout.IndexOf(Start), 1.0f);
+		CostLayer.Set(Layout.IndexOf(Goal), 1.0f);
+		CostLayer.CommitChanges();
+
+		FHxlbIncrementalPathfinder Planner;
+		TestFramework->TestTrue(TEXT("Init"), Planner.Init(GetCostField(), Start, Goal));
+		CostLayer.OnChanged.AddLambda([&](const FHxlbHexLayerBase& Layer, TConstArrayView<int32> ChangedIndices, bool bAllChanged)
+		{
+			Planner.UpdateCosts(GetCostField(), ChangedIndices);
+		});
+		
+		FHxlbPathResult Incremental;
+		Planner.FindPath(Incremental);
+		const int32 NumInitialExpanded = Incremental.NumExpanded;
+
+		FRandomStream Random(45);
+		int32 NumRepairExpanded = 0;
+		const int32 NumRounds = 12;
+		for (int32 Round = 0; Round < NumRounds; Round++)
+		{
+			// Block, unblock and reprice a few hexes, sometimes right on the current path.
+			for (int32 Count = 0; Count < 6; Count++)
+			{
+				const int32 Index = Count == 0 && Incremental.Path.Num() > 3
+					? Layout.IndexOf(Incremental.Path[Incremental.Path.Num() / 2])
+					: Random.RandHelper(Layout.Num());
+				if (Index != Layout.IndexOf(Goal))
+				{
+					CostLayer.Set(Index, Random.RandHelper(4) == 0 ? HxlbMovementCost::Blocked : 1.0f + Random.RandHelper(5));
+				}
+			}
+			CostLayer.CommitChanges();
+
+			// Walk the agent a couple of hexes along its last path.
+			if (Incremental.Path.Num() > 2)
+			{
+				Start = Incremental.Path[2];
+				TestFramework->TestTrue(TEXT("Start moves"), Planner.SetStart(Start));
+			}
+
+			FHxlbPathResult Plain;
+			FHxlbPathfinder::FindPath(GetCostField(), Start, Goal, FHxlbPathQueryParams(), Plain);
+			Planner.FindPath(Incremental);
+			NumRepairExpanded += Incremental.NumExpanded;
+			
+			TestFramework->TestTrue(TEXT("Same status"), Plain.Status == Incremental.Status);
+			TestFramework->TestTrue(TEXT("Same cost"), FMath::IsNearlyEqual(Plain.Cost, Incremental.Cost, UE_KINDA_SMALL_NUMBER));
+			if (Incremental.Status == EHxlbPathStatus::Found)
+			{
+				TestFramework->TestTrue(TEXT("Path is connected"), IsConnected(Incremental.Path, Start, Goal));
+				TestFramework->TestTrue(TEXT("Reported cost is the path cost"), FMath::IsNearlyEqual(PathCost(Incremental.Path), Incremental.Cost, UE_KINDA_SMALL_NUMBER));
+			}
+		}
+		TestFramework->TestTrue(TEXT("Repairs expand fewer hexes than the first search"), NumRepairExpanded / NumRounds < NumInitialExpanded);
+	}
+
+	void Test_IncrementalPathRecoversFromWall()
+	{
+		FHxlbIncrementalPathfinder Planner;
+		Planner.Init(GetCostField(), FIntPoint(0, -6), FIntPoint(0, 6));
+		CostLayer.OnChanged.AddLambda([&](const FHxlbHexLayerBase& Layer, TConstArrayView<int32> ChangedIndices, bool bAllChanged)
+		{
+			Planner.UpdateCosts(GetCostField(), ChangedIndices);
+		});
+
+		FHxlbPathResult Result;
+		TestFramework->TestTrue(TEXT("Open map"), Planner.FindPath(Result) == EHxlbPathStatus::Found);
+		TestFramework->TestEqual(TEXT("Straight path"), Result.Path.Num(), 13);
+
+		// Wall off row 0 completely, then open one hex at its end.
+		for (int32 Q = -8; Q <= 8; Q++)
+		{
+			const int32 Index = Layout.IndexOf(FIntPoint(Q, 0));
+			if (Index != INDEX_NONE)
+			{
+				CostLayer.Set(Index, HxlbMovementCost::Blocked);
+			}
+		}
+		CostLayer.CommitChanges();
+		TestFramework->TestTrue(TEXT("Wall blocks the way"), Planner.FindPath(Result) == EHxlbPathStatus::NoPath);
+
+		CostLayer.Set(Layout.IndexOf(FIntPoint(8, 0)), 1.0f);
+		CostLayer.CommitChanges();
+		TestFramework->TestTrue(TEXT("Gap is found"), Planner.FindPath(Result) == EHxlbPathStatus::Found);
+		TestFramework->TestTrue(TEXT("Path goes through the gap"), Result.Path.Contains(FIntPoint(8, 0)));
+		TestFramework->TestTrue(TEXT("Path is connected"), IsConnected(Result.Path, FIntPoint(0, -6), FIntPoint(0, 6)));
+	}
+
+private:
+	// Moves that aren't a step to a passable neighbor or a wait, agents in the same hex at the same tick, and agents
+	// swapping hexes. Agents stay on the last hex of their path until the end of the window.
+	int32 CountPlanConflicts(const TArray<FHxlbAgentPathRequest>& Requests, const TArray<FHxlbPathResult>& Results, int32 Window) const
+	{
+		auto HexAt = [&Results](int32 AgentId, int32 Tick)
+		{
+			const TArray<FIntPoint>& Path = Results[AgentId].Path;
+			return Path[FMath::Min(Tick, Path.Num() - 1)];
+		};
+		
+		int32 NumConflicts = 0;
+		for (int32 AgentId = 0; AgentId < Results.Num(); AgentId++)
+		{
+			const TArray<FIntPoint>& Path = Results[AgentId].Path;
+			NumConflicts += Path.IsEmpty() || Path[0] != Requests[AgentId].Start || Path.Num() > Window + 1;
+			for (int32 Tick = 1; Tick < Path.Num(); Tick++)
+			{
+				NumConflicts += UHxlbMath::AxialDistance(Path[Tick - 1], Path[Tick]) > 1 || CostLayer.Get(Layout.IndexOf(Path[Tick])) == HxlbMovementCost::Blocked;
+			}
+		}
+		if (NumConflicts > 0)
+		{
+			return NumConflicts;
+		}
+		
+		for (int32 Tick = 0; Tick <= Window; Tick++)
+		{
+			for (int32 A = 0; A < Results.Num(); A++)
+			{
+				for (int32 B = A + 1; B < Results.Num(); B++)
+				{
+					NumConflicts += HexAt(A, Tick) == HexAt(B, Tick);
+					NumConflicts += Tick > 0 && HexAt(A, Tick - 1) == HexAt(B, Tick) && HexAt(A, Tick) == HexAt(B, Tick - 1);
+				}
+			}
+		}
+		return NumConflicts;
+	}
+	
+	// Deterministic, uneven costs with a few blocked hexes.
+	void FillWithPseudoRandomCosts()
+	{
+		for (int32 Index = 0; Index < Layout.Num(); Index++)
+		{
+			const uint32 Hash = static_cast<uint32>(Index) * 2654435761u;
+			CostLayer.Set(Index, (Hash >> 28) == 0 ? HxlbMovementCost::Blocked : 1.0f + static_cast<float>((Hash >> 24) % 5));
+		}
+		CostLayer.CommitChanges();
+	}
+
+	float PathCost(const TArray<FIntPoint>& Path) const
+	{
+		float Cost = 0.0f;
+		for (int32 Index = 1; Index < Path.Num(); Index++)
+		{
+			Cost += CostLayer.Get(Layout.IndexOf(Path[Index]));
+		}
+		return Cost;
+	}
+	
+	FHxlbCostField GetCostField() const
+	{
+		float MinCost = TNumericLimits<float>::Max();
+		for (float Cost : CostLayer.GetValues())
+		{
+			MinCost = FMath::Min(MinCost, Cost);
+		}
+		return FHxlbCostField(Layout, CostLayer.GetValues(), MinCost);
+	}
+
+	bool IsConnected(const TArray<FIntPoint>& Path, FIntPoint Start, FIntPoint Goal) const
+	{
+		if (Path.IsEmpty() || Path[0] != Start || Path.Last() != Goal)
+		{
+			return false;
+		}
+		for (int32 Index = 1; Index < Path.Num(); Index++)
+		{
+			if (UHxlbMath::AxialDistance(Path[Index - 1], Path[Index]) != 1 || CostLayer.Get(Layout.IndexOf(Path[Index])) == HxlbMovementCost::Blocked)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// Relaxes every edge until nothing changes. Slow, but obviously correct.
+	TArray<float> ReferenceCosts(FIntPoint Start) const
+	{
+		TArray<float> Costs;
+		Costs.Init(TNumericLimits<float>::Max(), Layout.Num());
+		Costs[Layout.IndexOf(Start)] = 0.0f;
+		
+		bool bChanged = true;
+		while (bChanged)
+		{
+			bChanged = false;
+			for (int32 Index = 0; Index < Layout.Num(); Index++)
+			{
+				if (Costs[Index] == TNumericLimits<float>::Max())
+				{
+					continue;
+				}
+				for (int32 Direction = 0; Direction < 6; Direction++)
+				{
+					const int32 Neighbor = Layout.NeighborIndex(Layout.CoordOf(Index), Direction);
+					if (Neighbor == INDEX_NONE || CostLayer.Get(Neighbor) == HxlbMovementCost::Blocked)
+					{
+						continue;
+					}
+					if (Costs[Index] + CostLayer.Get(Neighbor) < Costs[Neighbor])
+					{
+						Costs[Neighbor] = Costs[Index] + CostLayer.Get(Neighbor);
+						bChanged = true;
+					}
+				}
+			}
+		}
+		return Costs;
+	}
+	
+	// Number of steps from Start to every hex, where every passable hex costs one step.
+	TArray<int32> ReferenceSteps(FIntPoint Start) const
+	{
+		TArray<int32> Steps;
+		Steps.Init(TNumericLimits<int32>::Max(), Layout.Num());
+		TArray<int32> Queue = {Layout.IndexOf(Start)};
+		Steps[Queue[0]] = 0;
+		for (int32 QueueIndex = 0; QueueIndex < Queue.Num(); QueueIndex++)
+		{
+			const int32 Index = Queue[QueueIndex];
+			for (int32 Direction = 0; Direction < 6; Direction++)
+			{
+				const int32 Neighbor = Layout.NeighborIndex(Layout.CoordOf(Index), Direction);
+				if (Neighbor != INDEX_NONE && CostLayer.Get(Neighbor) != HxlbMovementCost::Blocked && Steps[Neighbor] == TNumericLimits<int32>::Max())
+				{
+					Steps[Neighbor] = Steps[Index] + 1;
+					Queue.Add(Neighbor);
+				}
+			}
+		}
+		return Steps;
+	}
+
+	// Cost of the cheapest path from every hex to the nearest goal, by relaxing every edge until nothing changes.
+	TArray<float> ReferenceIntegration(const TArray<FIntPoint>& Goals) const
+	{
+		TArray<float> Costs;
+		Costs.Init(TNumericLimits<float>::Max(), Layout.Num());
+		for (FIntPoint Goal : Goals)
+		{
+			Costs[Layout.IndexOf(Goal)] = 0.0f;
+		}
+		
+		bool bChanged = true;
+		while (bChanged)
+		{
+			bChanged = false;
+			for (int32 Index = 0; Index < Layout.Num(); Index++)
+			{
+				if (Costs[Index] == TNumericLimits<float>::Max() || CostLayer.Get(Index) == HxlbMovementCost::Blocked)
+				{
+					continue;
+				}
+				for (int32 Direction = 0; Direction < 6; Direction++)
+				{
+					const int32 Neighbor = Layout.NeighborIndex(Layout.CoordOf(Index), Direction);
+					if (Neighbor != INDEX_NONE && Costs[Index] + CostLayer.Get(Index) < Costs[Neighbor])
+					{
+						Costs[Neighbor] = Costs[Index] + CostLayer.Get(Index);
+						bChanged = true;
+					}
+				}
+			}
+		}
+		return Costs;
+	}
+	
+	FAutomationTestBase* TestFramework;
+	FHxlbDenseLayout Layout;
+	THxlbHexLayer<float> CostLayer = THxlbHexLayer<float>(TEXT("TestCost"), 1.0f);
+};
+
+#define REGISTER_TEST_SUITE_FN(TargetTestName) Tests.Add(TEXT(#TargetTestName), &FPathfindingTestSuite::TargetTestName)
+
+class FHxlbPathfindingTests: public FAutomationTestBase
+{
+public:
+	typedef void (FPathfindingTestSuite::*TestFunction)();
+	
+	FHxlbPathfindingTests(const FString& TestName): FAutomationTestBase(TestName, false)
+	{
+		REGISTER_TEST_SUITE_FN(Test_HeapPopsInOrder);
+		REGISTER_TEST_SUITE_FN(Test_PathOnOpenMapIsStraight);
+		REGISTER_TEST_SUITE_FN(Test_PathMatchesDijkstra);
+		REGISTER_TEST_SUITE_FN(Test_WallIsAvoided);
+		REGISTER_TEST_SUITE_FN(Test_QueryLimits);
+		REGISTER_TEST_SUITE_FN(Test_LayerReportsChanges);
+		REGISTER_TEST_SUITE_FN(Test_HierarchicalPathIsValid);
+		REGISTER_TEST_SUITE_FN(Test_HierarchicalRepairMatchesRebuild);
+		REGISTER_TEST_SUITE_FN(Test_FlowFieldMatchesReference);
+		REGISTER_TEST_SUITE_FN(Test_FlowFieldUpdateMatchesRebuild);
+		REGISTER_TEST_SUITE_FN(Test_FlowFieldCache);
+		REGISTER_TEST_SUITE_FN(Test_MovementRangeMatchesReference);
+		REGISTER_TEST_SUITE_FN(Test_MovementRangeBatch);
+		REGISTER_TEST_SUITE_FN(Test_CooperativeAgentsPassThroughGap);
+		REGISTER_TEST_SUITE_FN(Test_CooperativeAgentInDeadEnd);
+		REGISTER_TEST_SUITE_FN(Test_CooperativeGroupHasNoConflicts);
+		REGISTER_TEST_SUITE_FN(Test_LandmarkBoundsAreAdmissible);
+		REGISTER_TEST_SUITE_FN(Test_LandmarkPathsMatchPlainPaths);
+		REGISTER_TEST_SUITE_FN(Test_IncrementalPathsMatchPlainPaths);
+		REGISTER_TEST_SUITE_FN(Test_IncrementalPathRecoversFromWall);
+	}
+	
+	virtual EAutomationTestFlags GetTestFlags() const override
+	{
+		return EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter;
+	}
+	virtual bool IsStressTest() const { return false; }
+	virtual uint32 GetRequiredDeviceNum() const override { return 1; }
+
+protected:
+	virtual FString GetBeautifiedTestName() const override
+	{
+		// This string is what the editor uses to organize your test in the Automated tests browser.
+		return "HexEngine.Runtime.PathfindingTests";
+	}
+	virtual void GetTests(TArray<FString>& OutBeautifiedNames, TArray<FString>& OutTestCommands) const override
+	{
+		TArray<FString> TargetTestNames;
+		Tests.GetKeys(TargetTestNames);
+		for (const FString& TargetTestName : TargetTestNames)
+		{
+			OutBeautifiedNames.Add(TargetTestName);
+			OutTestCommands.Add(TargetTestName);
+		}
+	}
+	virtual bool RunTest(const FString& Parameters) override
+	{
+		TestFunction* CurrentTest = Tests.Find(Parameters);
+		if (!CurrentTest || !*CurrentTest)
+		{
+			HXLB_LOG(LogHxlbRuntime, Error, TEXT("Cannot find test: %s"), *Parameters);
+			return false;
+		}
+
+		FPathfindingTestSuite Suite(this);
+		(Suite.**CurrentTest)(); // Run the current test from the test suite.
+
+		return true;
+	}
+
+	TMap<FString, TestFunction> Tests;
+};
+
+namespace
+{
+	FHxlbPathfindingTests FHxlbPathfindingTestsInstance(TEXT("FHxlbPathfindingTests"));
+}
+
+#endif //WITH_EDITOR
@@ -0,0 +1,470 @@
+// Copyright © Mason Stevenson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the disclaimer
+// below) provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+// THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+// CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+// NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "HexLibRuntimeLoggingDefs.h"
+#include "Containers/Array.h"
+#include "Containers/UnrealString.h"
+#include "Foundation/HxlbDenseLayout.h"
+#include "Foundation/HxlbHexBitmap.h"
+#include "Foundation/HxlbHexMap.h"
+#include "FunctionLibraries/HxlbMath.h"
+#include "Macros/HexLibLoggingMacros.h"
+#include "Math/RandomStream.h"
+#include "Misc/AutomationTest.h"
+#include "UObject/Package.h"
+#include "Vision/HxlbCoverMap.h"
+#include "Vision/HxlbFieldOfView.h"
+#include "Vision/HxlbFogOfWar.h"
+
+#if WITH_EDITOR
+
+class FVisionTestSuite
+{
+public:
+	FVisionTestSuite(FAutomationTestBase* NewTestFramework): TestFramework(NewTestFramework)
+	{
+		// This constructor is run before each test.
+		Layout.InitHexagonal(16, 8);
+		Elevation.Init(0.0f, Layout.Num());
+		Opacity.Init(0.0f, Layout.Num());
+		FieldOfView.Init(16);
+	}
+
+	void Test_FlatMapSeesEverythingInRange()
+	{
+		FHxlbVisionObserver Observer;
+		Observer.Radius = 6;
+		
+		FHxlbHexBitmap Visible;
+		const int32 NumVisible = FieldOfView.Compute(GetField(), Observer, Visible);
+		TestFramework->TestEqual(TEXT("Whole radius is visible"), NumVisible, 3 * 6 * 7 + 1);
+		TestFramework->TestTrue(TEXT("Edge of the range"), Visible.Get(Layout.IndexOf(FIntPoint(6, 0))));
+		TestFramework->TestFalse(TEXT("Past the range"), Visible.Get(Layout.IndexOf(FIntPoint(7, 0))));
+
+		// Near the edge of the map, hexes off the map are skipped.
+		Observer.HexCoord = FIntPoint(14, 0);
+		TestFramework->TestTrue(TEXT("Clipped to the map"), FieldOfView.Compute(GetField(), Observer, Visible) < 3 * 6 * 7 + 1);
+	}
+
+	void Test_OpaqueHexesCastShadows()
+	{
+		// A wall three hexes east of the observer.
+		for (int32 R = -2; R <= 2; R++)
+		{
+			Opacity[Layout.IndexOf(FIntPoint(3 - (R > 0 ? R : 0), R))] = FHxlbFieldOfView::kOpaque;
+		}
+		
+		FHxlbVisionObserver Observer;
+		Observer.Radius = 10;
+		FHxlbHexBitmap Visible;
+		FieldOfView.Compute(GetField(), Observer, Visible);
+		
+		TestFramework->TestTrue(TEXT("Wall is visible"), Visible.Get(Layout.IndexOf(FIntPoint(3, 0))));
+		TestFramework->TestFalse(TEXT("Right behind the wall"), Visible.Get(Layout.IndexOf(FIntPoint(4, 0))));
+		TestFramework->TestFalse(TEXT("Far behind the wall"), Visible.Get(Layout.IndexOf(FIntPoint(9, 0))));
+		TestFramework->TestTrue(TEXT("Other side is visible"), Visible.Get(Layout.IndexOf(FIntPoint(-9, 0))));
+		
+		// A closed ring of opaque hexes hides everything past it.
+		for (int32 Index = 0; Index < Layout.Num(); Index++)
+		{
+			Opacity[Index] = UHxlbMath::AxialDistance(Layout.CoordOf(Index), FIntPoint::ZeroValue) == 4 ? FHxlbFieldOfView::kOpaque : 0.0f;
+		}
+		const int32 NumVisible = FieldOfView.Compute(GetField(), Observer, Visible);
+		TestFramework->TestEqual(TEXT("Nothing leaks through a closed ring"), NumVisible, 3 * 4 * 5 + 1);
+	}
+
+	void Test_ElevationBlocksAndRaises()
+	{
+		// A ridge two hexes east of the observer, three units high.
+		for (int32 R = -3; R <= 3; R++)
+		{
+			Elevation[Layout.IndexOf(FIntPoint(2 - (R > 0 ? R : 0), R))] = 3.0f;
+		}
+		
+		FHxlbVisionObserver Observer;
+		Observer.Radius = 10;
+		FHxlbHexBitmap Visible;
+		FieldOfView.Compute(GetField(), Observer, Visible);
+		TestFramework->TestTrue(TEXT("Ridge is visible"), Visible.Get(Layout.IndexOf(FIntPoint(2, 0))));
+		TestFramework->TestFalse(TEXT("Valley behind the ridge is hidden"), Visible.Get(Layout.IndexOf(FIntPoint(4, 0))));
+
+		// A tall enough target sticks out above the ridge.
+		Observer.TargetHeight = 20.0f;
+		FieldOfView.Compute(GetField(), Observer, Visible);
+		TestFramework->TestTrue(TEXT("Tall target is visible"), Visible.Get(Layout.IndexOf(FIntPoint(6, 0))));
+
+		// So does an observer standing on higher ground.
+		Observer.TargetHeight = 0.0f;
+		Elevation[Layout.IndexOf(FIntPoint::ZeroValue)] = 10.0f;
+		FieldOfView.Compute(GetField(), Observer, Visible);
+		TestFramework->TestTrue(TEXT("Observer on a hill sees past the ridge"), Visible.Get(Layout.IndexOf(FIntPoint(6, 0))));
+
+		// Trees are short walls on top of the ground.
+		Elevation.Init(0.0f, Layout.Num());
+		Opacity[Layout.IndexOf(FIntPoint(-2, 0))] = 2.0f;
+		Observer.EyeHeight = 1.0f;
+		FieldOfView.Compute(GetField(), Observer, Visible);
+		TestFramework->TestFalse(TEXT("Trees hide the ground behind them"), Visible.Get(Layout.IndexOf(FIntPoint(-4, 0))));
+		Observer.EyeHeight = 5.0f;
+		FieldOfView.Compute(GetField(), Observer, Visible);
+		TestFramework->TestTrue(TEXT("A tall observer sees over trees"), Visible.Get(Layout.IndexOf(FIntPoint(-4, 0))));
+	}
+
+	void Test_BatchMatchesSingleQueries()
+	{
+		for (int32 Index = 0; Index < Layout.Num(); Index++)
+		{
+			const uint32 Hash = static_cast<uint32>(Index) * 2654435761u;
+			Opacity[Index] = (Hash >> 28) < 2 ? FHxlbFieldOfView::kOpaque : 0.0f;
+			Elevation[Index] = static_cast<float>((Hash >> 20) % 4);
+		}
+
+		TArray<FHxlbVisionObserver> Observers;
+		for (int32 Index = 0; Index < Layout.Num(); Index += 13)
+		{
+			FHxlbVisionObserver& Observer = Observers.AddDefaulted_GetRef();
+			Observer.HexCoord = Layout.CoordOf(Index);
+			Observer.Radius = 2 + Index % 12;
+		}
+		
+		TArray<TArray<int32>> Batch;
+		FieldOfView.ComputeBatch(GetField(), Observers, Batch);
+		FHxlbHexBitmap Union;
+		FieldOfView.ComputeUnion(GetField(), Observers, Union);
+
+		int32 NumMismatches = 0;
+		FHxlbHexBitmap Expected(Layout.Num());
+		for (int32 ObserverIndex = 0; ObserverIndex < Observers.Num(); ObserverIndex++)
+		{
+			TArray<int32> Single;
+			FieldOfView.Compute(GetField(), Observers[ObserverIndex], Single);
+			NumMismatches += Single != Batch[ObserverIndex];
+			for (int32 DenseIndex : Single)
+			{
+				Expected.Set(DenseIndex);
+			}
+		}
+		TestFramework->TestEqual(TEXT("Batch matches single queries"), NumMismatches, 0);
+		TestFramework->TestTrue(TEXT("Union matches single queries"), Union == Expected);
+	}
+
+	void Test_FogOfWarMatchesFromScratch()
+	{
+		for (int32 Index = 0; Index < Layout.Num(); Index++)
+		{
+			const uint32 Hash = static_cast<uint32>(Index) * 2654435761u;
+			Opacity[Index] = (Hash >> 28) < 2 ? FHxlbFieldOfView::kOpaque : 0.0f;
+		}
+		
+		FHxlbFogOfWar Fog;
+		Fog.Init(Layout);
+		TMap<int32, TArray<FHxlbVisionObserver>> Expected;
+		auto SetObserver = [&](int32 PlayerId, int32 ObserverId, FIntPoint HexCoord, int32 Radius)
+		{
+			FHxlbVisionObserver Observer;
+			Observer.HexCoord = HexCoord;
+			Observer.Radius = Radius;
+			Fog.SetObserver(PlayerId, ObserverId, Observer);
+			TArray<FHxlbVisionObserver>& Observers = Expected.FindOrAdd(PlayerId);
+			Observers.SetNum(FMath::Max(Observers.Num(), ObserverId + 1));
+			Observers[ObserverId] = Observer;
+		};
+		
+		int32 NumChanged = 0;
+		FHxlbHexBitmap Previous(Layout.Num());
+		Fog.OnChanged.AddLambda([&](int32 PlayerId, TConstArrayView<int32> BecameVisible, TConstArrayView<int32> BecameHidden)
+		{
+			if (PlayerId == 0)
+			{
+				NumChanged += BecameVisible.Num() + BecameHidden.Num();
+			}
+		});
+
+		auto CheckPlayers = [&](const TCHAR* What)
+		{
+			Fog.Update(FieldOfView, GetField());
+			for (int32 PlayerId = 0; PlayerId < 2; PlayerId++)
+			{
+				FHxlbHexBitmap FromScratch;
+				FieldOfView.ComputeUnion(GetField(), Expected.FindOrAdd(PlayerId), FromScratch);
+				TestFramework->TestTrue(What, *Fog.GetVisible(PlayerId) == FromScratch);
+
+				FHxlbHexBitmap Seen = *Fog.GetEverSeen(PlayerId);
+				Seen &= FromScratch;
+				TestFramework->TestTrue(TEXT("Visible hexes have been seen"), Seen == FromScratch);
+			}
+
+			// The reported changes are exactly the difference to the previous update.
+			FHxlbHexBitmap Difference = Previous;
+			for (int32 DenseIndex : Fog.GetBecameVisible(0))
+			{
+				Difference.Set(DenseIndex);
+			}
+			for (int32 DenseIndex : Fog.GetBecameHidden(0))
+			{
+				Difference.Clear(DenseIndex);
+			}
+			TestFramework->TestTrue(TEXT("Changes lead from the previous state to the current one"), Difference == *Fog.GetVisible(0));
+			Previous = *Fog.GetVisible(0);
+		};
+
+		SetObserver(0, 0, FIntPoint(0, 0), 6);
+		SetObserver(0, 1, FIntPoint(4, -2), 5);
+		SetObserver(1, 0, FIntPoint(-8, 3), 7);
+		CheckPlayers(TEXT("Initial observers"));
+		TestFramework->TestTrue(TEXT("Changes were broadcast"), NumChanged > 0);
+
+		// Moving an observer, changing its range and moving the other one on top of it.
+		SetObserver(0, 0, FIntPoint(2, 2), 6);
+		SetObserver(0, 1, FIntPoint(2, 2), 3);
+		CheckPlayers(TEXT("Moved observers"));
+
+		NumChanged = 0;
+		Fog.Update(FieldOfView, GetField());
+		TestFramework->TestEqual(TEXT("Nothing changes without changes"), NumChanged, 0);
+		
+		TestFramework->TestTrue(TEXT("Removed observer"), Fog.RemoveObserver(0, 1));
+		Expected.FindChecked(0).SetNum(1);
+		CheckPlayers(TEXT("Removed observer"));
+
+		// Opening up the terrain around the first observer.
+		TArray<int32> ChangedIndices;
+		for (int32 Index = 0; Index < Layout.Num(); Index++)
+		{
+			if (Opacity[Index] != 0.0f && UHxlbMath::AxialDistance(Layout.CoordOf(Index), FIntPoint(2, 2)) <= 3)
+			{
+				Opacity[Index] = 0.0f;
+				ChangedIndices.Add(Index);
+			}
+		}
+		Fog.MarkHexesChanged(ChangedIndices);
+		CheckPlayers(TEXT("Terrain changed"));
+		TestFramework->TestTrue(TEXT("Hexes seen before stay seen"), Fog.WasSeen(0, Layout.IndexOf(FIntPoint(4, -2))));
+		TestFramework->TestFalse(TEXT("Hexes that nobody sees anymore are hidden"), Fog.IsVisible(0, Layout.IndexOf(FIntPoint(9, -4))));
+	}
+
+	void Test_CoverMapMatchesNeighborHeights()
+	{
+		FRandomStream Random(50);
+		for (int32 Index = 0; Index < Layout.Num(); Index++)
+		{
+			Elevation[Index] = static_cast<float>(Random.RandHelper(3));
+			Opacity[Index] = Random.FRand() < 0.05f ? FHxlbFieldOfView::kOpaque : Random.FRandRange(0.0f, 2.0f);
+		}
+
+		FHxlbCoverSettings Settings;
+		FHxlbCoverMap CoverMap;
+		CoverMap.Build(GetField(), Settings);
+		int32 NumMismatches = 0;
+		for (int32 DenseIndex = 0; DenseIndex < Layout.Num(); DenseIndex++)
+		{
+			for (int32 DirectionIndex = 0; DirectionIndex < 6; DirectionIndex++)
+			{
+				const int32 NeighborIndex = Layout.IndexOf(Layout.CoordOf(DenseIndex) + UHxlbMath::DirectionIndexToAxial(DirectionIndex));
+				EHxlbCoverLevel Expected = EHxlbCoverLevel::None;
+				if (NeighborIndex != INDEX_NONE)
+				{
+					const float Height = Opacity[NeighborIndex] == FHxlbFieldOfView::kOpaque
+						? TNumericLimits<float>::Max()
+						: Elevation[NeighborIndex] + Opacity[NeighborIndex] - Elevation[DenseIndex];
+					Expected = Height >= Settings.FullCoverHeight ? EHxlbCoverLevel::Full : Height >= Settings.HalfCoverHeight ? EHxlbCoverLevel::Half : EHxlbCoverLevel::None;
+				}
+				NumMismatches += CoverMap.GetCover(DenseIndex, DirectionIndex) != Expected;
+			}
+		}
+		TestFramework->TestEqual(TEXT("Cover matches the neighbor heights"), NumMismatches, 0);
+
+		// Raising and clearing a few hexes only recomputes around them.
+		for (int32 Step = 0; Step < 5; Step++)
+		{
+			TArray<int32> ChangedIndices;
+			for (int32 Change = 0; Change < 10; Change++)
+			{
+				const int32 DenseIndex = Random.RandHelper(Layout.Num());
+				Elevation[DenseIndex] = static_cast<float>(Random.RandHelper(3));
+				Opacity[DenseIndex] = Step % 2 ? FHxlbFieldOfView::kOpaque : 0.0f;
+				ChangedIndices.Add(DenseIndex);
+			}
+			CoverMap.MarkHexesChanged(ChangedIndices);
+			TestFramework->TestTrue(TEXT("Changes are pending"), CoverMap.NeedsUpdate());
+			CoverMap.Update(GetField(), Settings);
+			TestFramework->TestFalse(TEXT("Changes were applied"), CoverMap.NeedsUpdate());
+
+			FHxlbCoverMap FromScratch;
+			FromScratch.Build(GetField(), Settings);
+			TestFramework->TestTrue(TEXT("Updated cover matches a rebuild"), TArray<uint16>(CoverMap.GetValues()) == TArray<uint16>(FromScratch.GetValues()));
+		}
+
+		Settings.FullCoverHeight = 1.0f;
+		CoverMap.Update(GetField(), Settings);
+		FHxlbCoverMap FromScratch;
+		FromScratch.Build(GetField(), Settings);
+		TestFramework->TestTrue(TEXT("New settings rebuild the cover"), TArray<uint16>(CoverMap.GetValues()) == TArray<uint16>(FromScratch.GetValues()));
+	}
+
+	void Test_CoverFacesThreats()
+	{
+		TestFramework->TestEqual(TEXT("Threat straight ahead faces one edge"), static_cast<int32>(FHxlbCoverMap::GetFacingEdges(FIntPoint(0, 0), FIntPoint(5, 0))), 0b000001);
+		TestFramework->TestEqual(TEXT("Threat across a corner faces two edges"), static_cast<int32>(FHxlbCoverMap::GetFacingEdges(FIntPoint(0, 0), FIntPoint(2, -1))), 0b000011);
+		TestFramework->TestEqual(TEXT("Threat between directions faces the closer one"), static_cast<int32>(FHxlbCoverMap::GetFacingEdges(FIntPoint(1, 1), FIntPoint(-2, 5))), 0b010000);
+		TestFramework->TestEqual(TEXT("Threat on the hex faces nothing"), static_cast<int32>(FHxlbCoverMap::GetFacingEdges(FIntPoint(3, 3), FIntPoint(3, 3))), 0);
+
+		// A wall to the east of the origin and a low ridge to its west.
+		Opacity[Layout.IndexOf(FIntPoint(1, 0))] = FHxlbFieldOfView::kOpaque;
+		Elevation[Layout.IndexOf(FIntPoint(-1, 0))] = 1.0f;
+		FHxlbCoverMap CoverMap;
+		CoverMap.Build(GetField(), FHxlbCoverSettings());
+		
+		const int32 Origin = Layout.IndexOf(FIntPoint(0, 0));
+		TestFramework->TestTrue(TEXT("Full cover behind the wall"), CoverMap.GetCoverAgainst(Origin, FIntPoint(6, 0)) == EHxlbCoverLevel::Full);
+		TestFramework->TestTrue(TEXT("Either edge of a corner covers"), CoverMap.GetCoverAgainst(Origin, FIntPoint(4, -2)) == EHxlbCoverLevel::Full);
+		TestFramework->TestTrue(TEXT("Half cover behind the ridge"), CoverMap.GetCoverAgainst(Origin, FIntPoint(-6, 0)) == EHxlbCoverLevel::Half);
+		TestFramework->TestTrue(TEXT("No cover in the open"), CoverMap.GetCoverAgainst(Origin, FIntPoint(0, 6)) == EHxlbCoverLevel::None);
+
+		const FIntPoint Threats[] = {FIntPoint(6, 0), FIntPoint(-6, 0), FIntPoint(0, 6), FIntPoint(0, 0)};
+		TestFramework->TestEqual(TEXT("Exposed to threats without half cover"), CoverMap.CountExposures(Origin, Threats), 2);
+		TestFramework->TestEqual(TEXT("Exposed to threats without full cover"), CoverMap.CountExposures(Origin, Threats, EHxlbCoverLevel::Full), 3);
+		TestFramework->TestTrue(TEXT("Hexes on the ridge look down on the origin"), CoverMap.GetCover(Layout.IndexOf(FIntPoint(-1, 0)), 0) == EHxlbCoverLevel::None);
+		TestFramework->TestTrue(TEXT("Border edges have no cover"), CoverMap.GetCover(Layout.IndexOf(FIntPoint(16, 0)), 0) == EHxlbCoverLevel::None);
+	}
+
+	void Test_MapVisionFollowsAggregatedLayers()
+	{
+		UHxlbHexMapComponent* HexMap = NewObject<UHxlbHexMapComponent>(GetTransientPackage());
+		HexMap->MapSettings.Shape = EHexMapShape::Hexagonal;
+		HexMap->MapSettings.HaxagonalMapSettings.Radius = 8;
+		HexMap->MapSettings.VisionSettings.ElevationLayerName = TEXT("Elevation");
+		HexMap->RebuildDenseLayout();
+		const FHxlbDenseLayout& MapLayout = HexMap->GetDenseLayout();
+		THxlbHexLayer<float>* ElevationLayer = HexMap->FindOrAddLayer<float>(TEXT("Elevation"));
+
+		// The aggregate binds the elevation layer before vision does.
+		const FHxlbHexAggregate* Highest = HexMap->GetAggregate(TEXT("Elevation"), EHxlbAggregateOp::Max);
+		FHxlbVisionObserver Observer;
+		Observer.Radius = 6;
+		HexMap->GetFogOfWar().SetObserver(0, 0, Observer);
+		HexMap->UpdateFogOfWar();
+		TestFramework->TestTrue(TEXT("Flat map is visible"), HexMap->GetFogOfWar().IsVisible(0, MapLayout.IndexOf(FIntPoint(4, 0))));
+		TestFramework->TestTrue(TEXT("Flat map has no cover"), HexMap->GetCoverMap().GetCoverAgainst(MapLayout.IndexOf(FIntPoint(1, 0)), FIntPoint(6, 0)) == EHxlbCoverLevel::None);
+
+		// A ridge two hexes east of the observer.
+		for (int32 R = -3; R <= 3; R++)
+		{
+			ElevationLayer->Set(MapLayout.IndexOf(FIntPoint(2 - (R > 0 ? R : 0), R)), 3.0f);
+		}
+		ElevationLayer->CommitChanges();
+		HexMap->UpdateFogOfWar();
+		TestFramework->TestTrue(TEXT("Aggregate sees the ridge"), Highest && Highest->GetValues(HexMap->GetHexHierarchy().NumLevels() - 1).Contains(3.0f));
+		TestFramework->TestFalse(TEXT("Fog sees the ridge"), HexMap->GetFogOfWar().IsVisible(0, MapLayout.IndexOf(FIntPoint(4, 0))));
+		TestFramework->TestTrue(TEXT("Cover sees the ridge"), HexMap->GetCoverMap().GetCoverAgainst(MapLayout.IndexOf(FIntPoint(1, 0)), FIntPoint(6, 0)) == EHxlbCoverLevel::Full);
+	}
+
+	// IMPORTANT! Be sure to register your fn inside your AutomationTest class below!
+
+private:
+	FHxlbVisionField GetField() const
+	{
+		return FHxlbVisionField(Layout, Elevation, Opacity);
+	}
+	
+	FAutomationTestBase* TestFramework;
+	FHxlbDenseLayout Layout;
+	TArray<float> Elevation;
+	TArray<float> Opacity;
+	FHxlbFieldOfView FieldOfView;
+};
+
+#define REGISTER_TEST_SUITE_FN(TargetTestName) Tests.Add(TEXT(#TargetTestName), &FVisionTestSuite::TargetTestName)
+
+class FHxlbVisionTests: public FAutomationTestBase
+{
+public:
+	typedef void (FVisionTestSuite::*TestFunction)();
+	
+	FHxlbVisionTests(const FString& TestName): FAutomationTestBase(TestName, false)
+	{
+		REGISTER_TEST_SUITE_FN(Test_FlatMapSeesEverythingInRange);
+		REGISTER_TEST_SUITE_FN(Test_OpaqueHexesCastShadows);
+		REGISTER_TEST_SUITE_FN(Test_ElevationBlocksAndRaises);
+		REGISTER_TEST_SUITE_FN(Test_BatchMatchesSingleQueries);
+		REGISTER_TEST_SUITE_FN(Test_FogOfWarMatchesFromScratch);
+		REGISTER_TEST_SUITE_FN(Test_CoverMapMatchesNeighborHeights);
+		REGISTER_TEST_SUITE_FN(Test_CoverFacesThreats);
+		REGISTER_TEST_SUITE_FN(Test_MapVisionFollowsAggregatedLayers);
+	}
+	
+	virtual EAutomationTestFlags GetTestFlags() const override
+	{
+		return EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter;
+	}
+	virtual bool IsStressTest() const { return false; }
+	virtual uint32 GetRequiredDeviceNum() const override { return 1; }
+
+protected:
+	virtual FString GetBeautifiedTestName() const override
+	{
+		// This string is what the editor uses to organize your test in the Automated tests browser.
+		return "HexEngine.Runtime.VisionTests";
+	}
+	virtual void GetTests(TArray<FString>& OutBeautifiedNames, TArray<FString>& OutTestCommands) const override
+	{
+		TArray<FString> TargetTestNames;
+		Tests.GetKeys(TargetTestNames);
+		for (const FString& TargetTestName : TargetTestNames)
+		{
+			OutBeautifiedNames.Add(TargetTestName);
+			OutTestCommands.Add(TargetTestName);
+		}
+	}
+	virtual bool RunTest(const FString& Parameters) override
+	{
+		TestFunction* CurrentTest = Tests.Find(Parameters);
+		if (!CurrentTest || !*CurrentTest)
+		{
+			HXLB_LOG(LogHxlbRuntime, Error, TEXT("Cannot find test: %s"), *Parameters);
+			return false;
+		}
+
+		FVisionTestSuite Suite(this);
+		(Suite.**CurrentTest)(); // Run the current test from the test suite.
+
+		return true;
+	}
+
+	TMap<FString, TestFunction> Tests;
+};
+
+namespace
+{
+	FHxlbVisionTests FHxlbVisionTestsInstance(TEXT("FHxlbVisionTests"));
+}
+
+#endif //WITH_EDITOR
@@ -0,0 +1,195 @@
+// Copyright © Mason Stevenson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the disclaimer
+// below) provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+// THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+// CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+// NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "Vision/HxlbCoverMap.h"
+
+#include "Foundation/HxlbHexRanges.h"
+#include "FunctionLibraries/HxlbMath.h"
+
+using HexMath = UHxlbMath;
+
+void FHxlbCoverMap::Build(const FHxlbVisionField& Field, const FHxlbCoverSettings& NewSettings)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(HXLB_BuildCoverMap);
+	
+	Reset();
+	if (!Field.IsValid())
+	{
+		return;
+	}
+	
+	Layout = &Field.GetLayout();
+	Settings = NewSettings;
+	PackedCover.SetNumUninitialized(Layout->Num());
+	DirtyHexes.Init(Layout->Num());
+	HxlbParallelForEachHex(*Layout, [this, &Field](FIntPoint HexCoord, int32 DenseIndex)
+	{
+		PackedCover[DenseIndex] = ComputeHex(Field, HexCoord, DenseIndex);
+	});
+}
+
+void FHxlbCoverMap::Reset()
+{
+	Layout = nullptr;
+	PackedCover.Reset();
+	DirtyIndices.Reset();
+	DirtyHexes.Reset();
+	bAllDirty = false;
+}
+
+void FHxlbCoverMap::MarkHexesChanged(TConstArrayView<int32> DenseIndices)
+{
+	if (!Layout || bAllDirty)
+	{
+		return;
+	}
+
+	auto MarkDirty = [this](int32 DenseIndex)
+	{
+		if (DenseIndex != INDEX_NONE && !DirtyHexes.Get(DenseIndex))
+		{
+			DirtyHexes.Set(DenseIndex);
+			DirtyIndices.Add(DenseIndex);
+		}
+	};
+	for (int32 DenseIndex : DenseIndices)
+	{
+		// Neighbors read this hex across their shared edge.
+		const FIntPoint HexCoord = Layout->CoordOf(DenseIndex);
+		MarkDirty(DenseIndex);
+		for (int32 DirectionIndex = 0; DirectionIndex < 6; DirectionIndex++)
+		{
+			MarkDirty(Layout->IndexOf(HexCoord + HexMath::DirectionIndexToAxial(DirectionIndex)));
+		}
+	}
+}
+
+void FHxlbCoverMap::Update(const FHxlbVisionField& Field, const FHxlbCoverSettings& NewSettings)
+{
+	if (!Field.IsValid())
+	{
+		Reset();
+		return;
+	}
+	if (bAllDirty || Layout != &Field.GetLayout() || PackedCover.Num() != Field.GetLayout().Num() || Settings != NewSettings)
+	{
+		Build(Field, NewSettings);
+		return;
+	}
+
+	TRACE_CPUPROFILER_EVENT_SCOPE(HXLB_UpdateCoverMap);
+	
+	for (int32 DenseIndex : DirtyIndices)
+	{
+		PackedCover[DenseIndex] = ComputeHex(Field, Layout->CoordOf(DenseIndex), DenseIndex);
+		DirtyHexes.Clear(DenseIndex);
+	}
+	DirtyIndices.Reset();
+}
+
+EHxlbCoverLevel FHxlbCoverMap::GetCoverAgainst(int32 DenseIndex, FIntPoint ThreatCoord) const
+{
+	uint8 FacingEdges = GetFacingEdges(Layout->CoordOf(DenseIndex), ThreatCoord);
+	uint16 BestCover = 0;
+	while (FacingEdges)
+	{
+		const int32 DirectionIndex = FMath::CountTrailingZeros(FacingEdges);
+		BestCover = FMath::Max<uint16>(BestCover, (PackedCover[DenseIndex] >> (DirectionIndex * kBitsPerEdge)) & kEdgeMask);
+		FacingEdges &= FacingEdges - 1;
+	}
+	return static_cast<EHxlbCoverLevel>(BestCover);
+}
+
+int32 FHxlbCoverMap::CountExposures(int32 DenseIndex, TConstArrayView<FIntPoint> ThreatCoords, EHxlbCoverLevel MinCover) const
+{
+	int32 NumExposures = 0;
+	for (FIntPoint ThreatCoord : ThreatCoords)
+	{
+		NumExposures += GetCoverAgainst(DenseIndex, ThreatCoord) < MinCover;
+	}
+	return NumExposures;
+}
+
+uint8 FHxlbCoverMap::GetFacingEdges(FIntPoint HexCoord, FIntPoint ThreatCoord)
+{
+	// In cube coordinates, the dot product with each direction is proportional to how far the threat lies along that
+	// direction on the plane, so the edges facing the threat are the ones with the largest dot product. The opposite
+	// directions are the negated dot products. Ties only happen between neighboring directions, across a corner.
+	const int32 DeltaQ = HEX_Q(ThreatCoord) - HEX_Q(HexCoord);
+	const int32 DeltaR = HEX_R(ThreatCoord) - HEX_R(HexCoord);
+	const int32 DeltaS = -DeltaQ - DeltaR;
+	if (DeltaQ == 0 && DeltaR == 0)
+	{
+		return 0;
+	}
+	
+	const int32 Dots[6] = {DeltaQ - DeltaS, DeltaQ - DeltaR, DeltaS - DeltaR, DeltaS - DeltaQ, DeltaR - DeltaQ, DeltaR - DeltaS};
+	int32 BestDot = Dots[0];
+	for (int32 DirectionIndex = 1; DirectionIndex < 6; DirectionIndex++)
+	{
+		BestDot = FMath::Max(BestDot, Dots[DirectionIndex]);
+	}
+	
+	uint8 FacingEdges = 0;
+	for (int32 DirectionIndex = 0; DirectionIndex < 6; DirectionIndex++)
+	{
+		FacingEdges |= (Dots[DirectionIndex] == BestDot) << DirectionIndex;
+	}
+	return FacingEdges;
+}
+
+uint16 FHxlbCoverMap::ComputeHex(const FHxlbVisionField& Field, FIntPoint HexCoord, int32 DenseIndex) const
+{
+	const float Ground = Field.GetElevation(DenseIndex);
+	uint16 Packed = 0;
+	for (int32 DirectionIndex = 0; DirectionIndex < 6; DirectionIndex++)
+	{
+		const int32 NeighborIndex = Layout->IndexOf(HexCoord + HexMath::DirectionIndexToAxial(DirectionIndex));
+		if (NeighborIndex == INDEX_NONE)
+		{
+			continue;
+		}
+
+		EHxlbCoverLevel Level = EHxlbCoverLevel::None;
+		const float Opacity = Field.GetOpacity(NeighborIndex);
+		const float Height = Field.GetElevation(NeighborIndex) + Opacity - Ground;
+		if (Opacity >= FHxlbFieldOfView::kOpaque || Height >= Settings.FullCoverHeight)
+		{
+			Level = EHxlbCoverLevel::Full;
+		}
+		else if (Height >= Settings.HalfCoverHeight)
+		{
+			Level = EHxlbCoverLevel::Half;
+		}
+		Packed |= static_cast<uint16>(Level) << (DirectionIndex * kBitsPerEdge);
+	}
+	return Packed;
+}
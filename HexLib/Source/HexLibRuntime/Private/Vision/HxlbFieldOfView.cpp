@@ -0,0 +1,175 @@
+// Copyright © Mason Stevenson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the disclaimer
+// below) provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+// THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+// CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+// NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "Vision/HxlbFieldOfView.h"
+
+#include "Async/ParallelFor.h"
+#include "Foundation/HxlbHexIterators.h"
+
+void FHxlbFieldOfView::Init(int32 MaxRadius)
+{
+	RingOffsets.Reset();
+	RingStarts.Reset();
+	RingStarts.Add(0);
+	
+	for (int32 Radius = 1; Radius <= MaxRadius; Radius++)
+	{
+		// The iterator ends back on the hex it started from.
+		auto Iterator = FHxlbRingIterator(FIntPoint::ZeroValue, Radius);
+		const int32 RingStart = RingOffsets.Num();
+		while (Iterator.Next() && RingOffsets.Num() - RingStart < 6 * Radius)
+		{
+			RingOffsets.Add(Iterator.Get());
+		}
+		RingStarts.Add(RingOffsets.Num());
+	}
+}
+
+int32 FHxlbFieldOfView::Compute(const FHxlbVisionField& Field, const FHxlbVisionObserver& Observer, TArray<int32>& OutVisible) const
+{
+	const int32 OriginIndex = Field.IsValid() ? Field.GetLayout().IndexOf(Observer.HexCoord) : INDEX_NONE;
+	if (OriginIndex == INDEX_NONE)
+	{
+		return 0;
+	}
+	const int32 FirstVisible = OutVisible.Num();
+	OutVisible.Add(OriginIndex);
+
+	const FHxlbDenseLayout& Layout = Field.GetLayout();
+	const int32 Radius = FMath::Clamp(Observer.Radius, 0, GetMaxRadius());
+	const float EyeElevation = Field.GetElevation(OriginIndex) + Observer.EyeHeight;
+	
+	// Bins are sized by the observer's own radius, so results don't depend on how far the table was initialized.
+	const int32 NumBins = FMath::Max(1, 6 * kBinsPerOuterHex * Radius);
+	static thread_local TArray<float> Horizon;
+	static thread_local TArray<float> RingSlopes;
+	Horizon.Init(TNumericLimits<float>::Lowest(), NumBins);
+
+	auto BinRange = [](double First, double Last, int32& OutFirst, int32& OutLast)
+	{
+		OutFirst = FMath::FloorToInt32(First);
+		OutLast = FMath::Max(OutFirst, FMath::CeilToInt32(Last) - 1);
+	};
+	auto WrapBin = [NumBins](int32 Bin)
+	{
+		return Bin < 0 ? Bin + NumBins : (Bin >= NumBins ? Bin - NumBins : Bin);
+	};
+	
+	for (int32 Ring = 1; Ring <= Radius; Ring++)
+	{
+		const double BinsPerHex = static_cast<double>(NumBins) / (6.0 * Ring);
+		const int32 RingStart = RingStarts[Ring - 1];
+		const int32 RingSize = 6 * Ring;
+		RingSlopes.SetNumUninitialized(RingSize, EAllowShrinking::No);
+
+		// Test the whole ring against the horizon before any of it raises the horizon, so that hexes of the same ring
+		// never hide each other.
+		for (int32 Position = 0; Position < RingSize; Position++)
+		{
+			const int32 DenseIndex = Layout.IndexOf(Observer.HexCoord + RingOffsets[RingStart + Position]);
+			if (DenseIndex == INDEX_NONE)
+			{
+				RingSlopes[Position] = TNumericLimits<float>::Lowest();
+				continue;
+			}
+			
+			const double Center = Position * BinsPerHex;
+			const float TargetSlope = (Field.GetElevation(DenseIndex) + Observer.TargetHeight - EyeElevation) / Ring;
+			int32 FirstBin, LastBin;
+			BinRange(Center - BinsPerHex / 4.0, Center + BinsPerHex / 4.0, FirstBin, LastBin);
+			for (int32 Bin = FirstBin; Bin <= LastBin; Bin++)
+			{
+				if (Horizon[WrapBin(Bin)] <= TargetSlope)
+				{
+					OutVisible.Add(DenseIndex);
+					break;
+				}
+			}
+
+			const float Opacity = Field.GetOpacity(DenseIndex);
+			RingSlopes[Position] = Opacity >= kOpaque ? kOpaque : (Field.GetElevation(DenseIndex) + Opacity - EyeElevation) / Ring;
+		}
+		
+		for (int32 Position = 0; Position < RingSize; Position++)
+		{
+			const double Center = Position * BinsPerHex;
+			int32 FirstBin, LastBin;
+			BinRange(Center - BinsPerHex / 2.0, Center + BinsPerHex / 2.0, FirstBin, LastBin);
+			for (int32 Bin = FirstBin; Bin <= LastBin; Bin++)
+			{
+				float& BinHorizon = Horizon[WrapBin(Bin)];
+				BinHorizon = FMath::Max(BinHorizon, RingSlopes[Position]);
+			}
+		}
+	}
+	
+	return OutVisible.Num() - FirstVisible;
+}
+
+int32 FHxlbFieldOfView::Compute(const FHxlbVisionField& Field, const FHxlbVisionObserver& Observer, FHxlbHexBitmap& OutVisible) const
+{
+	static thread_local TArray<int32> Visible;
+	Visible.Reset();
+	OutVisible.Init(Field.IsValid() ? Field.GetLayout().Num() : 0);
+	Compute(Field, Observer, Visible);
+	for (int32 DenseIndex : Visible)
+	{
+		OutVisible.Set(DenseIndex);
+	}
+	return Visible.Num();
+}
+
+void FHxlbFieldOfView::ComputeBatch(const FHxlbVisionField& Field, TConstArrayView<FHxlbVisionObserver> Observers, TArray<TArray<int32>>& OutVisible) const
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(HXLB_ComputeFieldOfViewBatch);
+	
+	OutVisible.SetNum(Observers.Num());
+	ParallelFor(Observers.Num(), [this, &Field, &Observers, &OutVisible](int32 ObserverIndex)
+	{
+		OutVisible[ObserverIndex].Reset();
+		Compute(Field, Observers[ObserverIndex], OutVisible[ObserverIndex]);
+	});
+}
+
+void FHxlbFieldOfView::ComputeUnion(const FHxlbVisionField& Field, TConstArrayView<FHxlbVisionObserver> Observers, FHxlbHexBitmap& OutVisible) const
+{
+	TArray<TArray<int32>> Visible;
+	ComputeBatch(Field, Observers, Visible);
+	
+	OutVisible.Init(Field.IsValid() ? Field.GetLayout().Num() : 0);
+	for (const TArray<int32>& ObserverVisible : Visible)
+	{
+		for (int32 DenseIndex : ObserverVisible)
+		{
+			OutVisible.Set(DenseIndex);
+		}
+	}
+}
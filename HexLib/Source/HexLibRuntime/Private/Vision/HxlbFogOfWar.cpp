@@ -0,0 +1,320 @@
+// Copyright © Mason Stevenson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the disclaimer
+// below) provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+// THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+// CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+// NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "Vision/HxlbFogOfWar.h"
+
+#include "Async/ParallelFor.h"
+#include "FunctionLibraries/HxlbMath.h"
+
+using HexMath = UHxlbMath;
+
+void FHxlbFogOfWar::Init(const FHxlbDenseLayout& NewLayout)
+{
+	Layout = &NewLayout;
+	for (auto& PlayerKV : Players)
+	{
+		FPlayerState& Player = PlayerKV.Value;
+		Player.RefCounts.Init(0, Layout->Num());
+		Player.Visible.Init(Layout->Num());
+		Player.EverSeen.Init(Layout->Num());
+		Player.PendingRemovals.Reset();
+		Player.BecameVisible.Reset();
+		Player.BecameHidden.Reset();
+		for (auto& ObserverKV : Player.Observers)
+		{
+			ObserverKV.Value.Visible.Reset();
+			ObserverKV.Value.bDirty = true;
+		}
+	}
+}
+
+FHxlbFogOfWar::FPlayerState& FHxlbFogOfWar::FindOrAddPlayer(int32 PlayerId)
+{
+	if (FPlayerState* Player = Players.Find(PlayerId))
+	{
+		return *Player;
+	}
+	
+	FPlayerState& Player = Players.Add(PlayerId);
+	const int32 NumHexes = Layout ? Layout->Num() : 0;
+	Player.RefCounts.Init(0, NumHexes);
+	Player.Visible.Init(NumHexes);
+	Player.EverSeen.Init(NumHexes);
+	return Player;
+}
+
+void FHxlbFogOfWar::SetObserver(int32 PlayerId, int32 ObserverId, const FHxlbVisionObserver& Observer)
+{
+	FObserverState& State = FindOrAddPlayer(PlayerId).Observers.FindOrAdd(ObserverId);
+	if (State.Observer != Observer || State.Visible.IsEmpty())
+	{
+		State.Observer = Observer;
+		State.bDirty = true;
+	}
+}
+
+bool FHxlbFogOfWar::RemoveObserver(int32 PlayerId, int32 ObserverId)
+{
+	FPlayerState* Player = Players.Find(PlayerId);
+	FObserverState* State = Player ? Player->Observers.Find(ObserverId) : nullptr;
+	if (!State)
+	{
+		return false;
+	}
+
+	Player->PendingRemovals.Append(State->Visible);
+	Player->Observers.Remove(ObserverId);
+	return true;
+}
+
+void FHxlbFogOfWar::RemovePlayer(int32 PlayerId)
+{
+	Players.Remove(PlayerId);
+}
+
+void FHxlbFogOfWar::MarkHexesChanged(TConstArrayView<int32> DenseIndices)
+{
+	if (!Layout || DenseIndices.IsEmpty())
+	{
+		return;
+	}
+
+	TArray<FIntPoint> ChangedCoords;
+	ChangedCoords.Reserve(DenseIndices.Num());
+	for (int32 DenseIndex : DenseIndices)
+	{
+		ChangedCoords.Add(Layout->CoordOf(DenseIndex));
+	}
+	
+	for (auto& PlayerKV : Players)
+	{
+		for (auto& ObserverKV : PlayerKV.Value.Observers)
+		{
+			FObserverState& State = ObserverKV.Value;
+			for (int32 ChangedIndex = 0; ChangedIndex < ChangedCoords.Num() && !State.bDirty; ChangedIndex++)
+			{
+				State.bDirty = HexMath::AxialDistanceFast(ChangedCoords[ChangedIndex], State.Observer.HexCoord) <= State.Observer.Radius;
+			}
+		}
+	}
+}
+
+void FHxlbFogOfWar::MarkAllChanged()
+{
+	for (auto& PlayerKV : Players)
+	{
+		for (auto& ObserverKV : PlayerKV.Value.Observers)
+		{
+			ObserverKV.Value.bDirty = true;
+		}
+	}
+}
+
+bool FHxlbFogOfWar::NeedsUpdate() const
+{
+	for (const auto& PlayerKV : Players)
+	{
+		if (!PlayerKV.Value.PendingRemovals.IsEmpty())
+		{
+			return true;
+		}
+		for (const auto& ObserverKV : PlayerKV.Value.Observers)
+		{
+			if (ObserverKV.Value.bDirty)
+			{
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+int32 FHxlbFogOfWar::GetMaxObserverRadius() const
+{
+	int32 MaxRadius = 0;
+	for (const auto& PlayerKV : Players)
+	{
+		for (const auto& ObserverKV : PlayerKV.Value.Observers)
+		{
+			MaxRadius = FMath::Max(MaxRadius, ObserverKV.Value.Observer.Radius);
+		}
+	}
+	return MaxRadius;
+}
+
+void FHxlbFogOfWar::Update(const FHxlbFieldOfView& FieldOfView, const FHxlbVisionField& Field)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(HXLB_UpdateFogOfWar);
+	
+	if (!Layout || !Field.IsValid() || &Field.GetLayout() != Layout)
+	{
+		return;
+	}
+
+	TArray<FObserverState*> DirtyStates;
+	TArray<FHxlbVisionObserver> DirtyObservers;
+	for (auto& PlayerKV : Players)
+	{
+		for (auto& ObserverKV : PlayerKV.Value.Observers)
+		{
+			if (ObserverKV.Value.bDirty)
+			{
+				DirtyStates.Add(&ObserverKV.Value);
+				DirtyObservers.Add(ObserverKV.Value.Observer);
+			}
+		}
+	}
+
+	// New contributions are computed before any count is touched, so that each player can swap old for new in one go.
+	TArray<TArray<int32>> NewVisible;
+	FieldOfView.ComputeBatch(Field, DirtyObservers, NewVisible);
+
+	TArray<FPlayerState*> PlayerList;
+	for (auto& PlayerKV : Players)
+	{
+		PlayerList.Add(&PlayerKV.Value);
+	}
+	
+	// Players don't share any state, so they are applied in parallel.
+	TMap<const FObserverState*, int32> NewVisibleOf;
+	for (int32 DirtyIndex = 0; DirtyIndex < DirtyStates.Num(); DirtyIndex++)
+	{
+		NewVisibleOf.Add(DirtyStates[DirtyIndex], DirtyIndex);
+	}
+	ParallelFor(PlayerList.Num(), [this, &PlayerList, &NewVisible, &NewVisibleOf](int32 PlayerIndex)
+	{
+		FPlayerState& Player = *PlayerList[PlayerIndex];
+		TArray<const TArray<int32>*> Added;
+		for (auto& ObserverKV : Player.Observers)
+		{
+			if (const int32* DirtyIndex = NewVisibleOf.Find(&ObserverKV.Value))
+			{
+				Player.PendingRemovals.Append(ObserverKV.Value.Visible);
+				ObserverKV.Value.Visible = MoveTemp(NewVisible[*DirtyIndex]);
+				ObserverKV.Value.bDirty = false;
+				Added.Add(&ObserverKV.Value.Visible);
+			}
+		}
+		ApplyChanges(Player, Added);
+	});
+	
+	for (auto& PlayerKV : Players)
+	{
+		if (!PlayerKV.Value.BecameVisible.IsEmpty() || !PlayerKV.Value.BecameHidden.IsEmpty())
+		{
+			OnChanged.Broadcast(PlayerKV.Key, PlayerKV.Value.BecameVisible, PlayerKV.Value.BecameHidden);
+		}
+	}
+}
+
+void FHxlbFogOfWar::ApplyChanges(FPlayerState& Player, TConstArrayView<const TArray<int32>*> Added)
+{
+	Player.BecameVisible.Reset();
+	Player.BecameHidden.Reset();
+
+	// A hex can be touched several times, but only the first visit can flip its bit.
+	TArray<int32> Touched;
+	for (int32 DenseIndex : Player.PendingRemovals)
+	{
+		check(Player.RefCounts[DenseIndex] > 0);
+		Player.RefCounts[DenseIndex]--;
+		Touched.Add(DenseIndex);
+	}
+	Player.PendingRemovals.Reset();
+	
+	for (const TArray<int32>* Contribution : Added)
+	{
+		for (int32 DenseIndex : *Contribution)
+		{
+			check(Player.RefCounts[DenseIndex] < TNumericLimits<uint16>::Max());
+			Player.RefCounts[DenseIndex]++;
+			Touched.Add(DenseIndex);
+		}
+	}
+
+	for (int32 DenseIndex : Touched)
+	{
+		const bool bIsVisible = Player.RefCounts[DenseIndex] > 0;
+		if (bIsVisible == Player.Visible.Get(DenseIndex))
+		{
+			continue;
+		}
+		
+		Player.Visible.SetTo(DenseIndex, bIsVisible);
+		if (bIsVisible)
+		{
+			Player.EverSeen.Set(DenseIndex);
+			Player.BecameVisible.Add(DenseIndex);
+		}
+		else
+		{
+			Player.BecameHidden.Add(DenseIndex);
+		}
+	}
+	Player.BecameVisible.Sort();
+	Player.BecameHidden.Sort();
+}
+
+bool FHxlbFogOfWar::IsVisible(int32 PlayerId, int32 DenseIndex) const
+{
+	const FHxlbHexBitmap* Visible = GetVisible(PlayerId);
+	return Visible && DenseIndex >= 0 && DenseIndex < Visible->Num() && Visible->Get(DenseIndex);
+}
+
+bool FHxlbFogOfWar::WasSeen(int32 PlayerId, int32 DenseIndex) const
+{
+	const FHxlbHexBitmap* EverSeen = GetEverSeen(PlayerId);
+	return EverSeen && DenseIndex >= 0 && DenseIndex < EverSeen->Num() && EverSeen->Get(DenseIndex);
+}
+
+const FHxlbHexBitmap* FHxlbFogOfWar::GetVisible(int32 PlayerId) const
+{
+	const FPlayerState* Player = Players.Find(PlayerId);
+	return Player ? &Player->Visible : nullptr;
+}
+
+const FHxlbHexBitmap* FHxlbFogOfWar::GetEverSeen(int32 PlayerId) const
+{
+	const FPlayerState* Player = Players.Find(PlayerId);
+	return Player ? &Player->EverSeen : nullptr;
+}
+
+TConstArrayView<int32> FHxlbFogOfWar::GetBecameVisible(int32 PlayerId) const
+{
+	const FPlayerState* Player = Players.Find(PlayerId);
+	return Player ? TConstArrayView<int32>(Player->BecameVisible) : TConstArrayView<int32>();
+}
+
+TConstArrayView<int32> FHxlbFogOfWar::GetBecameHidden(int32 PlayerId) const
+{
+	const FPlayerState* Player = Players.Find(PlayerId);
+	return Player ? TConstArrayView<int32>(Player->BecameHidden) : TConstArrayView<int32>();
+}
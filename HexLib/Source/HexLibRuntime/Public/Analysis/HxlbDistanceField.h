@@ -0,0 +1,104 @@
+// Copyright © Mason Stevenson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the disclaimer
+// below) provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+// THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+// CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+// NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+#include "Containers/Array.h"
+#include "Foundation/HxlbDenseLayout.h"
+#include "Navigation/HxlbCostField.h"
+#include "Navigation/HxlbSearchScratch.h"
+
+// Distance from every hex to the nearest of a set of source hexes, e.g. the distance to the nearest enemy city or to
+// the coast, along with which source is the nearest. Ties go to the source with the smaller dense index, so the result
+// doesn't depend on the order sources were added in.
+//
+// Unweighted fields count steps between neighbors, which is UHxlbMath::AxialDistance() to the nearest source on maps
+// without holes. They are built by a breadth first search that expands each ring of the frontier in parallel. Weighted
+// fields add up the cost of entering each hex of a cost field, skip blocked hexes, and are built by a multi-source
+// Dijkstra search.
+//
+// Adding a source only lowers distances, so the search runs outward from it while it improves on what is there.
+// Removing one clears the hexes it was nearest to and searches into them again from their neighbors. Either way, work is
+// proportional to the area whose nearest source changed.
+class HEXLIBRUNTIME_API FHxlbDistanceField
+{
+public:
+	static constexpr float Unreachable = TNumericLimits<float>::Max();
+
+	// The layout, or the cost field's layout and costs, must outlive the field.
+	void Build(const FHxlbDenseLayout& NewLayout, TConstArrayView<int32> SourceIndices);
+	void Build(const FHxlbCostField& NewCostField, TConstArrayView<int32> SourceIndices);
+	void Reset();
+	bool IsBuilt() const { return Layout != nullptr; }
+	bool IsWeighted() const { return CostField.IsValid(); }
+
+	void AddSources(TConstArrayView<int32> SourceIndices);
+	void RemoveSources(TConstArrayView<int32> SourceIndices);
+	bool IsSource(int32 DenseIndex) const;
+	TConstArrayView<int32> GetSources() const { return Sources; }
+
+	// Unreachable if there are no sources, or none that can reach the hex.
+	FORCEINLINE float GetDistance(int32 DenseIndex) const { return Distances[DenseIndex]; }
+	TConstArrayView<float> GetDistances() const { return Distances; }
+
+	// Dense index of the nearest source, or INDEX_NONE if there is none.
+	FORCEINLINE int32 GetNearestSource(int32 DenseIndex) const { return NearestSources[DenseIndex]; }
+
+	// Hexes whose distance or nearest source changed during the last AddSources() or RemoveSources(), in no particular
+	// order. Empty after a build, which changes everything.
+	TConstArrayView<int32> GetUpdatedHexes() const { return UpdatedHexes; }
+
+protected:
+	void Init(TConstArrayView<int32> SourceIndices);
+	void ClearUpdatedHexes();
+	void BuildUnweighted();
+
+	// Dijkstra search from every hex in the heap, ordered by (distance, nearest source).
+	void Propagate();
+	
+	FORCEINLINE float StepCost(int32 DenseIndex) const { return IsWeighted() ? CostField.GetCost(DenseIndex) : 1.0f; }
+	FORCEINLINE bool IsBetter(float Distance, int32 Source, int32 DenseIndex) const
+	{
+		return Distance < Distances[DenseIndex] || (Distance == Distances[DenseIndex] && Source < NearestSources[DenseIndex]);
+	}
+	void SetHex(int32 DenseIndex, float Distance, int32 Source);
+
+	const FHxlbDenseLayout* Layout = nullptr;
+	FHxlbCostField CostField;
+
+	// Sorted.
+	TArray<int32> Sources;
+	TArray<float> Distances;
+	TArray<int32> NearestSources;
+	
+	FHxlbNodeHeap Heap;
+	TArray<int32> UpdatedHexes;
+	TArray<uint8> UpdatedMask;
+};
@@ -0,0 +1,105 @@
+// Copyright © Mason Stevenson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the disclaimer
+// below) provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+// THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+// CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+// NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+#include "Foundation/HxlbHexHierarchy.h"
+#include "Templates/Function.h"
+
+#include "HxlbHexAggregate.generated.h"
+
+UENUM(BlueprintType)
+enum class EHxlbAggregateOp : uint8
+{
+	Sum,
+	Mean,
+	Min,
+	Max,
+	
+	// Most common value among the leaves, e.g. the dominant terrain type. Values are rounded to integers first, and
+	// ties go to the smaller value.
+	Dominant
+};
+
+// Aggregate of a per-hex value over every level of a hex hierarchy, e.g. the total population or the highest threat of
+// each super-hex. Super-hexes without leaves read as zero.
+//
+// Each super-hex is computed from its (at most seven) children, and Dominant additionally keeps a small histogram per
+// super-hex. Leaf edits only recompute the ancestors of the edited leaves, level by level, and stop climbing where an
+// ancestor doesn't change. Nothing is ever adjusted by a difference, so values don't drift.
+class HEXLIBRUNTIME_API FHxlbHexAggregate
+{
+public:
+	using FValueFunction = TFunctionRef<float(int32 /* LeafIndex */)>;
+
+	// The hierarchy must outlive the aggregate.
+	void Build(const FHxlbHexHierarchy& NewHierarchy, EHxlbAggregateOp NewOp, FValueFunction ValueOf);
+	void Reset();
+	bool IsBuilt() const { return Hierarchy != nullptr; }
+	EHxlbAggregateOp GetOp() const { return Op; }
+	
+	// Reads the changed leaves again and recomputes their ancestors.
+	void Update(TConstArrayView<int32> ChangedLeaves, FValueFunction ValueOf);
+
+	// Level 0 holds the leaf values themselves.
+	FORCEINLINE float GetValue(int32 Level, int32 DenseIndex) const { return LevelValues[Level][DenseIndex]; }
+	TConstArrayView<float> GetValues(int32 Level) const { return LevelValues[Level]; }
+
+	// Hexes of the level whose value changed during the last Update(), in ascending order.
+	TConstArrayView<int32> GetUpdatedHexes(int32 Level) const { return UpdatedHexes[Level]; }
+
+	// Coarse to fine search: descends from the top level into every super-hex whose value passes the predicate, and
+	// appends the leaves that pass it. Only finds every matching leaf if a super-hex passes whenever any of its leaves
+	// does, e.g. Max with "at least X", Min with "at most X" or Sum of non-negative values with "above zero".
+	void FindLeaves(TFunctionRef<bool(float /* Value */)> Predicate, TArray<int32>& OutLeaves) const;
+
+protected:
+	struct FCategoryCount
+	{
+		int32 Category;
+		int32 Count;
+
+		bool operator==(const FCategoryCount& Other) const { return Category == Other.Category && Count == Other.Count; }
+	};
+	using FHistogram = TArray<FCategoryCount, TInlineAllocator<4>>;
+
+	// Returns true if the value or the histogram of the super-hex changed.
+	bool Recompute(int32 Level, int32 DenseIndex);
+	void FindLeavesRecursive(int32 Level, int32 DenseIndex, TFunctionRef<bool(float)> Predicate, TArray<int32>& OutLeaves) const;
+
+	const FHxlbHexHierarchy* Hierarchy = nullptr;
+	EHxlbAggregateOp Op = EHxlbAggregateOp::Sum;
+	TArray<TArray<float>> LevelValues;
+
+	// Dominant only, from level 1 up.
+	TArray<TArray<FHistogram>> LevelHistograms;
+	
+	TArray<TArray<int32>> UpdatedHexes;
+};
@@ -0,0 +1,162 @@
+// Copyright © Mason Stevenson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the disclaimer
+// below) provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+// THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+// CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+// NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+#include "Containers/Map.h"
+#include "Foundation/HxlbDenseLayout.h"
+#include "Navigation/HxlbCostField.h"
+
+#include "HxlbInfluenceMap.generated.h"
+
+UENUM(BlueprintType)
+enum class EHxlbInfluenceFalloff : uint8
+{
+	// Full strength on every hex in range.
+	Constant,
+	
+	// Drops by the same amount with every step, reaching zero one step past the radius.
+	Linear,
+	
+	// Multiplied by Decay with every step.
+	Exponential
+};
+
+USTRUCT(BlueprintType)
+struct HEXLIBRUNTIME_API FHxlbInfluenceSource
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta=(ClampMin="0"), Category="Influence")
+	int32 Faction = 0;
+	
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Influence")
+	FIntPoint HexCoord = FIntPoint::ZeroValue;
+
+	// Influence on the source's own hex. May be negative.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Influence")
+	float Strength = 1.0f;
+
+	// Hexes further away than this, in steps, get nothing.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta=(ClampMin="0"), Category="Influence")
+	int32 Radius = 5;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Influence")
+	EHxlbInfluenceFalloff Falloff = EHxlbInfluenceFalloff::Linear;
+	
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta=(EditCondition="Falloff == EHxlbInfluenceFalloff::Exponential", ClampMin="0", ClampMax="1"), Category="Influence")
+	float Decay = 0.5f;
+
+	// If true, influence spreads around hexes that block movement instead of through them, and blocked hexes get none.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Influence")
+	bool bBlockedByTerrain = true;
+
+	float GetInfluenceAt(int32 Steps) const;
+
+	bool operator==(const FHxlbInfluenceSource& Other) const
+	{
+		return Faction == Other.Faction && HexCoord == Other.HexCoord && Strength == Other.Strength && Radius == Other.Radius
+			&& Falloff == Other.Falloff && Decay == Other.Decay && bBlockedByTerrain == Other.bBlockedByTerrain;
+	}
+	bool operator!=(const FHxlbInfluenceSource& Other) const { return !(*this == Other); }
+};
+
+// Per-faction influence over every hex of a dense layout: the sum, over all of the faction's sources, of each source's
+// strength after falloff. Summing the influence of the other factions gives a threat map.
+//
+// Each source keeps its own contribution, sorted by chunk. Sources that changed are recomputed in parallel, by a
+// bounded breadth-first search around blocked hexes or by walking the rows of their range when terrain doesn't matter.
+// Then every chunk touched by an old or a new contribution is summed again from scratch, also in parallel. Moving a few
+// units only recomputes those units and the chunks around them, and nothing accumulates rounding errors over time.
+class HEXLIBRUNTIME_API FHxlbInfluenceMap
+{
+public:
+	// Sizes every faction to the layout. Sources are kept and recomputed on the next update.
+	void Init(const FHxlbDenseLayout& NewLayout);
+	bool IsInitialized() const { return Layout != nullptr; }
+
+	// Adds or changes a source. Nothing is recomputed until Update().
+	void SetSource(int32 SourceId, const FHxlbInfluenceSource& Source);
+	bool RemoveSource(int32 SourceId);
+	void Reset();
+
+	// Recomputes sources blocked by terrain that could reach any of the hexes, e.g. after movement costs changed.
+	void MarkHexesChanged(TConstArrayView<int32> DenseIndices);
+	void MarkAllChanged();
+
+	bool NeedsUpdate() const;
+
+	// Brings every faction up to date. CostField may be invalid, in which case no hex blocks influence.
+	void Update(const FHxlbCostField& CostField);
+
+	// Chunks whose values changed during the last Update(), in ascending order.
+	TConstArrayView<int32> GetUpdatedChunks() const { return UpdatedChunks; }
+
+	// Zero for factions without sources.
+	float GetInfluence(int32 Faction, int32 DenseIndex) const;
+
+	// Sum of the influence of every other faction.
+	float GetOpposingInfluence(int32 Faction, int32 DenseIndex) const;
+
+	// Influence of the faction on every hex, by dense index. Empty for factions that never had a source.
+	TConstArrayView<float> GetValues(int32 Faction) const;
+
+protected:
+	struct FContribution
+	{
+		int32 Chunk;
+		int32 Index;
+		float Value;
+	};
+	
+	struct FSourceState
+	{
+		FHxlbInfluenceSource Source;
+
+		// Sorted by chunk, then by dense index.
+		TArray<FContribution> Contributions;
+		bool bDirty = true;
+	};
+
+	void ComputeContributions(const FHxlbCostField& CostField, FSourceState& State) const;
+	void MarkChunksDirty(const FSourceState& State);
+	int32 FindOrAddFaction(int32 Faction);
+
+	const FHxlbDenseLayout* Layout = nullptr;
+	TMap<int32, FSourceState> Sources;
+
+	// Faction id to index into FactionValues.
+	TMap<int32, int32> FactionSlots;
+	TArray<TArray<float>> FactionValues;
+	
+	TArray<uint8> DirtyChunks;
+	TArray<int32> UpdatedChunks;
+	bool bAllChunksDirty = false;
+};
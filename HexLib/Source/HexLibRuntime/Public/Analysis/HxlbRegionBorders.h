@@ -0,0 +1,109 @@
+// Copyright © Mason Stevenson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the disclaimer
+// below) provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+// THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+// CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+// NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+#include "Containers/Map.h"
+#include "Containers/Set.h"
+#include "Foundation/HxlbDenseLayout.h"
+
+#include "HxlbRegionBorders.generated.h"
+
+// One closed border line. The last point connects back to the first.
+USTRUCT(BlueprintType)
+struct HEXLIBRUNTIME_API FHxlbBorderLoop
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Borders")
+	TArray<FVector> Points;
+};
+
+// Border of one region: one or more closed loops of hex corners. Outer borders run counterclockwise around the region
+// and the borders of holes run clockwise, so the region is always on the same side of the line.
+struct HEXLIBRUNTIME_API FHxlbRegionBorder
+{
+public:
+	int32 NumLoops() const { return LoopStarts.Num(); }
+	TConstArrayView<FVector> GetLoop(int32 LoopIndex) const
+	{
+		const int32 LoopEnd = LoopIndex + 1 < LoopStarts.Num() ? LoopStarts[LoopIndex + 1] : Vertices.Num();
+		return TConstArrayView<FVector>(Vertices.GetData() + LoopStarts[LoopIndex], LoopEnd - LoopStarts[LoopIndex]);
+	}
+
+	// Corners of every loop, back to back, in the same space as UHxlbMath::AxialToWorld().
+	TArray<FVector> Vertices;
+	TArray<int32> LoopStarts;
+
+	// Hex edges on the border, as DenseIndex * 6 + DirectionIndex of the hex inside of the region.
+	TSet<int32> Edges;
+};
+
+// Borders of every region of a region id layer, where hexes with the same id belong to the same region.
+//
+// Each region keeps the set of hex edges between it and the rest of the map. When hexes change region, only their own
+// edges and the edges of their neighbors facing them are added to or taken out of those sets, and only the regions that
+// gained or lost edges chain their edges into loops again. The cost of an update depends on the hexes that changed and
+// the length of the affected borders, not on the size of the map or the number of regions.
+class HEXLIBRUNTIME_API FHxlbRegionBorders
+{
+public:
+	// Hexes with NoRegion aren't part of any region and get no border.
+	void Build(const FHxlbDenseLayout& NewLayout, TConstArrayView<int32> RegionIds, double NewHexSize, int32 NewNoRegion = INDEX_NONE);
+	void Reset();
+	bool IsBuilt() const { return Layout != nullptr; }
+
+	// Reads the region of the changed hexes again. Regions whose border changed are listed in GetUpdatedRegions().
+	void Update(TConstArrayView<int32> RegionIds, TConstArrayView<int32> ChangedIndices);
+
+	// Null for regions without any hex.
+	const FHxlbRegionBorder* GetBorder(int32 RegionId) const { return Borders.Find(RegionId); }
+	const TMap<int32, FHxlbRegionBorder>& GetBorders() const { return Borders; }
+
+	// Regions whose border was rebuilt or removed by the last Build() or Update(), in ascending order.
+	TConstArrayView<int32> GetUpdatedRegions() const { return UpdatedRegions; }
+
+	// Corners are shared by three hexes. Returns the same key for every hex that shares the corner.
+	static int64 CornerKey(FIntPoint HexCoord, int32 CornerIndex);
+
+protected:
+	void SetEdge(int32 RegionId, int32 DenseIndex, int32 Direction, bool bIsBorder);
+	void ChainLoops(FHxlbRegionBorder& Border) const;
+
+	const FHxlbDenseLayout* Layout = nullptr;
+	double HexSize = 1.0;
+	int32 NoRegion = INDEX_NONE;
+
+	// Region of every hex as of the last update.
+	TArray<int32> KnownRegionIds;
+	TMap<int32, FHxlbRegionBorder> Borders;
+	TSet<int32> DirtyRegions;
+	TArray<int32> UpdatedRegions;
+};
@@ -0,0 +1,102 @@
+// Copyright © Mason Stevenson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the disclaimer
+// below) provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+// THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+// CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+// NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+#include "Containers/Array.h"
+#include "Foundation/HxlbDenseLayout.h"
+#include "Templates/Function.h"
+
+// Splits a map into regions: maximal groups of connected hexes that share the same non-zero key. Keys come from a
+// predicate over the map, e.g. 1 for land and 0 for water, or the id of the owner of each hex, and hexes with key 0 are
+// not part of any region.
+//
+// Every hex stores the id of its region and every region stores its size, so both queries are a single lookup. When
+// hexes change key, regions are kept up to date locally instead of being relabeled from scratch:
+// - A hex that joins a key starts a region of its own, which is then united with the regions of its neighbors with the
+//   same key. Uniting relabels the smaller of the two regions, so no hex is relabeled more than log(N) times by joins.
+// - A hex that leaves a key may split its region. Its neighbors in the old region are flooded from at the same time, one
+//   hex each in turn, until all but one of the floods have run out of hexes. Those floods found the pieces that broke
+//   off and are relabeled; the rest of the region keeps its id. Work is proportional to the size of the smaller pieces.
+//
+// Region ids are reused once a region is gone.
+class HEXLIBRUNTIME_API FHxlbRegionLabeling
+{
+public:
+	using FKeyFunction = TFunctionRef<uint32(int32 /* DenseIndex */)>;
+	
+	// Labels every hex of the layout from scratch.
+	void Build(const FHxlbDenseLayout& NewLayout, FKeyFunction KeyOf);
+	void Reset();
+	bool IsBuilt() const { return Layout != nullptr; }
+
+	// Reads the keys of the changed hexes again and updates the regions around them. Falls back to Build() when too
+	// much of the map changed for local updates to pay off.
+	void Update(TConstArrayView<int32> ChangedIndices, FKeyFunction KeyOf);
+
+	// INDEX_NONE for hexes that aren't part of any region.
+	FORCEINLINE int32 GetRegion(int32 DenseIndex) const { return RegionIds[DenseIndex]; }
+	FORCEINLINE bool IsSameRegion(int32 DenseIndexA, int32 DenseIndexB) const
+	{
+		return RegionIds[DenseIndexA] != INDEX_NONE && RegionIds[DenseIndexA] == RegionIds[DenseIndexB];
+	}
+	
+	int32 GetRegionSize(int32 RegionId) const { return RegionSizes.IsValidIndex(RegionId) ? RegionSizes[RegionId] : 0; }
+	uint32 GetRegionKey(int32 RegionId) const { return RegionKeys.IsValidIndex(RegionId) ? RegionKeys[RegionId] : 0; }
+	int32 NumRegions() const { return RegionSizes.Num() - FreeRegionIds.Num(); }
+
+	// Region id of every hex, by dense index.
+	TConstArrayView<int32> GetRegionIds() const { return RegionIds; }
+
+	// Appends the dense index of every hex in the same region as the given hex.
+	void GetRegionHexes(int32 DenseIndex, TArray<int32>& OutIndices) const;
+
+protected:
+	void AddHex(int32 DenseIndex, FIntPoint HexCoord);
+	void RemoveHex(int32 DenseIndex, FIntPoint HexCoord);
+	int32 AllocateRegion(uint32 Key);
+	void FreeRegion(int32 RegionId);
+
+	// Gives every hex of the region that contains Seed a new id, by flooding from the seed. Returns the number of hexes.
+	int32 Relabel(int32 Seed, int32 NewRegionId);
+	
+	const FHxlbDenseLayout* Layout = nullptr;
+	TArray<uint32> Keys;
+	TArray<int32> RegionIds;
+	
+	TArray<int32> RegionSizes;
+	TArray<uint32> RegionKeys;
+	TArray<int32> FreeRegionIds;
+
+	// Scratch for floods. A hex has been visited by the current flood if its stamp equals the generation.
+	TArray<uint32> VisitStamps;
+	TArray<int32> VisitOwners;
+	uint32 Generation = 0;
+};
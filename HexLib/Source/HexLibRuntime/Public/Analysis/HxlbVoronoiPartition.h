@@ -0,0 +1,108 @@
+// Copyright © Mason Stevenson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the disclaimer
+// below) provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+// THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+// CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+// NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+#include "Containers/Array.h"
+#include "Containers/Map.h"
+#include "Analysis/HxlbDistanceField.h"
+#include "Foundation/HxlbDenseLayout.h"
+#include "Navigation/HxlbCostField.h"
+
+// Splits a map into one region per seed hex, where every hex belongs to the region of its nearest seed: a Voronoi
+// diagram in hex steps, or in movement cost if built over a cost field. Ties go to the seed with the smaller dense index,
+// like in FHxlbDistanceField, which does the flooding.
+//
+// Lloyd relaxation moves every seed to the hex of its region closest to the region's centroid and floods again, which
+// evens out region sizes and shapes. A few iterations are usually enough. Regions keep their index while seeds move.
+class HEXLIBRUNTIME_API FHxlbVoronoiPartition
+{
+public:
+	// The layout, or the cost field's layout and costs, must outlive the partition. Seeds outside of the layout, and
+	// repeated seeds, get empty regions.
+	void Build(const FHxlbDenseLayout& NewLayout, TConstArrayView<int32> SeedIndices, int32 LloydIterations = 0);
+	void Build(const FHxlbCostField& NewCostField, TConstArrayView<int32> SeedIndices, int32 LloydIterations = 0);
+	void Reset();
+	bool IsBuilt() const { return Layout != nullptr; }
+
+	int32 NumRegions() const { return Seeds.Num(); }
+
+	// Dense index of the seed of every region, after relaxation.
+	TConstArrayView<int32> GetSeeds() const { return Seeds; }
+
+	// Index of the region of the hex, or INDEX_NONE if no seed can reach it.
+	FORCEINLINE int32 GetRegion(int32 DenseIndex) const { return RegionIds[DenseIndex]; }
+	TConstArrayView<int32> GetRegionIds() const { return RegionIds; }
+	int32 GetRegionSize(int32 RegionIndex) const { return RegionSizes.IsValidIndex(RegionIndex) ? RegionSizes[RegionIndex] : 0; }
+
+	// Lloyd iterations that actually ran. Relaxation stops early once no seed moves.
+	int32 GetNumIterations() const { return NumIterations; }
+
+protected:
+	void Partition(const FHxlbCostField* CostField, int32 LloydIterations);
+	void Flood(const FHxlbCostField* CostField);
+
+	// Returns true if any seed moved.
+	bool MoveSeedsToCentroids();
+
+	const FHxlbDenseLayout* Layout = nullptr;
+	TArray<int32> Seeds;
+	TArray<int32> RegionIds;
+	TArray<int32> RegionSizes;
+	int32 NumIterations = 0;
+	FHxlbDistanceField DistanceField;
+};
+
+// A region next to another, and the number of hex edges along their shared border.
+struct FHxlbRegionLink
+{
+	int32 Region = INDEX_NONE;
+	int32 NumSharedEdges = 0;
+};
+
+// Which regions of a region id layer touch each other, e.g. to place roads between neighboring provinces or to plan
+// which zone an AI should push into next. Built in parallel over the rows of the map.
+class HEXLIBRUNTIME_API FHxlbRegionAdjacency
+{
+public:
+	// Hexes with NoRegion aren't part of any region and don't connect the regions around them.
+	void Build(const FHxlbDenseLayout& Layout, TConstArrayView<int32> RegionIds, int32 NoRegion = INDEX_NONE);
+	void Reset() { Links.Reset(); }
+
+	// Neighbors of the region, sorted by region id. Empty for unknown regions and regions that touch no other.
+	TConstArrayView<FHxlbRegionLink> GetNeighbors(int32 RegionId) const;
+	bool AreNeighbors(int32 RegionIdA, int32 RegionIdB) const;
+
+	// Every region with at least one neighbor.
+	const TMap<int32, TArray<FHxlbRegionLink>>& GetLinks() const { return Links; }
+
+protected:
+	TMap<int32, TArray<FHxlbRegionLink>> Links;
+};
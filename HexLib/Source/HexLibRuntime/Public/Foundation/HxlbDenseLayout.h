@@ -0,0 +1,179 @@
+// Copyright © Mason Stevenson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the disclaimer
+// below) provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+// THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+// CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+// NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+#include "Containers/Array.h"
+#include "FunctionLibraries/HxlbMath.h"
+#include "Math/IntPoint.h"
+
+// A contiguous run of hexes in a single row (constant R) of axial space, from QMin to QMax inclusive. A span with
+// QMax < QMin is empty.
+struct FHxlbHexRowSpan
+{
+public:
+	FHxlbHexRowSpan() = default;
+	FHxlbHexRowSpan(int32 NewR, int32 NewQMin, int32 NewQMax): R(NewR), QMin(NewQMin), QMax(NewQMax) {}
+
+	int32 Num() const { return FMath::Max(0, QMax - QMin + 1); }
+	bool IsEmpty() const { return QMax < QMin; }
+	bool Contains(FIntPoint AxialCoord) const
+	{
+		return HEX_R(AxialCoord) == R && HEX_Q(AxialCoord) >= QMin && HEX_Q(AxialCoord) <= QMax;
+	}
+	FIntPoint Get(int32 Offset) const { return FIntPoint(QMin + Offset, R); }
+
+	int32 R = 0;
+	int32 QMin = 0;
+	int32 QMax = -1;
+};
+
+// Maps every hex of a bounded map onto a dense index in [0, Num()). Hexes are laid out row by row (ascending R, then
+// ascending Q), so every row of the map is a contiguous run of indices and per-hex data can live in flat arrays instead
+// of TMap<FIntPoint, ...>.
+//
+// The layout is also partitioned into square chunks of ChunkSize x ChunkSize hexes in offset (column, row) space. Each
+// chunk covers at most ChunkSize rows, and within a row a chunk is always a contiguous run of dense indices. Chunks are
+// the unit of work for parallel passes and the unit of invalidation for cached data.
+class HEXLIBRUNTIME_API FHxlbDenseLayout
+{
+// constants
+public:
+	static constexpr int32 kDefaultChunkSize = 32;
+
+public:
+	FHxlbDenseLayout() = default;
+
+	void InitHexagonal(int32 Radius, int32 NewChunkSize = kDefaultChunkSize);
+	void InitRectangular(int32 HalfWidth, int32 HalfHeight, int32 NewChunkSize = kDefaultChunkSize);
+
+	// Rows must be sorted by R with no gaps between them. Empty rows are allowed.
+	void InitFromRows(const TArray<FHxlbHexRowSpan>& NewRows, int32 NewChunkSize = kDefaultChunkSize);
+	void Reset();
+
+	bool IsValid() const { return NumHexes > 0; }
+	int32 Num() const { return NumHexes; }
+
+	// True if both layouts cover the same hexes with the same chunking, i.e. dense indices and chunk indices agree.
+	bool HasSameShape(const FHxlbDenseLayout& Other) const;
+
+	// Rows. Together with Num() these let the layout be used directly as a hex range (see HxlbHexRanges.h), in which
+	// case the linear index of each hex is its dense index.
+	int32 NumRows() const { return Rows.Num(); }
+	const FHxlbHexRowSpan& GetRow(int32 RowIndex) const { return Rows[RowIndex]; }
+	int32 GetRowStart(int32 RowIndex) const { return RowStarts[RowIndex]; }
+	int32 GetMinR() const { return MinR; }
+	int32 GetMaxR() const { return MinR + Rows.Num() - 1; }
+
+	FORCEINLINE int32 IndexOf(FIntPoint AxialCoord) const
+	{
+		const int32 RowIndex = HEX_R(AxialCoord) - MinR;
+		if (static_cast<uint32>(RowIndex) >= static_cast<uint32>(Rows.Num()))
+		{
+			return INDEX_NONE;
+		}
+		
+		const FHxlbHexRowSpan& Row = Rows[RowIndex];
+		if (HEX_Q(AxialCoord) < Row.QMin || HEX_Q(AxialCoord) > Row.QMax)
+		{
+			return INDEX_NONE;
+		}
+		return RowStarts[RowIndex] + (HEX_Q(AxialCoord) - Row.QMin);
+	}
+	bool Contains(FIntPoint AxialCoord) const { return IndexOf(AxialCoord) != INDEX_NONE; }
+	FIntPoint CoordOf(int32 Index) const;
+
+	// Returns INDEX_NONE if the neighbor falls outside of the map.
+	FORCEINLINE int32 NeighborIndex(FIntPoint AxialCoord, int32 DirectionIndex) const
+	{
+		return IndexOf(AxialCoord + UHxlbMath::DirectionIndexToAxial(DirectionIndex));
+	}
+
+	// Chunks
+	int32 GetChunkSize() const { return ChunkSize; }
+	int32 NumChunks() const { return ChunkHexCounts.Num(); }
+	FIntPoint GetChunkGridSize() const { return FIntPoint(ChunkColumns, ChunkRows); }
+	int32 NumHexesInChunk(int32 ChunkIndex) const { return ChunkHexCounts[ChunkIndex]; }
+	int32 ChunkOf(FIntPoint AxialCoord) const;
+	int32 ChunkOfIndex(int32 Index) const { return ChunkOf(CoordOf(Index)); }
+
+	// Position of a hex inside of its chunk, in [0, ChunkSize * ChunkSize). Lets per-chunk work use small scratch
+	// arrays instead of map-sized ones. The hex must be inside of the map.
+	FORCEINLINE int32 ChunkLocalIndex(FIntPoint AxialCoord) const
+	{
+		const int32 LocalRow = (HEX_R(AxialCoord) - MinR) % ChunkSize;
+		const int32 LocalColumn = (OffsetColumn(AxialCoord) - MinColumn) % ChunkSize;
+		return LocalRow * ChunkSize + LocalColumn;
+	}
+
+	// Returns the part of the chunk that lies in its LocalRow-th row (0 <= LocalRow < ChunkSize). May be empty.
+	FHxlbHexRowSpan GetChunkRowSpan(int32 ChunkIndex, int32 LocalRow) const;
+
+	// Calls Func(const FHxlbHexRowSpan& Span, int32 FirstIndex) for each non-empty row of the chunk, where FirstIndex is
+	// the dense index of Span.QMin.
+	template <typename FuncType>
+	void ForEachChunkSpan(int32 ChunkIndex, FuncType&& Func) const
+	{
+		for (int32 LocalRow = 0; LocalRow < ChunkSize; ++LocalRow)
+		{
+			const FHxlbHexRowSpan Span = GetChunkRowSpan(ChunkIndex, LocalRow);
+			if (Span.IsEmpty())
+			{
+				continue;
+			}
+			const int32 RowIndex = Span.R - MinR;
+			Func(Span, RowStarts[RowIndex] + (Span.QMin - Rows[RowIndex].QMin));
+		}
+	}
+
+	// Offset column of a hex. Offset space is what chunks are square in.
+	static FORCEINLINE int32 OffsetColumn(FIntPoint AxialCoord)
+	{
+		return HEX_Q(AxialCoord) + FloorHalf(HEX_R(AxialCoord));
+	}
+	static FORCEINLINE int32 FloorHalf(int32 Value)
+	{
+		return (Value - (Value & 1)) / 2;
+	}
+
+protected:
+	void BuildChunks();
+
+	TArray<FHxlbHexRowSpan> Rows;
+	TArray<int32> RowStarts;
+	int32 MinR = 0;
+	int32 NumHexes = 0;
+
+	int32 ChunkSize = kDefaultChunkSize;
+	int32 ChunkColumns = 0;
+	int32 ChunkRows = 0;
+	int32 MinColumn = 0;
+	TArray<int32> ChunkHexCounts;
+};
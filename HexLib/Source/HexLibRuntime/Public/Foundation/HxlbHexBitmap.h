@@ -0,0 +1,114 @@
+// Copyright © Mason Stevenson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the disclaimer
+// below) provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+// THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+// CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+// NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+#include "Containers/Array.h"
+#include "Foundation/HxlbDenseLayout.h"
+
+// One bit per hex of a dense layout, indexed by dense index. Rows of the layout are contiguous runs of bits, so row
+// spans can be read and written a word at a time.
+class HEXLIBRUNTIME_API FHxlbHexBitmap
+{
+// constants
+public:
+	static constexpr int32 kBitsPerWord = 64;
+	
+public:
+	FHxlbHexBitmap() = default;
+	explicit FHxlbHexBitmap(int32 NewNumBits) { Init(NewNumBits); }
+	
+	static int32 NumWordsFor(int32 NumBits) { return (NumBits + kBitsPerWord - 1) / kBitsPerWord; }
+
+	// Resizes the bitmap and clears every bit.
+	void Init(int32 NewNumBits);
+	void Reset();
+	int32 Num() const { return NumBits; }
+	
+	FORCEINLINE bool Get(int32 Index) const
+	{
+		return (Words[Index / kBitsPerWord] >> (Index % kBitsPerWord)) & 1;
+	}
+	FORCEINLINE void Set(int32 Index)
+	{
+		Words[Index / kBitsPerWord] |= static_cast<uint64>(1) << (Index % kBitsPerWord);
+	}
+	FORCEINLINE void Clear(int32 Index)
+	{
+		Words[Index / kBitsPerWord] &= ~(static_cast<uint64>(1) << (Index % kBitsPerWord));
+	}
+	FORCEINLINE void SetTo(int32 Index, bool bValue)
+	{
+		bValue ? Set(Index) : Clear(Index);
+	}
+
+	// Up to 64 bits starting at FirstIndex, in the low bits of the result. Bits past the end read as zero.
+	uint64 ReadBits(int32 FirstIndex, int32 Count) const { return ReadWordBits(Words, FirstIndex, Count); }
+	
+	// ORs the low Count bits of Bits into the bitmap, starting at FirstIndex.
+	void OrBits(int32 FirstIndex, uint64 Bits, int32 Count) { OrWordBits(Words, FirstIndex, Bits, Count); }
+
+	// Same as ReadBits() and OrBits(), for other bit arrays laid out the same way.
+	static uint64 ReadWordBits(TConstArrayView<uint64> SourceWords, int32 FirstIndex, int32 Count);
+	static void OrWordBits(TArrayView<uint64> TargetWords, int32 FirstIndex, uint64 Bits, int32 Count);
+	
+	int32 CountSetBits() const;
+	bool IsEmpty() const;
+
+	FHxlbHexBitmap& operator|=(const FHxlbHexBitmap& Other);
+	FHxlbHexBitmap& operator&=(const FHxlbHexBitmap& Other);
+	FHxlbHexBitmap& AndNot(const FHxlbHexBitmap& Other);
+	bool operator==(const FHxlbHexBitmap& Other) const { return NumBits == Other.NumBits && Words == Other.Words; }
+	bool operator!=(const FHxlbHexBitmap& Other) const { return !(*this == Other); }
+
+	// Calls Func(DenseIndex) for every set bit, in ascending order.
+	template <typename FuncType>
+	void ForEachSetBit(FuncType&& Func) const
+	{
+		for (int32 WordIndex = 0; WordIndex < Words.Num(); WordIndex++)
+		{
+			uint64 Word = Words[WordIndex];
+			while (Word)
+			{
+				Func(WordIndex * kBitsPerWord + static_cast<int32>(FMath::CountTrailingZeros64(Word)));
+				Word &= Word - 1;
+			}
+		}
+	}
+
+	void ToCoords(const FHxlbDenseLayout& Layout, TArray<FIntPoint>& OutCoords) const;
+
+	TConstArrayView<uint64> GetWords() const { return Words; }
+	TArrayView<uint64> GetMutableWords() { return Words; }
+	
+protected:
+	TArray<uint64> Words;
+	int32 NumBits = 0;
+};
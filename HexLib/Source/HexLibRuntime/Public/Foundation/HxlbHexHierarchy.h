@@ -0,0 +1,123 @@
+// Copyright © Mason Stevenson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the disclaimer
+// below) provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+// THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+// CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+// NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+#include "Containers/Array.h"
+#include "Foundation/HxlbDenseLayout.h"
+
+// Aperture 7 hierarchy over a dense layout. Every hex of a level belongs to exactly one super-hex of the level above:
+// the hex is either the center of a seven hex flower or one of its six petals, and flowers tile the plane. The centers
+// of the flowers form a hex grid of their own, turned by about 19 degrees, which is used as the axial space of the next
+// level. Level 0 is the layout itself.
+//
+// Each level has its own dense layout, so per level data can live in flat arrays just like hex layers, along with the
+// parent of every hex and the children of every super-hex. Super-hexes at the edge of the map can have fewer than seven
+// children.
+class HEXLIBRUNTIME_API FHxlbHexHierarchy
+{
+// constants
+public:
+	static constexpr int32 kAperture = 7;
+
+public:
+	// Super-hex that contains the hex, in the axial space of the next level.
+	static FIntPoint ParentOf(FIntPoint AxialCoord);
+
+	// Center hex of a super-hex, in the axial space of the level below.
+	static FIntPoint CenterOf(FIntPoint ParentCoord);
+
+	// Same as calling ParentOf() or CenterOf() NumLevels times.
+	static FIntPoint AncestorOf(FIntPoint AxialCoord, int32 NumLevels);
+	static FIntPoint LeafCenterOf(FIntPoint AncestorCoord, int32 NumLevels);
+	
+	// Adds levels until the top one has at most MaxTopLevelHexes hexes. The leaf layout must outlive the hierarchy.
+	void Build(const FHxlbDenseLayout& LeafLayout, int32 MaxTopLevelHexes = 1);
+	void Reset();
+	bool IsBuilt() const { return !Levels.IsEmpty(); }
+
+	int32 NumLevels() const { return Levels.Num(); }
+	const FHxlbDenseLayout& GetLayout(int32 Level) const { return Level == 0 ? *LeafLayout : Levels[Level].Layout; }
+
+	// Lowest level with at most MaxHexes hexes, or the top level if there is none.
+	int32 FindLevelWithAtMost(int32 MaxHexes) const;
+	
+	// Dense index of the parent in Level + 1. INDEX_NONE on the top level.
+	FORCEINLINE int32 GetParent(int32 Level, int32 DenseIndex) const
+	{
+		return Levels[Level].Parents.IsEmpty() ? INDEX_NONE : Levels[Level].Parents[DenseIndex];
+	}
+
+	// Dense index of the ancestor of a leaf in the given level.
+	int32 GetAncestor(int32 LeafIndex, int32 Level) const;
+
+	// Dense indices of the children in Level - 1. Level must be at least 1.
+	FORCEINLINE TConstArrayView<int32> GetChildren(int32 Level, int32 DenseIndex) const
+	{
+		const FLevel& LevelData = Levels[Level];
+		const int32 First = LevelData.ChildStarts[DenseIndex];
+		return TConstArrayView<int32>(LevelData.Children.GetData() + First, LevelData.ChildStarts[DenseIndex + 1] - First);
+	}
+
+	// Number of leaves under a hex. Zero for super-hexes that only exist to keep the rows of their level contiguous.
+	FORCEINLINE int32 GetLeafCount(int32 Level, int32 DenseIndex) const
+	{
+		return Level == 0 ? 1 : Levels[Level].LeafCounts[DenseIndex];
+	}
+
+	// Calls Func(int32 LeafIndex) for every leaf under the hex.
+	template <typename FuncType>
+	void ForEachLeaf(int32 Level, int32 DenseIndex, FuncType&& Func) const
+	{
+		if (Level == 0)
+		{
+			Func(DenseIndex);
+			return;
+		}
+		for (int32 Child : GetChildren(Level, DenseIndex))
+		{
+			ForEachLeaf(Level - 1, Child, Func);
+		}
+	}
+
+protected:
+	struct FLevel
+	{
+		// Unused on level 0, see LeafLayout.
+		FHxlbDenseLayout Layout;
+		TArray<int32> Parents;
+		TArray<int32> ChildStarts;
+		TArray<int32> Children;
+		TArray<int32> LeafCounts;
+	};
+
+	const FHxlbDenseLayout* LeafLayout = nullptr;
+	TArray<FLevel> Levels;
+};
@@ -0,0 +1,143 @@
+// Copyright © Mason Stevenson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the disclaimer
+// below) provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+// THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+// CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+// NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+#include "Containers/Array.h"
+#include "Containers/ArrayView.h"
+#include "Containers/BitArray.h"
+#include "Delegates/Delegate.h"
+#include "Foundation/HxlbDenseLayout.h"
+#include "Templates/UnrealTypeTraits.h"
+
+class FHxlbHexLayerBase;
+
+// Broadcast by CommitChanges(). If bAllChanged is true, ChangedIndices is empty and every hex should be considered
+// changed (e.g. after the layer was resized or filled).
+DECLARE_MULTICAST_DELEGATE_ThreeParams(FOnHxlbHexLayerChanged, const FHxlbHexLayerBase& /*Layer*/, TConstArrayView<int32> /*ChangedIndices*/, bool /*bAllChanged*/);
+
+// A hex layer stores one value per hex of a dense layout, indexed by dense index.
+//
+// Writes made through Set() are recorded as pending changes. CommitChanges() bumps the version of every chunk that was
+// touched and then broadcasts the changed indices, which is what derived data (path graphs, flow fields, caches, ...)
+// uses to update incrementally instead of rebuilding. Bulk writers can write through GetMutableValues() from any number
+// of threads and call MarkAllChanged() afterward.
+//
+// Layers are not thread safe. Reading from worker threads is fine as long as nothing writes to the layer meanwhile.
+class HEXLIBRUNTIME_API FHxlbHexLayerBase
+{
+public:
+	FHxlbHexLayerBase(FName NewName, const TCHAR* NewTypeName): Name(NewName), TypeName(NewTypeName) {}
+	virtual ~FHxlbHexLayerBase() = default;
+
+	FName GetName() const { return Name; }
+	const TCHAR* GetTypeName() const { return TypeName; }
+	int32 Num() const { return NumValues; }
+
+	// Resizes the layer to match the layout and resets every value to the default value. The layout must outlive the
+	// layer, or the layer must be resized again before it is used.
+	void Resize(const FHxlbDenseLayout& NewLayout);
+	const FHxlbDenseLayout* GetLayout() const { return Layout; }
+
+	// Versions only ever go up. The layer version changes whenever any chunk version changes.
+	uint32 GetVersion() const { return Version; }
+	uint32 GetChunkVersion(int32 ChunkIndex) const { return ChunkVersions[ChunkIndex]; }
+
+	bool HasPendingChanges() const { return bAllPending || !PendingChanges.IsEmpty(); }
+	TConstArrayView<int32> GetPendingChanges() const { return PendingChanges; }
+	void MarkChanged(int32 DenseIndex);
+	void MarkAllChanged();
+	void CommitChanges();
+
+	FOnHxlbHexLayerChanged OnChanged;
+
+protected:
+	virtual void ResizeValues(int32 NewNum) = 0;
+
+	FName Name;
+	const TCHAR* TypeName = nullptr;
+	const FHxlbDenseLayout* Layout = nullptr;
+	int32 NumValues = 0;
+
+	uint32 Version = 0;
+	TArray<uint32> ChunkVersions;
+	
+	TArray<int32> PendingChanges;
+	TBitArray<> PendingMask;
+	bool bAllPending = false;
+};
+
+// ValueType must be exposed through TNameOf (see UnrealTypeTraits.h), which is what the map component uses to make sure
+// that a layer is always looked up with the type it was created with.
+template <typename ValueType>
+class THxlbHexLayer : public FHxlbHexLayerBase
+{
+public:
+	explicit THxlbHexLayer(FName NewName, const ValueType& NewDefaultValue = ValueType())
+		: FHxlbHexLayerBase(NewName, TNameOf<ValueType>::GetName())
+		, DefaultValue(NewDefaultValue)
+	{}
+
+	static const TCHAR* StaticTypeName() { return TNameOf<ValueType>::GetName(); }
+
+	FORCEINLINE const ValueType& Get(int32 DenseIndex) const { return Values[DenseIndex]; }
+	void Set(int32 DenseIndex, const ValueType& NewValue)
+	{
+		if (Values[DenseIndex] != NewValue)
+		{
+			Values[DenseIndex] = NewValue;
+			MarkChanged(DenseIndex);
+		}
+	}
+	void Fill(const ValueType& NewValue)
+	{
+		for (ValueType& Value : Values)
+		{
+			Value = NewValue;
+		}
+		MarkAllChanged();
+	}
+
+	const ValueType& GetDefaultValue() const { return DefaultValue; }
+	TConstArrayView<ValueType> GetValues() const { return Values; }
+
+	// Untracked writes. Call MarkChanged() or MarkAllChanged() when done.
+	TArrayView<ValueType> GetMutableValues() { return Values; }
+
+protected:
+	virtual void ResizeValues(int32 NewNum) override
+	{
+		Values.Reset();
+		Values.Init(DefaultValue, NewNum);
+	}
+
+	ValueType DefaultValue;
+	TArray<ValueType> Values;
+};
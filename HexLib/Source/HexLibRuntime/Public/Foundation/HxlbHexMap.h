@@ -32,10 +32,31 @@
 #pragma once
 #include "Components/SceneComponent.h"
 #include "GameplayTagContainer.h"
+#include "HxlbDenseLayout.h"
 #include "HxlbHex.h"
+#include "HxlbHexLayers.h"
+#include "HxlbHexStencil.h"
+#include "HxlbHexTimerWheel.h"
+#include "HxlbOccupancyIndex.h"
+#include "HxlbQueryCache.h"
 #include "HxlbTypes.h"
+#include "Analysis/HxlbDistanceField.h"
+#include "Analysis/HxlbHexAggregate.h"
+#include "Analysis/HxlbInfluenceMap.h"
+#include "Analysis/HxlbRegionBorders.h"
+#include "Analysis/HxlbRegionLabeling.h"
 #include "Data/HxlbHexTagInfo.h"
 #include "FunctionLibraries/HxlbMath.h"
+#include "Generation/HxlbMapGeneration.h"
+#include "Navigation/HxlbCostField.h"
+#include "Navigation/HxlbFlowField.h"
+#include "Navigation/HxlbMovementRange.h"
+#include "Vision/HxlbCoverMap.h"
+#include "Vision/HxlbFieldOfView.h"
+#include "Vision/HxlbFogOfWar.h"
+#include "Navigation/HxlbHierarchicalPathfinding.h"
+#include "Navigation/HxlbIncrementalPathfinding.h"
+#include "Navigation/HxlbLandmarks.h"
 
 #include "HxlbHexMap.generated.h"
 
@@ -133,6 +154,15 @@ public:
 	UPROPERTY(EditAnywhere, Category = "Hex Data")
 	TSubclassOf<UHxlbHex> DefaultHexClass = UHxlbHex::StaticClass();
 
+	UPROPERTY(EditAnywhere, Category = "Navigation")
+	FHxlbMovementCostSettings MovementCostSettings;
+
+	UPROPERTY(EditAnywhere, Category = "Vision")
+	FHxlbVisionSettings VisionSettings;
+
+	UPROPERTY(EditAnywhere, Category = "Vision")
+	FHxlbCoverSettings CoverSettings;
+
 	// Editor Only Properties -----------------------------------------------------------------------------------------
 	// UPROPERTY(EditAnywhere, meta = (Categories = "HexGame.Map"), Category="Hex Data")
 	UPROPERTY()
@@ -162,6 +192,7 @@ class HEXLIBRUNTIME_API UHxlbHexMapComponent : public USceneComponent
 // constants
 public:
 	static constexpr int32 kBatchedUpdateThreshold = 7;
+	static const FName kMovementCostLayerName;
 
 public:
 	UHxlbHexMapComponent(const FObjectInitializer& Initializer);
@@ -185,6 +216,161 @@ public:
 	
 	double GetHexSize() { return MapSettings.HexSize; }
 	FIntPoint GetGridOrigin() { return GridOrigin; }
+
+	// Dense index over the hexes of a bounded map. Invalid for unbounded maps.
+	const FHxlbDenseLayout& GetDenseLayout() const { return DenseLayout; }
+
+	// Returns true if the layout changed shape, in which case every hex layer has been resized and reset.
+	bool RebuildDenseLayout();
+
+	// Hex layers are per-hex data stored in flat arrays indexed by the dense layout. They are only populated on bounded
+	// maps. Looking up a layer with a different value type than it was created with fails.
+	template <typename ValueType>
+	THxlbHexLayer<ValueType>* FindLayer(FName LayerName) const
+	{
+		FHxlbHexLayerBase* Layer = FindLayerBase(LayerName);
+		if (!Layer || FCString::Strcmp(Layer->GetTypeName(), THxlbHexLayer<ValueType>::StaticTypeName()) != 0)
+		{
+			return nullptr;
+		}
+		return static_cast<THxlbHexLayer<ValueType>*>(Layer);
+	}
+
+	template <typename ValueType>
+	THxlbHexLayer<ValueType>* FindOrAddLayer(FName LayerName, const ValueType& DefaultValue = ValueType())
+	{
+		if (FHxlbHexLayerBase* Existing = FindLayerBase(LayerName))
+		{
+			THxlbHexLayer<ValueType>* TypedLayer = FindLayer<ValueType>(LayerName);
+			if (!TypedLayer)
+			{
+				ReportLayerTypeMismatch(*Existing, THxlbHexLayer<ValueType>::StaticTypeName());
+			}
+			return TypedLayer;
+		}
+		
+		TSharedRef<THxlbHexLayer<ValueType>> NewLayer = MakeShared<THxlbHexLayer<ValueType>>(LayerName, DefaultValue);
+		NewLayer->Resize(DenseLayout);
+		HexLayers.Add(LayerName, NewLayer);
+		return &NewLayer.Get();
+	}
+	
+	FHxlbHexLayerBase* FindLayerBase(FName LayerName) const;
+
+	// Removing the movement cost layer drops every agent path and weighted distance field (along with its layer), and
+	// everything else built from movement costs.
+	// Removing a vision layer makes fog and cover recompute everything on their next update.
+	bool RemoveLayer(FName LayerName);
+
+	// Compiles MapSettings.MovementCostSettings into the movement cost layer, which is what pathfinding runs on. Hex
+	// data is read here, so this has to run on the game thread. Call RecompileHexCosts() after changing the tags of a
+	// few hexes instead of recompiling everything.
+	void CompileCostLayer();
+	void RecompileHexCosts(TConstArrayView<FIntPoint> HexCoords);
+	
+	// Invalid until the cost layer has been compiled.
+	FHxlbCostField GetCostField() const;
+
+	// Hierarchical pathfinding graph over the movement cost layer. Built on first use, then repaired incrementally
+	// whenever movement cost changes are committed.
+	const FHxlbHierarchicalPathfinder& GetHierarchicalPathfinder();
+
+	// Landmark tables for tighter A* heuristics (see FHxlbPathfinder::FindPath()). Built on first use. Movement cost
+	// changes mark them stale, and they are rebuilt the next time they are requested.
+	const FHxlbLandmarks& GetLandmarks();
+
+	// Flow field toward a set of goals, for sending many units to the same place. Fields are cached per goal set and
+	// updated incrementally the next time they are requested after movement costs change. Sample them on the game
+	// thread.
+	TSharedRef<const FHxlbFlowField> GetFlowField(TConstArrayView<FIntPoint> Goals);
+
+	// Paths that are repaired instead of searched again when movement costs change, one per agent. Call SetAgentPath()
+	// again as the agent moves; the search is only started over if the goal changed. Agent ids are chosen by the caller.
+	bool SetAgentPath(int32 AgentId, FIntPoint Start, FIntPoint Goal);
+	bool RemoveAgentPath(int32 AgentId);
+	EHxlbPathStatus FindAgentPath(int32 AgentId, FHxlbPathResult& OutResult);
+
+	// Movement range queries over the movement cost layer. Built on first use, then kept up to date with movement cost
+	// changes.
+	const FHxlbMovementRange& GetMovementRange();
+
+	// Elevation and opacity layers named in MapSettings.VisionSettings. Missing layers count as flat and transparent.
+	FHxlbVisionField GetVisionField() const;
+
+	// Ring orderings for field of view queries, grown on demand to cover MinRadius. Call on the game thread.
+	const FHxlbFieldOfView& GetFieldOfView(int32 MinRadius);
+
+	// Per-player fog of war over this map. Register observers on it directly, then call UpdateFogOfWar() once per
+	// frame or turn to recompute the observers that changed. Listen to its OnChanged to hear about changed hexes.
+	FHxlbFogOfWar& GetFogOfWar();
+	void UpdateFogOfWar();
+
+	// Cover of every hex along each of its edges, from the vision layers and MapSettings.CoverSettings. Built on first
+	// use, then recomputed around the hexes whose elevation or opacity changes. Call on the game thread.
+	const FHxlbCoverMap& GetCoverMap();
+
+	// Which entities stand on which hex, for "who is on or near this hex" queries. Keep it up to date as entities move.
+	// Emptied if the map changes shape.
+	FHxlbOccupancyIndex& GetOccupancy();
+
+	// Timers on hexes: growth, cooldowns, decay. Schedule them on the wheel directly, then call AdvanceHexTimers() once
+	// per game tick. Layer actions are applied to their float layers, which are committed once per call, and every timer
+	// that fired is appended to OutFired in the order it was applied. Emptied if the map changes shape.
+	FHxlbHexTimerWheel& GetHexTimers();
+	void AdvanceHexTimers(int32 NumTicks, TArray<FHxlbHexTimer>& OutFired);
+
+	// Spatial queries that are asked again and again, cached by query. A cached result is only computed again once a
+	// layer it reads (movement costs, vision, the filter layer) changes near the query's origin. The cache is emptied
+	// if the map changes shape or a layer is removed. Call on the game thread.
+	TSharedRef<const FHxlbQueryResult> QueryHexes(const FHxlbHexQuery& Query);
+	FHxlbQueryCache& GetQueryCache() { return QueryCache; }
+
+	// Hexes whose hex data has Tag (or a child of it), for FHxlbHexQueryBuilder::WhereIn(). Built on first use and kept
+	// up to date by CompileCostLayer() and RecompileHexCosts(), or by RefreshHexTags() if only tags changed. Indexes keep
+	// their address for the lifetime of the map. Call on the game thread.
+	const FHxlbHexBitmap& GetTagIndex(const FGameplayTag& Tag);
+	void RefreshHexTags(TConstArrayView<FIntPoint> HexCoords);
+
+	// Per-faction influence over this map. Set sources on it directly, then call UpdateInfluenceMap() once per frame or
+	// turn. Sources blocked by terrain spread around hexes that block movement.
+	FHxlbInfluenceMap& GetInfluenceMap();
+	void UpdateInfluenceMap();
+
+	// Regions of connected hexes that share the same non-zero value in an int32 hex layer. Built on first use, then
+	// updated incrementally whenever changes to the layer are committed. Null if there is no such layer.
+	const FHxlbRegionLabeling* GetRegions(FName LayerName);
+
+	// Border loops of the regions of an int32 region id layer, where hexes with the same value belong to the same
+	// region and hexes with the layer's default value belong to none. Built on first use, then updated around the hexes
+	// that change whenever changes to the layer are committed. Null if there is no such layer.
+	const FHxlbRegionBorders* GetRegionBorders(FName LayerName);
+
+	// Aperture-7 hierarchy of super-hexes over this map, for strategic zoom levels and coarse queries. Built on first use.
+	const FHxlbHexHierarchy& GetHexHierarchy();
+
+	// Aggregate of a float or int32 hex layer over every level of the hex hierarchy. Built on first use, then updated
+	// along the ancestors of the hexes that change whenever changes to the layer are committed. Null if there is no
+	// such layer.
+	const FHxlbHexAggregate* GetAggregate(FName LayerName, EHxlbAggregateOp Op);
+
+	// Distance from every hex to the nearest of a set of source hexes, mirrored into a float hex layer of the same name
+	// so that it can be read like any other layer. Weighted fields add up movement costs and are rebuilt from scratch
+	// whenever movement costs change, however few hexes change: each costs a full Dijkstra over the map on every commit
+	// of the cost layer, so keep their number small on maps whose costs change often. Adding or removing sources updates
+	// the field and only the hexes of its layer that change. Adding a field that already exists replaces it. Sources
+	// survive a change of map shape, except for those that fall off the map. Removing the field's layer removes the
+	// field, and weighted fields are removed with the movement cost layer.
+	const FHxlbDistanceField* AddDistanceField(FName LayerName, TConstArrayView<FIntPoint> Sources, bool bWeighted = false);
+	void AddDistanceSources(FName LayerName, TConstArrayView<FIntPoint> Sources);
+	void RemoveDistanceSources(FName LayerName, TConstArrayView<FIntPoint> Sources);
+	const FHxlbDistanceField* GetDistanceField(FName LayerName) const;
+
+	// Neighborhood stencil over this map's layout, for cellular automata and convolutions over its hex layers.
+	const FHxlbHexStencil& GetStencil();
+
+	// Runs a generation pipeline over the layers of this map, adding the layers it writes. Every written layer is
+	// committed once the whole pipeline is done, and the cost layer is recompiled if there is one.
+	void GenerateMap(const FHxlbMapGenerator& Generator, int32 Seed);
 	
 	UPROPERTY()
 	FHxlbMapSettings MapSettings;
@@ -200,9 +386,55 @@ protected:
 	void WriteHexInfo_16(UTextureRenderTarget2D* PerHexDataRT, FIntPoint HexCoord, uint16 RawInfo, uint16 BitMask);
 
 	void SetHexHighlightType(FIntPoint HexCoord, EHxlbHighlightType HighlightType);
+
+	// The landscape part of IsValidAxialCoord(). Safe to call from worker threads.
+	bool IsWithinLandscapeBounds(FIntPoint AxialCoord) const;
+
+	void ReportLayerTypeMismatch(const FHxlbHexLayerBase& Layer, const TCHAR* RequestedTypeName) const;
+	float ComputeHexCost(int32 DenseIndex, const UHxlbHex* Hex, TConstArrayView<const THxlbHexLayer<float>*> CostLayers) const;
+	void GatherCostLayers(TArray<const THxlbHexLayer<float>*>& OutCostLayers) const;
+	void BindMovementCostLayer();
+	void OnMovementCostsChanged(const FHxlbHexLayerBase& Layer, TConstArrayView<int32> ChangedIndices, bool bAllChanged);
+	void BindVisionLayers();
+	void OnVisionLayerChanged(const FHxlbHexLayerBase& Layer, TConstArrayView<int32> ChangedIndices, bool bAllChanged);
+	void BindRegionLayer(THxlbHexLayer<int32>& Layer);
+	void OnRegionLayerChanged(const FHxlbHexLayerBase& Layer, TConstArrayView<int32> ChangedIndices, bool bAllChanged);
+	void RefreshAggregate(FHxlbHexAggregate& Aggregate, EHxlbAggregateOp Op, const FHxlbHexLayerBase& Layer, TConstArrayView<int32> ChangedIndices, bool bAllChanged);
+	void OnAggregateLayerChanged(const FHxlbHexLayerBase& Layer, TConstArrayView<int32> ChangedIndices, bool bAllChanged);
+	void ToDenseIndices(TConstArrayView<FIntPoint> HexCoords, TArray<int32>& OutDenseIndices) const;
+	void RebuildDistanceField(FName LayerName, FHxlbDistanceField& Field, TConstArrayView<int32> SourceIndices, bool bWeighted);
+	void WriteDistanceLayer(FName LayerName, const FHxlbDistanceField& Field, bool bAllChanged);
+	void FillTagIndex(const FGameplayTag& Tag, FHxlbHexBitmap& Index) const;
 	
 	FIntPoint GridOrigin = FIntPoint(0, 0);
 
+	FHxlbDenseLayout DenseLayout;
+	TMap<FName, TSharedRef<FHxlbHexLayerBase>> HexLayers;
+	float MinMovementCost = 1.0f;
+	TUniquePtr<FHxlbHierarchicalPathfinder> HierarchicalPathfinder;
+	FHxlbFlowFieldCache FlowFieldCache;
+	FHxlbLandmarks Landmarks;
+	TMap<int32, TUniquePtr<FHxlbIncrementalPathfinder>> AgentPaths;
+	FHxlbMovementRange MovementRange;
+	FHxlbFieldOfView FieldOfView;
+	FHxlbFogOfWar FogOfWar;
+	FHxlbCoverMap CoverMap;
+	FHxlbInfluenceMap InfluenceMap;
+	FHxlbOccupancyIndex Occupancy;
+	FHxlbHexTimerWheel HexTimers;
+	FHxlbQueryCache QueryCache;
+	TMap<FGameplayTag, TUniquePtr<FHxlbHexBitmap>> TagIndexes;
+	TMap<FName, TUniquePtr<FHxlbRegionLabeling>> RegionLabelings;
+	TMap<FName, TUniquePtr<FHxlbRegionBorders>> RegionBorders;
+	FHxlbHexHierarchy HexHierarchy;
+	FHxlbHexStencil Stencil;
+	TMap<FName, TArray<TUniquePtr<FHxlbHexAggregate>>> LayerAggregates;
+	TMap<FName, TUniquePtr<FHxlbDistanceField>> DistanceFields;
+
+	// Layers are bound once per purpose, and other bindings (aggregates, regions) to the same layer don't count.
+	TMap<FName, FDelegateHandle> VisionLayerBindings;
+	FDelegateHandle MovementCostBinding;
+
 	UPROPERTY()
 	TMap<FIntPoint, TObjectPtr<UHxlbHex>> HexData;
 
@@ -0,0 +1,197 @@
+// Copyright © Mason Stevenson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the disclaimer
+// below) provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+// THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+// CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+// NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+#include "Async/Future.h"
+#include "Containers/Array.h"
+#include "Foundation/HxlbHexBitmap.h"
+#include "Foundation/HxlbHexLayers.h"
+#include "Foundation/HxlbHexRanges.h"
+#include "Foundation/HxlbHexShapes.h"
+#include "Foundation/HxlbQueryCache.h"
+
+#include "HxlbHexQueryBuilder.generated.h"
+
+UENUM(BlueprintType)
+enum class EHxlbCompareOp : uint8
+{
+	Equal,
+	NotEqual,
+	Less,
+	LessOrEqual,
+	Greater,
+	GreaterOrEqual,
+
+	// For int32 layers of flags: the value shares at least one bit with the operand.
+	HasAnyBits,
+	
+	// For int32 layers of flags: the value shares no bit with the operand.
+	HasNoBits
+};
+
+// "Value of the hex in a layer <op> Value", for Blueprints. Works on float and int32 layers; int32 layers are compared
+// against Value rounded to the nearest integer.
+USTRUCT(BlueprintType)
+struct HEXLIBRUNTIME_API FHxlbLayerCondition
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hex Queries")
+	FName LayerName;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hex Queries")
+	EHxlbCompareOp Op = EHxlbCompareOp::Equal;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hex Queries")
+	float Value = 0.0f;
+};
+
+// Ad-hoc hex queries, e.g. "hexes within 8 of X where Terrain == Forest, Owner != Me and tagged Y, nearest first":
+//
+//   TArray<int32> Hexes;
+//   FHxlbHexQueryBuilder(Layout)
+//       .InRadius(X, 8)
+//       .Where(*TerrainLayer, EHxlbCompareOp::Equal, Forest)
+//       .Where(*OwnerLayer, EHxlbCompareOp::NotEqual, Me)
+//       .WhereIn(HexMap->GetTagIndex(TagY))
+//       .OrderByDistance(X)
+//       .Execute(Hexes);
+//
+// Queries run as bit operations over words of 64 hexes in dense order. The source is turned into a mask of candidate
+// hexes, and every predicate is pushed down into the scan: set predicates (tag indexes, visibility, ...) are ANDed in
+// first, a word at a time, then layer predicates compare 64 values of their layer with SIMD and AND in the result. Words
+// that run out of candidates skip the remaining predicates, so expensive predicates only read the parts of their layer
+// that are still in play. Large sources are split across worker threads by blocks of words.
+//
+// The query references the layout, layers and sets it is given, which must be left alone until it has run.
+class HEXLIBRUNTIME_API FHxlbHexQueryBuilder
+{
+// constants
+public:
+	static constexpr int32 kWordsPerTask = 64;
+
+public:
+	explicit FHxlbHexQueryBuilder(const FHxlbDenseLayout& NewLayout): Layout(&NewLayout) {}
+
+	// Sources. Without one, the whole map is searched. Each replaces the previous source.
+	FHxlbHexQueryBuilder& InRadius(FIntPoint Origin, int32 Radius, int32 MinRadius = 0);
+	FHxlbHexQueryBuilder& InSet(const FHxlbHexBitmap& Hexes);
+	FHxlbHexQueryBuilder& InQueryResult(const FHxlbQueryResult& Result);
+
+	// Any shape (see HxlbHexShapes.h), clipped to the map.
+	template <typename ShapeType>
+	FHxlbHexQueryBuilder& InShape(ShapeType Shape)
+	{
+		ResetSource(ESource::Runs);
+		auto Clipped = HxlbShapes::ClipToMap(MoveTemp(Shape), *Layout);
+		HxlbShapes::ForEachSpan(Clipped, [this](const FHxlbHexRowSpan& Span)
+		{
+			SourceRuns.Add({Layout->IndexOf(Span.Get(0)), Span.Num()});
+		});
+		return *this;
+	}
+
+	// Predicates. A hex has to pass all of them.
+	FHxlbHexQueryBuilder& Where(const THxlbHexLayer<float>& Layer, EHxlbCompareOp Op, float Value);
+	FHxlbHexQueryBuilder& Where(const THxlbHexLayer<int32>& Layer, EHxlbCompareOp Op, int32 Value);
+	FHxlbHexQueryBuilder& WhereIn(const FHxlbHexBitmap& Hexes);
+	FHxlbHexQueryBuilder& WhereNotIn(const FHxlbHexBitmap& Hexes);
+
+	// Order and limit only apply to arrays of results. Without an order, hexes come out in dense order. Ties are broken
+	// by dense index, so results don't depend on the number of threads.
+	FHxlbHexQueryBuilder& OrderByDistance(FIntPoint Origin);
+	FHxlbHexQueryBuilder& OrderBy(const THxlbHexLayer<float>& Layer, bool bDescending = false);
+	FHxlbHexQueryBuilder& Limit(int32 NewMaxResults);
+
+	// Every matching hex. Returns the number of matches.
+	int32 Execute(FHxlbHexBitmap& OutHexes) const;
+
+	// Dense indices of the matching hexes, ordered and limited.
+	void Execute(TArray<int32>& OutDenseIndices) const;
+
+	// Same as above, on a worker thread. The query is copied, but what it references is not.
+	TFuture<TArray<int32>> ExecuteAsync() const;
+
+protected:
+	enum class ESource : uint8
+	{
+		WholeMap,
+		Runs,
+		Set
+	};
+
+	enum class EOrder : uint8
+	{
+		None,
+		Distance,
+		LayerAscending,
+		LayerDescending
+	};
+
+	struct FColumnPredicate
+	{
+		EHxlbCompareOp Op = EHxlbCompareOp::Equal;
+		const float* Floats = nullptr;
+		const int32* Ints = nullptr;
+		float FloatOperand = 0.0f;
+		int32 IntOperand = 0;
+	};
+
+	struct FSetPredicate
+	{
+		const uint64* Words = nullptr;
+		bool bNegate = false;
+	};
+
+	void ResetSource(ESource NewSource);
+	bool CheckLayer(const FHxlbHexLayerBase& Layer);
+
+	// Leaves the matches in OutWords, which covers the words from OutFirstWord on.
+	void Evaluate(TArray<uint64>& OutWords, int32& OutFirstWord) const;
+	static uint64 EvaluateColumn(const FColumnPredicate& Predicate, int32 FirstIndex, int32 Count);
+	
+	const FHxlbDenseLayout* Layout = nullptr;
+	ESource Source = ESource::WholeMap;
+	TArray<FHxlbDenseRun> SourceRuns;
+	const FHxlbHexBitmap* SourceSet = nullptr;
+	
+	TArray<FSetPredicate> SetPredicates;
+	TArray<FColumnPredicate> ColumnPredicates;
+
+	// Set when a predicate can't be evaluated, in which case nothing matches.
+	bool bMatchesNothing = false;
+	
+	EOrder Order = EOrder::None;
+	FIntPoint OrderOrigin = FIntPoint::ZeroValue;
+	const float* OrderValues = nullptr;
+	int32 MaxResults = 0;
+};
@@ -0,0 +1,261 @@
+// Copyright © Mason Stevenson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the disclaimer
+// below) provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+// THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+// CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+// NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+#include "Algo/BinarySearch.h"
+#include "Async/ParallelFor.h"
+#include "Foundation/HxlbDenseLayout.h"
+
+// Hex ranges are lightweight, copyable descriptions of a set of hexes as an ordered list of row spans. Unlike the hex
+// iterators (see HxlbHexIterators.h), ranges can be sliced into sub-ranges, which is what allows whole-map passes to be
+// spread across worker threads.
+//
+// Every range type provides:
+//   int32 NumRows() const;
+//   FHxlbHexRowSpan GetRow(int32 RowIndex) const;   (may return an empty span)
+//   int32 Num() const;
+//   RangeType Slice(int32 RowBegin, int32 RowEnd) const;
+//
+// The "linear index" of a hex is its position when walking the range row by row. FHxlbDenseLayout also satisfies the
+// read half of this interface, in which case the linear index is the dense index.
+
+// All hexes within Radius of Origin.
+struct HEXLIBRUNTIME_API FHxlbRadialRange
+{
+public:
+	FHxlbRadialRange() = default;
+	FHxlbRadialRange(FIntPoint NewOrigin, int32 NewRadius);
+
+	int32 NumRows() const { return RowEnd - RowBegin; }
+	FHxlbHexRowSpan GetRow(int32 RowIndex) const;
+	int32 Num() const { return CountBefore(RowEnd) - CountBefore(RowBegin); }
+	FHxlbRadialRange Slice(int32 NewRowBegin, int32 NewRowEnd) const;
+
+protected:
+	// Number of hexes in the rows of the full (unsliced) hexagon that come before AbsoluteRow.
+	int32 CountBefore(int32 AbsoluteRow) const;
+	
+	FIntPoint Origin = FIntPoint::ZeroValue;
+	int32 Radius = -1;
+	int32 RowBegin = 0;
+	int32 RowEnd = 0;
+};
+
+// Same shape as FHxlbRectangularIterator(Origin, HalfWidth, HalfHeight).
+struct HEXLIBRUNTIME_API FHxlbRectangularRange
+{
+public:
+	FHxlbRectangularRange() = default;
+	FHxlbRectangularRange(FIntPoint NewOrigin, int32 NewHalfWidth, int32 NewHalfHeight);
+
+	int32 NumRows() const { return RowEnd - RowBegin; }
+	FHxlbHexRowSpan GetRow(int32 RowIndex) const;
+	int32 Num() const { return NumRows() * (2 * HalfWidth + 1); }
+	FHxlbRectangularRange Slice(int32 NewRowBegin, int32 NewRowEnd) const;
+
+protected:
+	FIntPoint Origin = FIntPoint::ZeroValue;
+	int32 HalfWidth = 0;
+	int32 HalfHeight = 0;
+	int32 RowBegin = 0;
+	int32 RowEnd = 0;
+};
+
+// The hexes of a contiguous run of chunks in a dense layout, chunk by chunk. Each chunk contributes ChunkSize rows
+// (some of which may be empty), so slicing on a multiple of the chunk size always splits on chunk boundaries. The layout
+// must outlive the range.
+struct HEXLIBRUNTIME_API FHxlbChunkedRange
+{
+public:
+	FHxlbChunkedRange() = default;
+	explicit FHxlbChunkedRange(const FHxlbDenseLayout& NewLayout);
+	FHxlbChunkedRange(const FHxlbDenseLayout& NewLayout, int32 ChunkBegin, int32 ChunkEnd);
+
+	int32 NumRows() const { return RowEnd - RowBegin; }
+	FHxlbHexRowSpan GetRow(int32 RowIndex) const;
+	int32 Num() const;
+	FHxlbChunkedRange Slice(int32 NewRowBegin, int32 NewRowEnd) const;
+	FHxlbChunkedRange SliceChunks(int32 ChunkBegin, int32 ChunkEnd) const;
+
+	int32 NumChunks() const;
+	int32 GetChunkIndex(int32 RowIndex) const;
+
+protected:
+	const FHxlbDenseLayout* Layout = nullptr;
+	int32 RowBegin = 0;
+	int32 RowEnd = 0;
+};
+
+namespace HxlbHexRanges
+{
+	// Hexes handed to a single task by default. Below this, the cost of scheduling outweighs the work for most bodies.
+	static constexpr int32 kDefaultMinBatchSize = 2048;
+
+	// Upper bound on the number of batches a range is cut into. This is deliberately a constant rather than a function
+	// of the worker count: batch boundaries only depend on the size of the range, so a pass that reduces per batch gets
+	// the same result on every machine.
+	static constexpr int32 kMaxBatches = 256;
+
+	inline int32 ComputeNumBatches(int32 NumHexes, int32 MinBatchSize)
+	{
+		if (NumHexes <= 0)
+		{
+			return 0;
+		}
+		return FMath::Clamp(NumHexes / FMath::Max(1, MinBatchSize), 1, kMaxBatches);
+	}
+
+	// Linear index of the first hex of each row, plus a trailing entry holding Range.Num().
+	template <typename RangeType>
+	void ComputeRowStarts(const RangeType& Range, TArray<int32>& OutRowStarts)
+	{
+		const int32 NumRows = Range.NumRows();
+		OutRowStarts.SetNumUninitialized(NumRows + 1);
+		
+		int32 Total = 0;
+		for (int32 RowIndex = 0; RowIndex < NumRows; ++RowIndex)
+		{
+			OutRowStarts[RowIndex] = Total;
+			Total += Range.GetRow(RowIndex).Num();
+		}
+		OutRowStarts[NumRows] = Total;
+	}
+	
+	// Splits a range into at most NumParts consecutive sub-ranges on row boundaries, balanced by hex count. Empty parts
+	// are dropped.
+	template <typename RangeType>
+	TArray<RangeType> SplitByRows(const RangeType& Range, int32 NumParts)
+	{
+		TArray<RangeType> Parts;
+		if (NumParts < 1)
+		{
+			return Parts;
+		}
+
+		TArray<int32> RowStarts;
+		ComputeRowStarts(Range, RowStarts);
+		const int32 NumRows = Range.NumRows();
+		const int32 Total = RowStarts[NumRows];
+
+		int32 PartRowBegin = 0;
+		for (int32 PartIndex = 1; PartIndex <= NumParts && PartRowBegin < NumRows; ++PartIndex)
+		{
+			const int32 Target = static_cast<int32>((static_cast<int64>(Total) * PartIndex) / NumParts);
+			
+			// First row that starts at or after the target, i.e. cut before the row that would overshoot it.
+			int32 PartRowEnd = PartIndex == NumParts ? NumRows : Algo::LowerBound(RowStarts, Target);
+			PartRowEnd = FMath::Clamp(PartRowEnd, PartRowBegin, NumRows);
+			
+			if (RowStarts[PartRowEnd] > RowStarts[PartRowBegin])
+			{
+				Parts.Add(Range.Slice(PartRowBegin, PartRowEnd));
+				PartRowBegin = PartRowEnd;
+			}
+		}
+
+		return Parts;
+	}
+}
+
+// Calls Body(const FHxlbHexRowSpan& Span, int32 FirstLinearIndex) for every hex of the range, one (possibly partial)
+// row span at a time, spread across worker threads. The range is cut into batches of equal hex count, so rows are split
+// by index when needed. Batch boundaries don't depend on the number of threads (see kMaxBatches), and every hex is
+// visited exactly once, so bodies that write to slots keyed by linear or dense index are deterministic.
+template <typename RangeType, typename BodyType>
+void HxlbParallelForEachSpan(const RangeType& Range, BodyType&& Body, int32 MinBatchSize = HxlbHexRanges::kDefaultMinBatchSize)
+{
+	TArray<int32> RowStarts;
+	HxlbHexRanges::ComputeRowStarts(Range, RowStarts);
+	
+	const int32 Total = RowStarts.Last();
+	const int32 NumBatches = HxlbHexRanges::ComputeNumBatches(Total, MinBatchSize);
+	if (NumBatches == 0)
+	{
+		return;
+	}
+
+	ParallelFor(NumBatches, [&Range, &Body, &RowStarts, Total, NumBatches](int32 BatchIndex)
+	{
+		const int32 BatchBegin = static_cast<int32>((static_cast<int64>(Total) * BatchIndex) / NumBatches);
+		const int32 BatchEnd = static_cast<int32>((static_cast<int64>(Total) * (BatchIndex + 1)) / NumBatches);
+
+		int32 RowIndex = Algo::UpperBound(RowStarts, BatchBegin) - 1;
+		int32 LinearIndex = BatchBegin;
+		
+		while (LinearIndex < BatchEnd)
+		{
+			const FHxlbHexRowSpan Row = Range.GetRow(RowIndex);
+			const int32 RowEndIndex = FMath::Min(RowStarts[RowIndex + 1], BatchEnd);
+			
+			if (RowEndIndex > LinearIndex)
+			{
+				const int32 QMin = Row.QMin + (LinearIndex - RowStarts[RowIndex]);
+				Body(FHxlbHexRowSpan(Row.R, QMin, QMin + (RowEndIndex - LinearIndex) - 1), LinearIndex);
+				LinearIndex = RowEndIndex;
+			}
+			++RowIndex;
+		}
+	}, NumBatches == 1 ? EParallelForFlags::ForceSingleThread : EParallelForFlags::None);
+}
+
+// Per-hex version of HxlbParallelForEachSpan(). Calls Body(FIntPoint AxialCoord, int32 LinearIndex).
+template <typename RangeType, typename BodyType>
+void HxlbParallelForEachHex(const RangeType& Range, BodyType&& Body, int32 MinBatchSize = HxlbHexRanges::kDefaultMinBatchSize)
+{
+	HxlbParallelForEachSpan(Range, [&Body](const FHxlbHexRowSpan& Span, int32 FirstLinearIndex)
+	{
+		int32 LinearIndex = FirstLinearIndex;
+		for (int32 Q = Span.QMin; Q <= Span.QMax; ++Q, ++LinearIndex)
+		{
+			Body(FIntPoint(Q, Span.R), LinearIndex);
+		}
+	}, MinBatchSize);
+}
+
+// Calls Body(int32 ChunkIndex) for every chunk of the layout, spread across worker threads. Chunks are independent units
+// of work, so bodies may freely write to any hex inside of the chunk they were handed.
+template <typename BodyType>
+void HxlbParallelForEachChunk(const FHxlbDenseLayout& Layout, BodyType&& Body, bool bForceSingleThread = false)
+{
+	const int32 NumChunks = Layout.NumChunks();
+	if (NumChunks == 0)
+	{
+		return;
+	}
+	
+	ParallelFor(NumChunks, [&Layout, &Body](int32 ChunkIndex)
+	{
+		if (Layout.NumHexesInChunk(ChunkIndex) > 0)
+		{
+			Body(ChunkIndex);
+		}
+	}, bForceSingleThread || NumChunks == 1 ? EParallelForFlags::ForceSingleThread : EParallelForFlags::None);
+}
@@ -0,0 +1,498 @@
+// Copyright © Mason Stevenson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the disclaimer
+// below) provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+// THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+// CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+// NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+#include "Containers/Set.h"
+#include "Foundation/HxlbDenseLayout.h"
+#include "Foundation/HxlbHexIterators.h"
+
+// Lazy, composable hex shapes.
+//
+// A shape is a single-pass stream of row spans with a single method:
+//   bool NextSpan(FHxlbHexRowSpan& OutSpan);
+//
+// Spans come out sorted by (R, QMin), are never empty, and never overlap. Because of that ordering, combining two shapes
+// is a merge of their spans rather than a merge of hex sets: nothing is materialized, and the cost of a combinator is
+// proportional to the number of rows touched instead of the number of hexes.
+//
+// Example: hexes within 5 of Origin, clipped to the map, minus the current selection, streamed into a buffer.
+//
+//   auto Shape = HxlbShapes::Exclude(
+//       HxlbShapes::ClipToMap(HxlbShapes::Spans(FHxlbRadialRange(Origin, 5)), HexMap->GetDenseLayout()),
+//       SelectionState.SelectedHexes);
+//   HxlbShapes::ForEachIndex(Shape, HexMap->GetDenseLayout(), [&](int32 DenseIndex) { Buffer[DenseIndex] = Value; });
+
+namespace HxlbShapes
+{
+	FORCEINLINE bool SpanLess(const FHxlbHexRowSpan& A, const FHxlbHexRowSpan& B)
+	{
+		return A.R < B.R || (A.R == B.R && A.QMin < B.QMin);
+	}
+
+	// Holds the next unconsumed span of a shape.
+	template <typename ShapeType>
+	struct TCursor
+	{
+	public:
+		explicit TCursor(ShapeType&& NewShape): Shape(MoveTemp(NewShape)) { Advance(); }
+
+		bool IsValid() const { return bIsValid; }
+		const FHxlbHexRowSpan& Head() const { return HeadSpan; }
+		void Advance() { bIsValid = Shape.NextSpan(HeadSpan); }
+
+	protected:
+		ShapeType Shape;
+		FHxlbHexRowSpan HeadSpan;
+		bool bIsValid = false;
+	};
+}
+
+// Adapts a hex range (see HxlbHexRanges.h) or a dense layout into a shape. The rows of the range must be sorted by R,
+// which holds for radial and rectangular ranges and for layouts, but not for chunked ranges.
+template <typename RangeType>
+struct THxlbRangeShape
+{
+public:
+	explicit THxlbRangeShape(RangeType NewRange): Range(NewRange) {}
+
+	bool NextSpan(FHxlbHexRowSpan& OutSpan)
+	{
+		while (RowIndex < Range.NumRows())
+		{
+			OutSpan = Range.GetRow(RowIndex++);
+			if (!OutSpan.IsEmpty())
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+protected:
+	RangeType Range;
+	int32 RowIndex = 0;
+};
+
+// Hexes in either shape.
+template <typename LhsType, typename RhsType>
+struct THxlbUnionShape
+{
+public:
+	THxlbUnionShape(LhsType&& Lhs, RhsType&& Rhs): LhsCursor(MoveTemp(Lhs)), RhsCursor(MoveTemp(Rhs)) {}
+
+	bool NextSpan(FHxlbHexRowSpan& OutSpan)
+	{
+		if (!PopLowest(OutSpan))
+		{
+			return false;
+		}
+
+		// Coalesce anything that overlaps or touches the span we just popped.
+		const FHxlbHexRowSpan* Next = PeekLowest();
+		while (Next && Next->R == OutSpan.R && Next->QMin <= OutSpan.QMax + 1)
+		{
+			OutSpan.QMax = FMath::Max(OutSpan.QMax, Next->QMax);
+			FHxlbHexRowSpan Discard;
+			PopLowest(Discard);
+			Next = PeekLowest();
+		}
+		return true;
+	}
+
+protected:
+	const FHxlbHexRowSpan* PeekLowest() const
+	{
+		if (LhsCursor.IsValid() && (!RhsCursor.IsValid() || !HxlbShapes::SpanLess(RhsCursor.Head(), LhsCursor.Head())))
+		{
+			return &LhsCursor.Head();
+		}
+		return RhsCursor.IsValid() ? &RhsCursor.Head() : nullptr;
+	}
+	
+	bool PopLowest(FHxlbHexRowSpan& OutSpan)
+	{
+		if (LhsCursor.IsValid() && (!RhsCursor.IsValid() || !HxlbShapes::SpanLess(RhsCursor.Head(), LhsCursor.Head())))
+		{
+			OutSpan = LhsCursor.Head();
+			LhsCursor.Advance();
+			return true;
+		}
+		if (RhsCursor.IsValid())
+		{
+			OutSpan = RhsCursor.Head();
+			RhsCursor.Advance();
+			return true;
+		}
+		return false;
+	}
+	
+	HxlbShapes::TCursor<LhsType> LhsCursor;
+	HxlbShapes::TCursor<RhsType> RhsCursor;
+};
+
+// Hexes in both shapes.
+template <typename LhsType, typename RhsType>
+struct THxlbIntersectShape
+{
+public:
+	THxlbIntersectShape(LhsType&& Lhs, RhsType&& Rhs): LhsCursor(MoveTemp(Lhs)), RhsCursor(MoveTemp(Rhs)) {}
+
+	bool NextSpan(FHxlbHexRowSpan& OutSpan)
+	{
+		while (LhsCursor.IsValid() && RhsCursor.IsValid())
+		{
+			const FHxlbHexRowSpan A = LhsCursor.Head();
+			const FHxlbHexRowSpan B = RhsCursor.Head();
+			
+			if (A.R != B.R)
+			{
+				A.R < B.R ? LhsCursor.Advance() : RhsCursor.Advance();
+				continue;
+			}
+
+			// Whichever span ends first can't overlap anything else in the other shape.
+			A.QMax < B.QMax ? LhsCursor.Advance() : RhsCursor.Advance();
+			
+			OutSpan = FHxlbHexRowSpan(A.R, FMath::Max(A.QMin, B.QMin), FMath::Min(A.QMax, B.QMax));
+			if (!OutSpan.IsEmpty())
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+protected:
+	HxlbShapes::TCursor<LhsType> LhsCursor;
+	HxlbShapes::TCursor<RhsType> RhsCursor;
+};
+
+// Hexes in the first shape but not in the second.
+template <typename LhsType, typename RhsType>
+struct THxlbSubtractShape
+{
+public:
+	THxlbSubtractShape(LhsType&& Lhs, RhsType&& Rhs): LhsCursor(MoveTemp(Lhs)), RhsCursor(MoveTemp(Rhs)) {}
+
+	bool NextSpan(FHxlbHexRowSpan& OutSpan)
+	{
+		while (true)
+		{
+			if (!bHasPending)
+			{
+				if (!LhsCursor.IsValid())
+				{
+					return false;
+				}
+				Pending = LhsCursor.Head();
+				LhsCursor.Advance();
+				bHasPending = true;
+			}
+
+			// Skip cuts that end before the pending span starts.
+			while (RhsCursor.IsValid() && (RhsCursor.Head().R < Pending.R || (RhsCursor.Head().R == Pending.R && RhsCursor.Head().QMax < Pending.QMin)))
+			{
+				RhsCursor.Advance();
+			}
+			
+			if (!RhsCursor.IsValid() || RhsCursor.Head().R > Pending.R || RhsCursor.Head().QMin > Pending.QMax)
+			{
+				OutSpan = Pending;
+				bHasPending = false;
+				return true;
+			}
+
+			// The cut overlaps the pending span. It isn't consumed here, since it may also overlap the next span.
+			const FHxlbHexRowSpan& Cut = RhsCursor.Head();
+			if (Cut.QMin > Pending.QMin)
+			{
+				OutSpan = FHxlbHexRowSpan(Pending.R, Pending.QMin, Cut.QMin - 1);
+				Pending.QMin = Cut.QMax + 1;
+				bHasPending = !Pending.IsEmpty();
+				return true;
+			}
+			
+			Pending.QMin = Cut.QMax + 1;
+			bHasPending = !Pending.IsEmpty();
+		}
+	}
+
+protected:
+	HxlbShapes::TCursor<LhsType> LhsCursor;
+	HxlbShapes::TCursor<RhsType> RhsCursor;
+	FHxlbHexRowSpan Pending;
+	bool bHasPending = false;
+};
+
+// Hexes of a shape for which Predicate(FIntPoint AxialCoord) returns true. Spans are split around rejected hexes.
+template <typename ShapeType, typename PredicateType>
+struct THxlbFilterShape
+{
+public:
+	THxlbFilterShape(ShapeType&& NewShape, PredicateType&& NewPredicate)
+		: Shape(MoveTemp(NewShape))
+		, Predicate(MoveTemp(NewPredicate))
+	{}
+
+	bool NextSpan(FHxlbHexRowSpan& OutSpan)
+	{
+		while (true)
+		{
+			if (!bHasCurrent)
+			{
+				if (!Shape.NextSpan(Current))
+				{
+					return false;
+				}
+				Q = Current.QMin;
+				bHasCurrent = true;
+			}
+
+			while (Q <= Current.QMax && !Predicate(FIntPoint(Q, Current.R)))
+			{
+				Q++;
+			}
+
+			const int32 RunStart = Q;
+			while (Q <= Current.QMax && Predicate(FIntPoint(Q, Current.R)))
+			{
+				Q++;
+			}
+
+			bHasCurrent = Q <= Current.QMax;
+			if (Q > RunStart)
+			{
+				OutSpan = FHxlbHexRowSpan(Current.R, RunStart, Q - 1);
+				return true;
+			}
+		}
+	}
+
+protected:
+	ShapeType Shape;
+	PredicateType Predicate;
+	FHxlbHexRowSpan Current;
+	int32 Q = 0;
+	bool bHasCurrent = false;
+};
+
+// Hexes of a shape that lie inside of the map. This is a per-row clip against the dense layout rather than a per-hex
+// IsValidAxialCoord() test, and it stops pulling from the input once it has moved past the last row of the map. An
+// invalid layout (e.g. an unbounded map) clips nothing. The layout must outlive the shape.
+template <typename ShapeType>
+struct THxlbClipToMapShape
+{
+public:
+	THxlbClipToMapShape(ShapeType&& NewShape, const FHxlbDenseLayout& NewLayout)
+		: Shape(MoveTemp(NewShape))
+		, Layout(&NewLayout)
+	{}
+
+	bool NextSpan(FHxlbHexRowSpan& OutSpan)
+	{
+		FHxlbHexRowSpan Span;
+		while (Shape.NextSpan(Span))
+		{
+			if (!Layout->IsValid())
+			{
+				OutSpan = Span;
+				return true;
+			}
+			if (Span.R > Layout->GetMaxR())
+			{
+				return false;
+			}
+			if (Span.R < Layout->GetMinR())
+			{
+				continue;
+			}
+
+			const FHxlbHexRowSpan& Row = Layout->GetRow(Span.R - Layout->GetMinR());
+			OutSpan = FHxlbHexRowSpan(Span.R, FMath::Max(Span.QMin, Row.QMin), FMath::Min(Span.QMax, Row.QMax));
+			if (!OutSpan.IsEmpty())
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+protected:
+	ShapeType Shape;
+	const FHxlbDenseLayout* Layout = nullptr;
+};
+
+// Exposes a shape through the FHxlbHexIterator interface, so that shapes can be handed to code that consumes iterators.
+template <typename ShapeType>
+struct THxlbShapeIterator : public FHxlbHexIterator
+{
+public:
+	explicit THxlbShapeIterator(ShapeType&& NewShape): Shape(MoveTemp(NewShape)) {}
+
+	virtual bool Next() override
+	{
+		if (bHasSpan && HEX_Q(Current) < CurrentSpan.QMax)
+		{
+			HEX_Q(Current)++;
+			return true;
+		}
+		
+		bHasSpan = Shape.NextSpan(CurrentSpan);
+		if (!bHasSpan)
+		{
+			return false;
+		}
+		Current = FIntPoint(CurrentSpan.QMin, CurrentSpan.R);
+		return true;
+	}
+	virtual FIntPoint Get() override { return Current; }
+
+protected:
+	ShapeType Shape;
+	FHxlbHexRowSpan CurrentSpan;
+	bool bHasSpan = false;
+};
+
+namespace HxlbShapes
+{
+	template <typename RangeType>
+	THxlbRangeShape<RangeType> Spans(const RangeType& Range)
+	{
+		return THxlbRangeShape<RangeType>(Range);
+	}
+
+	// Layouts are referenced rather than copied. The layout must outlive the shape.
+	inline THxlbRangeShape<const FHxlbDenseLayout&> Spans(const FHxlbDenseLayout& Layout)
+	{
+		return THxlbRangeShape<const FHxlbDenseLayout&>(Layout);
+	}
+
+	template <typename LhsType, typename RhsType>
+	THxlbUnionShape<LhsType, RhsType> Union(LhsType Lhs, RhsType Rhs)
+	{
+		return THxlbUnionShape<LhsType, RhsType>(MoveTemp(Lhs), MoveTemp(Rhs));
+	}
+
+	template <typename LhsType, typename RhsType>
+	THxlbIntersectShape<LhsType, RhsType> Intersect(LhsType Lhs, RhsType Rhs)
+	{
+		return THxlbIntersectShape<LhsType, RhsType>(MoveTemp(Lhs), MoveTemp(Rhs));
+	}
+
+	template <typename LhsType, typename RhsType>
+	THxlbSubtractShape<LhsType, RhsType> Subtract(LhsType Lhs, RhsType Rhs)
+	{
+		return THxlbSubtractShape<LhsType, RhsType>(MoveTemp(Lhs), MoveTemp(Rhs));
+	}
+
+	template <typename ShapeType, typename PredicateType>
+	THxlbFilterShape<ShapeType, PredicateType> Filter(ShapeType Shape, PredicateType Predicate)
+	{
+		return THxlbFilterShape<ShapeType, PredicateType>(MoveTemp(Shape), MoveTemp(Predicate));
+	}
+
+	// Removes the hexes of an unordered set. The set must outlive the shape.
+	template <typename ShapeType>
+	auto Exclude(ShapeType Shape, const TSet<FIntPoint>& Excluded)
+	{
+		return Filter(MoveTemp(Shape), [ExcludedPtr = &Excluded](FIntPoint AxialCoord)
+		{
+			return !ExcludedPtr->Contains(AxialCoord);
+		});
+	}
+
+	template <typename ShapeType>
+	THxlbClipToMapShape<ShapeType> ClipToMap(ShapeType Shape, const FHxlbDenseLayout& Layout)
+	{
+		return THxlbClipToMapShape<ShapeType>(MoveTemp(Shape), Layout);
+	}
+
+	template <typename ShapeType>
+	THxlbShapeIterator<ShapeType> MakeIterator(ShapeType Shape)
+	{
+		return THxlbShapeIterator<ShapeType>(MoveTemp(Shape));
+	}
+
+	// Consumers. These drain the shape.
+	
+	template <typename ShapeType, typename FuncType>
+	void ForEachSpan(ShapeType& Shape, FuncType&& Func)
+	{
+		FHxlbHexRowSpan Span;
+		while (Shape.NextSpan(Span))
+		{
+			Func(Span);
+		}
+	}
+
+	template <typename ShapeType, typename FuncType>
+	void ForEachHex(ShapeType& Shape, FuncType&& Func)
+	{
+		ForEachSpan(Shape, [&Func](const FHxlbHexRowSpan& Span)
+		{
+			for (int32 Q = Span.QMin; Q <= Span.QMax; Q++)
+			{
+				Func(FIntPoint(Q, Span.R));
+			}
+		});
+	}
+
+	// Calls Func(int32 DenseIndex) for every hex of the shape that is inside of the layout. Each span maps onto a
+	// contiguous run of dense indices, so this is a straight walk over the destination buffer.
+	template <typename ShapeType, typename FuncType>
+	void ForEachIndex(ShapeType& Shape, const FHxlbDenseLayout& Layout, FuncType&& Func)
+	{
+		ForEachSpan(Shape, [&Layout, &Func](const FHxlbHexRowSpan& Span)
+		{
+			const int32 RowIndex = Span.R - Layout.GetMinR();
+			if (RowIndex < 0 || RowIndex >= Layout.NumRows())
+			{
+				return;
+			}
+			
+			const FHxlbHexRowSpan& Row = Layout.GetRow(RowIndex);
+			const int32 QMin = FMath::Max(Span.QMin, Row.QMin);
+			const int32 QMax = FMath::Min(Span.QMax, Row.QMax);
+			const int32 FirstIndex = Layout.GetRowStart(RowIndex) + (QMin - Row.QMin);
+			
+			for (int32 Offset = 0; Offset <= QMax - QMin; Offset++)
+			{
+				Func(FirstIndex + Offset);
+			}
+		});
+	}
+
+	template <typename ShapeType>
+	void ToArray(ShapeType& Shape, TArray<FIntPoint>& OutHexes)
+	{
+		ForEachHex(Shape, [&OutHexes](FIntPoint AxialCoord) { OutHexes.Add(AxialCoord); });
+	}
+}
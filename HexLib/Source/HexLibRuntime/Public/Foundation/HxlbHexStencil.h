@@ -0,0 +1,263 @@
+// Copyright © Mason Stevenson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the disclaimer
+// below) provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+// THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+// CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+// NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+#include "Containers/Array.h"
+#include "Foundation/HxlbDenseLayout.h"
+#include "Foundation/HxlbHexBitmap.h"
+#include "Foundation/HxlbHexLayers.h"
+#include "Foundation/HxlbHexRanges.h"
+
+// What stencils read for neighbors that fall outside of the map.
+enum class EHxlbStencilEdge : uint8
+{
+	// The value of the hex itself, so that smoothing doesn't pull values at the edge of the map toward anything.
+	Clamp,
+	
+	// A fixed value, e.g. zero when counting burning neighbors.
+	Constant
+};
+
+// Runs "new value = f(hex, its six neighbors)" over every hex of a dense layout, for cellular automata (fire, disease,
+// erosion) and convolutions (smoothing, diffusion).
+//
+// Within a row, the neighbors of a hex are at fixed dense index offsets from it, which only depend on where the rows
+// above and below start. Hexes whose six neighbors all exist run through a tight loop over those offsets with no
+// lookups or branches, which compilers vectorize for simple kernels; Convolve() is vectorized explicitly. Hexes at the
+// edge of the map look their neighbors up. Work is spread across chunks.
+//
+// Neighbors are passed in direction index order (see UHxlbMath::DirectionIndexToAxial()).
+class HEXLIBRUNTIME_API FHxlbHexStencil
+{
+public:
+	// The layout must outlive the stencil.
+	void Init(const FHxlbDenseLayout& NewLayout);
+	void Reset();
+	bool IsInitialized() const { return Layout != nullptr; }
+	const FHxlbDenseLayout& GetLayout() const { return *Layout; }
+
+	// Writes Kernel(int32 DenseIndex, const ValueType& Center, const ValueType (&Neighbors)[6]) into Target for every
+	// hex. Source and Target must not overlap.
+	template <typename ValueType, typename KernelType>
+	void Apply(TConstArrayView<ValueType> Source, TArrayView<ValueType> Target, KernelType&& Kernel, EHxlbStencilEdge Edge = EHxlbStencilEdge::Clamp, const ValueType& EdgeValue = ValueType()) const
+	{
+		check(Source.Num() == Layout->Num() && Target.Num() == Layout->Num());
+		HxlbParallelForEachChunk(*Layout, [this, Source, Target, &Kernel, Edge, &EdgeValue](int32 ChunkIndex)
+		{
+			Layout->ForEachChunkSpan(ChunkIndex, [this, Source, Target, &Kernel, Edge, &EdgeValue](const FHxlbHexRowSpan& Span, int32 FirstIndex)
+			{
+				const FRowInfo& Row = RowInfos[Span.R - Layout->GetMinR()];
+				const int32 InteriorBegin = FMath::Clamp(Row.InteriorQMin, Span.QMin, Span.QMax + 1);
+				const int32 InteriorEnd = FMath::Clamp(Row.InteriorQMax + 1, InteriorBegin, Span.QMax + 1);
+				
+				for (int32 Q = Span.QMin; Q < InteriorBegin; ++Q)
+				{
+					ApplyEdgeHex(Source, Target, FIntPoint(Q, Span.R), FirstIndex + (Q - Span.QMin), Kernel, Edge, EdgeValue);
+				}
+				ApplyInterior(Source, Target, Row, FirstIndex + (InteriorBegin - Span.QMin), FirstIndex + (InteriorEnd - Span.QMin), Kernel);
+				for (int32 Q = InteriorEnd; Q <= Span.QMax; ++Q)
+				{
+					ApplyEdgeHex(Source, Target, FIntPoint(Q, Span.R), FirstIndex + (Q - Span.QMin), Kernel, Edge, EdgeValue);
+				}
+			});
+		});
+	}
+
+	// Same as Apply(), but only for the hexes set in Active. Target is left alone everywhere else, see
+	// THxlbStencilBuffers::StepActive() for keeping both buffers in sync.
+	template <typename ValueType, typename KernelType>
+	void ApplyActive(TConstArrayView<ValueType> Source, TArrayView<ValueType> Target, const FHxlbHexBitmap& Active, KernelType&& Kernel, EHxlbStencilEdge Edge = EHxlbStencilEdge::Clamp, const ValueType& EdgeValue = ValueType()) const
+	{
+		check(Source.Num() == Layout->Num() && Target.Num() == Layout->Num() && Active.Num() == Layout->Num());
+		HxlbParallelForEachChunk(*Layout, [this, Source, Target, &Active, &Kernel, Edge, &EdgeValue](int32 ChunkIndex)
+		{
+			Layout->ForEachChunkSpan(ChunkIndex, [this, Source, Target, &Active, &Kernel, Edge, &EdgeValue](const FHxlbHexRowSpan& Span, int32 FirstIndex)
+			{
+				const FRowInfo& Row = RowInfos[Span.R - Layout->GetMinR()];
+				for (int32 Offset = 0; Offset < Span.Num(); Offset += FHxlbHexBitmap::kBitsPerWord)
+				{
+					uint64 Bits = Active.ReadBits(FirstIndex + Offset, FMath::Min(FHxlbHexBitmap::kBitsPerWord, Span.Num() - Offset));
+					while (Bits)
+					{
+						const int32 SpanOffset = Offset + static_cast<int32>(FMath::CountTrailingZeros64(Bits));
+						const int32 Q = Span.QMin + SpanOffset;
+						const int32 DenseIndex = FirstIndex + SpanOffset;
+						if (Q >= Row.InteriorQMin && Q <= Row.InteriorQMax)
+						{
+							ApplyInterior(Source, Target, Row, DenseIndex, DenseIndex + 1, Kernel);
+						}
+						else
+						{
+							ApplyEdgeHex(Source, Target, FIntPoint(Q, Span.R), DenseIndex, Kernel, Edge, EdgeValue);
+						}
+						Bits &= Bits - 1;
+					}
+				}
+			});
+		});
+	}
+
+	// Weighted sum of each hex and its neighbors, e.g. a blur or a diffusion step. Vectorized.
+	void Convolve(TConstArrayView<float> Source, TArrayView<float> Target, float CenterWeight, const float (&NeighborWeights)[6], EHxlbStencilEdge Edge = EHxlbStencilEdge::Clamp, float EdgeValue = 0.0f) const;
+	void Convolve(TConstArrayView<float> Source, TArrayView<float> Target, float CenterWeight, float NeighborWeight, EHxlbStencilEdge Edge = EHxlbStencilEdge::Clamp, float EdgeValue = 0.0f) const
+	{
+		const float NeighborWeights[6] = {NeighborWeight, NeighborWeight, NeighborWeight, NeighborWeight, NeighborWeight, NeighborWeight};
+		Convolve(Source, Target, CenterWeight, NeighborWeights, Edge, EdgeValue);
+	}
+
+	// One stencil pass over a hex layer, through a scratch copy. Marks the whole layer changed.
+	template <typename ValueType, typename KernelType>
+	void ApplyToLayer(THxlbHexLayer<ValueType>& Layer, KernelType&& Kernel, EHxlbStencilEdge Edge = EHxlbStencilEdge::Clamp, const ValueType& EdgeValue = ValueType()) const
+	{
+		const TArray<ValueType> Source(Layer.GetValues().GetData(), Layer.GetValues().Num());
+		Apply<ValueType>(Source, Layer.GetMutableValues(), Kernel, Edge, EdgeValue);
+		Layer.MarkAllChanged();
+	}
+	
+	// Sets every hex that is set in Source or has a neighbor that is, a machine word of hexes at a time. This turns the
+	// hexes that changed during a step into the hexes that may change during the next one.
+	void Dilate(const FHxlbHexBitmap& Source, FHxlbHexBitmap& Target) const;
+
+protected:
+	struct FRowInfo
+	{
+		// Hexes of the row whose six neighbors are all in the map. Empty if InteriorQMin > InteriorQMax.
+		int32 InteriorQMin = 0;
+		int32 InteriorQMax = -1;
+
+		// Dense index of (Q, R - 1) and (Q, R + 1) minus dense index of (Q, R).
+		int32 UpOffset = 0;
+		int32 DownOffset = 0;
+	};
+
+	template <typename ValueType, typename KernelType>
+	FORCEINLINE void ApplyInterior(TConstArrayView<ValueType> Source, TArrayView<ValueType> Target, const FRowInfo& Row, int32 BeginIndex, int32 EndIndex, KernelType& Kernel) const
+	{
+		const ValueType* RESTRICT In = Source.GetData();
+		ValueType* RESTRICT Out = Target.GetData();
+		const int32 Up = Row.UpOffset;
+		const int32 Down = Row.DownOffset;
+		for (int32 DenseIndex = BeginIndex; DenseIndex < EndIndex; ++DenseIndex)
+		{
+			const ValueType Neighbors[6] = {
+				In[DenseIndex + 1], In[DenseIndex + Up + 1], In[DenseIndex + Up],
+				In[DenseIndex - 1], In[DenseIndex + Down - 1], In[DenseIndex + Down]
+			};
+			Out[DenseIndex] = Kernel(DenseIndex, In[DenseIndex], Neighbors);
+		}
+	}
+
+	template <typename ValueType, typename KernelType>
+	void ApplyEdgeHex(TConstArrayView<ValueType> Source, TArrayView<ValueType> Target, FIntPoint AxialCoord, int32 DenseIndex, KernelType& Kernel, EHxlbStencilEdge Edge, const ValueType& EdgeValue) const
+	{
+		const ValueType& Missing = Edge == EHxlbStencilEdge::Clamp ? Source[DenseIndex] : EdgeValue;
+		ValueType Neighbors[6];
+		for (int32 Direction = 0; Direction < 6; ++Direction)
+		{
+			const int32 NeighborIndex = Layout->NeighborIndex(AxialCoord, Direction);
+			Neighbors[Direction] = NeighborIndex != INDEX_NONE ? Source[NeighborIndex] : Missing;
+		}
+		Target[DenseIndex] = Kernel(DenseIndex, Source[DenseIndex], Neighbors);
+	}
+
+	// Bits of the row for Q in [QStart, QStart + Count), with zeros where the row doesn't reach.
+	uint64 ReadRowBits(const FHxlbHexBitmap& Bitmap, int32 RowIndex, int32 QStart, int32 Count) const;
+
+	const FHxlbDenseLayout* Layout = nullptr;
+	TArray<FRowInfo> RowInfos;
+};
+
+// A pair of value buffers for running a stencil step after step: each step reads the current buffer and writes the
+// other one, then they swap.
+template <typename ValueType>
+class THxlbStencilBuffers
+{
+public:
+	void Init(TConstArrayView<ValueType> Values)
+	{
+		Buffers[0] = TArray<ValueType>(Values.GetData(), Values.Num());
+		Buffers[1] = Buffers[0];
+		Current = 0;
+		bStaleEverywhere = false;
+		LastActive.Reset();
+	}
+
+	TConstArrayView<ValueType> GetCurrent() const { return Buffers[Current]; }
+
+	// For writes between steps. Call MarkChanged() after writing a hex if steps run on active hexes only.
+	TArrayView<ValueType> GetMutableCurrent() { return Buffers[Current]; }
+	void MarkChanged(int32 DenseIndex)
+	{
+		Buffers[1 - Current][DenseIndex] = Buffers[Current][DenseIndex];
+	}
+
+	template <typename KernelType>
+	void Step(const FHxlbHexStencil& Stencil, KernelType&& Kernel, EHxlbStencilEdge Edge = EHxlbStencilEdge::Clamp, const ValueType& EdgeValue = ValueType())
+	{
+		Stencil.Apply<ValueType>(Buffers[Current], Buffers[1 - Current], Kernel, Edge, EdgeValue);
+		Current = 1 - Current;
+		
+		// The other buffer now holds the previous step everywhere.
+		bStaleEverywhere = true;
+		LastActive.Reset();
+	}
+
+	// Steps only the active hexes; every other hex keeps its value. The other buffer is two steps behind, so the hexes
+	// that the previous step wrote are copied over first, which keeps this proportional to the number of active hexes.
+	template <typename KernelType>
+	void StepActive(const FHxlbHexStencil& Stencil, const FHxlbHexBitmap& Active, KernelType&& Kernel, EHxlbStencilEdge Edge = EHxlbStencilEdge::Clamp, const ValueType& EdgeValue = ValueType())
+	{
+		TArray<ValueType>& Source = Buffers[Current];
+		TArray<ValueType>& Target = Buffers[1 - Current];
+		if (bStaleEverywhere)
+		{
+			Target = Source;
+		}
+		else
+		{
+			LastActive.ForEachSetBit([&Source, &Target](int32 DenseIndex)
+			{
+				Target[DenseIndex] = Source[DenseIndex];
+			});
+		}
+		
+		Stencil.ApplyActive<ValueType>(Source, Target, Active, Kernel, Edge, EdgeValue);
+		Current = 1 - Current;
+		bStaleEverywhere = false;
+		LastActive = Active;
+	}
+
+private:
+	TArray<ValueType> Buffers[2];
+	int32 Current = 0;
+	bool bStaleEverywhere = false;
+	FHxlbHexBitmap LastActive;
+};
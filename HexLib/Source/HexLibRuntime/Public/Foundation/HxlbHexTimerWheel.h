@@ -0,0 +1,161 @@
+// Copyright © Mason Stevenson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the disclaimer
+// below) provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+// THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+// CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+// NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+#include "Containers/Array.h"
+#include "Foundation/HxlbDenseLayout.h"
+
+#include "HxlbHexTimerWheel.generated.h"
+
+UENUM(BlueprintType)
+enum class EHxlbHexTimerAction : uint8
+{
+	// Only reported back to the caller.
+	Notify,
+
+	// Writes Value into the hex's cell of a float layer.
+	SetLayerValue,
+
+	// Adds Value to the hex's cell of a float layer.
+	AddToLayerValue
+};
+
+// What happens to a hex when its timer fires, e.g. a crop that grows, a cooldown that ends or a crater that decays.
+struct HEXLIBRUNTIME_API FHxlbHexTimer
+{
+	int32 DenseIndex = INDEX_NONE;
+
+	// Chosen by the caller, to tell timers apart when they fire.
+	int32 EventType = 0;
+	float Value = 0.0f;
+	
+	EHxlbHexTimerAction Action = EHxlbHexTimerAction::Notify;
+
+	// Float layer changed by the layer actions.
+	FName LayerName;
+};
+
+// A timer that fired, for Blueprints.
+USTRUCT(BlueprintType)
+struct HEXLIBRUNTIME_API FHxlbHexTimerFired
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(BlueprintReadOnly, Category = "Hex Timers")
+	FIntPoint HexCoord = FIntPoint::ZeroValue;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Hex Timers")
+	int32 EventType = 0;
+	
+	UPROPERTY(BlueprintReadOnly, Category = "Hex Timers")
+	float Value = 0.0f;
+};
+
+// Timers on hexes that fire after a number of ticks, so that nothing has to be ticked or scanned per hex while waiting.
+//
+// A hierarchical timer wheel: kNumLevels wheels of kSlotsPerLevel buckets, where each bucket of a level spans a whole
+// turn of the level below it. A timer goes into the lowest level whose span covers its delay, and moves down a level
+// each time the wheel above comes around to its bucket, until it lands in the bucket of its own tick. Timers further
+// out than the top level wait in an overflow bucket, which is sorted out each time the top level moves on. Buckets are
+// intrusive doubly linked lists threaded through a slot array, so scheduling and canceling are O(1) and never allocate
+// once the slot array has grown. Advancing costs one step per tick while timers are pending, plus the timers that move
+// down.
+//
+// Timers that fire during the same Advance() come out as one batch, sorted by chunk and then by hex, so that whoever
+// applies them walks memory in order. Timers on the same hex keep the order of their ticks, then of their scheduling.
+class HEXLIBRUNTIME_API FHxlbHexTimerWheel
+{
+// constants
+public:
+	static constexpr int32 kSlotBits = 6;
+	static constexpr int32 kSlotsPerLevel = 1 << kSlotBits;
+	static constexpr int32 kNumLevels = 4;
+	
+public:
+	// Drops every timer and restarts at tick 0. The layout must outlive the wheel.
+	void Init(const FHxlbDenseLayout& NewLayout);
+	void Reset();
+	bool IsInitialized() const { return Layout != nullptr; }
+
+	// Returns a handle for Cancel(), or 0 if the hex isn't on the map. Delays under one tick fire on the next tick.
+	int64 Schedule(const FHxlbHexTimer& Timer, int32 DelayTicks);
+	bool Cancel(int64 Handle);
+	bool IsScheduled(int64 Handle) const { return FindSlot(Handle) != INDEX_NONE; }
+
+	// Ticks until the timer fires, or INDEX_NONE if it isn't scheduled.
+	int64 GetRemainingTicks(int64 Handle) const;
+	
+	int64 GetCurrentTick() const { return CurrentTick; }
+	int32 Num() const { return NumScheduled; }
+	
+	// Moves time forward and appends every timer that fired, as described above.
+	void Advance(int32 NumTicks, TArray<FHxlbHexTimer>& OutFired);
+
+protected:
+	static constexpr int32 kOverflowBucket = kNumLevels * kSlotsPerLevel;
+	
+	struct FSlot
+	{
+		FHxlbHexTimer Timer;
+		int64 DueTick = 0;
+		uint64 Sequence = 0;
+		int32 Chunk = INDEX_NONE;
+
+		// Bumped every time the slot is released, so that stale handles don't cancel the next timer in the slot.
+		uint32 Serial = 1;
+		
+		// INDEX_NONE once the slot has been released.
+		int32 Bucket = INDEX_NONE;
+		int32 Prev = INDEX_NONE;
+
+		// Next timer in the same bucket, or the next free slot once the slot has been released.
+		int32 Next = INDEX_NONE;
+	};
+
+	int32 FindSlot(int64 Handle) const;
+	int32 BucketOf(int64 DueTick) const;
+	void Link(int32 SlotIndex);
+	void Unlink(int32 SlotIndex);
+	void Release(int32 SlotIndex);
+
+	// Takes every timer out of the bucket and links it again, one level down.
+	void Cascade(int32 Bucket);
+
+	const FHxlbDenseLayout* Layout = nullptr;
+	int64 CurrentTick = 0;
+	uint64 NextSequence = 0;
+	int32 NumScheduled = 0;
+	TArray<int32> BucketHeads;
+	TArray<FSlot> Slots;
+	int32 FirstFreeSlot = INDEX_NONE;
+	TArray<int32> DueSlots;
+};
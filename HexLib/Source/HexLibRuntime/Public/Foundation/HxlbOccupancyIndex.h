@@ -0,0 +1,209 @@
+// Copyright © Mason Stevenson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the disclaimer
+// below) provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+// THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+// CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+// NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+#include "Containers/Array.h"
+#include "Containers/Map.h"
+#include "Foundation/HxlbDenseLayout.h"
+#include "FunctionLibraries/HxlbMath.h"
+
+#include "HxlbOccupancyIndex.generated.h"
+
+UENUM(BlueprintType)
+enum class EHxlbAreaShape : uint8
+{
+	// Hexes within Radius of the origin.
+	Radial,
+
+	// Hexes at least InnerRadius and at most Radius away from the origin.
+	Ring,
+
+	// Hexes within HalfWidth columns and HalfHeight rows of the origin, as FHxlbRectangularIterator.
+	Rectangle
+};
+
+// An area of effect for FHxlbOccupancyIndex::ResolveAreaEffects().
+USTRUCT(BlueprintType)
+struct HEXLIBRUNTIME_API FHxlbAreaEffect
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hex Occupancy")
+	int32 EffectId = 0;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hex Occupancy")
+	EHxlbAreaShape Shape = EHxlbAreaShape::Radial;
+	
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hex Occupancy")
+	FIntPoint Origin = FIntPoint::ZeroValue;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hex Occupancy")
+	int32 Radius = 0;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hex Occupancy")
+	int32 InnerRadius = 0;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hex Occupancy")
+	int32 HalfWidth = 0;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hex Occupancy")
+	int32 HalfHeight = 0;
+};
+
+USTRUCT(BlueprintType)
+struct HEXLIBRUNTIME_API FHxlbAreaEffectHit
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(BlueprintReadOnly, Category = "Hex Occupancy")
+	int32 EffectId = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Hex Occupancy")
+	int32 EntityId = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Hex Occupancy")
+	FIntPoint HexCoord = FIntPoint::ZeroValue;
+};
+
+// Which entities (units, buildings, ...) stand on which hex. Entities are identified by ids chosen by the caller, and
+// each one occupies a single hex at a time.
+//
+// Every hex heads an intrusive doubly linked list of the entities on it, threaded through a compact slot array, so
+// adding, moving and removing an entity are O(1) and never allocate once the slot array has grown. Radius and nearest
+// queries walk the rings around a hex from the inside out and stop as soon as they have what they need, or once every
+// entity has been seen.
+class HEXLIBRUNTIME_API FHxlbOccupancyIndex
+{
+public:
+	// Resets the index. The layout must outlive it.
+	void Init(const FHxlbDenseLayout& NewLayout);
+	void Reset();
+	bool IsInitialized() const { return Layout != nullptr; }
+
+	// Adds the entity, or moves it if it is already in the index. Returns false if the hex isn't on the map, in which
+	// case the index is left unchanged.
+	bool SetEntity(int32 EntityId, int32 DenseIndex);
+	bool RemoveEntity(int32 EntityId);
+	void RemoveAll();
+
+	// Dense index of the hex the entity is on, or INDEX_NONE if it isn't in the index.
+	int32 FindEntity(int32 EntityId) const;
+	int32 NumEntities() const { return SlotOfEntity.Num(); }
+	int32 NumEntitiesAt(int32 DenseIndex) const { return Counts[DenseIndex]; }
+
+	// Visits the entities on a hex, most recently added first. Don't modify the index from the visitor.
+	template <typename VisitorType>
+	void ForEachEntityAt(int32 DenseIndex, VisitorType&& Visitor) const
+	{
+		for (int32 SlotIndex = Heads[DenseIndex]; SlotIndex != INDEX_NONE; SlotIndex = Slots[SlotIndex].Next)
+		{
+			Visitor(Slots[SlotIndex].EntityId);
+		}
+	}
+
+	// Visits Visitor(EntityId, DenseIndex, Distance) for the entities within Radius of Center, nearest rings first, in
+	// the order of FHxlbRingIterator within a ring. Stops early if the visitor returns false. Center doesn't have to be
+	// on the map.
+	template <typename VisitorType>
+	void ForEachEntityInRadius(FIntPoint Center, int32 Radius, VisitorType&& Visitor) const
+	{
+		int32 NumSeen = 0;
+		const int32 MaxRadius = FMath::Min(Radius, GetMaxUsefulRadius(Center));
+		for (int32 Ring = 0; Ring <= MaxRadius && NumSeen < NumEntities(); Ring++)
+		{
+			// Same walk as FHxlbRingIterator: start Ring steps in direction 4, then follow directions 0 to 5.
+			FIntPoint HexCoord = Center + UHxlbMath::DirectionIndexToAxial(4) * Ring;
+			const int32 NumSteps = FMath::Max(6 * Ring, 1);
+			for (int32 Step = 0; Step < NumSteps; Step++)
+			{
+				const int32 DenseIndex = Layout->IndexOf(HexCoord);
+				if (DenseIndex != INDEX_NONE)
+				{
+					for (int32 SlotIndex = Heads[DenseIndex]; SlotIndex != INDEX_NONE; SlotIndex = Slots[SlotIndex].Next)
+					{
+						NumSeen++;
+						if (!Visitor(Slots[SlotIndex].EntityId, DenseIndex, Ring))
+						{
+							return;
+						}
+					}
+				}
+				if (Ring > 0)
+				{
+					HexCoord += UHxlbMath::DirectionIndexToAxial(Step / Ring);
+				}
+			}
+		}
+	}
+
+	// Entities within Radius of Center, nearest first.
+	void FindInRadius(FIntPoint Center, int32 Radius, TArray<int32>& OutEntities) const;
+
+	// Up to Count entities nearest to Center, nearest first, looking no further than MaxRadius. Ties are broken by
+	// ring order.
+	void FindNearest(FIntPoint Center, int32 Count, int32 MaxRadius, TArray<int32>& OutEntities) const;
+
+	// Every (effect, entity) pair where the entity stands inside the effect's area. Each effect is clipped to the map
+	// and walked as runs of dense indices, so the cost is proportional to the number of hexes covered plus the number
+	// of hits rather than to effects times entities. Effects are resolved in parallel. Hits come out grouped by effect,
+	// in the order of Effects.
+	void ResolveAreaEffects(TConstArrayView<FHxlbAreaEffect> Effects, TArray<FHxlbAreaEffectHit>& OutHits) const;
+
+protected:
+	// Distance from Center to the farthest hex of the layout. Rings past it are empty.
+	int32 GetMaxUsefulRadius(FIntPoint Center) const;
+	void ResolveAreaEffect(const FHxlbAreaEffect& Effect, TArray<FHxlbAreaEffectHit>& OutHits) const;
+
+	template <typename ShapeType>
+	void CollectHits(ShapeType& Shape, int32 EffectId, TArray<FHxlbAreaEffectHit>& OutHits) const;
+	
+	void Link(int32 SlotIndex, int32 DenseIndex);
+	void Unlink(int32 SlotIndex);
+	
+	struct FSlot
+	{
+		int32 EntityId = INDEX_NONE;
+		int32 DenseIndex = INDEX_NONE;
+		int32 Prev = INDEX_NONE;
+
+		// Next entity on the same hex, or the next free slot once the slot has been released.
+		int32 Next = INDEX_NONE;
+	};
+	
+	const FHxlbDenseLayout* Layout = nullptr;
+	TArray<int32> Heads;
+	TArray<int32> Counts;
+	TArray<FSlot> Slots;
+	int32 FirstFreeSlot = INDEX_NONE;
+	TMap<int32, int32> SlotOfEntity;
+};
@@ -0,0 +1,239 @@
+// Copyright © Mason Stevenson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the disclaimer
+// below) provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+// THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+// CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+// NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+#include "Containers/Map.h"
+#include "Foundation/HxlbHexBitmap.h"
+#include "Foundation/HxlbHexLayers.h"
+#include "Templates/Function.h"
+#include "Templates/SharedPointer.h"
+
+#include "HxlbQueryCache.generated.h"
+
+UENUM(BlueprintType)
+enum class EHxlbHexQueryKind : uint8
+{
+	// Every hex within Radius of the origin.
+	Radius,
+
+	// Every hex that can be reached in Radius steps over passable hexes.
+	Reachable,
+
+	// Every hex that can be reached for a total movement cost of at most MaxCost.
+	ReachableByCost,
+
+	// Every hex in sight of an observer on the origin, out to Radius.
+	Visible
+};
+
+// A spatial query whose result is worth remembering, e.g. the hexes around a city or in range of a fortress. Two
+// queries with the same fields are the same query.
+USTRUCT(BlueprintType)
+struct HEXLIBRUNTIME_API FHxlbHexQuery
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hex Queries")
+	EHxlbHexQueryKind Kind = EHxlbHexQueryKind::Radius;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hex Queries")
+	FIntPoint Origin = FIntPoint::ZeroValue;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hex Queries")
+	int32 Radius = 1;
+
+	// Hexes closer to the origin than this are left out, which turns the result into a ring.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hex Queries")
+	int32 MinRadius = 0;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hex Queries")
+	float MaxCost = 0.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hex Queries")
+	float EyeHeight = 1.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hex Queries")
+	float TargetHeight = 0.0f;
+
+	// Keeps only the hexes whose value in this int32 layer shares a bit with FilterMask, e.g. a layer of tag bits.
+	// Ignored if None.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hex Queries")
+	FName FilterLayerName;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hex Queries")
+	int32 FilterMask = -1;
+
+	bool operator==(const FHxlbHexQuery& Other) const
+	{
+		return Kind == Other.Kind && Origin == Other.Origin && Radius == Other.Radius && MinRadius == Other.MinRadius
+			&& MaxCost == Other.MaxCost && EyeHeight == Other.EyeHeight && TargetHeight == Other.TargetHeight
+			&& FilterLayerName == Other.FilterLayerName && FilterMask == Other.FilterMask;
+	}
+	bool operator!=(const FHxlbHexQuery& Other) const { return !(*this == Other); }
+
+	friend uint32 GetTypeHash(const FHxlbHexQuery& Query)
+	{
+		uint32 Hash = HashCombine(GetTypeHash(static_cast<uint8>(Query.Kind)), GetTypeHash(Query.Origin));
+		Hash = HashCombine(Hash, GetTypeHash(Query.Radius));
+		Hash = HashCombine(Hash, GetTypeHash(Query.MinRadius));
+		Hash = HashCombine(Hash, GetTypeHash(Query.MaxCost));
+		Hash = HashCombine(Hash, GetTypeHash(Query.EyeHeight));
+		Hash = HashCombine(Hash, GetTypeHash(Query.TargetHeight));
+		Hash = HashCombine(Hash, GetTypeHash(Query.FilterLayerName));
+		return HashCombine(Hash, GetTypeHash(Query.FilterMask));
+	}
+};
+
+USTRUCT(BlueprintType)
+struct HEXLIBRUNTIME_API FHxlbQueryCacheStats
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(BlueprintReadOnly, Category = "Hex Queries")
+	int64 Hits = 0;
+
+	// Queries that weren't cached yet, or that had been evicted.
+	UPROPERTY(BlueprintReadOnly, Category = "Hex Queries")
+	int64 Misses = 0;
+
+	// Queries that were cached, but had to be computed again because a layer they read changed under them.
+	UPROPERTY(BlueprintReadOnly, Category = "Hex Queries")
+	int64 Invalidations = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Hex Queries")
+	int64 Evictions = 0;
+};
+
+// A run of consecutive dense indices.
+struct FHxlbDenseRun
+{
+	int32 First = 0;
+	int32 Num = 0;
+};
+
+// The hexes found by a query, as sorted runs of dense indices. Each run lies in a single row of the layout, so a radius
+// query stores one run per row instead of one bit per hex of the map.
+class HEXLIBRUNTIME_API FHxlbQueryResult
+{
+public:
+	int32 Num() const { return NumHexes; }
+	bool IsEmpty() const { return NumHexes == 0; }
+	TConstArrayView<FHxlbDenseRun> GetRuns() const { return Runs; }
+	bool Contains(int32 DenseIndex) const;
+	
+	// Calls Func(int32 DenseIndex) for every hex, in ascending order.
+	template <typename FuncType>
+	void ForEachIndex(FuncType&& Func) const
+	{
+		for (const FHxlbDenseRun& Run : Runs)
+		{
+			for (int32 DenseIndex = Run.First; DenseIndex < Run.First + Run.Num; DenseIndex++)
+			{
+				Func(DenseIndex);
+			}
+		}
+	}
+
+	// ORs the result into a bitmap over the same layout.
+	void ToBitmap(FHxlbHexBitmap& OutBitmap) const;
+	void ToCoords(const FHxlbDenseLayout& Layout, TArray<FIntPoint>& OutCoords) const;
+	
+	SIZE_T GetAllocatedSize() const { return Runs.GetAllocatedSize(); }
+
+protected:
+	friend class FHxlbQueryCache;
+	
+	TArray<FHxlbDenseRun> Runs;
+	int32 NumHexes = 0;
+};
+
+// Query results cached by query, so that UI and AI asking the same questions every frame don't recompute them.
+//
+// Every query has a footprint: the hexes within some radius of its origin, outside of which nothing can change its
+// result. Entries remember the version of every layer they read in every chunk under their footprint, and are only
+// computed again once one of those chunks has changed. Checking an entry whose layers haven't changed at all is a
+// comparison per layer, and changes elsewhere on the map cost a scan of the footprint's chunk versions. The least
+// recently used entry is evicted when the cache is full.
+//
+// Results are shared and never modified once handed out, so they can be kept across frames.
+class HEXLIBRUNTIME_API FHxlbQueryCache
+{
+// constants
+public:
+	static constexpr int32 kDefaultMaxEntries = 256;
+
+public:
+	// Returns the cached result of the query, or calls Compute to find it. Compute fills a bitmap over the layout and is
+	// responsible for sizing it; only bits within FootprintRadius of the query origin are kept. Layers are the layers
+	// that Compute reads, which may include nulls for layers that don't exist (yet). Their order matters.
+	TSharedRef<const FHxlbQueryResult> FindOrCompute(
+		const FHxlbHexQuery& Query,
+		const FHxlbDenseLayout& Layout,
+		int32 FootprintRadius,
+		TConstArrayView<const FHxlbHexLayerBase*> Layers,
+		TFunctionRef<void(FHxlbHexBitmap&)> Compute
+	);
+
+	// Drops every entry, e.g. when the layout changes. Stats are kept.
+	void Reset() { Entries.Reset(); }
+	int32 Num() const { return Entries.Num(); }
+	
+	const FHxlbQueryCacheStats& GetStats() const { return Stats; }
+	void ResetStats() { Stats = FHxlbQueryCacheStats(); }
+	
+	SIZE_T GetAllocatedSize() const;
+
+	int32 MaxEntries = kDefaultMaxEntries;
+
+protected:
+	struct FEntry
+	{
+		TSharedRef<const FHxlbQueryResult> Result = MakeShared<FHxlbQueryResult>();
+
+		// Chunks under the footprint, and for every layer (in the order given) its version in each of them.
+		TArray<int32> Chunks;
+		TArray<const FHxlbHexLayerBase*> Layers;
+		TArray<uint32> LayerVersions;
+		TArray<uint32> ChunkVersions;
+		uint64 LastUsed = 0;
+	};
+
+	bool IsUpToDate(FEntry& Entry, TConstArrayView<const FHxlbHexLayerBase*> Layers) const;
+	void Fill(FEntry& Entry, const FHxlbHexQuery& Query, const FHxlbDenseLayout& Layout, int32 FootprintRadius, TConstArrayView<const FHxlbHexLayerBase*> Layers, TFunctionRef<void(FHxlbHexBitmap&)> Compute);
+	void EvictOldest();
+	
+	TMap<FHxlbHexQuery, FEntry> Entries;
+	FHxlbHexBitmap Scratch;
+	uint64 UseCounter = 0;
+	FHxlbQueryCacheStats Stats;
+};
@@ -0,0 +1,114 @@
+// Copyright © Mason Stevenson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the disclaimer
+// below) provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+// THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+// CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+// NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+#include "Kismet/BlueprintFunctionLibrary.h"
+#include "Analysis/HxlbHexAggregate.h"
+#include "Analysis/HxlbInfluenceMap.h"
+#include "Analysis/HxlbRegionBorders.h"
+
+#include "HxlbAnalysisFunctions.generated.h"
+
+class UHxlbHexMapComponent;
+
+UCLASS()
+class HEXLIBRUNTIME_API UHxlbAnalysisFunctions : public UBlueprintFunctionLibrary
+{
+	GENERATED_BODY()
+
+public:
+	// Adds or changes a source of the map's influence map. Takes effect on the next UpdateInfluenceMap().
+	UFUNCTION(BlueprintCallable, Category = "Hex Analysis")
+	static void SetInfluenceSource(UHxlbHexMapComponent* HexMap, int32 SourceId, FHxlbInfluenceSource Source);
+
+	UFUNCTION(BlueprintCallable, Category = "Hex Analysis")
+	static void RemoveInfluenceSource(UHxlbHexMapComponent* HexMap, int32 SourceId);
+
+	// Recomputes the sources that changed since the last update, and the chunks they touch.
+	UFUNCTION(BlueprintCallable, Category = "Hex Analysis")
+	static void UpdateInfluenceMap(UHxlbHexMapComponent* HexMap);
+
+	UFUNCTION(BlueprintPure, Category = "Hex Analysis")
+	static float GetInfluence(UHxlbHexMapComponent* HexMap, int32 Faction, FIntPoint HexCoord);
+
+	// Sum of the influence of every faction but the given one.
+	UFUNCTION(BlueprintPure, Category = "Hex Analysis")
+	static float GetThreat(UHxlbHexMapComponent* HexMap, int32 Faction, FIntPoint HexCoord);
+
+	// Id of the region of connected hexes with the same non-zero value in the int32 layer that the hex belongs to, or
+	// -1 if the hex isn't in one.
+	UFUNCTION(BlueprintPure, Category = "Hex Analysis")
+	static int32 GetHexRegion(UHxlbHexMapComponent* HexMap, FName LayerName, FIntPoint HexCoord);
+
+	UFUNCTION(BlueprintPure, Category = "Hex Analysis")
+	static int32 GetRegionSize(UHxlbHexMapComponent* HexMap, FName LayerName, int32 RegionId);
+
+	// Every hex in the same region as the given hex.
+	UFUNCTION(BlueprintCallable, Category = "Hex Analysis")
+	static TArray<FIntPoint> GetRegionHexes(UHxlbHexMapComponent* HexMap, FName LayerName, FIntPoint HexCoord);
+
+	// Closed border loops around every hex with the given value in the int32 region id layer, in the same space as
+	// AxialToWorld. Empty if no hex has the value.
+	UFUNCTION(BlueprintCallable, Category = "Hex Analysis")
+	static TArray<FHxlbBorderLoop> GetRegionBorderLoops(UHxlbHexMapComponent* HexMap, FName LayerName, int32 RegionId);
+
+	// Coordinate of the super-hex that contains the hex, Level levels up the aperture-7 hierarchy. Level 0 is the hex
+	// itself.
+	UFUNCTION(BlueprintPure, Category = "Hex Analysis")
+	static FIntPoint GetSuperHex(FIntPoint HexCoord, int32 Level);
+
+	// Coordinate of the hex at the center of a super-hex.
+	UFUNCTION(BlueprintPure, Category = "Hex Analysis")
+	static FIntPoint GetSuperHexCenter(FIntPoint SuperHexCoord, int32 Level);
+
+	// Aggregate of a float or int32 layer over a super-hex, e.g. the total population or dominant terrain of a region.
+	UFUNCTION(BlueprintPure, Category = "Hex Analysis")
+	static float GetAggregateValue(UHxlbHexMapComponent* HexMap, FName LayerName, EHxlbAggregateOp Op, FIntPoint SuperHexCoord, int32 Level);
+
+	// Adds a float layer holding the distance from every hex to the nearest source, replacing any existing field with
+	// that name. Weighted distances add up movement costs instead of counting steps.
+	UFUNCTION(BlueprintCallable, Category = "Hex Analysis")
+	static void AddDistanceField(UHxlbHexMapComponent* HexMap, FName LayerName, const TArray<FIntPoint>& Sources, bool bWeighted = false);
+
+	UFUNCTION(BlueprintCallable, Category = "Hex Analysis")
+	static void AddDistanceSources(UHxlbHexMapComponent* HexMap, FName LayerName, const TArray<FIntPoint>& Sources);
+
+	UFUNCTION(BlueprintCallable, Category = "Hex Analysis")
+	static void RemoveDistanceSources(UHxlbHexMapComponent* HexMap, FName LayerName, const TArray<FIntPoint>& Sources);
+
+	// Distance to the nearest source of the field, or -1 if no source can reach the hex.
+	UFUNCTION(BlueprintPure, Category = "Hex Analysis")
+	static float GetDistanceToNearestSource(UHxlbHexMapComponent* HexMap, FName LayerName, FIntPoint HexCoord);
+
+	// Returns false if no source can reach the hex.
+	UFUNCTION(BlueprintPure, Category = "Hex Analysis")
+	static bool GetNearestSource(UHxlbHexMapComponent* HexMap, FName LayerName, FIntPoint HexCoord, FIntPoint& OutSourceCoord);
+};
@@ -0,0 +1,63 @@
+// Copyright © Mason Stevenson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the disclaimer
+// below) provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+// THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+// CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+// NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+#include "Kismet/BlueprintFunctionLibrary.h"
+#include "Generation/HxlbMapGeneration.h"
+
+#include "HxlbGenerationFunctions.generated.h"
+
+class UHxlbHexMapComponent;
+
+UCLASS()
+class HEXLIBRUNTIME_API UHxlbGenerationFunctions : public UBlueprintFunctionLibrary
+{
+	GENERATED_BODY()
+
+public:
+	// Generates elevation, moisture, biomes, rivers and resources into the map's hex layers. The same settings always
+	// produce the same map.
+	UFUNCTION(BlueprintCallable, Category = "Hex Generation")
+	static void GenerateMap(UHxlbHexMapComponent* HexMap, const FHxlbMapGenSettings& Settings);
+
+	// Splits the map into regions around random seed hexes and writes them into an int32 layer, from 1 to NumRegions.
+	UFUNCTION(BlueprintCallable, Category = "Hex Generation")
+	static void GenerateRegions(UHxlbHexMapComponent* HexMap, FName RegionLayerName, const FHxlbRegionGenSettings& Settings, int32 Seed);
+
+	// Regions of an int32 layer that share a border with RegionId, in ascending order. Region 0 is treated as no region.
+	// Scans the whole layer, so build an FHxlbRegionAdjacency from C++ to run many queries.
+	UFUNCTION(BlueprintCallable, Category = "Hex Generation")
+	static TArray<int32> GetAdjacentRegions(UHxlbHexMapComponent* HexMap, FName RegionLayerName, int32 RegionId);
+
+	// Whether a river runs along the edge of the hex in the given direction (see UHxlbMath::DirectionIndexToCube()).
+	UFUNCTION(BlueprintPure, Category = "Hex Generation")
+	static bool HasRiverEdge(UHxlbHexMapComponent* HexMap, FName RiverLayerName, FIntPoint HexCoord, int32 DirectionIndex);
+};
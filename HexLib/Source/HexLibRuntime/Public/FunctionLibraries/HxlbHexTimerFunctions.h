@@ -0,0 +1,61 @@
+// Copyright © Mason Stevenson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the disclaimer
+// below) provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+// THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+// CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+// NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+#include "Kismet/BlueprintFunctionLibrary.h"
+#include "Foundation/HxlbHexTimerWheel.h"
+
+#include "HxlbHexTimerFunctions.generated.h"
+
+class UHxlbHexMapComponent;
+
+UCLASS()
+class HEXLIBRUNTIME_API UHxlbHexTimerFunctions : public UBlueprintFunctionLibrary
+{
+	GENERATED_BODY()
+
+public:
+	// Fires once AdvanceHexTimers() has moved DelayTicks ticks forward. Returns a handle for CancelHexTimer(), or 0 if
+	// the hex isn't on the map.
+	UFUNCTION(BlueprintCallable, Category = "Hex Timers")
+	static int64 ScheduleHexEvent(UHxlbHexMapComponent* HexMap, FIntPoint HexCoord, int32 DelayTicks, int32 EventType, float Value = 0.0f);
+
+	// Sets the hex's value in a float layer when the timer fires, or adds to it if bAdd is true.
+	UFUNCTION(BlueprintCallable, Category = "Hex Timers")
+	static int64 ScheduleLayerChange(UHxlbHexMapComponent* HexMap, FName LayerName, FIntPoint HexCoord, int32 DelayTicks, float Value, bool bAdd = false);
+
+	UFUNCTION(BlueprintCallable, Category = "Hex Timers")
+	static bool CancelHexTimer(UHxlbHexMapComponent* HexMap, int64 Handle);
+
+	// Applies every layer change that comes due and returns every timer that fired, grouped by chunk.
+	UFUNCTION(BlueprintCallable, Category = "Hex Timers")
+	static TArray<FHxlbHexTimerFired> AdvanceHexTimers(UHxlbHexMapComponent* HexMap, int32 NumTicks = 1);
+};
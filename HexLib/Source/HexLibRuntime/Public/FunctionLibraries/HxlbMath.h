@@ -164,7 +164,24 @@ public:
 
 	// for when you want to walk through each direction in order
 	static FIntVector DirectionIndexToCube(int32 Index);
-	
+
+	// Same ordering as DirectionIndexToCube(), but skips the round trip through cube coordinates. Prefer this in hot
+	// loops that only need the axial offset of a neighbor.
+	static FORCEINLINE FIntPoint DirectionIndexToAxial(int32 Index)
+	{
+		static constexpr int32 DirectionQ[6] = {1, 1, 0, -1, -1, 0};
+		static constexpr int32 DirectionR[6] = {0, -1, -1, 0, 1, 1};
+		return FIntPoint(DirectionQ[Index], DirectionR[Index]);
+	}
+
+	// Same result as AxialDistance(), computed directly from axial coordinates so that it can be inlined into searches.
+	static FORCEINLINE int32 AxialDistanceFast(FIntPoint AxialCoordA, FIntPoint AxialCoordB)
+	{
+		const int32 DeltaQ = HEX_Q(AxialCoordA) - HEX_Q(AxialCoordB);
+		const int32 DeltaR = HEX_R(AxialCoordA) - HEX_R(AxialCoordB);
+		return (FMath::Abs(DeltaQ) + FMath::Abs(DeltaR) + FMath::Abs(DeltaQ + DeltaR)) / 2;
+	}
+
 protected:
 	// protected because you almost certainly want to use WorldToAxial instead.
 	static FIntPoint CartesianToAxial(
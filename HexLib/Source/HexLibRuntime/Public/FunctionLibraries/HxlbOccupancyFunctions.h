@@ -0,0 +1,72 @@
+// Copyright © Mason Stevenson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the disclaimer
+// below) provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+// THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+// CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+// NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+#include "Kismet/BlueprintFunctionLibrary.h"
+#include "Foundation/HxlbOccupancyIndex.h"
+
+#include "HxlbOccupancyFunctions.generated.h"
+
+class UHxlbHexMapComponent;
+
+UCLASS()
+class HEXLIBRUNTIME_API UHxlbOccupancyFunctions : public UBlueprintFunctionLibrary
+{
+	GENERATED_BODY()
+
+public:
+	// Places the entity on a hex, or moves it there if it is already on the map. Returns false if the hex isn't on the
+	// map.
+	UFUNCTION(BlueprintCallable, Category = "Hex Occupancy")
+	static bool SetEntityHex(UHxlbHexMapComponent* HexMap, int32 EntityId, FIntPoint HexCoord);
+
+	UFUNCTION(BlueprintCallable, Category = "Hex Occupancy")
+	static bool RemoveEntity(UHxlbHexMapComponent* HexMap, int32 EntityId);
+
+	// Returns false if the entity isn't on the map.
+	UFUNCTION(BlueprintPure, Category = "Hex Occupancy")
+	static bool GetEntityHex(UHxlbHexMapComponent* HexMap, int32 EntityId, FIntPoint& OutHexCoord);
+
+	UFUNCTION(BlueprintCallable, Category = "Hex Occupancy")
+	static TArray<int32> GetEntitiesOnHex(UHxlbHexMapComponent* HexMap, FIntPoint HexCoord);
+
+	// Entities within Radius of the hex, nearest first.
+	UFUNCTION(BlueprintCallable, Category = "Hex Occupancy")
+	static TArray<int32> GetEntitiesInRadius(UHxlbHexMapComponent* HexMap, FIntPoint HexCoord, int32 Radius);
+
+	// Up to Count entities nearest to the hex, looking no further than MaxRadius.
+	UFUNCTION(BlueprintCallable, Category = "Hex Occupancy")
+	static TArray<int32> GetNearestEntities(UHxlbHexMapComponent* HexMap, FIntPoint HexCoord, int32 Count, int32 MaxRadius = 16);
+
+	// Every entity caught by each of the effects, grouped by effect in the order given.
+	UFUNCTION(BlueprintCallable, Category = "Hex Occupancy")
+	static TArray<FHxlbAreaEffectHit> ResolveAreaEffects(UHxlbHexMapComponent* HexMap, const TArray<FHxlbAreaEffect>& Effects);
+};
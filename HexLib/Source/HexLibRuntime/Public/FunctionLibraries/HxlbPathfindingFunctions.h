@@ -0,0 +1,100 @@
+// Copyright © Mason Stevenson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the disclaimer
+// below) provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+// THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+// CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+// NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+#include "Kismet/BlueprintFunctionLibrary.h"
+#include "Navigation/HxlbCooperativePathfinding.h"
+#include "Navigation/HxlbPathfinding.h"
+
+#include "HxlbPathfindingFunctions.generated.h"
+
+class UHxlbHexMapComponent;
+
+UCLASS()
+class HEXLIBRUNTIME_API UHxlbPathfindingFunctions : public UBlueprintFunctionLibrary
+{
+	GENERATED_BODY()
+
+public:
+	// Finds the cheapest path from Start to Goal over the movement cost layer of the map. The cost layer is compiled on
+	// first use.
+	UFUNCTION(BlueprintCallable, Category = "Hex Pathfinding")
+	static FHxlbPathResult FindPath(UHxlbHexMapComponent* HexMap, FIntPoint Start, FIntPoint Goal, FHxlbPathQueryParams Params);
+
+	// Memory used by the landmark tables of the map, per landmark. Builds the tables if they haven't been yet.
+	UFUNCTION(BlueprintPure, Category = "Hex Pathfinding")
+	static int64 GetLandmarkMemoryPerLandmark(UHxlbHexMapComponent* HexMap);
+
+	// Same as FindPath(), but plans on the hierarchical graph of the map first. Much faster across large maps, at the
+	// price of paths that are close to, but not always exactly, the cheapest ones.
+	UFUNCTION(BlueprintCallable, Category = "Hex Pathfinding")
+	static FHxlbPathResult FindPathHierarchical(UHxlbHexMapComponent* HexMap, FIntPoint Start, FIntPoint Goal);
+
+	// Plans a group of agents together so that they don't run into each other, e.g. a formation moving through a
+	// chokepoint. Results are in the order of Requests, and each path lists the hex the agent occupies at every tick,
+	// waits included. Replan before Params.Window ticks have passed.
+	UFUNCTION(BlueprintCallable, Category = "Hex Pathfinding")
+	static TArray<FHxlbPathResult> PlanGroupPaths(UHxlbHexMapComponent* HexMap, const TArray<FHxlbAgentPathRequest>& Requests, FHxlbCooperativePathParams Params);
+
+	// Starts or moves an agent along a path that the map keeps repairing as movement costs change. Call again with the
+	// agent's current hex as it moves; changing the goal starts a new search. Returns false if a hex is off the map.
+	UFUNCTION(BlueprintCallable, Category = "Hex Pathfinding")
+	static bool SetAgentPath(UHxlbHexMapComponent* HexMap, int32 AgentId, FIntPoint Start, FIntPoint Goal);
+
+	// The current cheapest path of an agent registered with SetAgentPath(), repaired first if costs changed.
+	UFUNCTION(BlueprintCallable, Category = "Hex Pathfinding")
+	static FHxlbPathResult GetAgentPath(UHxlbHexMapComponent* HexMap, int32 AgentId);
+
+	UFUNCTION(BlueprintCallable, Category = "Hex Pathfinding")
+	static bool RemoveAgentPath(UHxlbHexMapComponent* HexMap, int32 AgentId);
+
+	// Samples the flow field toward Goals, which is built and cached by the map on first use. Returns false if the hex
+	// is one of the goals or can't reach any of them. Cheap enough to call for every unit every frame.
+	UFUNCTION(BlueprintCallable, Category = "Hex Pathfinding")
+	static bool GetFlowFieldNextHex(UHxlbHexMapComponent* HexMap, const TArray<FIntPoint>& Goals, FIntPoint HexCoord, FIntPoint& OutNextHex);
+
+	// Every hex that can be reached from Origin for at most MaxCost, including Origin. With bUniformCost, every
+	// passable hex costs one step regardless of its movement cost.
+	UFUNCTION(BlueprintCallable, Category = "Hex Pathfinding")
+	static TArray<FIntPoint> GetMovementRange(UHxlbHexMapComponent* HexMap, FIntPoint Origin, float MaxCost, bool bUniformCost = false);
+
+	// Recompiles the whole movement cost layer, e.g. after changing the movement cost settings of the map.
+	UFUNCTION(BlueprintCallable, Category = "Hex Pathfinding")
+	static void CompileMovementCosts(UHxlbHexMapComponent* HexMap);
+
+	// Recompiles the movement cost of a few hexes, e.g. after changing their gameplay tags.
+	UFUNCTION(BlueprintCallable, Category = "Hex Pathfinding")
+	static void UpdateMovementCosts(UHxlbHexMapComponent* HexMap, const TArray<FIntPoint>& HexCoords);
+
+	// Returns false if the hex is outside of the map. Blocked hexes have a cost of TNumericLimits<float>::Max().
+	UFUNCTION(BlueprintPure, Category = "Hex Pathfinding")
+	static bool GetMovementCost(UHxlbHexMapComponent* HexMap, FIntPoint HexCoord, float& OutCost);
+};
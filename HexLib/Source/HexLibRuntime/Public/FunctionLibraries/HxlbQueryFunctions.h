@@ -0,0 +1,76 @@
+// Copyright © Mason Stevenson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the disclaimer
+// below) provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+// THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+// CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+// NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+#include "Kismet/BlueprintFunctionLibrary.h"
+#include "GameplayTagContainer.h"
+#include "Foundation/HxlbHexQueryBuilder.h"
+#include "Foundation/HxlbQueryCache.h"
+
+#include "HxlbQueryFunctions.generated.h"
+
+class UHxlbHexMapComponent;
+
+UCLASS()
+class HEXLIBRUNTIME_API UHxlbQueryFunctions : public UBlueprintFunctionLibrary
+{
+	GENERATED_BODY()
+
+public:
+	// Hexes found by the query, served from the map's query cache when nothing it depends on has changed.
+	UFUNCTION(BlueprintCallable, Category = "Hex Queries")
+	static TArray<FIntPoint> QueryHexes(UHxlbHexMapComponent* HexMap, const FHxlbHexQuery& Query);
+
+	// Same as checking whether QueryHexes() returns the hex, without building the array.
+	UFUNCTION(BlueprintCallable, Category = "Hex Queries")
+	static bool IsHexInQuery(UHxlbHexMapComponent* HexMap, const FHxlbHexQuery& Query, FIntPoint HexCoord);
+
+	UFUNCTION(BlueprintPure, Category = "Hex Queries")
+	static FHxlbQueryCacheStats GetQueryCacheStats(UHxlbHexMapComponent* HexMap);
+
+	UFUNCTION(BlueprintCallable, Category = "Hex Queries")
+	static void ResetQueryCacheStats(UHxlbHexMapComponent* HexMap);
+
+	// Hexes within Radius of Origin that pass every layer condition, have all of RequiredTags and none of ExcludedTags.
+	// Nearest first unless bNearestFirst is false, in which case they come out in no particular order. A MaxResults of 0
+	// returns every match. Nothing matches if a condition names a layer that isn't a float or int32 layer.
+	UFUNCTION(BlueprintCallable, Category = "Hex Queries", meta = (AutoCreateRefTerm = "LayerConditions,RequiredTags,ExcludedTags"))
+	static TArray<FIntPoint> FindHexesNear(
+		UHxlbHexMapComponent* HexMap,
+		FIntPoint Origin,
+		int32 Radius,
+		const TArray<FHxlbLayerCondition>& LayerConditions,
+		const FGameplayTagContainer& RequiredTags,
+		const FGameplayTagContainer& ExcludedTags,
+		bool bNearestFirst = true,
+		int32 MaxResults = 0
+	);
+};
@@ -0,0 +1,87 @@
+// Copyright © Mason Stevenson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the disclaimer
+// below) provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+// THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+// CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+// NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+#include "Kismet/BlueprintFunctionLibrary.h"
+#include "Vision/HxlbCoverMap.h"
+#include "Vision/HxlbFieldOfView.h"
+
+#include "HxlbVisionFunctions.generated.h"
+
+class UHxlbHexMapComponent;
+
+UCLASS()
+class HEXLIBRUNTIME_API UHxlbVisionFunctions : public UBlueprintFunctionLibrary
+{
+	GENERATED_BODY()
+
+public:
+	// Every hex the observer can see, using the elevation and opacity layers named in the vision settings of the map.
+	UFUNCTION(BlueprintCallable, Category = "Hex Vision")
+	static TArray<FIntPoint> GetVisibleHexes(UHxlbHexMapComponent* HexMap, FHxlbVisionObserver Observer);
+
+	// Every hex that any of the observers can see. Observers are computed in parallel.
+	UFUNCTION(BlueprintCallable, Category = "Hex Vision")
+	static TArray<FIntPoint> GetVisibleHexesForObservers(UHxlbHexMapComponent* HexMap, const TArray<FHxlbVisionObserver>& Observers);
+
+	// Adds or moves an observer of the player's fog of war. Takes effect on the next UpdateFogOfWar().
+	UFUNCTION(BlueprintCallable, Category = "Hex Vision")
+	static void SetVisionObserver(UHxlbHexMapComponent* HexMap, int32 PlayerId, int32 ObserverId, FHxlbVisionObserver Observer);
+
+	UFUNCTION(BlueprintCallable, Category = "Hex Vision")
+	static void RemoveVisionObserver(UHxlbHexMapComponent* HexMap, int32 PlayerId, int32 ObserverId);
+
+	// Recomputes the observers that changed since the last update, for every player.
+	UFUNCTION(BlueprintCallable, Category = "Hex Vision")
+	static void UpdateFogOfWar(UHxlbHexMapComponent* HexMap);
+
+	// Hexes of the player that became visible or hidden during the last UpdateFogOfWar().
+	UFUNCTION(BlueprintPure, Category = "Hex Vision")
+	static void GetFogOfWarChanges(UHxlbHexMapComponent* HexMap, int32 PlayerId, TArray<FIntPoint>& OutBecameVisible, TArray<FIntPoint>& OutBecameHidden);
+
+	UFUNCTION(BlueprintPure, Category = "Hex Vision")
+	static bool IsHexVisibleToPlayer(UHxlbHexMapComponent* HexMap, int32 PlayerId, FIntPoint HexCoord);
+
+	UFUNCTION(BlueprintPure, Category = "Hex Vision")
+	static bool WasHexSeenByPlayer(UHxlbHexMapComponent* HexMap, int32 PlayerId, FIntPoint HexCoord);
+
+	// Cover of the hex along the edge toward its neighbor in the given direction (see UHxlbMath::DirectionIndexToCube()).
+	UFUNCTION(BlueprintPure, Category = "Hex Vision")
+	static EHxlbCoverLevel GetHexEdgeCover(UHxlbHexMapComponent* HexMap, FIntPoint HexCoord, int32 DirectionIndex);
+
+	// Best cover of the hex against a threat, from the edges that face the threat.
+	UFUNCTION(BlueprintPure, Category = "Hex Vision")
+	static EHxlbCoverLevel GetHexCoverAgainst(UHxlbHexMapComponent* HexMap, FIntPoint HexCoord, FIntPoint ThreatCoord);
+
+	// Number of threats against which the hex has less than MinCover.
+	UFUNCTION(BlueprintPure, Category = "Hex Vision")
+	static int32 CountHexExposures(UHxlbHexMapComponent* HexMap, FIntPoint HexCoord, const TArray<FIntPoint>& ThreatCoords, EHxlbCoverLevel MinCover = EHxlbCoverLevel::Half);
+};
@@ -0,0 +1,416 @@
+// Copyright © Mason Stevenson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the disclaimer
+// below) provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+// THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+// CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+// NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+#include "Foundation/HxlbDenseLayout.h"
+#include "Foundation/HxlbHexLayers.h"
+#include "Foundation/HxlbHexRanges.h"
+#include "Templates/SharedPointer.h"
+
+#include "HxlbMapGeneration.generated.h"
+
+// Counter-based random numbers for map generation. Every value is a pure function of the seed, a stream id and a hex
+// coordinate, so a generated map doesn't depend on the order in which hexes are visited, or on the number of threads.
+// Stages use distinct streams so that their numbers are independent.
+namespace HxlbHexRandom
+{
+	FORCEINLINE uint32 Mix(uint32 Value)
+	{
+		Value ^= Value >> 16;
+		Value *= 0x7feb352dU;
+		Value ^= Value >> 15;
+		Value *= 0x846ca68bU;
+		Value ^= Value >> 16;
+		return Value;
+	}
+
+	FORCEINLINE uint32 Hash(int32 Seed, uint32 Stream, int32 X, int32 Y)
+	{
+		uint32 Value = Mix(static_cast<uint32>(Seed) + 0x9e3779b9U * (Stream + 1));
+		Value = Mix(Value ^ static_cast<uint32>(X));
+		return Mix(Value ^ (static_cast<uint32>(Y) * 0x85ebca6bU));
+	}
+
+	// In [0, 1).
+	FORCEINLINE float FRand(int32 Seed, uint32 Stream, FIntPoint AxialCoord)
+	{
+		return static_cast<float>(Hash(Seed, Stream, AxialCoord.X, AxialCoord.Y) >> 8) * (1.0f / 16777216.0f);
+	}
+
+	// Fractal value noise at the center of a hex, in [0, 1]. Sampled in cartesian space, so features aren't skewed
+	// along the axial axes.
+	HEXLIBRUNTIME_API float FractalNoise(int32 Seed, uint32 Stream, FIntPoint AxialCoord, float Frequency, int32 Octaves, float Lacunarity, float Persistence);
+}
+
+USTRUCT(BlueprintType)
+struct HEXLIBRUNTIME_API FHxlbNoiseSettings
+{
+	GENERATED_BODY()
+
+	// Features per hex. 0.05 gives blobs roughly 20 hexes across.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta=(ClampMin="0.0001"), Category="Map Generation")
+	float Frequency = 0.05f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta=(ClampMin="1", ClampMax="12"), Category="Map Generation")
+	int32 Octaves = 4;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Map Generation")
+	float Lacunarity = 2.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Map Generation")
+	float Persistence = 0.5f;
+
+	// The noise is remapped from [0, 1] to [MinValue, MaxValue].
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Map Generation")
+	float MinValue = 0.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Map Generation")
+	float MaxValue = 1.0f;
+};
+
+// Hexes whose elevation and moisture both fall in [Min, Max) get the biome. Rules are checked in order.
+USTRUCT(BlueprintType)
+struct HEXLIBRUNTIME_API FHxlbBiomeRule
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Map Generation")
+	int32 Biome = 0;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Map Generation")
+	float MinElevation = -UE_BIG_NUMBER;
+	
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Map Generation")
+	float MaxElevation = UE_BIG_NUMBER;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Map Generation")
+	float MinMoisture = -UE_BIG_NUMBER;
+	
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Map Generation")
+	float MaxMoisture = UE_BIG_NUMBER;
+};
+
+// Places a resource on a hex with the given chance. Rules are checked in order, and a hex gets at most one resource.
+USTRUCT(BlueprintType)
+struct HEXLIBRUNTIME_API FHxlbResourceRule
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Map Generation")
+	int32 Resource = 1;
+
+	// Empty means any biome.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Map Generation")
+	TArray<int32> Biomes;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta=(ClampMin="0.0", ClampMax="1.0"), Category="Map Generation")
+	float Chance = 0.05f;
+};
+
+// Splits the map into regions around seed hexes picked at random, e.g. provinces or AI zones (see FHxlbVoronoiPartition).
+USTRUCT(BlueprintType)
+struct HEXLIBRUNTIME_API FHxlbRegionGenSettings
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta=(ClampMin="1"), Category="Map Generation")
+	int32 NumRegions = 12;
+
+	// Lloyd relaxation steps, which make regions more even in size and shape.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta=(ClampMin="0"), Category="Map Generation")
+	int32 LloydIterations = 2;
+
+	// float layer read as the cost of entering each hex, so that regions grow around expensive terrain instead of
+	// across it. None measures distance in hex steps.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Map Generation")
+	FName CostLayerName;
+
+	// Costs below this are raised to it.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta=(ClampMin="0.001"), Category="Map Generation")
+	float MinimumCost = 0.1f;
+};
+
+// The standard generation pipeline: elevation and moisture noise, biome classification, rivers and resources. Any
+// stage whose layer name is None is skipped.
+USTRUCT(BlueprintType)
+struct HEXLIBRUNTIME_API FHxlbMapGenSettings
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Map Generation")
+	int32 Seed = 0;
+	
+	// float layer
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Map Generation|Elevation")
+	FName ElevationLayerName = TEXT("Elevation");
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Map Generation|Elevation")
+	FHxlbNoiseSettings ElevationNoise;
+
+	// Hexes below sea level are water. Rivers end when they reach them.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Map Generation|Elevation")
+	float SeaLevel = 0.35f;
+
+	// float layer
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Map Generation|Moisture")
+	FName MoistureLayerName = TEXT("Moisture");
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Map Generation|Moisture")
+	FHxlbNoiseSettings MoistureNoise;
+
+	// int32 layer, read from elevation and moisture
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Map Generation|Biomes")
+	FName BiomeLayerName = TEXT("Biome");
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Map Generation|Biomes")
+	TArray<FHxlbBiomeRule> BiomeRules;
+	
+	// Biome of hexes that match no rule.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Map Generation|Biomes")
+	int32 DefaultBiome = 0;
+
+	// uint8 layer holding one bit per hex edge (see UHxlbMath::DirectionIndexToAxial() for the edge order).
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Map Generation|Rivers")
+	FName RiverLayerName = TEXT("RiverEdges");
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta=(ClampMin="0"), Category="Map Generation|Rivers")
+	int32 NumRivers = 8;
+
+	// Rivers only start on hexes at least this high.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Map Generation|Rivers")
+	float RiverSourceMinElevation = 0.6f;
+
+	// int32 layer, where 0 means no resource
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Map Generation|Resources")
+	FName ResourceLayerName = TEXT("Resource");
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Map Generation|Resources")
+	TArray<FHxlbResourceRule> ResourceRules;
+
+	// int32 layer holding region ids from 1 to NumRegions, where 0 means no region. Off by default.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Map Generation|Regions")
+	FName RegionLayerName;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Map Generation|Regions")
+	FHxlbRegionGenSettings RegionSettings;
+};
+
+// What generation stages run on: the layout, the layers of the map and the seed.
+class HEXLIBRUNTIME_API FHxlbMapGenContext
+{
+public:
+	FHxlbMapGenContext(const FHxlbDenseLayout& NewLayout, TMap<FName, TSharedRef<FHxlbHexLayerBase>>& NewLayers, int32 NewSeed)
+		: Layout(NewLayout)
+		, Layers(NewLayers)
+		, Seed(NewSeed)
+	{}
+
+	const FHxlbDenseLayout& GetLayout() const { return Layout; }
+	int32 GetSeed() const { return Seed; }
+
+	template <typename ValueType>
+	const THxlbHexLayer<ValueType>* FindLayer(FName LayerName) const
+	{
+		const TSharedRef<FHxlbHexLayerBase>* Layer = Layers.Find(LayerName);
+		if (!Layer || FCString::Strcmp((*Layer)->GetTypeName(), THxlbHexLayer<ValueType>::StaticTypeName()) != 0)
+		{
+			return nullptr;
+		}
+		return static_cast<const THxlbHexLayer<ValueType>*>(&Layer->Get());
+	}
+
+	// Finds or adds the layer and marks it as fully changed. Null if a layer with that name holds another type.
+	template <typename ValueType>
+	THxlbHexLayer<ValueType>* WriteLayer(FName LayerName, const ValueType& DefaultValue = ValueType())
+	{
+		if (!Layers.Contains(LayerName))
+		{
+			TSharedRef<THxlbHexLayer<ValueType>> NewLayer = MakeShared<THxlbHexLayer<ValueType>>(LayerName, DefaultValue);
+			NewLayer->Resize(Layout);
+			Layers.Add(LayerName, NewLayer);
+		}
+		
+		THxlbHexLayer<ValueType>* Layer = const_cast<THxlbHexLayer<ValueType>*>(FindLayer<ValueType>(LayerName));
+		if (Layer)
+		{
+			Layer->MarkAllChanged();
+			WrittenLayers.AddUnique(LayerName);
+		}
+		return Layer;
+	}
+
+	TConstArrayView<FName> GetWrittenLayers() const { return WrittenLayers; }
+
+	// Calls Func(int32 ChunkIndex) for every chunk, in parallel unless bForceSingleThread is set. Both give the same map.
+	template <typename FuncType>
+	void ForEachChunk(FuncType&& Func) const
+	{
+		HxlbParallelForEachChunk(Layout, Func, bForceSingleThread);
+	}
+
+	// Calls Func(FIntPoint AxialCoord, int32 DenseIndex) for every hex, in parallel across chunks.
+	template <typename FuncType>
+	void ForEachHex(FuncType&& Func) const
+	{
+		ForEachChunk([this, &Func](int32 ChunkIndex)
+		{
+			Layout.ForEachChunkSpan(ChunkIndex, [&Func](const FHxlbHexRowSpan& Span, int32 FirstIndex)
+			{
+				for (int32 Q = Span.QMin; Q <= Span.QMax; ++Q)
+				{
+					Func(FIntPoint(Q, Span.R), FirstIndex + Q - Span.QMin);
+				}
+			});
+		});
+	}
+
+	bool bForceSingleThread = false;
+
+private:
+	const FHxlbDenseLayout& Layout;
+	TMap<FName, TSharedRef<FHxlbHexLayerBase>>& Layers;
+	int32 Seed = 0;
+	TArray<FName> WrittenLayers;
+};
+
+// One step of a generation pipeline. Stages run one after another, and each stage may read the layers written by the
+// stages before it. Stages must only draw random numbers from HxlbHexRandom so that the result is deterministic.
+class HEXLIBRUNTIME_API FHxlbMapGenStage
+{
+public:
+	virtual ~FHxlbMapGenStage() = default;
+	virtual void Run(FHxlbMapGenContext& Context) const = 0;
+};
+
+// Writes fractal noise into a float layer.
+class HEXLIBRUNTIME_API FHxlbNoiseStage : public FHxlbMapGenStage
+{
+public:
+	FHxlbNoiseStage(FName NewLayerName, const FHxlbNoiseSettings& NewSettings, uint32 NewStream)
+		: LayerName(NewLayerName), Settings(NewSettings), Stream(NewStream) {}
+
+	virtual void Run(FHxlbMapGenContext& Context) const override;
+
+private:
+	FName LayerName;
+	FHxlbNoiseSettings Settings;
+	uint32 Stream;
+};
+
+// Classifies every hex into a biome from its elevation and moisture. Missing input layers read as zero.
+class HEXLIBRUNTIME_API FHxlbBiomeStage : public FHxlbMapGenStage
+{
+public:
+	FHxlbBiomeStage(FName NewLayerName, FName NewElevationLayerName, FName NewMoistureLayerName, TArray<FHxlbBiomeRule> NewRules, int32 NewDefaultBiome)
+		: LayerName(NewLayerName), ElevationLayerName(NewElevationLayerName), MoistureLayerName(NewMoistureLayerName)
+		, Rules(MoveTemp(NewRules)), DefaultBiome(NewDefaultBiome) {}
+	
+	virtual void Run(FHxlbMapGenContext& Context) const override;
+
+private:
+	FName LayerName;
+	FName ElevationLayerName;
+	FName MoistureLayerName;
+	TArray<FHxlbBiomeRule> Rules;
+	int32 DefaultBiome;
+};
+
+// Runs rivers downhill along hex edges, from corner to corner, until they reach water, the edge of the map or a local
+// minimum. The elevation of a corner is the mean elevation of the three hexes that share it. Rivers are traced in
+// parallel and merged by setting edge bits, which doesn't depend on the order they finish in.
+class HEXLIBRUNTIME_API FHxlbRiverStage : public FHxlbMapGenStage
+{
+public:
+	FHxlbRiverStage(FName NewLayerName, FName NewElevationLayerName, int32 NewNumRivers, float NewSourceMinElevation, float NewSeaLevel, uint32 NewStream)
+		: LayerName(NewLayerName), ElevationLayerName(NewElevationLayerName), NumRivers(NewNumRivers)
+		, SourceMinElevation(NewSourceMinElevation), SeaLevel(NewSeaLevel), Stream(NewStream) {}
+	
+	virtual void Run(FHxlbMapGenContext& Context) const override;
+
+private:
+	FName LayerName;
+	FName ElevationLayerName;
+	int32 NumRivers;
+	float SourceMinElevation;
+	float SeaLevel;
+	uint32 Stream;
+};
+
+// Scatters resources over the map. Each rule rolls its own stream, so adding a rule doesn't move the others.
+class HEXLIBRUNTIME_API FHxlbResourceStage : public FHxlbMapGenStage
+{
+public:
+	FHxlbResourceStage(FName NewLayerName, FName NewBiomeLayerName, TArray<FHxlbResourceRule> NewRules, uint32 NewStream)
+		: LayerName(NewLayerName), BiomeLayerName(NewBiomeLayerName), Rules(MoveTemp(NewRules)), Stream(NewStream) {}
+	
+	virtual void Run(FHxlbMapGenContext& Context) const override;
+
+private:
+	FName LayerName;
+	FName BiomeLayerName;
+	TArray<FHxlbResourceRule> Rules;
+	uint32 Stream;
+};
+
+// Partitions the map into regions around random seed hexes and writes the region of every hex, from 1 to NumRegions.
+// Hexes that no seed can reach get 0. Build an FHxlbRegionAdjacency over the layer to find which regions touch.
+class HEXLIBRUNTIME_API FHxlbRegionStage : public FHxlbMapGenStage
+{
+public:
+	FHxlbRegionStage(FName NewLayerName, const FHxlbRegionGenSettings& NewSettings, uint32 NewStream)
+		: LayerName(NewLayerName), Settings(NewSettings), Stream(NewStream) {}
+	
+	virtual void Run(FHxlbMapGenContext& Context) const override;
+
+private:
+	FName LayerName;
+	FHxlbRegionGenSettings Settings;
+	uint32 Stream;
+};
+
+// A list of generation stages. The same seed produces the same map regardless of the number of worker threads.
+class HEXLIBRUNTIME_API FHxlbMapGenerator
+{
+public:
+	// The standard pipeline described by the settings.
+	static FHxlbMapGenerator FromSettings(const FHxlbMapGenSettings& Settings);
+	
+	FHxlbMapGenerator& AddStage(TSharedRef<const FHxlbMapGenStage> Stage)
+	{
+		Stages.Add(MoveTemp(Stage));
+		return *this;
+	}
+
+	void Run(FHxlbMapGenContext& Context) const;
+
+private:
+	TArray<TSharedRef<const FHxlbMapGenStage>> Stages;
+};
@@ -0,0 +1,182 @@
+// Copyright © Mason Stevenson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the disclaimer
+// below) provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+// THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+// CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+// NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+#include "Containers/Array.h"
+#include "Containers/Map.h"
+#include "Navigation/HxlbCostField.h"
+#include "Navigation/HxlbPathfinding.h"
+#include "Navigation/HxlbSearchScratch.h"
+
+#include "HxlbCooperativePathfinding.generated.h"
+
+USTRUCT(BlueprintType)
+struct HEXLIBRUNTIME_API FHxlbAgentPathRequest
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Pathfinding")
+	FIntPoint Start = FIntPoint::ZeroValue;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Pathfinding")
+	FIntPoint Goal = FIntPoint::ZeroValue;
+
+	// Agents with a higher priority are planned first, and the others plan around them. Equal priorities keep the order
+	// of the requests.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Pathfinding")
+	int32 Priority = 0;
+};
+
+USTRUCT(BlueprintType)
+struct HEXLIBRUNTIME_API FHxlbCooperativePathParams
+{
+	GENERATED_BODY()
+
+	// How many ticks ahead agents plan and reserve. Replan before the window runs out.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta=(ClampMin="1"), Category="Pathfinding")
+	int32 Window = 16;
+
+	// Bounds the cost of planning each agent. Agents that run out of expansions get a partial path.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta=(ClampMin="1"), Category="Pathfinding")
+	int32 MaxExpansionsPerAgent = 2048;
+
+	// Cost of waiting one tick in place.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta=(ClampMin="0.0"), Category="Pathfinding")
+	float WaitCost = 1.0f;
+};
+
+// Open addressing hash map from a packed (dense index, tick) key to an int32, with linear probing. Reset() keeps the
+// allocation, so a table that is reused from one plan to the next stops allocating once it has grown.
+class HEXLIBRUNTIME_API FHxlbSpaceTimeTable
+{
+public:
+	static FORCEINLINE uint64 PackKey(int32 DenseIndex, int32 Tick)
+	{
+		return (static_cast<uint64>(static_cast<uint32>(Tick)) << 32) | static_cast<uint32>(DenseIndex);
+	}
+	
+	void Reset();
+	int32 Num() const { return NumUsed; }
+
+	// INDEX_NONE if the key isn't in the table.
+	int32 Find(uint64 Key) const;
+
+	// Adds the key with Value if it isn't in the table yet. Returns the value stored for the key either way.
+	int32& FindOrAdd(uint64 Key, int32 Value);
+
+protected:
+	static constexpr uint64 kEmptyKey = MAX_uint64;
+	
+	static FORCEINLINE uint32 HashKey(uint64 Key)
+	{
+		Key ^= Key >> 33;
+		Key *= 0xff51afd7ed558ccdULL;
+		Key ^= Key >> 33;
+		return static_cast<uint32>(Key);
+	}
+	void Grow();
+
+	TArray<uint64> Keys;
+	TArray<int32> Values;
+	int32 NumUsed = 0;
+};
+
+// Windowed cooperative A* (WHCA*) for groups of agents moving on the same map.
+//
+// Agents are planned one at a time over (hex, tick) states, where every tick an agent either moves to a neighbor or
+// waits in place. Each planned path is written into a reservation table, and later agents treat reserved states as
+// blocked: they can't enter a hex another agent holds at that tick, and can't swap hexes with another agent. Only the
+// next Window ticks are planned, which keeps the cost of each agent bounded. Agents are expected to replan before their
+// window runs out. An agent that reaches its goal within the window holds it for the rest of the window.
+//
+// In a group, agents are planned in order of priority, and an agent planned later gets out of the way of paths planned
+// before it. If it can't, because it is boxed in at its start (say at the end of a dead-end corridor), the paths that
+// run into it are planned again around it.
+//
+// Result paths list the hex occupied at every tick, starting with the start hex at tick 0, so waits show up as
+// repeated hexes.
+class HEXLIBRUNTIME_API FHxlbCooperativePlanner
+{
+public:
+	// Forgets every reservation.
+	void Reset();
+
+	// Plans every agent in one call, in order of priority, against an empty reservation table. Every start hex is
+	// reserved at tick 0 before the first agent is planned. OutResults is in the order of Requests.
+	void PlanGroup(const FHxlbCostField& CostField, TConstArrayView<FHxlbAgentPathRequest> Requests, const FHxlbCooperativePathParams& Params, TArray<FHxlbPathResult>& OutResults);
+
+	// Plans a single agent against the current reservations and then reserves its path, replacing whatever the agent
+	// held before. Found if the agent reaches its goal within the window, Partial if it is on its way, and NoPath if it
+	// has to wait in place.
+	EHxlbPathStatus PlanAgent(const FHxlbCostField& CostField, int32 AgentId, const FHxlbAgentPathRequest& Request, const FHxlbCooperativePathParams& Params, FHxlbPathResult& OutResult);
+
+	// Id of the agent that holds the hex at the tick, or INDEX_NONE.
+	int32 GetReservation(int32 DenseIndex, int32 Tick) const { return Reservations.Find(FHxlbSpaceTimeTable::PackKey(DenseIndex, Tick)); }
+
+	// States that couldn't be reserved since the last Reset() because another agent already held them, e.g. an agent
+	// planned on its own that can't stay where its path ends, or two agents given the same start. Zero means the plans
+	// don't collide.
+	int32 GetNumConflicts() const { return NumConflicts; }
+
+protected:
+	bool CanMove(int32 AgentId, int32 FromIndex, int32 ToIndex, int32 Tick) const;
+	bool CanHold(int32 AgentId, int32 DenseIndex, int32 Tick, int32 Window) const;
+
+	// Returns false, and counts a conflict, if another agent holds the state. Holders of states after tick 0 are added
+	// to Blockers.
+	bool Reserve(int32 AgentId, int32 DenseIndex, int32 Tick);
+	void ReleaseAgent(int32 AgentId);
+
+	// Reserves the states along the path that ends at EndNode, then holds its last hex until the end of the window.
+	void ReservePath(int32 AgentId, int32 EndNode, int32 Window);
+
+	struct FNode
+	{
+		int32 DenseIndex = INDEX_NONE;
+		int32 Tick = 0;
+		float Cost = 0.0f;
+		int32 Parent = INDEX_NONE;
+		bool bClosed = false;
+	};
+	
+	// Released states are kept with INDEX_NONE as their holder.
+	FHxlbSpaceTimeTable Reservations;
+	TMap<int32, TArray<uint64>> AgentReservations;
+	int32 NumConflicts = 0;
+
+	// Agents whose reservations were in the way of the path last reserved.
+	TArray<int32> Blockers;
+
+	// Search state, reused from one agent to the next.
+	FHxlbSpaceTimeTable NodeIndices;
+	TArray<FNode> Nodes;
+	FHxlbNodeHeap Heap;
+};
@@ -0,0 +1,127 @@
+// Copyright © Mason Stevenson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the disclaimer
+// below) provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+// THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+// CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+// NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+#include "GameplayTagContainer.h"
+#include "Foundation/HxlbDenseLayout.h"
+
+#include "HxlbCostField.generated.h"
+
+// Extra cost for entering hexes that have a given gameplay tag.
+USTRUCT(BlueprintType)
+struct HEXLIBRUNTIME_API FHxlbTagMovementCost
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (Categories = "HexGame.Map"), Category="Movement Cost")
+	FGameplayTag Tag;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Movement Cost")
+	float AdditionalCost = 0.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Movement Cost")
+	bool bBlocksMovement = false;
+};
+
+// Extra cost for entering a hex, proportional to the hex's value in a float hex layer (e.g. elevation or slope).
+USTRUCT(BlueprintType)
+struct HEXLIBRUNTIME_API FHxlbLayerMovementCost
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Movement Cost")
+	FName LayerName;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Movement Cost")
+	float CostPerUnit = 1.0f;
+
+	// Hexes whose layer value is at or above the threshold can't be entered.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Movement Cost")
+	bool bBlockAboveThreshold = false;
+	
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta=(EditCondition="bBlockAboveThreshold"), Category="Movement Cost")
+	float BlockingThreshold = 0.0f;
+};
+
+// Describes how the cost layer of a hex map is compiled. The cost of entering a hex is BaseCost, plus the cost of each
+// matching tag, plus the cost of each layer. Costs are clamped to MinimumCost so that path heuristics stay admissible.
+USTRUCT(BlueprintType)
+struct HEXLIBRUNTIME_API FHxlbMovementCostSettings
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta=(ClampMin="0.001"), Category="Movement Cost")
+	float BaseCost = 1.0f;
+	
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta=(ClampMin="0.001"), Category="Movement Cost")
+	float MinimumCost = 0.1f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Movement Cost")
+	TArray<FHxlbTagMovementCost> TagCosts;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Movement Cost")
+	TArray<FHxlbLayerMovementCost> LayerCosts;
+};
+
+namespace HxlbMovementCost
+{
+	// Cost of a hex that can't be entered.
+	inline constexpr float Blocked = TNumericLimits<float>::Max();
+
+	FORCEINLINE bool IsBlocked(float Cost) { return Cost >= Blocked; }
+}
+
+// Read-only view of a compiled cost layer, which is what the searches in this folder run on. The cost of a hex is the
+// cost of entering it. The view doesn't own anything, so the layout and the costs must outlive it.
+struct HEXLIBRUNTIME_API FHxlbCostField
+{
+public:
+	FHxlbCostField() = default;
+	FHxlbCostField(const FHxlbDenseLayout& NewLayout, TConstArrayView<float> NewCosts, float NewMinCost)
+		: Layout(&NewLayout)
+		, Costs(NewCosts)
+		, MinCost(NewMinCost)
+	{}
+
+	bool IsValid() const { return Layout && Layout->IsValid() && Costs.Num() == Layout->Num() && MinCost > 0.0f; }
+	
+	const FHxlbDenseLayout& GetLayout() const { return *Layout; }
+	FORCEINLINE float GetCost(int32 DenseIndex) const { return Costs[DenseIndex]; }
+	FORCEINLINE bool IsBlocked(int32 DenseIndex) const { return HxlbMovementCost::IsBlocked(Costs[DenseIndex]); }
+
+	// A lower bound on the cost of entering any hex. Multiplied by a hex distance, it gives an admissible heuristic.
+	float GetMinCost() const { return MinCost; }
+
+protected:
+	const FHxlbDenseLayout* Layout = nullptr;
+	TConstArrayView<float> Costs;
+	float MinCost = 1.0f;
+};
@@ -0,0 +1,126 @@
+// Copyright © Mason Stevenson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the disclaimer
+// below) provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+// THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+// CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+// NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+#include "Containers/Set.h"
+#include "Navigation/HxlbCostField.h"
+#include "Templates/SharedPointer.h"
+
+// Flow field toward a set of goal hexes.
+//
+// The integration field holds, for every hex, the cost of the cheapest path from that hex to the nearest goal. The
+// direction field holds, for every hex, the direction index (see UHxlbMath::DirectionIndexToAxial()) of the next hex
+// along that path, packed into 3 bits. Units sample their next hex in O(1) instead of running a search each.
+//
+// The integration field is computed chunk by chunk: each chunk runs a local multi-source Dijkstra seeded from its own
+// hexes and from the borders of its neighbors, and chunks whose values changed wake up their neighbors. Chunks are
+// processed in four phases by (row, column) parity, so chunks processed together never share a border and can run in
+// parallel without locks. Directions are stored per chunk for the same reason.
+//
+// When costs change, only the hexes whose path went through a changed hex are reset, and only the chunks around them
+// are recomputed.
+class HEXLIBRUNTIME_API FHxlbFlowField
+{
+// constants
+public:
+	static constexpr uint8 kGoal = 6;
+	static constexpr uint8 kUnreachable = 7;
+	static constexpr int32 kDirectionsPerWord = 21;
+	static constexpr float kUnreached = TNumericLimits<float>::Max();
+
+public:
+	void Build(const FHxlbCostField& CostField, TConstArrayView<FIntPoint> Goals);
+	void Update(const FHxlbCostField& CostField, TConstArrayView<int32> ChangedIndices);
+	bool IsValid() const { return Layout != nullptr; }
+
+	TConstArrayView<FIntPoint> GetGoals() const { return Goals; }
+
+	// Returns kUnreachable for hexes that are outside of the map or that can't reach any goal.
+	uint8 GetDirection(FIntPoint HexCoord) const;
+
+	// Returns false if the hex is a goal or can't reach one.
+	bool GetNextHex(FIntPoint HexCoord, FIntPoint& OutNextHex) const;
+
+	// Cost of the cheapest path to a goal, or kUnreached.
+	float GetIntegratedCost(FIntPoint HexCoord) const;
+	
+	SIZE_T GetAllocatedSize() const { return Integration.GetAllocatedSize() + Directions.GetAllocatedSize(); }
+
+protected:
+	FORCEINLINE uint8 GetPackedDirection(int32 Chunk, int32 Local) const
+	{
+		const uint64 Word = Directions[Chunk * WordsPerChunk + Local / kDirectionsPerWord];
+		return static_cast<uint8>((Word >> ((Local % kDirectionsPerWord) * 3)) & 7);
+	}
+	uint8 GetDirectionUnchecked(FIntPoint HexCoord) const;
+
+	// Runs chunk relaxation until nothing changes. Adds every processed chunk to OutTouchedChunks.
+	void Relax(const FHxlbCostField& CostField, TSet<int32>& DirtyChunks, TSet<int32>& OutTouchedChunks);
+	bool RelaxChunk(const FHxlbCostField& CostField, int32 Chunk);
+	void UpdateDirections(const FHxlbCostField& CostField, const TSet<int32>& Chunks);
+	void AddNeighborChunks(int32 Chunk, TSet<int32>& OutChunks) const;
+	
+	const FHxlbDenseLayout* Layout = nullptr;
+	TArray<FIntPoint> Goals;
+	TArray<float> Integration;
+	TArray<uint64> Directions;
+	int32 WordsPerChunk = 0;
+};
+
+// Flow fields cached by goal set. Cost changes are queued per field and applied the next time the field is requested,
+// so fields that nobody asks for don't cost anything. The least recently used field is evicted when the cache is full.
+class HEXLIBRUNTIME_API FHxlbFlowFieldCache
+{
+// constants
+public:
+	static constexpr int32 kDefaultMaxFields = 16;
+
+public:
+	TSharedRef<const FHxlbFlowField> FindOrBuild(const FHxlbCostField& CostField, TConstArrayView<FIntPoint> Goals);
+	void MarkHexesChanged(TConstArrayView<int32> DenseIndices);
+	void Reset() { Entries.Reset(); }
+	int32 Num() const { return Entries.Num(); }
+
+	int32 MaxFields = kDefaultMaxFields;
+	
+protected:
+	struct FEntry
+	{
+		TArray<FIntPoint> SortedGoals;
+		TSharedRef<FHxlbFlowField> Field = MakeShared<FHxlbFlowField>();
+		TSet<int32> PendingChanges;
+		bool bNeedsRebuild = false;
+		uint64 LastUsed = 0;
+	};
+
+	TArray<FEntry> Entries;
+	uint64 UseCounter = 0;
+};
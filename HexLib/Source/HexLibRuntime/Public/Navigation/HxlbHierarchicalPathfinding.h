@@ -0,0 +1,118 @@
+// Copyright © Mason Stevenson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the disclaimer
+// below) provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+// THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+// CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+// NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+#include "Containers/Map.h"
+#include "Containers/Set.h"
+#include "Navigation/HxlbPathfinding.h"
+
+// Hierarchical A* (HPA*) over the chunks of a dense layout.
+//
+// Every pair of neighboring chunks is connected through entrances: runs of passable hexes along their shared border,
+// each represented by one pair of hexes facing each other. Those hexes are the nodes of an abstract graph. Nodes in the
+// same chunk are connected by the cost of the cheapest path between them that stays inside of the chunk, and the two
+// hexes of an entrance are connected by the cost of stepping across. Queries plan on the abstract graph and then
+// refine each abstract edge with a search that never leaves a single chunk, which keeps queries cheap on large maps.
+// Paths are close to, but not always exactly, the cheapest ones.
+//
+// The graph only depends on the cost field through chunks. When costs change, MarkHexesChanged() + Repair() recompute
+// the entrances around the changed chunks and the intra-chunk edges of the chunks that were touched, nothing else.
+//
+// Build() and Repair() must not run concurrently with queries. Queries are safe to run from any number of threads.
+class HEXLIBRUNTIME_API FHxlbHierarchicalPathfinder
+{
+// constants
+public:
+	// Border runs longer than this are split into several entrances.
+	static constexpr int32 kMaxEntranceWidth = 8;
+
+public:
+	void Build(const FHxlbCostField& CostField);
+	void Reset();
+	bool IsBuilt() const { return bIsBuilt; }
+
+	void MarkHexesChanged(TConstArrayView<int32> DenseIndices);
+	bool NeedsRepair() const { return !DirtyChunks.IsEmpty(); }
+	void Repair(const FHxlbCostField& CostField);
+
+	EHxlbPathStatus FindPath(const FHxlbCostField& CostField, FIntPoint Start, FIntPoint Goal, FHxlbPathResult& OutResult) const;
+
+	int32 NumNodes() const { return NodeOfHex.Num(); }
+	int32 NumEdges() const;
+
+protected:
+	struct FEntrance
+	{
+		int32 LowIndex = INDEX_NONE;
+		int32 HighIndex = INDEX_NONE;
+
+		bool operator==(const FEntrance& Other) const { return LowIndex == Other.LowIndex && HighIndex == Other.HighIndex; }
+	};
+
+	struct FIntraEdge
+	{
+		int32 TargetNode = INDEX_NONE;
+		float Cost = 0.0f;
+	};
+
+	struct FNode
+	{
+		FIntPoint Coord = FIntPoint::ZeroValue;
+		int32 DenseIndex = INDEX_NONE;
+		int32 Chunk = INDEX_NONE;
+		int32 NumEntrances = 0;
+		
+		// Costs of the inter-chunk edges aren't stored, since they are just the cost of the target hex.
+		TArray<int32> InterEdges;
+		TArray<FIntraEdge> IntraEdges;
+	};
+
+	static uint64 MakePairKey(int32 LowChunk, int32 HighChunk) { return (static_cast<uint64>(LowChunk) << 32) | static_cast<uint32>(HighChunk); }
+
+	// Finds the entrances between Chunk and each of its neighbors. If bOnlyHigherChunks is set, only neighbors with a
+	// higher chunk index are considered.
+	void ComputeEntrances(const FHxlbCostField& CostField, int32 Chunk, bool bOnlyHigherChunks, TMap<int32, TArray<FEntrance>>& OutEntrances) const;
+	
+	// Returns true if the entrances of the pair changed.
+	bool SetEntrances(int32 LowChunk, int32 HighChunk, TArray<FEntrance>&& NewEntrances);
+	int32 AcquireNode(int32 DenseIndex, int32 Chunk);
+	void ReleaseNode(int32 NodeIndex);
+	void RebuildIntraEdges(const FHxlbCostField& CostField, TConstArrayView<int32> Chunks);
+
+	bool bIsBuilt = false;
+	const FHxlbDenseLayout* Layout = nullptr;
+	TArray<FNode> Nodes;
+	TArray<int32> FreeNodes;
+	TMap<int32, int32> NodeOfHex;
+	TArray<TArray<int32>> ChunkNodes;
+	TMap<uint64, TArray<FEntrance>> Entrances;
+	TSet<int32> DirtyChunks;
+};
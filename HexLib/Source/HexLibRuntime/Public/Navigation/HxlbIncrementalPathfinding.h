@@ -0,0 +1,122 @@
+// Copyright © Mason Stevenson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the disclaimer
+// below) provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+// THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+// CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+// NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+#include "Containers/Array.h"
+#include "Navigation/HxlbCostField.h"
+#include "Navigation/HxlbPathfinding.h"
+
+// D* Lite: a path from a moving start to a fixed goal that is repaired instead of searched again when costs change.
+//
+// The search runs backward from the goal and keeps, for every hex it has touched, the cost of the cheapest path from
+// that hex to the goal. When the agent moves, only the heuristic changes, and nothing is searched until the next path
+// is requested. When costs change, only the hexes next to the changed ones are queued, and the repair expands just the
+// hexes whose cost to the goal actually changed, plus those needed to prove the new path is the cheapest.
+//
+// One planner is meant to live per agent (or per goal, for agents that share one) for as long as the agent follows the
+// path. It holds a few arrays the size of the map, about 17 bytes per hex.
+class HEXLIBRUNTIME_API FHxlbIncrementalPathfinder
+{
+public:
+	// Starts a new search. The cost field's layout and costs must outlive the planner, or until the next Init().
+	bool Init(const FHxlbCostField& NewCostField, FIntPoint Start, FIntPoint Goal);
+	void Reset();
+	bool IsValid() const { return CostField.IsValid() && GoalIndex != INDEX_NONE; }
+
+	FIntPoint GetGoal() const { return Goal; }
+	FIntPoint GetStart() const { return Start; }
+
+	// Call as the agent moves along its path. Returns false, and keeps the old start, if the hex isn't on the map.
+	bool SetStart(FIntPoint NewStart);
+
+	// Call with the hexes whose cost changed, e.g. from the cost layer's OnChanged. NewCostField must view the same
+	// layout. If the minimum cost dropped, the heuristic is no longer admissible and the search starts over.
+	void UpdateCosts(const FHxlbCostField& NewCostField, TConstArrayView<int32> ChangedIndices);
+
+	// Repairs the search as needed and returns the cheapest path from the start to the goal. NumExpanded counts the
+	// hexes expanded by this repair only.
+	EHxlbPathStatus FindPath(FHxlbPathResult& OutResult);
+
+protected:
+	struct FKey
+	{
+		float Primary = 0.0f;
+		float Secondary = 0.0f;
+
+		FORCEINLINE bool operator<(const FKey& Other) const
+		{
+			return Primary < Other.Primary || (Primary == Other.Primary && Secondary < Other.Secondary);
+		}
+	};
+	struct FQueueEntry
+	{
+		FKey Key;
+		int32 Index = INDEX_NONE;
+	};
+	struct FQueueEntryLess
+	{
+		FORCEINLINE bool operator()(const FQueueEntry& A, const FQueueEntry& B) const
+		{
+			return A.Key < B.Key || (!(B.Key < A.Key) && A.Index < B.Index);
+		}
+	};
+
+	FORCEINLINE float Heuristic(int32 DenseIndex) const;
+	FORCEINLINE float EdgeCost(int32 ToIndex) const;
+	FKey CalculateKey(int32 DenseIndex) const;
+	void UpdateVertex(int32 DenseIndex);
+
+	// Drops stale entries from the top of the queue. Returns false if the queue is empty.
+	bool PeekQueue(FQueueEntry& OutEntry);
+
+	// Stale entries pile up across repairs. Rebuilds the queue from the queued hexes once they outnumber the map.
+	void CompactQueue();
+	int32 ComputeShortestPath();
+
+	FHxlbCostField CostField;
+	FIntPoint Start = FIntPoint::ZeroValue;
+	FIntPoint Goal = FIntPoint::ZeroValue;
+	int32 StartIndex = INDEX_NONE;
+	int32 GoalIndex = INDEX_NONE;
+	float HeuristicScale = 0.0f;
+
+	// Added to every key whenever the start moves, instead of re-keying the whole queue.
+	float KeyModifier = 0.0f;
+
+	// Cost to the goal as of the last expansion, and as implied by the neighbors.
+	TArray<float> CostToGoal;
+	TArray<float> Lookahead;
+
+	// Key the hex is queued with, valid while bQueued. Queue entries with any other key are stale.
+	TArray<FKey> QueuedKeys;
+	TArray<uint8> bQueued;
+	TArray<FQueueEntry> Queue;
+};
@@ -0,0 +1,95 @@
+// Copyright © Mason Stevenson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the disclaimer
+// below) provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+// THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+// CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+// NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+#include "Containers/Array.h"
+#include "Navigation/HxlbCostField.h"
+
+// Landmark (ALT) lower bounds on path costs, for A* on maps where the hex distance heuristic badly underestimates, e.g.
+// around lakes and mountain ranges.
+//
+// Each landmark L stores the cost of the cheapest path from L to every hex. Since the cost of a path is the cost of
+// entering its hexes, the reverse of a path only costs differently by the costs of its two ends, so one table per
+// landmark bounds the cost from X to G from both sides of the triangle inequality:
+//   Cost(X, G) >= Cost(L, G) - Cost(L, X)
+//   Cost(X, G) >= Cost(X, L) - Cost(G, L)
+//
+// Landmarks are picked by farthest point sampling over hex steps, so they end up spread along the edges of the map.
+// Their tables are built in parallel, one weighted distance field per landmark, and interleaved by hex so that the
+// bounds for one hex are read from a single cache line. Tables cost sizeof(float) per hex per landmark.
+//
+// The bounds are only valid for the costs the tables were built from. Mark the landmarks dirty when costs change, and
+// Refresh() them before the next query.
+class HEXLIBRUNTIME_API FHxlbLandmarks
+{
+// constants
+public:
+	static constexpr int32 kDefaultNumLandmarks = 8;
+	
+public:
+	void Build(const FHxlbCostField& CostField, int32 NumLandmarks = kDefaultNumLandmarks);
+	void Reset();
+	bool IsBuilt() const { return !Landmarks.IsEmpty(); }
+
+	// Rebuilds the tables of the same landmarks if costs changed since they were built.
+	void MarkDirty() { bDirty = true; }
+	bool IsDirty() const { return bDirty; }
+	void Refresh(const FHxlbCostField& CostField);
+
+	// True if the bounds can be used for searches on the cost field.
+	bool IsUsableWith(const FHxlbCostField& CostField) const
+	{
+		return IsBuilt() && !bDirty && CostField.IsValid() && Distances.Num() == CostField.GetLayout().Num() * Landmarks.Num();
+	}
+
+	int32 Num() const { return Landmarks.Num(); }
+	TConstArrayView<int32> GetLandmarks() const { return Landmarks; }
+
+	// Cost of the cheapest path from the landmark to the hex, or FHxlbDistanceField::Unreachable.
+	FORCEINLINE float GetDistance(int32 LandmarkIndex, int32 DenseIndex) const { return Distances[DenseIndex * Landmarks.Num() + LandmarkIndex]; }
+
+	// Lower bound on the cost of the cheapest path from one hex to another, over the cost field the tables were built
+	// from. Zero if no landmark can tell.
+	float GetLowerBound(const FHxlbCostField& CostField, int32 FromIndex, int32 ToIndex) const;
+
+	SIZE_T GetAllocatedSize() const { return Landmarks.GetAllocatedSize() + Distances.GetAllocatedSize(); }
+	SIZE_T GetAllocatedSizePerLandmark() const { return IsBuilt() ? Distances.GetAllocatedSize() / Landmarks.Num() : 0; }
+
+protected:
+	void PickLandmarks(const FHxlbCostField& CostField, int32 NumLandmarks);
+	void BuildTables(const FHxlbCostField& CostField);
+	
+	TArray<int32> Landmarks;
+	
+	// Indexed by DenseIndex * Num() + LandmarkIndex.
+	TArray<float> Distances;
+	bool bDirty = false;
+};
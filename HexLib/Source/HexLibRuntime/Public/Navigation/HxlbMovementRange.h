@@ -0,0 +1,80 @@
+// Copyright © Mason Stevenson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the disclaimer
+// below) provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+// THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+// CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+// NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+#include "Foundation/HxlbHexBitmap.h"
+#include "Navigation/HxlbCostField.h"
+#include "Templates/Function.h"
+
+struct FHxlbMovementRangeQuery
+{
+	FIntPoint Origin = FIntPoint::ZeroValue;
+
+	// Number of steps if bUniformCost is set, otherwise the largest total movement cost.
+	float MaxCost = 0.0f;
+	bool bUniformCost = true;
+};
+
+// Which hexes can be reached from an origin within a movement budget.
+//
+// Uniform queries, where every passable hex costs one step, run a breadth-first search on bitmaps: each step expands
+// the whole frontier at once by shifting the rows of a small window around the origin toward all six neighbors, 64
+// hexes per operation. Weighted queries run Dial's algorithm, which replaces the heap of Dijkstra's algorithm with
+// buckets of width MinCost. Both write their result into a bitmap over the dense layout.
+class HEXLIBRUNTIME_API FHxlbMovementRange
+{
+// constants
+public:
+	static constexpr int32 kMaxBuckets = 4096;
+
+public:
+	// Snapshot of which hexes can be entered. Uniform queries only read this, so it has to be rebuilt or updated when
+	// costs change.
+	void Build(const FHxlbCostField& CostField);
+	void UpdateHexes(const FHxlbCostField& CostField, TConstArrayView<int32> DenseIndices);
+	void Reset();
+	bool IsBuilt() const { return Layout != nullptr; }
+	const FHxlbHexBitmap& GetPassable() const { return Passable; }
+
+	// Every hex within MaxSteps steps of Origin, including Origin. OutReachable is resized to the layout and cleared.
+	// Returns the number of reachable hexes.
+	int32 FindReachable(FIntPoint Origin, int32 MaxSteps, FHxlbHexBitmap& OutReachable) const;
+
+	// Every hex that can be reached from Origin for a total movement cost of at most MaxCost, including Origin.
+	static int32 FindReachableWeighted(const FHxlbCostField& CostField, FIntPoint Origin, float MaxCost, FHxlbHexBitmap& OutReachable);
+
+	// Runs many queries in parallel. Func(QueryIndex, Reachable) is called once per query, on worker threads.
+	void FindReachableBatch(const FHxlbCostField& CostField, TConstArrayView<FHxlbMovementRangeQuery> Queries, TFunctionRef<void(int32, const FHxlbHexBitmap&)> Func) const;
+
+protected:
+	const FHxlbDenseLayout* Layout = nullptr;
+	FHxlbHexBitmap Passable;
+};
@@ -0,0 +1,118 @@
+// Copyright © Mason Stevenson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the disclaimer
+// below) provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+// THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+// CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+// NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+#include "Navigation/HxlbCostField.h"
+#include "Navigation/HxlbLandmarks.h"
+
+#include "HxlbPathfinding.generated.h"
+
+UENUM(BlueprintType)
+enum class EHxlbPathStatus : uint8
+{
+	// The path ends at the goal (or within GoalTolerance of it).
+	Found,
+
+	// The goal couldn't be reached within the query limits, and the path ends at the explored hex closest to the goal.
+	Partial,
+	
+	NoPath,
+
+	// The start or the goal is outside of the map, or the map has no compiled cost layer.
+	InvalidQuery
+};
+
+USTRUCT(BlueprintType)
+struct HEXLIBRUNTIME_API FHxlbPathQueryParams
+{
+	GENERATED_BODY()
+
+	// Paths that cost more than this are not considered. Zero or less means unlimited.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Pathfinding")
+	float MaxCost = 0.0f;
+
+	// Gives up after expanding this many hexes. Zero or less means unlimited.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Pathfinding")
+	int32 MaxExpansions = 0;
+
+	// Stops as soon as any hex within this distance of the goal is reached.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta=(ClampMin="0"), Category="Pathfinding")
+	int32 GoalTolerance = 0;
+
+	// Weights above 1 make the search greedier. Paths are found faster but may no longer be the cheapest.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta=(ClampMin="1.0"), Category="Pathfinding")
+	float HeuristicWeight = 1.0f;
+
+	// If the goal can't be reached, return the path to the explored hex that is closest to it.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Pathfinding")
+	bool bAllowPartialPath = false;
+
+	// Use the map's landmark tables for a tighter heuristic (see FHxlbLandmarks). They are built on first use. Ignored
+	// when GoalTolerance is above zero.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Pathfinding")
+	bool bUseLandmarks = false;
+};
+
+USTRUCT(BlueprintType)
+struct HEXLIBRUNTIME_API FHxlbPathResult
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category="Pathfinding")
+	EHxlbPathStatus Status = EHxlbPathStatus::NoPath;
+
+	// Hexes from the start to the end of the path, both included.
+	UPROPERTY(BlueprintReadOnly, Category="Pathfinding")
+	TArray<FIntPoint> Path;
+
+	// Sum of the costs of every hex entered along the path. The start hex is free.
+	UPROPERTY(BlueprintReadOnly, Category="Pathfinding")
+	float Cost = 0.0f;
+	
+	UPROPERTY(BlueprintReadOnly, Category="Pathfinding")
+	int32 NumExpanded = 0;
+
+	bool HasPath() const { return Status == EHxlbPathStatus::Found || Status == EHxlbPathStatus::Partial; }
+};
+
+// A* over the dense index of a hex map.
+//
+// Searches run on a compiled cost field (see UHxlbHexMapComponent::CompileCostLayer()) and use the per-thread search
+// scratch, so a query doesn't allocate anything besides growing OutResult.Path. Queries are safe to run from any
+// number of threads at once, as long as the cost layer isn't modified meanwhile.
+//
+// Pass up to date landmarks to tighten the heuristic beyond the hex distance. Paths stay the cheapest ones, but far
+// fewer hexes are expanded on maps with large obstacles.
+class HEXLIBRUNTIME_API FHxlbPathfinder
+{
+public:
+	static EHxlbPathStatus FindPath(const FHxlbCostField& CostField, FIntPoint Start, FIntPoint Goal, const FHxlbPathQueryParams& Params, FHxlbPathResult& OutResult, const FHxlbLandmarks* Landmarks = nullptr);
+};
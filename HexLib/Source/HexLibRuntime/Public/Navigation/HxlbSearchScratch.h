@@ -0,0 +1,143 @@
+// Copyright © Mason Stevenson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the disclaimer
+// below) provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+// THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+// CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+// NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+#include "Containers/Array.h"
+
+struct FHxlbHeapNode
+{
+	float Key = 0.0f;
+	int32 Index = INDEX_NONE;
+};
+
+// Binary min-heap of (key, dense index) pairs. There is no decrease-key: searches push a hex again when they find a
+// cheaper way to it, and skip stale entries when they pop them. Ties are broken by index so that searches are
+// deterministic. Reset() keeps the allocation.
+class FHxlbNodeHeap
+{
+public:
+	void Reset() { Nodes.Reset(); }
+	bool IsEmpty() const { return Nodes.IsEmpty(); }
+	int32 Num() const { return Nodes.Num(); }
+	const FHxlbHeapNode& Top() const { return Nodes[0]; }
+
+	void Push(float Key, int32 Index)
+	{
+		int32 Child = Nodes.Add(FHxlbHeapNode{Key, Index});
+		while (Child > 0)
+		{
+			const int32 Parent = (Child - 1) / 2;
+			if (!Less(Nodes[Child], Nodes[Parent]))
+			{
+				break;
+			}
+			Swap(Nodes[Child], Nodes[Parent]);
+			Child = Parent;
+		}
+	}
+
+	FHxlbHeapNode Pop()
+	{
+		const FHxlbHeapNode Result = Nodes[0];
+		Nodes[0] = Nodes.Last();
+		Nodes.Pop(EAllowShrinking::No);
+
+		const int32 NumNodes = Nodes.Num();
+		int32 Parent = 0;
+		while (true)
+		{
+			const int32 Left = 2 * Parent + 1;
+			if (Left >= NumNodes)
+			{
+				break;
+			}
+			const int32 Right = Left + 1;
+			const int32 Smallest = (Right < NumNodes && Less(Nodes[Right], Nodes[Left])) ? Right : Left;
+			if (!Less(Nodes[Smallest], Nodes[Parent]))
+			{
+				break;
+			}
+			Swap(Nodes[Smallest], Nodes[Parent]);
+			Parent = Smallest;
+		}
+		return Result;
+	}
+
+protected:
+	static FORCEINLINE bool Less(const FHxlbHeapNode& A, const FHxlbHeapNode& B)
+	{
+		return A.Key < B.Key || (A.Key == B.Key && A.Index < B.Index);
+	}
+	
+	TArray<FHxlbHeapNode> Nodes;
+};
+
+// Per-hex search state that is reused from one query to the next. Instead of clearing its arrays for every query, each
+// query starts a new generation, and slots stamped with an older generation read as unvisited. Once the arrays have
+// grown to the size of the map, queries don't allocate.
+//
+// Use GetForThisThread() to get the scratch of the calling thread. A search must not be re-entered on the same thread
+// while it is using the scratch.
+struct HEXLIBRUNTIME_API FHxlbSearchScratch
+{
+public:
+	static FHxlbSearchScratch& GetForThisThread();
+	
+	// Starts a new query over NumHexes hexes.
+	void Begin(int32 NumHexes);
+
+	FORCEINLINE bool IsOpened(int32 Index) const { return OpenStamps[Index] == Generation; }
+	FORCEINLINE bool IsClosed(int32 Index) const { return ClosedStamps[Index] == Generation; }
+	
+	// Cost from the start, or the largest float if the hex hasn't been reached yet this query.
+	FORCEINLINE float GetCost(int32 Index) const { return IsOpened(Index) ? Costs[Index] : TNumericLimits<float>::Max(); }
+	FORCEINLINE int32 GetParent(int32 Index) const { return Parents[Index]; }
+	FORCEINLINE FIntPoint GetCoord(int32 Index) const { return Coords[Index]; }
+	
+	FORCEINLINE void Open(int32 Index, FIntPoint Coord, float Cost, int32 Parent)
+	{
+		OpenStamps[Index] = Generation;
+		Coords[Index] = Coord;
+		Costs[Index] = Cost;
+		Parents[Index] = Parent;
+	}
+	FORCEINLINE void Close(int32 Index) { ClosedStamps[Index] = Generation; }
+
+	FHxlbNodeHeap Heap;
+
+protected:
+	uint32 Generation = 0;
+	TArray<uint32> OpenStamps;
+	TArray<uint32> ClosedStamps;
+	TArray<float> Costs;
+	TArray<int32> Parents;
+	TArray<FIntPoint> Coords;
+};
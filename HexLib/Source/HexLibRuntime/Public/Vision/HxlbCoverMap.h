@@ -0,0 +1,131 @@
+// Copyright © Mason Stevenson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the disclaimer
+// below) provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+// THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+// CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+// NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+#include "Foundation/HxlbHexBitmap.h"
+#include "Vision/HxlbFieldOfView.h"
+
+#include "HxlbCoverMap.generated.h"
+
+UENUM(BlueprintType)
+enum class EHxlbCoverLevel : uint8
+{
+	None,
+	Half,
+	Full
+};
+
+// How tall a blocker has to be to give cover. Heights are in the units of the vision layers.
+USTRUCT(BlueprintType)
+struct HEXLIBRUNTIME_API FHxlbCoverSettings
+{
+	GENERATED_BODY()
+
+	// Height above the ground of a hex that the ground and whatever stands on a neighbor must reach to give the hex half
+	// cover along their shared edge.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta=(ClampMin="0"), Category="Cover")
+	float HalfCoverHeight = 0.5f;
+
+	// Same for full cover. Opaque neighbors always give full cover.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta=(ClampMin="0"), Category="Cover")
+	float FullCoverHeight = 1.5f;
+
+	bool operator==(const FHxlbCoverSettings& Other) const
+	{
+		return HalfCoverHeight == Other.HalfCoverHeight && FullCoverHeight == Other.FullCoverHeight;
+	}
+	bool operator!=(const FHxlbCoverSettings& Other) const { return !(*this == Other); }
+};
+
+// Cover of every hex of a dense layout along each of its six edges, for tactical scoring without line traces.
+//
+// The cover along an edge comes from the neighbor across it: how far its ground plus whatever stands on it rises above
+// the ground of the hex, read from the elevation and opacity layers of a FHxlbVisionField. Edges on the border of the map
+// have no cover. Each hex packs its six levels into 2 bits per edge, in direction index order (see
+// UHxlbMath::DirectionIndexToAxial()), so the whole table is one uint16 per hex.
+//
+// A hex's cover only depends on itself and its neighbors, so changed hexes are marked and only they and their neighbors
+// are recomputed on the next update.
+class HEXLIBRUNTIME_API FHxlbCoverMap
+{
+// constants
+public:
+	static constexpr int32 kBitsPerEdge = 2;
+	static constexpr uint16 kEdgeMask = (1 << kBitsPerEdge) - 1;
+
+public:
+	// Computes the cover of every hex.
+	void Build(const FHxlbVisionField& Field, const FHxlbCoverSettings& NewSettings);
+	bool IsBuilt() const { return Layout != nullptr; }
+	void Reset();
+
+	// Recomputes the hexes and their neighbors on the next update, e.g. after their elevation or opacity changed.
+	void MarkHexesChanged(TConstArrayView<int32> DenseIndices);
+	void MarkAllChanged() { bAllDirty = true; }
+
+	bool NeedsUpdate() const { return bAllDirty || !DirtyIndices.IsEmpty(); }
+
+	// Recomputes the hexes that changed. Everything is built again if the settings or the layout changed, or if the map
+	// was never built.
+	void Update(const FHxlbVisionField& Field, const FHxlbCoverSettings& NewSettings);
+
+	FORCEINLINE uint16 GetPackedCover(int32 DenseIndex) const { return PackedCover[DenseIndex]; }
+	FORCEINLINE EHxlbCoverLevel GetCover(int32 DenseIndex, int32 DirectionIndex) const
+	{
+		return static_cast<EHxlbCoverLevel>((PackedCover[DenseIndex] >> (DirectionIndex * kBitsPerEdge)) & kEdgeMask);
+	}
+
+	// Best cover of the hex against a threat, from the edges that face it. A threat straight across a corner faces both
+	// edges of the corner. Threats on the hex itself get no cover.
+	EHxlbCoverLevel GetCoverAgainst(int32 DenseIndex, FIntPoint ThreatCoord) const;
+
+	// Number of threats against which the hex has less than MinCover.
+	int32 CountExposures(int32 DenseIndex, TConstArrayView<FIntPoint> ThreatCoords, EHxlbCoverLevel MinCover = EHxlbCoverLevel::Half) const;
+
+	// Bit D is set if edge D of the hex faces the threat. One or two bits are set, or none if the threat is on the hex.
+	static uint8 GetFacingEdges(FIntPoint HexCoord, FIntPoint ThreatCoord);
+
+	// Packed cover of every hex, by dense index.
+	TConstArrayView<uint16> GetValues() const { return PackedCover; }
+	const FHxlbCoverSettings& GetSettings() const { return Settings; }
+
+protected:
+	uint16 ComputeHex(const FHxlbVisionField& Field, FIntPoint HexCoord, int32 DenseIndex) const;
+	
+	const FHxlbDenseLayout* Layout = nullptr;
+	FHxlbCoverSettings Settings;
+	TArray<uint16> PackedCover;
+
+	// Hexes to recompute, with their neighbors already added. DirtyHexes dedupes them.
+	TArray<int32> DirtyIndices;
+	FHxlbHexBitmap DirtyHexes;
+	bool bAllDirty = false;
+};
@@ -0,0 +1,144 @@
+// Copyright © Mason Stevenson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the disclaimer
+// below) provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+// THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+// CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+// NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+#include "Foundation/HxlbDenseLayout.h"
+#include "Foundation/HxlbHexBitmap.h"
+
+#include "HxlbFieldOfView.generated.h"
+
+// Which float hex layers vision reads. Missing layers count as flat ground and as transparent.
+USTRUCT(BlueprintType)
+struct HEXLIBRUNTIME_API FHxlbVisionSettings
+{
+	GENERATED_BODY()
+
+	// Ground height of each hex, in the same units as EyeHeight.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Vision")
+	FName ElevationLayerName;
+
+	// Height of whatever stands on each hex (trees, walls, ...) above the ground. Hexes at or above
+	// FHxlbFieldOfView::kOpaque block sight completely.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Vision")
+	FName OpacityLayerName;
+};
+
+USTRUCT(BlueprintType)
+struct HEXLIBRUNTIME_API FHxlbVisionObserver
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Vision")
+	FIntPoint HexCoord = FIntPoint::ZeroValue;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Vision")
+	int32 Radius = 8;
+
+	// Height of the eye above the ground of the observer's hex.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Vision")
+	float EyeHeight = 1.0f;
+
+	// Height above the ground of a hex that has to be in sight for the hex to count as visible.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Vision")
+	float TargetHeight = 0.0f;
+
+	bool operator==(const FHxlbVisionObserver& Other) const
+	{
+		return HexCoord == Other.HexCoord && Radius == Other.Radius && EyeHeight == Other.EyeHeight && TargetHeight == Other.TargetHeight;
+	}
+	bool operator!=(const FHxlbVisionObserver& Other) const { return !(*this == Other); }
+};
+
+// Non-owning view of the elevation and opacity of every hex of a dense layout. Either may be empty.
+class FHxlbVisionField
+{
+public:
+	FHxlbVisionField() = default;
+	FHxlbVisionField(const FHxlbDenseLayout& NewLayout, TConstArrayView<float> NewElevation, TConstArrayView<float> NewOpacity)
+		: Layout(&NewLayout), Elevation(NewElevation), Opacity(NewOpacity)
+	{
+		check(Elevation.IsEmpty() || Elevation.Num() == Layout->Num());
+		check(Opacity.IsEmpty() || Opacity.Num() == Layout->Num());
+	}
+
+	bool IsValid() const { return Layout && Layout->IsValid(); }
+	const FHxlbDenseLayout& GetLayout() const { return *Layout; }
+	FORCEINLINE float GetElevation(int32 DenseIndex) const { return Elevation.IsEmpty() ? 0.0f : Elevation[DenseIndex]; }
+	FORCEINLINE float GetOpacity(int32 DenseIndex) const { return Opacity.IsEmpty() ? 0.0f : Opacity[DenseIndex]; }
+
+protected:
+	const FHxlbDenseLayout* Layout = nullptr;
+	TConstArrayView<float> Elevation;
+	TConstArrayView<float> Opacity;
+};
+
+// Field of view by shadowcasting over rings.
+//
+// Rings around the observer are visited from the inside out, in the order of FHxlbRingIterator. Each hex of ring R
+// covers an arc of 1 / (6 * R) of the turn around the observer, and rings line up at their corners, so the arc of a hex
+// is covered by the arcs of the hexes in front of it. The arc is split into bins that each remember the steepest slope
+// from the eye to anything seen in that direction so far (the horizon). A hex is visible if the horizon is at or below
+// it anywhere in the middle half of its arc, and then raises the horizon over its whole arc to the slope of its ground
+// plus whatever stands on it. Opaque hexes raise it all the way. Flat, transparent maps see everything in range.
+//
+// Ring offsets are computed once, so a query touches no memory beyond its scratch and the map.
+class HEXLIBRUNTIME_API FHxlbFieldOfView
+{
+// constants
+public:
+	static constexpr float kOpaque = TNumericLimits<float>::Max();
+	static constexpr int32 kBinsPerOuterHex = 4;
+
+public:
+	FHxlbFieldOfView() = default;
+	explicit FHxlbFieldOfView(int32 MaxRadius) { Init(MaxRadius); }
+
+	// Precomputes ring orderings. Observers with a larger radius are clamped to MaxRadius.
+	void Init(int32 MaxRadius);
+	int32 GetMaxRadius() const { return RingStarts.Num() - 1; }
+
+	// Appends the dense index of every visible hex, including the observer's own hex. Returns the number appended.
+	int32 Compute(const FHxlbVisionField& Field, const FHxlbVisionObserver& Observer, TArray<int32>& OutVisible) const;
+
+	// Same as above, written into a bitmap that is resized to the layout and cleared first.
+	int32 Compute(const FHxlbVisionField& Field, const FHxlbVisionObserver& Observer, FHxlbHexBitmap& OutVisible) const;
+
+	// Computes many observers in parallel. OutVisible gets one array of dense indices per observer.
+	void ComputeBatch(const FHxlbVisionField& Field, TConstArrayView<FHxlbVisionObserver> Observers, TArray<TArray<int32>>& OutVisible) const;
+
+	// Everything any of the observers can see.
+	void ComputeUnion(const FHxlbVisionField& Field, TConstArrayView<FHxlbVisionObserver> Observers, FHxlbHexBitmap& OutVisible) const;
+	
+protected:
+	// Offsets of ring R are RingOffsets[RingStarts[R - 1] ... RingStarts[R]).
+	TArray<FIntPoint> RingOffsets;
+	TArray<int32> RingStarts;
+};
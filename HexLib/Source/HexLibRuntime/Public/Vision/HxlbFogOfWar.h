@@ -0,0 +1,104 @@
+// Copyright © Mason Stevenson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the disclaimer
+// below) provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+// THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+// CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT
+// NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+// OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+// ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+#include "Containers/Map.h"
+#include "Vision/HxlbFieldOfView.h"
+
+DECLARE_MULTICAST_DELEGATE_ThreeParams(FOnHxlbFogOfWarChanged, int32 /* PlayerId */, TConstArrayView<int32> /* BecameVisible */, TConstArrayView<int32> /* BecameHidden */);
+
+// What every player currently sees and has ever seen, kept up to date incrementally.
+//
+// Each player has a set of observers, and every hex counts how many of the player's observers see it. Only observers
+// that moved, changed their vision or had the terrain in their range change are recomputed, in parallel; their old
+// contribution is taken off the counts and the new one is added. Hexes whose count goes from zero to non-zero or back
+// are reported as changed, so that rendering and replication only have to deal with the difference.
+class HEXLIBRUNTIME_API FHxlbFogOfWar
+{
+public:
+	// Sizes every player's bitmaps to the layout and clears them. Observers are kept and recomputed on the next update.
+	void Init(const FHxlbDenseLayout& NewLayout);
+	bool IsInitialized() const { return Layout != nullptr; }
+
+	// Adds or moves an observer. Nothing is recomputed until Update().
+	void SetObserver(int32 PlayerId, int32 ObserverId, const FHxlbVisionObserver& Observer);
+	bool RemoveObserver(int32 PlayerId, int32 ObserverId);
+	void RemovePlayer(int32 PlayerId);
+
+	// Recomputes observers that can see any of the hexes, e.g. after their elevation or opacity changed.
+	void MarkHexesChanged(TConstArrayView<int32> DenseIndices);
+	void MarkAllChanged();
+	
+	bool NeedsUpdate() const;
+	int32 GetMaxObserverRadius() const;
+	
+	// Recomputes every observer that changed and broadcasts OnChanged for every player whose visibility changed.
+	void Update(const FHxlbFieldOfView& FieldOfView, const FHxlbVisionField& Field);
+
+	bool IsVisible(int32 PlayerId, int32 DenseIndex) const;
+	bool WasSeen(int32 PlayerId, int32 DenseIndex) const;
+	const FHxlbHexBitmap* GetVisible(int32 PlayerId) const;
+	const FHxlbHexBitmap* GetEverSeen(int32 PlayerId) const;
+
+	// Hexes that changed during the last Update(), in ascending order.
+	TConstArrayView<int32> GetBecameVisible(int32 PlayerId) const;
+	TConstArrayView<int32> GetBecameHidden(int32 PlayerId) const;
+
+	FOnHxlbFogOfWarChanged OnChanged;
+	
+protected:
+	struct FObserverState
+	{
+		FHxlbVisionObserver Observer;
+		TArray<int32> Visible;
+		bool bDirty = true;
+	};
+
+	struct FPlayerState
+	{
+		TMap<int32, FObserverState> Observers;
+		
+		// Contributions of removed observers, taken off the counts on the next update.
+		TArray<int32> PendingRemovals;
+		
+		TArray<uint16> RefCounts;
+		FHxlbHexBitmap Visible;
+		FHxlbHexBitmap EverSeen;
+		TArray<int32> BecameVisible;
+		TArray<int32> BecameHidden;
+	};
+
+	FPlayerState& FindOrAddPlayer(int32 PlayerId);
+	void ApplyChanges(FPlayerState& Player, TConstArrayView<const TArray<int32>*> Added);
+	
+	const FHxlbDenseLayout* Layout = nullptr;
+	TMap<int32, FPlayerState> Players;
+};